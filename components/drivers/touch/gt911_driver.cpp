@@ -14,6 +14,58 @@ i2c_master_bus_handle_t gt911_get_i2c_handle(void)
     return touch_instance->get_i2c_handle();
 }
 
+void gt911_get_last_sample(gt911_sample_t *sample)
+{
+    if (sample == NULL) {
+        return;
+    }
+    if (touch_instance == nullptr) {
+        *sample = gt911_sample_t{};
+        return;
+    }
+    touch_instance->get_last_sample(sample);
+}
+
+esp_err_t gt911_enable_interrupt(void)
+{
+    if (touch_instance == nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!touch_instance->enable_interrupt()) {
+        ESP_LOGI(TAG, "GT911 INT not available, polling");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    ESP_LOGI(TAG, "GT911 reads triggered by INT (GPIO %d)", TP_INT_PIN);
+    return ESP_OK;
+}
+
+void gt911_get_stats(gt911_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    if (touch_instance == nullptr) {
+        *stats = gt911_stats_t{};
+        return;
+    }
+    touch_instance->get_stats(stats);
+}
+
+bool gt911_bus_lock(uint32_t timeout_ms)
+{
+    if (touch_instance == nullptr) {
+        return false;
+    }
+    return touch_instance->bus_lock(timeout_ms);
+}
+
+void gt911_bus_unlock(void)
+{
+    if (touch_instance != nullptr) {
+        touch_instance->bus_unlock();
+    }
+}
+
 esp_err_t gt911_init(esp_lcd_touch_handle_t *tp_handle)
 {
     ESP_LOGI(TAG, "Initializing GT911 touch driver");
@@ -23,7 +75,7 @@ esp_err_t gt911_init(esp_lcd_touch_handle_t *tp_handle)
     }
 
     // Create GT911 touch instance
-    touch_instance = new gt911_touch(TP_I2C_SDA, TP_I2C_SCL, -1, -1);
+    touch_instance = new gt911_touch(TP_I2C_SDA, TP_I2C_SCL, -1, TP_INT_PIN);
     if (touch_instance == NULL) {
         ESP_LOGE(TAG, "Failed to create GT911 instance");
         return ESP_ERR_NO_MEM;
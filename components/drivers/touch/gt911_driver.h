@@ -2,6 +2,7 @@
 #define GT911_DRIVER_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
 #include "esp_lcd_touch.h"  // From espressif__esp_lcd_touch managed component
 #include "driver/i2c_master.h"
@@ -15,6 +16,30 @@ extern "C" {
 #define TP_I2C_SCL 8
 #define TP_I2C_NUM I2C_NUM_0
 
+// GT911 INT line. -1 polls the controller on every LVGL read period; with
+// the GPIO wired to INT the touch is read only when it reports new data.
+// Only set it on boards that route INT: in interrupt mode nothing reads a
+// controller that never raises it.
+#define TP_INT_PIN -1
+
+// Latest touch point read from the controller
+typedef struct {
+    uint32_t seq;       // Reads that returned a point since boot
+    int64_t read_us;    // esp_timer time when that read finished
+    int64_t irq_us;     // INT edge that triggered the read, 0 when polling
+    uint16_t x;
+    uint16_t y;
+} gt911_sample_t;
+
+// Touch bus activity since boot
+typedef struct {
+    bool interrupt_mode;    // Reads are triggered by INT
+    uint32_t reads;         // Status reads over I2C
+    uint32_t interrupts;    // INT edges
+    uint32_t skipped;       // Reads answered with the last point, no new data
+    uint32_t deferred;      // Reads postponed while another device held the bus
+} gt911_stats_t;
+
 /**
  * @brief Initialize GT911 touch driver
  * 
@@ -34,6 +59,45 @@ esp_err_t gt911_init(esp_lcd_touch_handle_t *tp_handle);
  */
 esp_err_t gt911_read_touch(esp_lcd_touch_handle_t tp_handle, uint16_t *x, uint16_t *y, bool *pressed);
 
+/**
+ * @brief Get the latest read that returned a touch point
+ * Call from the task that reads the touch (LVGL task)
+ * 
+ * @param sample Filled with the sample; seq is 0 before the first touch
+ */
+void gt911_get_last_sample(gt911_sample_t *sample);
+
+/**
+ * @brief Switch to INT driven reads when TP_INT_PIN is set
+ * Call after lvgl_port_add_touch(): esp_lvgl_port installs its wake
+ * callback on the INT pin there, and the driver chains in front of it to
+ * flag and timestamp new data. Wakes that arrive while a read is already
+ * flagged are coalesced into it; a read postponed by a camera sequence on
+ * the bus wakes LVGL again from a one-shot timer.
+ * 
+ * @return esp_err_t ESP_OK in interrupt mode, ESP_ERR_NOT_SUPPORTED when polling
+ */
+esp_err_t gt911_enable_interrupt(void);
+
+/**
+ * @brief Get the touch bus counters
+ * 
+ * @param stats Filled with the counters
+ */
+void gt911_get_stats(gt911_stats_t *stats);
+
+/**
+ * @brief Hold the shared I2C bus for a sequence of transfers
+ * The I2C driver serializes single transfers; devices sharing the bus
+ * (camera SCCB) take this lock around register sequences so a touch read
+ * never lands in the middle, and touch reads wait for it. Recursive.
+ * 
+ * @param timeout_ms Time to wait for a touch read in progress
+ * @return true if the bus is held, release it with gt911_bus_unlock()
+ */
+bool gt911_bus_lock(uint32_t timeout_ms);
+void gt911_bus_unlock(void);
+
 /**
  * @brief Get the I2C bus handle used by the touch driver
  * This can be shared with other I2C devices (like camera)
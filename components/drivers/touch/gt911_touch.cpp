@@ -1,11 +1,15 @@
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/i2c_master.h"
 #include "esp_lcd_touch_gt911.h"
 #include "gt911_touch.h"
+#include "gt911_wake.h"
 
 #define CONFIG_LCD_HRES 480
 #define CONFIG_LCD_VRES 800
@@ -15,10 +19,29 @@
 #define I2C_MASTER_SDA_IO       7
 #define I2C_MASTER_FREQ_HZ      400000
 
+// Longest a touch read waits for a camera register sequence
+#define TOUCH_BUS_WAIT_MS       20
+// A postponed read is tried again this long after giving up
+#define TOUCH_RETRY_US          10000
+
 static const char *TAG = "GT911_TOUCH";
 
 static esp_lcd_panel_io_handle_t tp_io_handle = NULL;
 static i2c_master_bus_handle_t i2c_bus_handle = NULL;
+static SemaphoreHandle_t bus_mutex = NULL;
+static esp_err_t (*gt911_read_data)(esp_lcd_touch_handle_t tp) = NULL;
+static gt911_sample_t last_sample = {};
+static gt911_stats_t stats = {};
+
+// INT state, shared with the ISR
+static portMUX_TYPE int_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_lcd_touch_interrupt_callback_t wake_cb = NULL;
+static gt911_wake_t wake = {};
+static esp_timer_handle_t retry_timer = NULL;
+
+// Point of the last I2C read, handed out again until the next one
+static uint8_t held_points = 0;
+static uint16_t held_x = 0, held_y = 0, held_strength = 0;
 
 // Global getter for I2C bus handle (for sharing with camera)
 i2c_master_bus_handle_t gt911_touch::get_i2c_handle()
@@ -26,6 +49,165 @@ i2c_master_bus_handle_t gt911_touch::get_i2c_handle()
     return i2c_bus_handle;
 }
 
+void gt911_touch::get_last_sample(gt911_sample_t *sample)
+{
+    *sample = last_sample;
+}
+
+void gt911_touch::get_stats(gt911_stats_t *out)
+{
+    portENTER_CRITICAL(&int_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&int_lock);
+}
+
+bool gt911_touch::bus_lock(uint32_t timeout_ms)
+{
+    if (bus_mutex == NULL) {
+        return false;
+    }
+    return xSemaphoreTakeRecursive(bus_mutex, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+void gt911_touch::bus_unlock()
+{
+    xSemaphoreGiveRecursive(bus_mutex);
+}
+
+// Flag new data, then wake LVGL through the callback esp_lvgl_port installed
+static void IRAM_ATTR touch_isr(esp_lcd_touch_handle_t tp)
+{
+    portENTER_CRITICAL_ISR(&int_lock);
+    gt911_wake_edge(&wake, esp_timer_get_time());
+    stats.interrupts++;
+    portEXIT_CRITICAL_ISR(&int_lock);
+
+    if (wake_cb) {
+        wake_cb(tp);
+    }
+}
+
+// Wake LVGL again for an edge whose read was postponed
+static void retry_timer_cb(void *arg)
+{
+    portENTER_CRITICAL(&int_lock);
+    gt911_wake_retry_done(&wake);
+    portEXIT_CRITICAL(&int_lock);
+
+    if (wake_cb) {
+        wake_cb((esp_lcd_touch_handle_t)arg);
+    }
+}
+
+static void hold_last_point(esp_lcd_touch_handle_t tp)
+{
+    portENTER_CRITICAL(&tp->data.lock);
+    tp->data.points = held_points;
+    tp->data.coords[0].x = held_x;
+    tp->data.coords[0].y = held_y;
+    tp->data.coords[0].strength = held_strength;
+    portEXIT_CRITICAL(&tp->data.lock);
+}
+
+// Replaces the GT911 read_data: in interrupt mode only an INT edge costs an
+// I2C read, and every wake queued behind it (LVGL busy rendering) gets the
+// same point. Reads also wait for camera sequences on the shared bus.
+static esp_err_t read_data(esp_lcd_touch_handle_t tp)
+{
+    int64_t irq_us = 0;
+    if (stats.interrupt_mode) {
+        portENTER_CRITICAL(&int_lock);
+        bool pending = gt911_wake_take(&wake, &irq_us);
+        if (!pending) {
+            stats.skipped++;
+        }
+        portEXIT_CRITICAL(&int_lock);
+        if (!pending) {
+            hold_last_point(tp);
+            return ESP_OK;
+        }
+    }
+
+    if (xSemaphoreTakeRecursive(bus_mutex, pdMS_TO_TICKS(TOUCH_BUS_WAIT_MS)) != pdTRUE) {
+        // Keep the edge and wake up for it again, report the last point
+        // meanwhile. Nothing else would read a release edge until the next touch.
+        portENTER_CRITICAL(&int_lock);
+        bool arm = stats.interrupt_mode && gt911_wake_defer(&wake, irq_us);
+        stats.deferred++;
+        portEXIT_CRITICAL(&int_lock);
+        if (arm && esp_timer_start_once(retry_timer, TOUCH_RETRY_US) != ESP_OK) {
+            portENTER_CRITICAL(&int_lock);
+            gt911_wake_retry_done(&wake);
+            portEXIT_CRITICAL(&int_lock);
+        }
+        hold_last_point(tp);
+        return ESP_OK;
+    }
+    esp_err_t ret = gt911_read_data(tp);
+    xSemaphoreGiveRecursive(bus_mutex);
+
+    portENTER_CRITICAL(&int_lock);
+    stats.reads++;
+    portEXIT_CRITICAL(&int_lock);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    portENTER_CRITICAL(&tp->data.lock);
+    held_points = tp->data.points ? 1 : 0;
+    held_x = tp->data.coords[0].x;
+    held_y = tp->data.coords[0].y;
+    held_strength = tp->data.coords[0].strength;
+    portEXIT_CRITICAL(&tp->data.lock);
+
+    // Right after the I2C read: the earliest moment the firmware knows the point
+    if (held_points) {
+        last_sample.seq++;
+        last_sample.read_us = esp_timer_get_time();
+        last_sample.irq_us = irq_us;
+        last_sample.x = held_x;
+        last_sample.y = held_y;
+    }
+    return ESP_OK;
+}
+
+bool gt911_touch::enable_interrupt()
+{
+    if (_tp_handle == NULL || _int < 0) {
+        return false;
+    }
+
+    // lvgl_port_add_touch() registered the LVGL wake on the INT pin; run
+    // ours in front of it. Without it (older port) LVGL keeps polling,
+    // but polls without an edge stay off the bus.
+    wake_cb = _tp_handle->config.interrupt_callback;
+    if (retry_timer == NULL) {
+        const esp_timer_create_args_t retry_args = {
+            .callback = retry_timer_cb,
+            .arg = _tp_handle,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "touch_retry",
+            .skip_unhandled_events = true,
+        };
+        if (esp_timer_create(&retry_args, &retry_timer) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create touch retry timer");
+            return false;
+        }
+    }
+    gt911_wake_edge(&wake, esp_timer_get_time());   // First read picks up whatever is there already
+    stats.interrupt_mode = true;
+    esp_err_t ret = esp_lcd_touch_register_interrupt_callback(_tp_handle, touch_isr);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to install INT handler: %s", esp_err_to_name(ret));
+        stats.interrupt_mode = false;
+        if (wake_cb) {
+            esp_lcd_touch_register_interrupt_callback(_tp_handle, wake_cb);
+        }
+        return false;
+    }
+    return true;
+}
+
 gt911_touch::gt911_touch(int8_t sda_pin, int8_t scl_pin, int8_t rst_pin, int8_t int_pin)
 {
     _sda = sda_pin;
@@ -40,6 +222,12 @@ void gt911_touch::begin()
     // Create I2C master bus
     ESP_LOGI(TAG, "Initializing I2C master bus");
     
+    bus_mutex = xSemaphoreCreateRecursiveMutex();
+    if (bus_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create I2C bus lock");
+        return;
+    }
+    
     i2c_master_bus_config_t i2c_bus_config = {
         .i2c_port = I2C_NUM_0,
         .sda_io_num = (gpio_num_t)_sda,
@@ -92,6 +280,8 @@ void gt911_touch::begin()
         ESP_LOGE(TAG, "Failed to initialize GT911: %s", esp_err_to_name(ret));
         return;
     }
+    gt911_read_data = _tp_handle->read_data;
+    _tp_handle->read_data = read_data;
     
     ESP_LOGI(TAG, "GT911 touch controller initialized successfully");
 }
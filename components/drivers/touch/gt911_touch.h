@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include "esp_lcd_touch.h"
 #include "driver/i2c_master.h"
+#include "gt911_driver.h"
 
 class gt911_touch
 {
@@ -18,6 +19,17 @@ public:
     
     // Get the I2C bus handle for sharing with other devices (camera)
     i2c_master_bus_handle_t get_i2c_handle();
+    
+    // Latest read that returned a point, for latency measurement
+    void get_last_sample(gt911_sample_t *sample);
+    
+    // Read on INT instead of every poll; false without an INT pin
+    bool enable_interrupt();
+    void get_stats(gt911_stats_t *stats);
+    
+    // Arbitration of the I2C bus shared with the camera
+    bool bus_lock(uint32_t timeout_ms);
+    void bus_unlock();
 
 private:
     int8_t _sda, _scl, _rst, _int;
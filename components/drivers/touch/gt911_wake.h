@@ -0,0 +1,57 @@
+#ifndef GT911_WAKE_H
+#define GT911_WAKE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// INT edge bookkeeping for interrupt mode reads. LVGL only reads the touch
+// when woken, so an edge whose read had to be postponed (bus held by the
+// camera) needs a wake of its own, or it waits for the next touch. Plain
+// state without locking: the driver calls these under its spinlock.
+typedef struct {
+    bool pending;       // Edge not read yet
+    int64_t edge_us;    // Time of the oldest unread edge
+    bool retry_armed;   // A retry wake is scheduled
+} gt911_wake_t;
+
+// INT edge (ISR); edges before the read coalesce into the first one
+static inline void gt911_wake_edge(gt911_wake_t *w, int64_t now_us)
+{
+    if (!w->pending) {
+        w->pending = true;
+        w->edge_us = now_us;
+    }
+}
+
+// A read: true if there is an edge to read, whose time goes to edge_us
+static inline bool gt911_wake_take(gt911_wake_t *w, int64_t *edge_us)
+{
+    bool pending = w->pending;
+    w->pending = false;
+    *edge_us = w->edge_us;
+    return pending;
+}
+
+// The read taken for edge_us could not get the bus: keep the edge (the
+// older of the two if another came in meanwhile). True when the caller has
+// to schedule the retry wake, false when one is already on its way.
+static inline bool gt911_wake_defer(gt911_wake_t *w, int64_t edge_us)
+{
+    if (!w->pending || edge_us < w->edge_us) {
+        w->edge_us = edge_us;
+    }
+    w->pending = true;
+    if (w->retry_armed) {
+        return false;
+    }
+    w->retry_armed = true;
+    return true;
+}
+
+// The retry wake fired, or could not be scheduled
+static inline void gt911_wake_retry_done(gt911_wake_t *w)
+{
+    w->retry_armed = false;
+}
+
+#endif // GT911_WAKE_H
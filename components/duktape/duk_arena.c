@@ -0,0 +1,405 @@
+/**
+ * Duktape heap arena implementation
+ * Every page has a descriptor. The first page of a free run, slab or
+ * large allocation holds its length; the other pages of a slab or
+ * allocation point back to the first, and the last page of a free run
+ * does too, so a freed run finds both neighbours in constant time.
+ */
+
+#include "duk_arena.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+enum {
+    PAGE_FREE = 0,
+    PAGE_SLAB,          // First page of a slab
+    PAGE_RUN,           // First page of a large allocation
+    PAGE_TAIL,          // Any other page of a slab or large allocation
+};
+
+typedef struct {
+    uint8_t kind;
+    uint8_t cls;                // Slab: size class
+    uint16_t used;              // Slab: objects handed out
+    uint32_t pages;             // First page: length of the run
+    uint32_t head;              // Tail pages and last free page: first page
+    int32_t next;               // Slab: partial slabs of the same class
+    int32_t prev;
+    void *free_list;            // Slab: first free object
+} duk_arena_page_t;
+
+// 8-byte steps where almost all of Duktape's allocations are (strings,
+// objects, property tables, activations), coarser above
+static const uint16_t class_size[] = {
+    8, 16, 24, 32, 40, 48, 56, 64,
+    80, 96, 112, 128, 160, 192, 224, 256,
+    320, 384, 448, 512, 640, 768, 896, 1024,
+    1280, 1536, 1792, 2048,
+};
+#define NUM_CLASSES     (int)(sizeof(class_size) / sizeof(class_size[0]))
+
+static uint8_t class_of_size[DUK_ARENA_SMALL_MAX / 8 + 1];    // By (size + 7) / 8
+static uint8_t class_pages[NUM_CLASSES];                        // Pages per slab
+
+struct duk_arena {
+    uint8_t *base;              // First page
+    duk_arena_page_t *pages;
+    uint32_t npages;
+    uint32_t hint;              // No free page below this one
+    uint32_t max_free;          // No free run is longer than this
+    int32_t partial[NUM_CLASSES];   // Slabs with free objects, per class
+
+    size_t used;
+    size_t peak;
+    size_t pages_used;
+    size_t pages_peak;
+    size_t slab_bytes;          // Pages taken by slabs
+    size_t slab_used;           // Objects handed out from slabs, in bytes
+    uint32_t live;
+    uint32_t allocs;
+    uint32_t failed;
+};
+
+static void classes_init(void) {
+    if (class_pages[0]) return;
+    int cls = 0;
+    for (int i = 0; i <= DUK_ARENA_SMALL_MAX / 8; i++) {
+        while (class_size[cls] < i * 8) cls++;
+        class_of_size[i] = (uint8_t)cls;
+    }
+    // Fewest pages that waste at most 1/16 of the slab, else least waste
+    for (int c = 0; c < NUM_CLASSES; c++) {
+        int best = 1;
+        size_t best_waste = DUK_ARENA_PAGE_SIZE % class_size[c];
+        for (int n = 1; n <= 4; n++) {
+            size_t slab = (size_t)n * DUK_ARENA_PAGE_SIZE;
+            size_t waste = slab % class_size[c];
+            if (waste <= slab / 16) {
+                best = n;
+                break;
+            }
+            if (waste * best < best_waste * n) {
+                best = n;
+                best_waste = waste;
+            }
+        }
+        class_pages[c] = (uint8_t)best;
+    }
+}
+
+static inline uint32_t pages_for(size_t size) {
+    return (uint32_t)((size + DUK_ARENA_PAGE_SIZE - 1) >> DUK_ARENA_PAGE_SHIFT);
+}
+
+static inline bool owns(const duk_arena_t *a, const void *ptr) {
+    const uint8_t *p = (const uint8_t *)ptr;
+    return p >= a->base && p < a->base + ((size_t)a->npages << DUK_ARENA_PAGE_SHIFT);
+}
+
+// First page of the slab or run ptr belongs to
+static inline uint32_t page_of(const duk_arena_t *a, const void *ptr) {
+    uint32_t i = (uint32_t)(((const uint8_t *)ptr - a->base) >> DUK_ARENA_PAGE_SHIFT);
+    return a->pages[i].kind == PAGE_TAIL ? a->pages[i].head : i;
+}
+
+static void account_used(duk_arena_t *a, long delta) {
+    a->used += delta;
+    if (a->used > a->peak) a->peak = a->used;
+}
+
+static void account_pages(duk_arena_t *a, long pages) {
+    a->pages_used += pages * DUK_ARENA_PAGE_SIZE;
+    if (a->pages_used > a->pages_peak) a->pages_peak = a->pages_used;
+}
+
+// ============ PAGE RUNS ============
+
+static void mark_free(duk_arena_t *a, uint32_t first, uint32_t n) {
+    duk_arena_page_t *pg = &a->pages[first];
+    pg->kind = PAGE_FREE;
+    pg->pages = n;
+    pg->head = first;
+    pg = &a->pages[first + n - 1];
+    pg->kind = PAGE_FREE;
+    pg->pages = n;
+    pg->head = first;
+}
+
+static void mark_used(duk_arena_t *a, uint32_t first, uint32_t from, uint32_t n) {
+    for (uint32_t i = from; i < first + n; i++) {
+        a->pages[i].kind = PAGE_TAIL;
+        a->pages[i].head = first;
+    }
+    a->pages[first].pages = n;
+}
+
+// Take the first free run of at least n pages; -1 if there is none.
+// A failed scan lowers max_free, so a full arena refuses at once (the
+// emergency GC retries every allocation it compacts).
+static int32_t run_alloc(duk_arena_t *a, uint32_t n, uint8_t kind) {
+    if (n > a->max_free) return -1;
+    bool skipped = false;
+    uint32_t longest = 0;
+    for (uint32_t i = a->hint; i < a->npages; i += a->pages[i].pages) {
+        duk_arena_page_t *pg = &a->pages[i];
+        if (pg->kind != PAGE_FREE) continue;
+        if (pg->pages < n) {
+            if (pg->pages > longest) longest = pg->pages;
+            skipped = true;
+            continue;
+        }
+        uint32_t rest = pg->pages - n;
+        if (rest) mark_free(a, i + n, rest);
+        if (!skipped) a->hint = i + n;
+        mark_used(a, i, i + 1, n);
+        pg->kind = kind;
+        account_pages(a, n);
+        return (int32_t)i;
+    }
+    a->max_free = longest;
+    return -1;
+}
+
+// Give a slab's or allocation's pages back, merging with free neighbours
+static void run_free(duk_arena_t *a, uint32_t first) {
+    uint32_t n = a->pages[first].pages;
+    account_pages(a, -(long)n);
+    if (first + n < a->npages && a->pages[first + n].kind == PAGE_FREE) {
+        n += a->pages[first + n].pages;
+    }
+    if (first > 0 && a->pages[first - 1].kind == PAGE_FREE) {
+        uint32_t prev = a->pages[first - 1].head;
+        n += first - prev;
+        first = prev;
+    }
+    mark_free(a, first, n);
+    if (first < a->hint) a->hint = first;
+    if (n > a->max_free) a->max_free = n;
+}
+
+// Resize a large allocation in place: shrink, or grow into a free run
+// right after it. False if that run is missing or too small.
+static bool run_resize(duk_arena_t *a, uint32_t first, uint32_t n) {
+    uint32_t have = a->pages[first].pages;
+    if (n < have) {
+        a->pages[first].pages = n;
+        a->pages[first + n].kind = PAGE_RUN;
+        a->pages[first + n].pages = have - n;
+        run_free(a, first + n);
+    } else if (n > have) {
+        uint32_t next = first + have;
+        uint32_t more = n - have;
+        if (next >= a->npages || a->pages[next].kind != PAGE_FREE || a->pages[next].pages < more) {
+            return false;
+        }
+        uint32_t rest = a->pages[next].pages - more;
+        if (rest) mark_free(a, next + more, rest);
+        if (a->hint == next) a->hint = next + more;
+        mark_used(a, first, next, n);
+        account_pages(a, more);
+    }
+    account_used(a, ((long)n - (long)have) * DUK_ARENA_PAGE_SIZE);
+    return true;
+}
+
+// ============ SLABS ============
+
+static void partial_push(duk_arena_t *a, int cls, uint32_t slab) {
+    duk_arena_page_t *pg = &a->pages[slab];
+    pg->prev = -1;
+    pg->next = a->partial[cls];
+    if (pg->next >= 0) a->pages[pg->next].prev = (int32_t)slab;
+    a->partial[cls] = (int32_t)slab;
+}
+
+static void partial_remove(duk_arena_t *a, int cls, uint32_t slab) {
+    duk_arena_page_t *pg = &a->pages[slab];
+    if (pg->prev >= 0) {
+        a->pages[pg->prev].next = pg->next;
+    } else {
+        a->partial[cls] = pg->next;
+    }
+    if (pg->next >= 0) a->pages[pg->next].prev = pg->prev;
+}
+
+static int32_t slab_create(duk_arena_t *a, int cls) {
+    int32_t slab = run_alloc(a, class_pages[cls], PAGE_SLAB);
+    if (slab < 0) return -1;
+
+    duk_arena_page_t *pg = &a->pages[slab];
+    size_t size = class_size[cls];
+    size_t count = ((size_t)class_pages[cls] << DUK_ARENA_PAGE_SHIFT) / size;
+    uint8_t *obj = a->base + ((size_t)slab << DUK_ARENA_PAGE_SHIFT);
+    pg->cls = (uint8_t)cls;
+    pg->used = 0;
+    pg->free_list = obj;
+    for (size_t i = 0; i + 1 < count; i++, obj += size) {
+        *(void **)obj = obj + size;
+    }
+    *(void **)obj = NULL;
+
+    a->slab_bytes += (size_t)class_pages[cls] << DUK_ARENA_PAGE_SHIFT;
+    partial_push(a, cls, (uint32_t)slab);
+    return slab;
+}
+
+static void *slab_alloc(duk_arena_t *a, int cls) {
+    int32_t slab = a->partial[cls];
+    if (slab < 0) slab = slab_create(a, cls);
+    if (slab < 0) return NULL;
+
+    duk_arena_page_t *pg = &a->pages[slab];
+    void *obj = pg->free_list;
+    pg->free_list = *(void **)obj;
+    pg->used++;
+    if (!pg->free_list) partial_remove(a, cls, (uint32_t)slab);
+    a->slab_used += class_size[cls];
+    account_used(a, class_size[cls]);
+    return obj;
+}
+
+static void slab_free(duk_arena_t *a, uint32_t slab, void *obj) {
+    duk_arena_page_t *pg = &a->pages[slab];
+    int cls = pg->cls;
+    bool was_full = !pg->free_list;
+    *(void **)obj = pg->free_list;
+    pg->free_list = obj;
+    pg->used--;
+    a->slab_used -= class_size[cls];
+    account_used(a, -(long)class_size[cls]);
+    if (was_full) partial_push(a, cls, slab);
+
+    // An empty slab goes back to the pages unless it is the class's last
+    // one with room, which would just be created again
+    if (pg->used == 0 && (a->partial[cls] != (int32_t)slab || pg->next >= 0)) {
+        partial_remove(a, cls, slab);
+        a->slab_bytes -= (size_t)class_pages[cls] << DUK_ARENA_PAGE_SHIFT;
+        run_free(a, slab);
+    }
+}
+
+// ============ API ============
+
+duk_arena_t *duk_arena_create(size_t size) {
+    if (size < DUK_ARENA_MIN_SIZE) size = DUK_ARENA_MIN_SIZE;
+    classes_init();
+
+#ifdef ESP_PLATFORM
+    uint8_t *mem = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+    uint8_t *mem = malloc(size);
+#endif
+    if (!mem) return NULL;
+
+    // Arena, page descriptors, then the pages (8-byte aligned)
+    duk_arena_t *a = (duk_arena_t *)mem;
+    memset(a, 0, sizeof(*a));
+    size_t avail = size - sizeof(*a) - 8;
+    a->npages = (uint32_t)(avail / (DUK_ARENA_PAGE_SIZE + sizeof(duk_arena_page_t)));
+    a->pages = (duk_arena_page_t *)(mem + sizeof(*a));
+    a->base = (uint8_t *)(((uintptr_t)(a->pages + a->npages) + 7) & ~(uintptr_t)7);
+    memset(a->pages, 0, a->npages * sizeof(duk_arena_page_t));
+    for (int c = 0; c < NUM_CLASSES; c++) a->partial[c] = -1;
+    mark_free(a, 0, a->npages);
+    a->max_free = a->npages;
+    return a;
+}
+
+void duk_arena_destroy(duk_arena_t *arena) {
+#ifdef ESP_PLATFORM
+    heap_caps_free(arena);
+#else
+    free(arena);
+#endif
+}
+
+void *duk_arena_alloc(duk_arena_t *arena, size_t size) {
+    if (size == 0) return NULL;
+
+    void *ptr = NULL;
+    if (size <= DUK_ARENA_SMALL_MAX) {
+        ptr = slab_alloc(arena, class_of_size[(size + 7) >> 3]);
+    } else {
+        uint32_t n = pages_for(size);
+        int32_t first = run_alloc(arena, n, PAGE_RUN);
+        if (first >= 0) {
+            ptr = arena->base + ((size_t)first << DUK_ARENA_PAGE_SHIFT);
+            account_used(arena, (long)n * DUK_ARENA_PAGE_SIZE);
+        }
+    }
+    if (!ptr) {
+        arena->failed++;
+        return NULL;
+    }
+    arena->live++;
+    arena->allocs++;
+    return ptr;
+}
+
+void duk_arena_free(duk_arena_t *arena, void *ptr) {
+    if (!ptr || !owns(arena, ptr)) return;
+    uint32_t first = page_of(arena, ptr);
+    if (arena->pages[first].kind == PAGE_SLAB) {
+        slab_free(arena, first, ptr);
+    } else {
+        account_used(arena, -(long)arena->pages[first].pages * DUK_ARENA_PAGE_SIZE);
+        run_free(arena, first);
+    }
+    arena->live--;
+}
+
+void *duk_arena_realloc(duk_arena_t *arena, void *ptr, size_t size) {
+    if (!ptr) return duk_arena_alloc(arena, size);
+    if (size == 0) {
+        duk_arena_free(arena, ptr);
+        return NULL;
+    }
+    if (!owns(arena, ptr)) return NULL;
+
+    // Stay in place if the size class or page count allows it
+    uint32_t first = page_of(arena, ptr);
+    size_t old;
+    if (arena->pages[first].kind == PAGE_SLAB) {
+        old = class_size[arena->pages[first].cls];
+        if (size <= DUK_ARENA_SMALL_MAX && class_of_size[(size + 7) >> 3] == arena->pages[first].cls) {
+            return ptr;
+        }
+    } else {
+        old = (size_t)arena->pages[first].pages << DUK_ARENA_PAGE_SHIFT;
+        if (size > DUK_ARENA_SMALL_MAX && run_resize(arena, first, pages_for(size))) {
+            return ptr;
+        }
+    }
+
+    void *moved = duk_arena_alloc(arena, size);
+    if (!moved) return NULL;
+    memcpy(moved, ptr, old < size ? old : size);
+    duk_arena_free(arena, ptr);
+    return moved;
+}
+
+void duk_arena_get_stats(const duk_arena_t *arena, duk_arena_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->size = (size_t)arena->npages << DUK_ARENA_PAGE_SHIFT;
+    stats->used = arena->used;
+    stats->peak = arena->peak;
+    stats->pages_used = arena->pages_used;
+    stats->pages_peak = arena->pages_peak;
+    stats->slab_slack = arena->slab_bytes - arena->slab_used;
+    stats->live = arena->live;
+    stats->allocs = arena->allocs;
+    stats->failed = arena->failed;
+
+    for (uint32_t i = 0; i < arena->npages; i += arena->pages[i].pages) {
+        if (arena->pages[i].kind != PAGE_FREE) continue;
+        size_t bytes = (size_t)arena->pages[i].pages << DUK_ARENA_PAGE_SHIFT;
+        stats->free += bytes;
+        if (bytes > stats->largest_free) stats->largest_free = bytes;
+    }
+    if (stats->free) {
+        stats->fragmentation = (uint8_t)(100 - stats->largest_free * 100 / stats->free);
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * Duktape heap arena
+ * One contiguous block per Duktape heap (PSRAM on the ESP32) that all of
+ * the heap's allocations come from, so JS objects never touch the system
+ * heap and destroying the heap gives the block back in one piece.
+ *
+ * The block is split into 4 KB pages. Requests up to DUK_ARENA_SMALL_MAX
+ * bytes are served from slabs of equal-sized objects, in size classes
+ * that follow Duktape's allocation profile (strings, objects and property
+ * tables, nearly all below 160 bytes); larger ones get a run of whole
+ * pages, first fit, coalesced again when freed.
+ *
+ * Not thread safe: a Duktape heap is only used by one task at a time.
+ */
+
+#ifndef DUK_ARENA_H
+#define DUK_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DUK_ARENA_PAGE_SHIFT    12
+#define DUK_ARENA_PAGE_SIZE     (1 << DUK_ARENA_PAGE_SHIFT)
+#define DUK_ARENA_SMALL_MAX     2048
+#define DUK_ARENA_MIN_SIZE      (256 * 1024)
+
+typedef struct duk_arena duk_arena_t;
+
+typedef struct {
+    size_t size;                // Bytes available for allocations
+    size_t used;                // Bytes handed out, rounded up to size class or page
+    size_t peak;                // Highest used
+    size_t pages_used;          // Bytes of pages taken by slabs and runs
+    size_t pages_peak;          // Highest pages_used
+    size_t slab_slack;          // Free bytes inside slabs
+    size_t free;                // Bytes of free pages
+    size_t largest_free;        // Largest allocation of whole pages that would succeed
+    uint8_t fragmentation;      // Percent of free pages outside the largest free run
+    uint32_t live;              // Allocations outstanding
+    uint32_t allocs;            // Allocations made (realloc moves included)
+    uint32_t failed;            // Allocations refused
+} duk_arena_stats_t;
+
+// Create an arena of about size bytes (page tables included).
+// Returns NULL if the memory is not available.
+duk_arena_t *duk_arena_create(size_t size);
+
+// Free the whole arena, whatever is still allocated from it
+void duk_arena_destroy(duk_arena_t *arena);
+
+// malloc/realloc/free semantics; size 0 allocates nothing
+void *duk_arena_alloc(duk_arena_t *arena, size_t size);
+void *duk_arena_realloc(duk_arena_t *arena, void *ptr, size_t size);
+void duk_arena_free(duk_arena_t *arena, void *ptr);
+
+void duk_arena_get_stats(const duk_arena_t *arena, duk_arena_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DUK_ARENA_H
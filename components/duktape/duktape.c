@@ -52172,6 +52172,13 @@ DUK_INTERNAL duk_uint32_t duk_heap_hashstring(duk_heap *heap, const duk_uint8_t
 
 /* #include duk_internal.h -> already included */
 
+#if defined(DUK_USE_MARK_AND_SWEEP_HOOK)
+/* Port: called with the heap udata as each mark-and-sweep pass (not
+ * counting finalizer execution) starts and ends.
+ */
+extern void DUK_USE_MARK_AND_SWEEP_HOOK(void *udata, duk_bool_t start);
+#endif
+
 DUK_LOCAL_DECL void duk__mark_heaphdr(duk_heap *heap, duk_heaphdr *h);
 DUK_LOCAL_DECL void duk__mark_heaphdr_nonnull(duk_heap *heap, duk_heaphdr *h);
 DUK_LOCAL_DECL void duk__mark_tval(duk_heap *heap, duk_tval *tv);
@@ -53457,6 +53464,10 @@ DUK_INTERNAL void duk_heap_mark_and_sweep(duk_heap *heap, duk_small_uint_t flags
 	 *  Begin
 	 */
 
+#if defined(DUK_USE_MARK_AND_SWEEP_HOOK)
+	DUK_USE_MARK_AND_SWEEP_HOOK(heap->heap_udata, 1);
+#endif
+
 	DUK_ASSERT(heap->ms_prevent_count == 0);
 	DUK_ASSERT(heap->ms_running == 0);
 	heap->ms_prevent_count = 1;
@@ -53640,6 +53651,10 @@ DUK_INTERNAL void duk_heap_mark_and_sweep(duk_heap *heap, duk_small_uint_t flags
 	duk__dump_stats(heap);
 #endif
 
+#if defined(DUK_USE_MARK_AND_SWEEP_HOOK)
+	DUK_USE_MARK_AND_SWEEP_HOOK(heap->heap_udata, 0);
+#endif
+
 	/*
 	 *  Finalize objects in the finalization work list.  Finalized
 	 *  objects are queued back to heap_allocated with FINALIZED set.
@@ -77307,6 +77322,13 @@ DUK_INTERNAL void duk_js_compile(duk_hthread *thr, const duk_uint8_t *src_buffer
 
 /* #include duk_internal.h -> already included */
 
+#if defined(DUK_USE_EXEC_TIMEOUT_CHECK)
+/* Port: called with the heap udata from executor interrupts; nonzero
+ * aborts the running code with a RangeError.
+ */
+extern duk_bool_t DUK_USE_EXEC_TIMEOUT_CHECK(void *udata);
+#endif
+
 /*
  *  Local declarations.
  */
@@ -6,6 +6,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
@@ -13,16 +16,72 @@
 
 static const char *TAG = "DUKTAPE";
 
-// Store console callback globally (accessed from native functions)
-static duk_console_callback_t g_console_cb = NULL;
+// Cache file: header, then the duk_dump_function() output. Bytecode is not
+// validated by duk_load_function(), so its hash is checked before loading.
+#define DUK_CACHE_MAGIC         0x43424B44      // "DKBC"
+#define DUK_CACHE_MAX_SOURCE    (256 * 1024)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t duk_version;
+    uint32_t source_len;
+    uint32_t bytecode_len;
+    uint64_t source_hash;
+    uint64_t bytecode_hash;
+} duk_cache_header_t;
+
+// The wrapper a native function runs under (the heap udata)
+duk_esp32_t* duk_esp32_from_ctx(duk_context *ctx) {
+    duk_memory_functions funcs;
+    duk_get_memory_functions(ctx, &funcs);
+    return (duk_esp32_t *)funcs.udata;
+}
+
+// Queue a line for duk_esp32_read_output(). Waits a little for the reader
+// when the queue is full, then drops the line.
+static void duk_output_push(duk_esp32_t *duk, const char *text, size_t len) {
+    if (len > DUK_ESP32_OUTPUT_SIZE) len = DUK_ESP32_OUTPUT_SIZE;
+    uint32_t head = duk->out_head;
+    for (int wait = 0; ; wait++) {
+        uint32_t tail = __atomic_load_n(&duk->out_tail, __ATOMIC_ACQUIRE);
+        if (DUK_ESP32_OUTPUT_SIZE - (head - tail) >= len) break;
+        if (wait >= 20 || duk->stop) {
+            duk->out_dropped += len;
+            return;
+        }
+        vTaskDelay(1);
+    }
+    for (size_t i = 0; i < len; i++) {
+        duk->out[(head + i) & (DUK_ESP32_OUTPUT_SIZE - 1)] = text[i];
+    }
+    __atomic_store_n(&duk->out_head, head + (uint32_t)len, __ATOMIC_RELEASE);
+}
 
 // Native console.log implementation
 static duk_ret_t native_console_log(duk_context *ctx) {
+    duk_esp32_t *duk = duk_esp32_from_ctx(ctx);
     int n = duk_get_top(ctx);
+    
+    // On the worker the arguments become one queued line
+    if (duk && __atomic_load_n(&duk->state, __ATOMIC_ACQUIRE) == DUK_ESP32_RUNNING) {
+        for (int i = 0; i < n; i++) {
+            duk_safe_to_string(ctx, i);
+        }
+        duk_push_string(ctx, " ");
+        duk_insert(ctx, 0);
+        duk_join(ctx, n);
+        duk_push_string(ctx, "\n");
+        duk_concat(ctx, 2);
+        duk_size_t len = 0;
+        const char *line = duk_get_lstring(ctx, -1, &len);
+        duk_output_push(duk, line, len);
+        return 0;
+    }
+    
     for (int i = 0; i < n; i++) {
         const char *str = duk_safe_to_string(ctx, i);
-        if (g_console_cb) {
-            g_console_cb(str);
+        if (duk && duk->console_cb) {
+            duk->console_cb(str);
         } else {
             ESP_LOGI(TAG, "%s", str);
         }
@@ -42,15 +101,322 @@ static duk_ret_t native_millis(duk_context *ctx) {
     return 1;
 }
 
-// Native delay(ms) - blocking delay
+// Native delay(ms) - on the worker it sleeps without using up the run's
+// CPU budget and duk_esp32_stop() wakes it. Anywhere else the caller
+// (often the LVGL task) is blocked too, so the sleep is cut short at the
+// budget and the run then ends on it.
 static duk_ret_t native_delay(duk_context *ctx) {
+    duk_esp32_t *duk = duk_esp32_from_ctx(ctx);
     int ms = duk_require_int(ctx, 0);
-    if (ms > 0) {
-        vTaskDelay(pdMS_TO_TICKS(ms));
+    if (ms <= 0) return 0;
+    
+    int64_t start = esp_timer_get_time();
+    if (duk->worker && xTaskGetCurrentTaskHandle() == (TaskHandle_t)duk->worker) {
+        TickType_t until = xTaskGetTickCount() + pdMS_TO_TICKS(ms);
+        while (!duk->stop) {
+            TickType_t left = until - xTaskGetTickCount();
+            if ((int32_t)left <= 0) break;
+            ulTaskNotifyTake(pdTRUE, left);
+        }
+        if (duk->deadline) duk->deadline += esp_timer_get_time() - start;
+    } else {
+        if (duk->deadline) {
+            int64_t left_ms = (duk->deadline - start + 999) / 1000;
+            if (ms > left_ms) ms = left_ms > 0 ? (int)left_ms : 0;
+        }
+        if (ms > 0) vTaskDelay(pdMS_TO_TICKS(ms));
+    }
+    if (duk->stop) {
+        return duk_error(ctx, DUK_ERR_ERROR, "Stopped");
+    }
+    if (duk->deadline && esp_timer_get_time() >= duk->deadline) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "CPU budget used up");
+    }
+    return 0;
+}
+
+// ============ TIMERS AND MICROTASKS ============
+
+// Promise for scripts: Duktape's own is a stub, this one resolves through
+// queueMicrotask(), so reactions run when the microtask queue is drained
+static const char *duk_promise_js =
+    "(function (g) {\n"
+    "if (typeof g.Promise === 'function') return;\n"
+    "function NOOP() {}\n"
+    "function P(executor) {\n"
+    "  if (!(this instanceof P)) throw new TypeError('Promise needs new');\n"
+    "  this._s = 0; this._v = undefined; this._q = null;\n"
+    "  if (executor === NOOP) return;\n"
+    "  var self = this, done = false;\n"
+    "  try {\n"
+    "    executor(function (v) { if (!done) { done = true; resolve(self, v); } },\n"
+    "             function (r) { if (!done) { done = true; settle(self, 2, r); } });\n"
+    "  } catch (e) { if (!done) { done = true; settle(self, 2, e); } }\n"
+    "}\n"
+    "function settle(p, s, v) {\n"
+    "  if (p._s !== 0) return;\n"
+    "  p._s = s; p._v = v;\n"
+    "  var q = p._q; p._q = null;\n"
+    "  for (var i = 0; q && i < q.length; i++) react(p, q[i]);\n"
+    "}\n"
+    "function resolve(p, v) {\n"
+    "  if (v === p) return settle(p, 2, new TypeError('Promise resolved with itself'));\n"
+    "  if (v !== null && (typeof v === 'object' || typeof v === 'function')) {\n"
+    "    var then;\n"
+    "    try { then = v.then; } catch (e) { return settle(p, 2, e); }\n"
+    "    if (typeof then === 'function') {\n"
+    "      queueMicrotask(function () {\n"
+    "        var called = false;\n"
+    "        try {\n"
+    "          then.call(v, function (y) { if (!called) { called = true; resolve(p, y); } },\n"
+    "                       function (r) { if (!called) { called = true; settle(p, 2, r); } });\n"
+    "        } catch (e) { if (!called) { called = true; settle(p, 2, e); } }\n"
+    "      });\n"
+    "      return;\n"
+    "    }\n"
+    "  }\n"
+    "  settle(p, 1, v);\n"
+    "}\n"
+    "function react(p, h) {\n"
+    "  queueMicrotask(function () {\n"
+    "    var cb = p._s === 1 ? h.f : h.r, x;\n"
+    "    if (typeof cb !== 'function') {\n"
+    "      if (p._s === 1) resolve(h.p, p._v); else settle(h.p, 2, p._v);\n"
+    "      return;\n"
+    "    }\n"
+    "    try { x = cb(p._v); } catch (e) { settle(h.p, 2, e); return; }\n"
+    "    resolve(h.p, x);\n"
+    "  });\n"
+    "}\n"
+    "P.prototype.then = function (f, r) {\n"
+    "  var h = { f: f, r: r, p: new P(NOOP) };\n"
+    "  if (this._s === 0) (this._q || (this._q = [])).push(h); else react(this, h);\n"
+    "  return h.p;\n"
+    "};\n"
+    "P.prototype['catch'] = function (r) { return this.then(undefined, r); };\n"
+    "P.prototype['finally'] = function (f) {\n"
+    "  return this.then(function (v) { return P.resolve(f()).then(function () { return v; }); },\n"
+    "                   function (e) { return P.resolve(f()).then(function () { throw e; }); });\n"
+    "};\n"
+    "P.resolve = function (v) { return v instanceof P ? v : new P(function (res) { res(v); }); };\n"
+    "P.reject = function (r) { return new P(function (res, rej) { rej(r); }); };\n"
+    "P.all = function (list) {\n"
+    "  return new P(function (res, rej) {\n"
+    "    var out = [], left = list.length;\n"
+    "    if (!left) return res(out);\n"
+    "    list.forEach(function (item, i) {\n"
+    "      P.resolve(item).then(function (v) { out[i] = v; if (--left === 0) res(out); }, rej);\n"
+    "    });\n"
+    "  });\n"
+    "};\n"
+    "P.race = function (list) {\n"
+    "  return new P(function (res, rej) {\n"
+    "    list.forEach(function (item) { P.resolve(item).then(res, rej); });\n"
+    "  });\n"
+    "};\n"
+    "g.Promise = P;\n"
+    "})(this);\n";
+
+// Push stash[key]: "timers" (id -> [callback, args...]) or "jobs"
+static void duk_push_stash_prop(duk_context *ctx, const char *key) {
+    duk_push_heap_stash(ctx);
+    duk_get_prop_string(ctx, -1, key);
+    duk_remove(ctx, -2);
+}
+
+// Print a line the way console.log would
+static void duk_print_line(duk_esp32_t *duk, const char *text) {
+    if (__atomic_load_n(&duk->state, __ATOMIC_ACQUIRE) == DUK_ESP32_RUNNING) {
+        duk_output_push(duk, text, strlen(text));
+        duk_output_push(duk, "\n", 1);
+    } else if (duk->console_cb) {
+        duk->console_cb(text);
+    } else {
+        ESP_LOGI(TAG, "%s", text);
+    }
+}
+
+// An error escaped a timer callback or microtask (on the stack top).
+// Returns false if it is the run being stopped or out of budget.
+static bool duk_report_uncaught(duk_esp32_t *duk) {
+    if (duk->stop || (duk->deadline && esp_timer_get_time() >= duk->deadline)) return false;
+    char line[160];
+    snprintf(line, sizeof(line), "Uncaught %s", duk_safe_to_string(duk->ctx, -1));
+    duk_print_line(duk, line);
+    return true;
+}
+
+// Run queued microtasks, including those they queue, until none are left.
+// The queue is taken a batch at a time (with a fresh array for what the
+// batch queues), so a long promise chain does not keep one growing array.
+// Returns false if the run was stopped or ran out of budget.
+static bool duk_drain_microtasks(duk_esp32_t *duk) {
+    duk_context *ctx = duk->ctx;
+    duk_idx_t base = duk_get_top(ctx);
+    duk_push_heap_stash(ctx);
+    
+    bool ok = true;
+    while (ok) {
+        duk_get_prop_string(ctx, base, "jobs");
+        duk_uarridx_t n = (duk_uarridx_t)duk_get_length(ctx, -1);
+        if (n == 0) break;
+        duk_push_array(ctx);
+        duk_put_prop_string(ctx, base, "jobs");
+        for (duk_uarridx_t i = 0; ok && i < n; i++) {
+            duk_get_prop_index(ctx, base + 1, i);
+            if (duk_pcall(ctx, 0) != 0) ok = duk_report_uncaught(duk);
+            duk_pop(ctx);
+        }
+        duk_pop(ctx);
+    }
+    
+    // A stopped run drops whatever is still queued
+    if (!ok) {
+        duk_push_array(ctx);
+        duk_put_prop_string(ctx, base, "jobs");
+    }
+    duk_set_top(ctx, base);
+    return ok;
+}
+
+static bool duk_timer_before(const duk_esp32_timer_t *a, const duk_esp32_timer_t *b) {
+    return a->due < b->due || (a->due == b->due && a->id < b->id);
+}
+
+static void duk_timer_sift_down(duk_esp32_t *duk, int i) {
+    duk_esp32_timer_t *h = duk->timers;
+    for (;;) {
+        int min = i, l = 2 * i + 1, r = l + 1;
+        if (l < duk->timer_count && duk_timer_before(&h[l], &h[min])) min = l;
+        if (r < duk->timer_count && duk_timer_before(&h[r], &h[min])) min = r;
+        if (min == i) return;
+        duk_esp32_timer_t t = h[i];
+        h[i] = h[min];
+        h[min] = t;
+        i = min;
+    }
+}
+
+// Caller made room with duk_timer_reserve()
+static void duk_timer_push(duk_esp32_t *duk, duk_esp32_timer_t t) {
+    duk_esp32_timer_t *h = duk->timers;
+    int i = duk->timer_count++;
+    while (i > 0 && duk_timer_before(&t, &h[(i - 1) / 2])) {
+        h[i] = h[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    h[i] = t;
+}
+
+static duk_esp32_timer_t duk_timer_pop(duk_esp32_t *duk) {
+    duk_esp32_timer_t t = duk->timers[0];
+    duk->timers[0] = duk->timers[--duk->timer_count];
+    duk_timer_sift_down(duk, 0);
+    return t;
+}
+
+// Room for one more timer. Slots of cleared timers are reclaimed first
+// when they are the majority, so set/clear churn does not grow the heap.
+static bool duk_timer_reserve(duk_esp32_t *duk) {
+    if (duk->timer_count < duk->timer_cap) return true;
+    
+    if (duk->timer_count > 2 * duk->timers_live) {
+        duk_context *ctx = duk->ctx;
+        duk_push_stash_prop(ctx, "timers");
+        int n = 0;
+        for (int i = 0; i < duk->timer_count; i++) {
+            if (duk_has_prop_index(ctx, -1, duk->timers[i].id)) duk->timers[n++] = duk->timers[i];
+        }
+        duk_pop(ctx);
+        duk->timer_count = n;
+        for (int i = n / 2 - 1; i >= 0; i--) duk_timer_sift_down(duk, i);
+        if (n < duk->timer_cap) return true;
+    }
+    
+    int cap = duk->timer_cap ? duk->timer_cap * 2 : 16;
+    duk_esp32_timer_t *timers = realloc(duk->timers, cap * sizeof(duk_esp32_timer_t));
+    if (!timers) return false;
+    duk->timers = timers;
+    duk->timer_cap = cap;
+    return true;
+}
+
+// Forget all timers (a new run starts, or the event loop ended)
+static void duk_timers_reset(duk_esp32_t *duk) {
+    duk->timer_count = 0;
+    duk->timers_live = 0;
+    duk_push_heap_stash(duk->ctx);
+    duk_push_object(duk->ctx);
+    duk_put_prop_string(duk->ctx, -2, "timers");
+    duk_pop(duk->ctx);
+}
+
+// setTimeout(fn, ms, ...args) / setInterval(fn, ms, ...args)
+static duk_ret_t duk_set_timer(duk_context *ctx, bool repeat) {
+    duk_esp32_t *duk = duk_esp32_from_ctx(ctx);
+    int nargs = duk_get_top(ctx);
+    duk_require_function(ctx, 0);
+    double ms = duk_get_number_default(ctx, 1, 0);
+    if (!(ms >= 0)) ms = 0;             // NaN as well
+    if (ms > 0x7FFFFFFF) ms = 0x7FFFFFFF;
+    if (!duk_timer_reserve(duk)) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "Too many timers");
+    }
+    
+    // [callback, args...] under the timer's id
+    duk_push_array(ctx);
+    for (int i = 0; i < nargs; i++) {
+        if (i == 1) continue;
+        duk_dup(ctx, i);
+        duk_put_prop_index(ctx, -2, i ? i - 1 : 0);
+    }
+    uint32_t id = ++duk->timer_next_id;
+    duk_push_stash_prop(ctx, "timers");
+    duk_dup(ctx, -2);
+    duk_put_prop_index(ctx, -2, id);
+    duk_pop_2(ctx);
+    
+    duk_esp32_timer_t t = {
+        .due = esp_timer_get_time() + (int64_t)(ms * 1000),
+        .id = id,
+        .interval_ms = repeat ? (ms < 1 ? 1 : (uint32_t)ms) : 0,
+    };
+    duk_timer_push(duk, t);
+    duk->timers_live++;
+    duk_push_uint(ctx, id);
+    return 1;
+}
+
+static duk_ret_t native_set_timeout(duk_context *ctx) {
+    return duk_set_timer(ctx, false);
+}
+
+static duk_ret_t native_set_interval(duk_context *ctx) {
+    return duk_set_timer(ctx, true);
+}
+
+// clearTimeout(id) / clearInterval(id); unknown ids are ignored
+static duk_ret_t native_clear_timer(duk_context *ctx) {
+    duk_esp32_t *duk = duk_esp32_from_ctx(ctx);
+    if (!duk_is_number(ctx, 0)) return 0;
+    duk_uarridx_t id = duk_get_uint(ctx, 0);
+    duk_push_stash_prop(ctx, "timers");
+    if (duk_has_prop_index(ctx, -1, id)) {
+        duk_del_prop_index(ctx, -1, id);
+        duk->timers_live--;
     }
     return 0;
 }
 
+// queueMicrotask(fn)
+static duk_ret_t native_queue_microtask(duk_context *ctx) {
+    duk_require_function(ctx, 0);
+    duk_push_stash_prop(ctx, "jobs");
+    duk_dup(ctx, 0);
+    duk_put_prop_index(ctx, -2, (duk_uarridx_t)duk_get_length(ctx, -2));
+    return 0;
+}
+
 // Setup global objects and functions
 static void duk_setup_globals(duk_context *ctx) {
     // Create console object
@@ -79,25 +445,104 @@ static void duk_setup_globals(duk_context *ctx) {
     
     duk_push_c_function(ctx, native_delay, 1);
     duk_put_global_string(ctx, "delay");
+    
+    // Timers and the microtask queue
+    duk_push_c_function(ctx, native_set_timeout, DUK_VARARGS);
+    duk_put_global_string(ctx, "setTimeout");
+    
+    duk_push_c_function(ctx, native_set_interval, DUK_VARARGS);
+    duk_put_global_string(ctx, "setInterval");
+    
+    duk_push_c_function(ctx, native_clear_timer, 1);
+    duk_put_global_string(ctx, "clearTimeout");
+    
+    duk_push_c_function(ctx, native_clear_timer, 1);
+    duk_put_global_string(ctx, "clearInterval");
+    
+    duk_push_c_function(ctx, native_queue_microtask, 1);
+    duk_put_global_string(ctx, "queueMicrotask");
+    
+    duk_push_heap_stash(ctx);
+    duk_push_object(ctx);
+    duk_put_prop_string(ctx, -2, "timers");
+    duk_push_array(ctx);
+    duk_put_prop_string(ctx, -2, "jobs");
+    duk_pop(ctx);
+    
+    if (duk_peval_string_noresult(ctx, duk_promise_js) != 0) {
+        ESP_LOGE(TAG, "Promise setup failed");
+    }
+}
+
+// ============ HEAP ============
+
+// Allocation functions: udata is the wrapper, so GC timing finds it too
+static void* duk_esp32_alloc(void *udata, duk_size_t size) {
+    duk_esp32_t *duk = (duk_esp32_t *)udata;
+    return duk->arena ? duk_arena_alloc(duk->arena, size) : malloc(size);
+}
+
+static void* duk_esp32_realloc(void *udata, void *ptr, duk_size_t size) {
+    duk_esp32_t *duk = (duk_esp32_t *)udata;
+    return duk->arena ? duk_arena_realloc(duk->arena, ptr, size) : realloc(ptr, size);
+}
+
+static void duk_esp32_free(void *udata, void *ptr) {
+    duk_esp32_t *duk = (duk_esp32_t *)udata;
+    if (duk->arena) {
+        duk_arena_free(duk->arena, ptr);
+    } else {
+        free(ptr);
+    }
+}
+
+// DUK_USE_MARK_AND_SWEEP_HOOK: called by duktape.c around each GC pass
+void duk_esp32_gc_hook(void *udata, duk_bool_t start) {
+    duk_esp32_t *duk = (duk_esp32_t *)udata;
+    if (!duk) return;
+    
+    int64_t now = esp_timer_get_time();
+    if (start) {
+        duk->gc_start = now;
+        return;
+    }
+    uint32_t us = (uint32_t)(now - duk->gc_start);
+    duk->gc.count++;
+    duk->gc.last_us = us;
+    duk->gc.total_us += us;
+    if (us > duk->gc.max_us) duk->gc.max_us = us;
 }
 
 duk_esp32_t* duk_esp32_init(void) {
+    return duk_esp32_init_arena(DUK_ESP32_ARENA_SIZE);
+}
+
+duk_esp32_t* duk_esp32_init_arena(size_t arena_size) {
     duk_esp32_t *duk = calloc(1, sizeof(duk_esp32_t));
     if (!duk) {
         ESP_LOGE(TAG, "Failed to allocate context wrapper");
         return NULL;
     }
     
+    // Heap in its own PSRAM arena, away from LVGL and internal SRAM
+    duk->arena = duk_arena_create(arena_size);
+    if (!duk->arena) {
+        ESP_LOGW(TAG, "No memory for a %u KB arena, using the system heap", (unsigned)(arena_size / 1024));
+    }
+    
     // Create Duktape heap
-    duk->ctx = duk_create_heap_default();
+    duk->ctx = duk_create_heap(duk_esp32_alloc, duk_esp32_realloc, duk_esp32_free, duk, NULL);
     if (!duk->ctx) {
         ESP_LOGE(TAG, "Failed to create Duktape heap");
+        if (duk->arena) duk_arena_destroy(duk->arena);
         free(duk);
         return NULL;
     }
     
     // Setup global objects
     duk_setup_globals(duk->ctx);
+    snprintf(duk->cache_dir, sizeof(duk->cache_dir), "%s", DUK_ESP32_CACHE_DIR);
+    duk->budget_ms = DUK_ESP32_BUDGET_MS;
     
     ESP_LOGI(TAG, "Duktape initialized");
     return duk;
@@ -106,27 +551,110 @@ duk_esp32_t* duk_esp32_init(void) {
 void duk_esp32_cleanup(duk_esp32_t *duk) {
     if (!duk) return;
     
+    // Interrupt any script and wait for the worker to exit
+    if (duk->worker) {
+        duk->quit = true;
+        duk->stop = true;
+        xTaskNotifyGive((TaskHandle_t)duk->worker);
+        while (__atomic_load_n(&duk->worker, __ATOMIC_ACQUIRE) != NULL) {
+            vTaskDelay(pdMS_TO_TICKS(5));
+        }
+    }
+    
     if (duk->ctx) {
         duk_destroy_heap(duk->ctx);
     }
+    
+    // Whatever the heap still held goes with the arena
+    if (duk->arena) {
+        duk_arena_stats_t st;
+        duk_arena_get_stats(duk->arena, &st);
+        ESP_LOGI(TAG, "Heap peak %u KB, %lu GCs, longest %lu us", (unsigned)(st.peak / 1024),
+                 (unsigned long)duk->gc.count, (unsigned long)duk->gc.max_us);
+        duk_arena_destroy(duk->arena);
+    }
+    free(duk->job_code);
+    free(duk->result);
+    free(duk->timers);
     free(duk);
-    g_console_cb = NULL;
     ESP_LOGI(TAG, "Duktape cleaned up");
 }
 
 void duk_esp32_set_console_callback(duk_esp32_t *duk, duk_console_callback_t cb) {
     if (duk) {
         duk->console_cb = cb;
-        g_console_cb = cb;
     }
 }
 
+void duk_esp32_set_budget(duk_esp32_t *duk, uint32_t budget_ms) {
+    if (duk) {
+        duk->budget_ms = budget_ms;
+    }
+}
+
+// Start the budget clock; duk_esp32_exec_timeout_check() enforces it
+static void duk_budget_arm(duk_esp32_t *duk) {
+    duk->deadline = duk->budget_ms ? esp_timer_get_time() + (int64_t)duk->budget_ms * 1000 : 0;
+}
+
+// A new run: timers left over from the last one are dropped
+static void duk_run_begin(duk_esp32_t *duk) {
+    duk->stop = false;
+    duk->end = DUK_ESP32_END_OK;
+    duk_timers_reset(duk);
+    duk_budget_arm(duk);
+}
+
+// Record how a run ended; a timeout RangeError gets a clearer message
+static void duk_run_end(duk_esp32_t *duk, bool ok) {
+    if (ok) {
+        duk->end = DUK_ESP32_END_OK;
+    } else if (duk->stop) {
+        duk->end = DUK_ESP32_END_STOPPED;
+        snprintf(duk->last_error, sizeof(duk->last_error), "Stopped");
+    } else if (duk->deadline && esp_timer_get_time() >= duk->deadline) {
+        duk->end = DUK_ESP32_END_BUDGET;
+        snprintf(duk->last_error, sizeof(duk->last_error), "CPU budget of %lu ms used up",
+                 (unsigned long)duk->budget_ms);
+    } else {
+        duk->end = DUK_ESP32_END_ERROR;
+    }
+    duk->deadline = 0;
+}
+
+// DUK_USE_EXEC_TIMEOUT_CHECK: polled by the executor every few hundred
+// thousand bytecode instructions
+duk_bool_t duk_esp32_exec_timeout_check(void *udata) {
+    duk_esp32_t *duk = (duk_esp32_t *)udata;
+    if (!duk) return 0;
+    if (duk->stop) return 1;
+    return duk->deadline && esp_timer_get_time() >= duk->deadline;
+}
+
+// The script returned (value on the stack top): run the microtasks it
+// queued, then the value as a string for the caller
+static char* duk_run_finish(duk_esp32_t *duk) {
+    bool ok = duk_drain_microtasks(duk);
+    duk_run_end(duk, ok);
+    
+    char *result = NULL;
+    if (ok && !duk_is_undefined(duk->ctx, -1)) {
+        const char *str = duk_safe_to_string(duk->ctx, -1);
+        if (str) {
+            result = strdup(str);
+        }
+    }
+    duk_pop(duk->ctx);
+    return result;
+}
+
 char* duk_esp32_eval(duk_esp32_t *duk, const char *code) {
     if (!duk || !duk->ctx || !code) {
         return NULL;
     }
     
     duk->last_error[0] = '\0';
+    duk_run_begin(duk);
     
     // Evaluate code with protected call
     duk_push_string(duk->ctx, code);
@@ -136,22 +664,420 @@ char* duk_esp32_eval(duk_esp32_t *duk, const char *code) {
         const char *err = duk_safe_to_string(duk->ctx, -1);
         snprintf(duk->last_error, sizeof(duk->last_error), "%s", err);
         duk_pop(duk->ctx);
+        duk_run_end(duk, false);
         return NULL;
     }
+    return duk_run_finish(duk);
+}
+
+// ============ BYTECODE CACHE ============
+
+// FNV-1a, 64 bit
+static uint64_t duk_cache_hash(uint64_t h, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    while (len--) {
+        h ^= *p++;
+        h *= 0x100000001B3ULL;
+    }
+    return h;
+}
+
+// Bytecode depends on the Duktape build, so the build is part of the key
+static uint64_t duk_cache_source_hash(const char *code, size_t len) {
+    uint64_t h = duk_cache_hash(0xCBF29CE484222325ULL, DUK_GIT_DESCRIBE, strlen(DUK_GIT_DESCRIBE));
+    return duk_cache_hash(h, code, len);
+}
+
+static void duk_cache_path(const duk_esp32_t *duk, uint64_t hash, char *path, size_t size) {
+    snprintf(path, size, "%s/%08lx%08lx.dbc", duk->cache_dir,
+             (unsigned long)(hash >> 32), (unsigned long)(hash & 0xFFFFFFFF));
+}
+
+// Push the cached function for this source; false if there is none.
+// The hashes catch truncation and stale builds, not tampering: the entry
+// is trusted because nothing remote can write to the cache directory.
+static bool duk_cache_load(duk_esp32_t *duk, uint64_t hash, size_t source_len) {
+    char path[96];
+    duk_cache_path(duk, hash, path, sizeof(path));
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
     
-    // Get result as string
-    char *result = NULL;
-    if (!duk_is_undefined(duk->ctx, -1)) {
-        const char *str = duk_safe_to_string(duk->ctx, -1);
-        if (str) {
-            result = strdup(str);
+    duk_cache_header_t hdr;
+    bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1 &&
+              hdr.magic == DUK_CACHE_MAGIC && hdr.duk_version == DUK_VERSION &&
+              hdr.source_len == source_len && hdr.source_hash == hash &&
+              hdr.bytecode_len > 0 && hdr.bytecode_len <= 4 * DUK_CACHE_MAX_SOURCE;
+    if (ok) {
+        void *buf = duk_push_fixed_buffer(duk->ctx, hdr.bytecode_len);
+        ok = fread(buf, 1, hdr.bytecode_len, f) == hdr.bytecode_len &&
+             duk_cache_hash(0xCBF29CE484222325ULL, buf, hdr.bytecode_len) == hdr.bytecode_hash;
+        if (ok) {
+            duk_load_function(duk->ctx);
+        } else {
+            duk_pop(duk->ctx);
         }
     }
+    fclose(f);
+    if (!ok) {
+        ESP_LOGW(TAG, "Dropping stale cache entry %s", path);
+        unlink(path);
+    }
+    return ok;
+}
+
+// Flush the whole cache once it holds DUK_ESP32_CACHE_MAX entries
+static void duk_cache_trim(duk_esp32_t *duk) {
+    DIR *dir = opendir(duk->cache_dir);
+    if (!dir) return;
+    int count = 0;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strstr(ent->d_name, ".dbc")) count++;
+    }
+    closedir(dir);
+    if (count >= DUK_ESP32_CACHE_MAX) duk_esp32_cache_clear(duk);
+}
+
+// Store the compiled function on the stack top (left in place)
+static void duk_cache_store(duk_esp32_t *duk, uint64_t hash, size_t source_len) {
+    mkdir(duk->cache_dir, 0755);
+    duk_cache_trim(duk);
+    
+    duk_dup_top(duk->ctx);
+    duk_dump_function(duk->ctx);
+    duk_size_t len = 0;
+    const void *buf = duk_get_buffer_data(duk->ctx, -1, &len);
+    
+    duk_cache_header_t hdr = {
+        .magic = DUK_CACHE_MAGIC,
+        .duk_version = DUK_VERSION,
+        .source_len = (uint32_t)source_len,
+        .bytecode_len = (uint32_t)len,
+        .source_hash = hash,
+        .bytecode_hash = duk_cache_hash(0xCBF29CE484222325ULL, buf, len),
+    };
     
+    // Written under a temporary name so a reader never sees half a file
+    char path[96], tmp[100];
+    duk_cache_path(duk, hash, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    bool ok = f && fwrite(&hdr, sizeof(hdr), 1, f) == 1 && fwrite(buf, 1, len, f) == len;
+    if (f) ok = (fclose(f) == 0) && ok;
+    if (ok) ok = rename(tmp, path) == 0;
+    if (!ok) {
+        unlink(tmp);
+        ESP_LOGW(TAG, "Could not write cache entry %s", path);
+    }
     duk_pop(duk->ctx);
+}
+
+// Leave the compiled program on the stack, from the cache if possible.
+// Returns false with last_error set if it does not compile.
+static bool duk_cache_get(duk_esp32_t *duk, const char *code, size_t len, const char *name) {
+    uint64_t hash = duk_cache_source_hash(code, len);
+    int64_t start = esp_timer_get_time();
+    
+    duk->cache.last_compile_us = 0;
+    duk->cache.last_load_us = 0;
+    duk->cache.last_cached = duk->cache_dir[0] && duk_cache_load(duk, hash, len);
+    if (duk->cache.last_cached) {
+        duk->cache.hits++;
+        duk->cache.last_load_us = (uint32_t)(esp_timer_get_time() - start);
+        return true;
+    }
+    
+    duk_push_lstring(duk->ctx, code, len);
+    duk_push_string(duk->ctx, name ? name : "input");
+    if (duk_pcompile(duk->ctx, DUK_COMPILE_EVAL) != 0) {
+        snprintf(duk->last_error, sizeof(duk->last_error), "%s", duk_safe_to_string(duk->ctx, -1));
+        duk_pop(duk->ctx);
+        return false;
+    }
+    duk->cache.last_compile_us = (uint32_t)(esp_timer_get_time() - start);
+    if (duk->cache_dir[0]) {
+        duk->cache.misses++;
+        duk_cache_store(duk, hash, len);
+    }
+    return true;
+}
+
+char* duk_esp32_eval_cached(duk_esp32_t *duk, const char *code, const char *name) {
+    if (!duk || !duk->ctx || !code) {
+        return NULL;
+    }
+    
+    duk->last_error[0] = '\0';
+    duk_run_begin(duk);
+    if (!duk_cache_get(duk, code, strlen(code), name)) {
+        duk_run_end(duk, false);
+        return NULL;
+    }
+    
+    int64_t start = esp_timer_get_time();
+    int rc = duk_pcall(duk->ctx, 0);
+    duk->cache.last_run_us = (uint32_t)(esp_timer_get_time() - start);
+    if (rc != 0) {
+        const char *err = duk_safe_to_string(duk->ctx, -1);
+        snprintf(duk->last_error, sizeof(duk->last_error), "%s", err);
+        duk_pop(duk->ctx);
+        duk_run_end(duk, false);
+        return NULL;
+    }
+    return duk_run_finish(duk);
+}
+
+// Whole file into a malloc'd, NUL-terminated buffer
+static char* duk_read_file(duk_esp32_t *duk, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        snprintf(duk->last_error, sizeof(duk->last_error), "Cannot open %s", path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < 0 || size > DUK_CACHE_MAX_SOURCE) {
+        snprintf(duk->last_error, sizeof(duk->last_error), "%s: too large", path);
+        fclose(f);
+        return NULL;
+    }
+    
+    char *code = malloc(size + 1);
+    if (code && fread(code, 1, size, f) != (size_t)size) {
+        free(code);
+        code = NULL;
+    }
+    fclose(f);
+    if (!code) {
+        snprintf(duk->last_error, sizeof(duk->last_error), "Cannot read %s", path);
+        return NULL;
+    }
+    code[size] = '\0';
+    return code;
+}
+
+char* duk_esp32_run_file(duk_esp32_t *duk, const char *path) {
+    if (!duk || !duk->ctx || !path) return NULL;
+    duk->last_error[0] = '\0';
+    char *code = duk_read_file(duk, path);
+    if (!code) return NULL;
+    
+    const char *name = strrchr(path, '/');
+    char *result = duk_esp32_eval_cached(duk, code, name ? name + 1 : path);
+    free(code);
     return result;
 }
 
+int duk_esp32_precompile(duk_esp32_t *duk, const char *path) {
+    if (!duk || !duk->ctx || !path) return -1;
+    duk->last_error[0] = '\0';
+    if (!duk->cache_dir[0]) {
+        snprintf(duk->last_error, sizeof(duk->last_error), "Cache disabled");
+        return -1;
+    }
+    char *code = duk_read_file(duk, path);
+    if (!code) return -1;
+    
+    const char *name = strrchr(path, '/');
+    bool ok = duk_cache_get(duk, code, strlen(code), name ? name + 1 : path);
+    if (ok) duk_pop(duk->ctx);
+    free(code);
+    return ok ? 0 : -1;
+}
+
+void duk_esp32_set_cache_dir(duk_esp32_t *duk, const char *dir) {
+    if (!duk) return;
+    // Only hidden directories are closed to the file server (see DUK_ESP32_CACHE_DIR)
+    const char *base = dir ? strrchr(dir, '/') : NULL;
+    if (dir && dir[0] && (!base || base[1] != '.')) {
+        ESP_LOGW(TAG, "Cache dir %s is not a hidden directory, caching off", dir);
+        dir = NULL;
+    }
+    snprintf(duk->cache_dir, sizeof(duk->cache_dir), "%s", dir ? dir : "");
+}
+
+void duk_esp32_cache_clear(duk_esp32_t *duk) {
+    if (!duk || !duk->cache_dir[0]) return;
+    DIR *dir = opendir(duk->cache_dir);
+    if (!dir) return;
+    char path[96];
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (!strstr(ent->d_name, ".dbc")) continue;
+        snprintf(path, sizeof(path), "%s/%s", duk->cache_dir, ent->d_name);
+        unlink(path);
+    }
+    closedir(dir);
+}
+
+// ============ WORKER ============
+
+// Run one due timer, then the microtasks it queued. An interval is put
+// back first, so the callback can clear it. False ends the event loop.
+static bool duk_timer_fire(duk_esp32_t *duk, const duk_esp32_timer_t *t) {
+    duk_context *ctx = duk->ctx;
+    duk_idx_t base = duk_get_top(ctx);
+    duk_push_stash_prop(ctx, "timers");
+    if (!duk_get_prop_index(ctx, base, t->id)) {
+        duk_set_top(ctx, base);
+        return true;        // Cleared
+    }
+    if (t->interval_ms) {
+        // Behind schedule (a long callback): skip the missed ticks
+        duk_esp32_timer_t next = *t;
+        int64_t now = esp_timer_get_time();
+        next.due += (int64_t)t->interval_ms * 1000;
+        if (next.due < now) next.due = now + (int64_t)t->interval_ms * 1000;
+        duk_timer_push(duk, next);
+    } else {
+        duk_del_prop_index(ctx, base, t->id);
+        duk->timers_live--;
+    }
+    
+    duk_idx_t entry = base + 1;
+    duk_uarridx_t n = (duk_uarridx_t)duk_get_length(ctx, entry);
+    for (duk_uarridx_t i = 0; i < n; i++) {
+        duk_get_prop_index(ctx, entry, i);
+    }
+    
+    // Each callback gets a budget of its own
+    duk_budget_arm(duk);
+    bool ok = true;
+    if (duk_pcall(ctx, (duk_idx_t)n - 1) != 0) ok = duk_report_uncaught(duk);
+    if (ok) ok = duk_drain_microtasks(duk);
+    if (ok) {
+        duk->deadline = 0;
+    } else {
+        duk_run_end(duk, false);
+    }
+    duk_set_top(ctx, base);
+    return ok;
+}
+
+// Event loop after a script that returned normally: sleep until the next
+// timer is due (or a stop), fire it, until no timers are left
+static void duk_run_timers(duk_esp32_t *duk) {
+    while (duk->end == DUK_ESP32_END_OK && duk->timers_live > 0 && !duk->stop && !duk->quit) {
+        int64_t wait = duk->timers[0].due - esp_timer_get_time();
+        if (wait > 0) {
+            uint32_t ms = (uint32_t)((wait + 999) / 1000);
+            ulTaskNotifyTake(pdTRUE, (ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS);
+            continue;
+        }
+        duk_esp32_timer_t t = duk_timer_pop(duk);
+        if (!duk_timer_fire(duk, &t)) break;
+    }
+    if (duk->stop && duk->end == DUK_ESP32_END_OK) {
+        duk->end = DUK_ESP32_END_STOPPED;
+        snprintf(duk->last_error, sizeof(duk->last_error), "Stopped");
+    }
+    duk_timers_reset(duk);
+}
+
+// Runs each started script; sleeps on its task notification in between
+static void duk_esp32_worker(void *arg) {
+    duk_esp32_t *duk = (duk_esp32_t *)arg;
+    
+    while (!duk->quit) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (duk->quit) break;
+        if (__atomic_load_n(&duk->state, __ATOMIC_ACQUIRE) != DUK_ESP32_RUNNING || !duk->job_code) {
+            continue;   // Leftover wakeup from duk_esp32_stop()
+        }
+        
+        duk->result = duk_esp32_eval_cached(duk, duk->job_code, duk->job_name);
+        free(duk->job_code);
+        duk->job_code = NULL;
+        duk_run_timers(duk);
+        __atomic_store_n(&duk->state, DUK_ESP32_DONE, __ATOMIC_RELEASE);
+    }
+    
+    __atomic_store_n(&duk->worker, NULL, __ATOMIC_RELEASE);
+    vTaskDelete(NULL);
+}
+
+int duk_esp32_start(duk_esp32_t *duk, const char *code, const char *name) {
+    if (!duk || !duk->ctx || !code) return -1;
+    if (duk_esp32_poll(duk) == DUK_ESP32_RUNNING) return -1;
+    
+    if (!duk->worker) {
+        TaskHandle_t task = NULL;
+        if (xTaskCreate(duk_esp32_worker, "js_worker", DUK_ESP32_WORKER_STACK, duk,
+                        DUK_ESP32_WORKER_PRIO, &task) != pdPASS) {
+            snprintf(duk->last_error, sizeof(duk->last_error), "Cannot start JS task");
+            return -1;
+        }
+        duk->worker = task;
+    }
+    
+    free(duk->result);
+    duk->result = NULL;
+    duk->job_code = strdup(code);
+    if (!duk->job_code) {
+        snprintf(duk->last_error, sizeof(duk->last_error), "Out of memory");
+        return -1;
+    }
+    snprintf(duk->job_name, sizeof(duk->job_name), "%s", name ? name : "input");
+    duk->last_error[0] = '\0';
+    duk->stop = false;
+    __atomic_store_n(&duk->state, DUK_ESP32_RUNNING, __ATOMIC_RELEASE);
+    xTaskNotifyGive((TaskHandle_t)duk->worker);
+    return 0;
+}
+
+int duk_esp32_start_file(duk_esp32_t *duk, const char *path) {
+    if (!duk || !duk->ctx || !path) return -1;
+    if (duk_esp32_poll(duk) == DUK_ESP32_RUNNING) return -1;
+    duk->last_error[0] = '\0';
+    char *code = duk_read_file(duk, path);
+    if (!code) return -1;
+    
+    const char *name = strrchr(path, '/');
+    int ret = duk_esp32_start(duk, code, name ? name + 1 : path);
+    free(code);
+    return ret;
+}
+
+void duk_esp32_stop(duk_esp32_t *duk) {
+    if (!duk) return;
+    duk->stop = true;
+    if (duk->worker && duk_esp32_poll(duk) == DUK_ESP32_RUNNING) {
+        xTaskNotifyGive((TaskHandle_t)duk->worker);
+    }
+}
+
+duk_esp32_state_t duk_esp32_poll(duk_esp32_t *duk) {
+    if (!duk) return DUK_ESP32_IDLE;
+    return (duk_esp32_state_t)__atomic_load_n(&duk->state, __ATOMIC_ACQUIRE);
+}
+
+char* duk_esp32_take_result(duk_esp32_t *duk) {
+    if (duk_esp32_poll(duk) != DUK_ESP32_DONE) return NULL;
+    char *result = duk->result;
+    duk->result = NULL;
+    __atomic_store_n(&duk->state, DUK_ESP32_IDLE, __ATOMIC_RELEASE);
+    return result;
+}
+
+size_t duk_esp32_read_output(duk_esp32_t *duk, char *buf, size_t size) {
+    if (!duk || !buf || size == 0) return 0;
+    uint32_t tail = duk->out_tail;
+    uint32_t head = __atomic_load_n(&duk->out_head, __ATOMIC_ACQUIRE);
+    size_t n = head - tail;
+    if (n > size - 1) n = size - 1;
+    for (size_t i = 0; i < n; i++) {
+        buf[i] = duk->out[(tail + i) & (DUK_ESP32_OUTPUT_SIZE - 1)];
+    }
+    buf[n] = '\0';
+    __atomic_store_n(&duk->out_tail, tail + (uint32_t)n, __ATOMIC_RELEASE);
+    return n;
+}
+
+int duk_esp32_pending_timers(duk_esp32_t *duk) {
+    return duk ? duk->timers_live : 0;
+}
+
 const char* duk_esp32_get_error(duk_esp32_t *duk) {
     if (!duk) return "No context";
     return duk->last_error[0] ? duk->last_error : NULL;
@@ -162,3 +1088,9 @@ void duk_esp32_gc(duk_esp32_t *duk) {
         duk_gc(duk->ctx, 0);
     }
 }
+
+bool duk_esp32_get_arena_stats(duk_esp32_t *duk, duk_arena_stats_t *stats) {
+    if (!duk || !duk->arena) return false;
+    duk_arena_get_stats(duk->arena, stats);
+    return true;
+}
@@ -7,7 +7,9 @@
 #define DUKTAPE_ESP32_H
 
 #include "duktape.h"
+#include "duk_arena.h"
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 #ifdef __cplusplus
@@ -17,32 +19,181 @@ extern "C" {
 // Console output callback type
 typedef void (*duk_console_callback_t)(const char *msg);
 
+// Every context's heap comes from its own arena in PSRAM
+#define DUK_ESP32_ARENA_SIZE    (2 * 1024 * 1024)
+
+typedef struct {
+    uint32_t count;             // Mark-and-sweep passes
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} duk_esp32_gc_stats_t;
+
+// Scripts started with duk_esp32_start() run on a worker task per context
+#define DUK_ESP32_WORKER_STACK  16384
+#define DUK_ESP32_WORKER_PRIO   3       // Below LVGL, so the UI stays responsive
+#define DUK_ESP32_BUDGET_MS     10000   // Default CPU time per run or timer callback (delay() on the worker excluded)
+#define DUK_ESP32_OUTPUT_SIZE   4096    // console output queued for the owner (power of 2)
+
+typedef enum {
+    DUK_ESP32_IDLE = 0,
+    DUK_ESP32_RUNNING,
+    DUK_ESP32_DONE,             // Finished; collect with duk_esp32_take_result()
+} duk_esp32_state_t;
+
+typedef enum {
+    DUK_ESP32_END_OK = 0,
+    DUK_ESP32_END_ERROR,        // Compile or runtime error
+    DUK_ESP32_END_STOPPED,      // duk_esp32_stop()
+    DUK_ESP32_END_BUDGET,       // Ran out of CPU budget
+} duk_esp32_end_t;
+
+// setTimeout()/setInterval() timer, kept in a min-heap on due. Callbacks
+// live in the heap stash by id; clearTimeout() only removes that entry
+// and the heap slot is dropped when it comes up.
+typedef struct {
+    int64_t due;                // esp_timer time
+    uint32_t id;
+    uint32_t interval_ms;       // 0: one-shot
+} duk_esp32_timer_t;
+
+// Compiled-script cache: bytecode files named by a hash of the source.
+// duk_load_function() trusts bytecode completely and the hashes only catch
+// corruption, so the directory must stay out of reach of anything remote:
+// the file server refuses dot-directories and BLE receive writes below
+// its own folder only. Never point it at a shared folder.
+#define DUK_ESP32_CACHE_DIR     "/littlefs/.jscache"
+#define DUK_ESP32_CACHE_MAX     32      // Entries kept before the cache is flushed
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    bool last_cached;           // Last run was loaded from the cache
+    uint32_t last_compile_us;   // Parse + compile of the last run (0 if cached)
+    uint32_t last_load_us;      // Reading and loading bytecode (0 if compiled)
+    uint32_t last_run_us;       // Execution of the last run
+} duk_esp32_cache_stats_t;
+
 // Duktape context wrapper
 typedef struct {
     duk_context *ctx;
     duk_console_callback_t console_cb;
     char last_error[512];
+    char cache_dir[64];         // Empty: caching off
+    duk_esp32_cache_stats_t cache;
+    duk_arena_t *arena;         // NULL: heap on the system allocator
+    duk_esp32_gc_stats_t gc;
+    int64_t gc_start;
+
+    // Execution budget and interruption (any run, worker or not)
+    uint32_t budget_ms;         // 0: unlimited
+    int64_t deadline;           // esp_timer time the budget runs out, 0 when idle
+    volatile bool stop;
+    duk_esp32_end_t end;        // How the last run ended
+
+    // Worker task
+    void *worker;               // TaskHandle_t, NULL until the first start
+    volatile bool quit;
+    volatile int state;         // duk_esp32_state_t
+    char *job_code;
+    char job_name[32];
+    char *result;
+
+    // Event loop: timers fire only on the worker, after the script returned
+    duk_esp32_timer_t *timers;
+    int timer_count;
+    int timer_cap;
+    int timers_live;            // Set and not cleared or fired
+    uint32_t timer_next_id;
+
+    // Console output while on the worker: single producer, single consumer
+    char out[DUK_ESP32_OUTPUT_SIZE];
+    uint32_t out_head;          // Written by the worker only
+    uint32_t out_tail;          // Written by the reader only
+    uint32_t out_dropped;
 } duk_esp32_t;
 
-// Initialize Duktape context
+// Initialize Duktape context (DUK_ESP32_ARENA_SIZE arena)
 duk_esp32_t* duk_esp32_init(void);
 
+// Initialize Duktape context with an arena of arena_size bytes; falls
+// back to the system heap if the arena cannot be allocated
+duk_esp32_t* duk_esp32_init_arena(size_t arena_size);
+
 // Cleanup Duktape context
 void duk_esp32_cleanup(duk_esp32_t *duk);
 
 // Set console.log callback
 void duk_esp32_set_console_callback(duk_esp32_t *duk, duk_console_callback_t cb);
 
+// CPU time allowed per run in ms, 0 for unlimited (default DUK_ESP32_BUDGET_MS)
+void duk_esp32_set_budget(duk_esp32_t *duk, uint32_t budget_ms);
+
 // Execute JavaScript code
 // Returns result as string (caller must free) or NULL on error
 char* duk_esp32_eval(duk_esp32_t *duk, const char *code);
 
+// Execute JavaScript code through the bytecode cache: the first run of a
+// given source compiles and stores it, later runs load the bytecode.
+// name is used in error messages. Same result contract as duk_esp32_eval.
+char* duk_esp32_eval_cached(duk_esp32_t *duk, const char *code, const char *name);
+
+// Run a script file (e.g. "/littlefs/scripts/clock.js") through the cache
+char* duk_esp32_run_file(duk_esp32_t *duk, const char *path);
+
+// Compile a script file into the cache without running it
+// Returns 0 on success (or if already cached), -1 on error (see get_error)
+int duk_esp32_precompile(duk_esp32_t *duk, const char *path);
+
+// Cache directory; NULL or "" turns caching off (default DUK_ESP32_CACHE_DIR)
+void duk_esp32_set_cache_dir(duk_esp32_t *duk, const char *dir);
+
+// Delete all cached bytecode
+void duk_esp32_cache_clear(duk_esp32_t *duk);
+
+// Run code through the cache on the context's worker task and return at
+// once; -1 if a run is still in progress. console output is queued for
+// duk_esp32_read_output() instead of going to the console callback.
+// The run goes on while setTimeout()/setInterval() timers are pending:
+// the worker sleeps until the next one is due, runs it (with a budget of
+// its own) and then the promise/microtask queue. Every run drains the
+// microtask queue; timers set by a run that is not on the worker never fire.
+int duk_esp32_start(duk_esp32_t *duk, const char *code, const char *name);
+
+// duk_esp32_start() for a script file, named like duk_esp32_run_file();
+// -1 if it cannot be read (see get_error) or a run is in progress
+int duk_esp32_start_file(duk_esp32_t *duk, const char *path);
+
+// Interrupt the running script (worker or not); it ends with END_STOPPED
+void duk_esp32_stop(duk_esp32_t *duk);
+
+// DUK_ESP32_IDLE, _RUNNING or _DONE
+duk_esp32_state_t duk_esp32_poll(duk_esp32_t *duk);
+
+// After DONE: the run's result (caller must free, NULL on error or
+// undefined; see end and get_error) and back to IDLE
+char* duk_esp32_take_result(duk_esp32_t *duk);
+
+// Move up to size - 1 bytes of queued console output into buf (NUL
+// terminated, lines end in '\n'); returns the length
+size_t duk_esp32_read_output(duk_esp32_t *duk, char *buf, size_t size);
+
+// Timers still pending (set and neither fired nor cleared)
+int duk_esp32_pending_timers(duk_esp32_t *duk);
+
+// The wrapper whose heap ctx belongs to, for native functions added by
+// the application (e.g. to honour stop and the budget while blocking)
+duk_esp32_t* duk_esp32_from_ctx(duk_context *ctx);
+
 // Get last error message
 const char* duk_esp32_get_error(duk_esp32_t *duk);
 
 // Run garbage collection
 void duk_esp32_gc(duk_esp32_t *duk);
 
+// Heap usage and fragmentation; false if the context has no arena
+bool duk_esp32_get_arena_stats(duk_esp32_t *duk, duk_arena_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,12 +6,16 @@
  */
 
 #include "bluetooth_transfer.h"
+#include "bt_session.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "system_settings.h"
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/stat.h>
 
 // Check if BT is enabled in config
@@ -32,6 +36,14 @@ static const char *TAG = "BT_TRANSFER";
 #include "services/gap/ble_svc_gap.h"
 #include "services/gatt/ble_svc_gatt.h"
 #include "esp_hosted.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "freertos/ringbuf.h"
 
 // BLE UUIDs for File Transfer Service
 #define FILE_TRANSFER_SERVICE_UUID      0x1234
@@ -53,13 +65,82 @@ static char bt_device_name[32] = "WinEsp32-PDA";
 static char bt_mac_str[18] = {0};
 static char bt_connected_device[32] = {0};
 
+// Link parameters requested on connect: largest ATT MTU, LE Data Length
+// Extension (251-byte link-layer packets) and the 2M PHY
+#define BT_DATA_LEN_OCTETS      251
+#define BT_DATA_LEN_TIME_US     2120
+#define BT_CONN_ITVL_MIN        6       // 7.5 ms (1.25 ms units)
+#define BT_CONN_ITVL_MAX        12      // 15 ms
+#define BT_SUPERVISION_TIMEOUT  400     // 4 s (10 ms units)
+
+// Control characteristic commands (first byte of a write)
+#define BT_CMD_CANCEL           0x00
+#define BT_CMD_RECEIVE          0x01    // 0x01 "filename|size": raw data writes
+#define BT_CMD_STREAM           0x02    // 0x02 [u32 window]: notify the pending send
+#define BT_CMD_ACK              0x03    // 0x03 u32 bytes received, opens the window
+#define BT_CMD_RECEIVE_FRAMED   0x04    // 0x04 "filename|size[|crc32]": framed, resumable
+#define BT_CMD_RECEIVE_SESSION  0x05    // 0x05 [folder]: framed bt_session stream
+
+// Send path: a pre-read task fills the ring from the file; data leaves
+// either as notifications from the stream task or through GATT reads
+#define BT_TX_RING_SIZE         (16 * 1024)
+#define BT_TX_READ_SIZE         4096
+#define BT_TX_MAX_IN_FLIGHT     8       // Notifications queued in the host
+#define BT_TX_READER_DONE       BIT0
+#define BT_TX_STREAM_DONE       BIT1
+
+// Receive path: data writes are copied into the ring in the host task and
+// put on flash by the writer task. Framed writes start with
+// {u32 offset, u32 crc32} (little endian) over the payload.
+#define BT_RX_RING_SIZE         (32 * 1024)     // Power of two
+#define BT_RX_WRITE_SIZE        4096            // Flash write unit and resume granularity
+#define BT_RX_COMMIT_BYTES      (64 * 1024)     // fsync interval
+#define BT_RX_FRAME_HEADER      8
+#define BT_ATT_ERR_CRC          0x80            // Application error: chunk CRC mismatch
+
 // Transfer state
 static bt_transfer_info_t current_transfer = {0};
 static bt_transfer_callback_t transfer_callback = NULL;
-static FILE *transfer_file = NULL;
-static uint8_t *transfer_buffer = NULL;
 static const size_t CHUNK_SIZE = 512;
 static char receive_save_dir[128] = "/littlefs/received";
+static int64_t transfer_start_us = 0;
+
+// Link state
+static uint16_t bt_mtu = BLE_ATT_MTU_DFLT;
+static bool bt_data_subscribed = false;
+
+// Send path state
+static RingbufHandle_t tx_ring = NULL;
+static SemaphoreHandle_t tx_lock = NULL;        // Serializes tx_finish()
+static SemaphoreHandle_t tx_credits = NULL;     // Free notification slots
+static EventGroupHandle_t tx_events = NULL;
+static TaskHandle_t tx_stream_task_handle = NULL;
+static volatile bool tx_stop = false;
+static volatile uint32_t tx_acked = 0;
+static uint32_t tx_window = 0;                  // 0 = link-level flow control only
+static volatile uint32_t tx_stream_len = 0;     // Bytes to send; UINT32_MAX until a session is encoded
+static bt_session_tx_t *tx_session = NULL;
+
+// Receive path state. rx_head is only advanced by the host task and
+// rx_tail only by the writer; both count bytes since rx_base.
+static uint8_t *rx_ring = NULL;
+static uint32_t rx_head = 0;
+static uint32_t rx_tail = 0;
+static uint32_t rx_base = 0;                    // File offset the session started at
+static uint32_t rx_next_offset = 0;             // Next file offset expected from the phone
+static char rx_path[200];
+static bool rx_framed = false;
+static bool rx_check_file_crc = false;
+static uint32_t rx_file_crc = 0;
+static bool rx_resync = false;
+static uint32_t rx_crc_errors = 0;
+static uint32_t rx_dropped = 0;
+static volatile bool rx_ready = false;          // Writer set up, accepting data
+static volatile bool rx_stop = false;
+static volatile bool rx_discard = false;
+static volatile bool rx_writer_running = false;
+static TaskHandle_t rx_writer_handle = NULL;
+static bt_session_rx_t *rx_session = NULL;
 
 // GATT attribute handles
 static uint16_t file_info_handle;
@@ -73,16 +154,627 @@ static void bt_on_sync(void);
 static int bt_gap_event(struct ble_gap_event *event, void *arg);
 static int gatt_svr_init(void);
 
+// ============ SEND PATH ============
+
+static void tx_update_rate(void)
+{
+    int64_t elapsed_us = esp_timer_get_time() - transfer_start_us;
+    if (elapsed_us > 0) {
+        current_transfer.throughput_kbs =
+            (uint32_t)((uint64_t)current_transfer.transferred * 1000000 / 1024 / elapsed_us);
+    }
+}
+
+static void tx_progress(size_t len)
+{
+    current_transfer.transferred += len;
+    if (tx_session) {
+        // transferred counts compressed stream bytes: go by the encoder
+        current_transfer.progress_percent = (tx_session->total_bytes > 0) ?
+            (uint8_t)(tx_session->raw_done * 100 / tx_session->total_bytes) : 100;
+    } else {
+        current_transfer.progress_percent = 
+            (current_transfer.file_size > 0) ?
+            (current_transfer.transferred * 100 / current_transfer.file_size) : 0;
+    }
+    tx_update_rate();
+    if (transfer_callback) transfer_callback(&current_transfer);
+}
+
+// End the send: stop both tasks, free the ring and report. Safe to call
+// from any task and more than once; a send task must have set its own
+// done bit before calling it.
+static void tx_finish(bt_transfer_status_t status)
+{
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    if (!tx_ring) {
+        xSemaphoreGive(tx_lock);
+        return;
+    }
+    
+    tx_stop = true;
+    EventBits_t bits = xEventGroupWaitBits(tx_events, BT_TX_READER_DONE | BT_TX_STREAM_DONE,
+                                           pdFALSE, pdTRUE, pdMS_TO_TICKS(500));
+    bool stopped = (bits & (BT_TX_READER_DONE | BT_TX_STREAM_DONE)) == (BT_TX_READER_DONE | BT_TX_STREAM_DONE);
+    if (stopped) {
+        vRingbufferDelete(tx_ring);
+    } else {
+        ESP_LOGE(TAG, "Send tasks did not stop, leaking ring buffer");
+    }
+    tx_ring = NULL;
+    tx_stream_task_handle = NULL;
+    
+    tx_update_rate();
+    current_transfer.status = status;
+    if (tx_session) {
+        ESP_LOGI(TAG, "Session: %d/%d files, %llu bytes in %llu (%lu blocks compressed, %lu stored)",
+                 tx_session->index, tx_session->count, (unsigned long long)tx_session->raw_done,
+                 (unsigned long long)tx_session->stream_bytes, (unsigned long)tx_session->blocks_compressed,
+                 (unsigned long)tx_session->blocks_stored);
+        if (stopped) {
+            bt_session_tx_free(tx_session);
+            free(tx_session);
+        }
+        tx_session = NULL;
+    }
+    ESP_LOGI(TAG, "Send %s: %s, %lu/%lu bytes, %lu KB/s (%u-byte chunks)",
+             status == BT_TRANSFER_COMPLETE ? "complete" : "ended",
+             current_transfer.filename, (unsigned long)current_transfer.transferred,
+             (unsigned long)current_transfer.file_size, (unsigned long)current_transfer.throughput_kbs,
+             current_transfer.chunk_size);
+    if (transfer_callback) transfer_callback(&current_transfer);
+    if (status != BT_TRANSFER_COMPLETE) transfer_callback = NULL;
+    xSemaphoreGive(tx_lock);
+}
+
+// Read-driven sends run out in the host's read callback, which must not
+// block: the producer task waits for the last read and finishes the send.
+// Returns false when streaming took over or the send was stopped.
+static bool tx_wait_read_done(void)
+{
+    while (!tx_stop && !tx_stream_task_handle && current_transfer.transferred < tx_stream_len) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    return !tx_stop && !tx_stream_task_handle;
+}
+
+// Pre-read the file into the ring so no file I/O happens in the BLE host
+static void tx_reader_task(void *param)
+{
+    FILE *f = (FILE *)param;
+    uint8_t *buf = (uint8_t *)malloc(BT_TX_READ_SIZE);
+    
+    if (buf) {
+        setvbuf(f, NULL, _IONBF, 0);
+        size_t n;
+        while (!tx_stop && (n = fread(buf, 1, BT_TX_READ_SIZE, f)) > 0) {
+            while (!tx_stop && xRingbufferSend(tx_ring, buf, n, pdMS_TO_TICKS(100)) != pdTRUE) {
+            }
+        }
+        free(buf);
+    } else {
+        ESP_LOGE(TAG, "Pre-read buffer allocation failed");
+    }
+    fclose(f);
+    
+    bool read_done = tx_wait_read_done();
+    xEventGroupSetBits(tx_events, BT_TX_READER_DONE);
+    if (read_done) tx_finish(BT_TRANSFER_COMPLETE);
+    vTaskDelete(NULL);
+}
+// Encode the queued files into the ring; the stream length is only
+// known once the last record is out
+static void tx_session_task(void *param)
+{
+    uint8_t *buf = (uint8_t *)malloc(BT_TX_READ_SIZE);
+    uint32_t produced = 0;
+    
+    if (buf) {
+        size_t n;
+        while (!tx_stop && (n = bt_session_tx_read(tx_session, buf, BT_TX_READ_SIZE)) > 0) {
+            while (!tx_stop && xRingbufferSend(tx_ring, buf, n, pdMS_TO_TICKS(100)) != pdTRUE) {
+            }
+            produced += n;
+            current_transfer.files_done = tx_session->index;
+            snprintf(current_transfer.filename, sizeof(current_transfer.filename), "%s",
+                     bt_session_tx_current(tx_session));
+        }
+        free(buf);
+    } else {
+        ESP_LOGE(TAG, "Pre-read buffer allocation failed");
+    }
+    
+    bool failed = !tx_stop && !bt_session_tx_done(tx_session);
+    bool read_done = false;
+    if (failed) {
+        ESP_LOGE(TAG, "Session encoding failed at %s: errno %d",
+                 bt_session_tx_current(tx_session), tx_session->error);
+    } else {
+        tx_stream_len = produced;
+        if (tx_stream_task_handle) xTaskNotifyGive(tx_stream_task_handle);
+        read_done = tx_wait_read_done();
+    }
+    
+    xEventGroupSetBits(tx_events, BT_TX_READER_DONE);
+    if (failed) tx_finish(BT_TRANSFER_ERROR);
+    else if (read_done) tx_finish(BT_TRANSFER_COMPLETE);
+    vTaskDelete(NULL);
+}
+
+// Notify chunks of (MTU - 3) bytes. At most BT_TX_MAX_IN_FLIGHT are queued
+// in the host at once, and with a window the phone's last BT_CMD_ACK must
+// be within tx_window bytes of what was sent.
+static void tx_stream_task(void *param)
+{
+    uint16_t conn = bt_conn_handle;
+    uint16_t chunk = current_transfer.chunk_size;
+    bool ok = true;
+    
+    while (!tx_stop && current_transfer.transferred < tx_stream_len) {
+        if (tx_window && current_transfer.transferred - tx_acked >= tx_window) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+            continue;
+        }
+        if (xSemaphoreTake(tx_credits, pdMS_TO_TICKS(100)) != pdTRUE) continue;
+        
+        size_t len = 0;
+        uint8_t *data = (uint8_t *)xRingbufferReceiveUpTo(tx_ring, &len, pdMS_TO_TICKS(100), chunk);
+        if (!data) {
+            xSemaphoreGive(tx_credits);
+            continue;
+        }
+        
+        // The host frees the mbuf even on failure, so keep the ring item
+        // until a copy of it was accepted
+        int rc;
+        do {
+            struct os_mbuf *om = ble_hs_mbuf_from_flat(data, len);
+            rc = om ? ble_gatts_notify_custom(conn, file_data_handle, om) : BLE_HS_ENOMEM;
+            if (rc == BLE_HS_ENOMEM) vTaskDelay(pdMS_TO_TICKS(5));
+        } while (rc == BLE_HS_ENOMEM && !tx_stop);
+        vRingbufferReturnItem(tx_ring, data);
+        
+        if (rc != 0) {
+            xSemaphoreGive(tx_credits);
+            if (!tx_stop) ESP_LOGE(TAG, "Notify failed: %d", rc);
+            ok = false;
+            break;
+        }
+        tx_progress(len);
+    }
+    
+    // Let the queued notifications drain before reporting completion
+    for (int i = 0; i < 100 && !tx_stop && uxSemaphoreGetCount(tx_credits) < BT_TX_MAX_IN_FLIGHT; i++) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    
+    xEventGroupSetBits(tx_events, BT_TX_STREAM_DONE);
+    if (ok && !tx_stop) tx_finish(BT_TRANSFER_COMPLETE);
+    vTaskDelete(NULL);
+}
+
+static int tx_stream_start(uint32_t window)
+{
+    if (current_transfer.status != BT_TRANSFER_SENDING || !tx_ring || tx_stream_task_handle) return -1;
+    if (!bt_data_subscribed) {
+        ESP_LOGW(TAG, "Stream requested without data notifications enabled");
+        return -2;
+    }
+    
+    tx_window = window;
+    tx_acked = 0;
+    current_transfer.chunk_size = bt_mtu - 3;
+    while (xSemaphoreTake(tx_credits, 0) == pdTRUE) {
+    }
+    for (int i = 0; i < BT_TX_MAX_IN_FLIGHT; i++) xSemaphoreGive(tx_credits);
+    
+    xEventGroupClearBits(tx_events, BT_TX_STREAM_DONE);
+    if (xTaskCreate(tx_stream_task, "bt_stream", 4096, NULL, 6, &tx_stream_task_handle) != pdPASS) {
+        xEventGroupSetBits(tx_events, BT_TX_STREAM_DONE);
+        tx_stream_task_handle = NULL;
+        return -3;
+    }
+    ESP_LOGI(TAG, "Streaming %s: MTU %u, window %lu", current_transfer.filename, bt_mtu, (unsigned long)window);
+    return 0;
+}
+
+// ============ RECEIVE PATH ============
+
+// Writes are copied straight from the host's mbufs into the ring; the
+// writer task puts them on flash in whole BT_RX_WRITE_SIZE blocks. The
+// .part file only grows in whole blocks from a block-aligned start, so
+// every write is aligned and a resume always restarts on a block edge.
+static void rx_notify_info(void)
+{
+    if (bt_conn_handle != BLE_HS_CONN_HANDLE_NONE) ble_gatts_chr_updated(file_info_handle);
+}
+
+// Write-without-response errors never reach the phone, so the first
+// rejected chunk of a run notifies the info value: its offset field is
+// where the phone has to continue from
+static void rx_request_resync(void)
+{
+    if (rx_resync) return;
+    rx_resync = true;
+    rx_notify_info();
+}
+
+// Report the result and release the ring; ends the calling writer task
+static void rx_exit(bt_transfer_status_t status)
+{
+    if (!rx_discard) current_transfer.status = status;
+    bt_transfer_callback_t callback = transfer_callback;
+    if (callback) callback(&current_transfer);
+    
+    heap_caps_free(rx_ring);
+    rx_ring = NULL;
+    rx_ready = false;
+    rx_writer_running = false;
+    rx_notify_info();
+    vTaskDelete(NULL);
+}
+
+static void rx_writer_task(void *param)
+{
+    char part[sizeof(rx_path) + 8];
+    snprintf(part, sizeof(part), "%s.part", rx_path);
+    
+    uint32_t written = rx_base;
+    uint32_t committed = rx_base;
+    uint32_t crc = 0;
+    bool ok = true;
+    
+    int fd = open(part, O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || ftruncate(fd, rx_base) != 0 || lseek(fd, rx_base, SEEK_SET) != (off_t)rx_base) {
+        ESP_LOGE(TAG, "Cannot open %s", part);
+        ok = false;
+    }
+    
+    // Resuming with a whole-file CRC: account for what is already on flash.
+    // The ring is still unused, so it serves as the read buffer.
+    if (ok && rx_check_file_crc && rx_base > 0) {
+        lseek(fd, 0, SEEK_SET);
+        for (uint32_t done = 0; ok && done < rx_base; ) {
+            uint32_t n = rx_base - done < BT_RX_RING_SIZE ? rx_base - done : BT_RX_RING_SIZE;
+            ok = read(fd, rx_ring, n) == (ssize_t)n;
+            crc = esp_rom_crc32_le(crc, rx_ring, n);
+            done += n;
+        }
+    }
+    rx_ready = ok;
+    rx_notify_info();
+    
+    while (ok && !rx_discard) {
+        uint32_t head = __atomic_load_n(&rx_head, __ATOMIC_ACQUIRE);
+        uint32_t avail = head - rx_tail;
+        bool last = rx_base + head >= current_transfer.file_size;
+    
+        // Whole blocks only, up to the ring end; a partial block is
+        // written once nothing more will come
+        uint32_t pos = rx_tail & (BT_RX_RING_SIZE - 1);
+        uint32_t n = avail & ~(uint32_t)(BT_RX_WRITE_SIZE - 1);
+        if (n == 0 && (last || rx_stop)) n = avail;
+        if (n > BT_RX_RING_SIZE - pos) n = BT_RX_RING_SIZE - pos;
+    
+        if (n == 0) {
+            if (last || rx_stop) break;
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+            continue;
+        }
+    
+        const uint8_t *p = rx_ring + pos;
+        for (uint32_t left = n; left > 0; ) {
+            ssize_t w = write(fd, p, left);
+            if (w <= 0) {
+                ESP_LOGE(TAG, "Write failed at %lu", (unsigned long)written);
+                ok = false;
+                break;
+            }
+            p += w;
+            left -= w;
+        }
+        if (!ok) break;
+        if (rx_check_file_crc) crc = esp_rom_crc32_le(crc, rx_ring + pos, n);
+        __atomic_store_n(&rx_tail, rx_tail + n, __ATOMIC_RELEASE);
+        written += n;
+    
+        if (written - committed >= BT_RX_COMMIT_BYTES) {
+            fsync(fd);
+            committed = written;
+        }
+    }
+    
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+    
+    bt_transfer_status_t status = BT_TRANSFER_IDLE;
+    if (rx_discard) {
+        unlink(part);
+    } else if (!ok) {
+        status = BT_TRANSFER_ERROR;     // .part kept: the phone may resume
+    } else if (written == current_transfer.file_size) {
+        if (rx_check_file_crc && crc != rx_file_crc) {
+            ESP_LOGE(TAG, "File CRC mismatch: %08lx != %08lx", (unsigned long)crc, (unsigned long)rx_file_crc);
+            unlink(part);
+            status = BT_TRANSFER_ERROR;
+        } else {
+            unlink(rx_path);    // FAT rename() does not replace
+            status = rename(part, rx_path) == 0 ? BT_TRANSFER_COMPLETE : BT_TRANSFER_ERROR;
+        }
+    }
+    
+    int64_t elapsed_us = esp_timer_get_time() - transfer_start_us;
+    uint32_t received = written - rx_base;
+    if (elapsed_us > 0) {
+        current_transfer.throughput_kbs = (uint32_t)((uint64_t)received * 1000000 / 1024 / elapsed_us);
+    }
+    ESP_LOGI(TAG, "Receive %s: %s, %lu/%lu bytes (resumed at %lu), %lu KB/s, %lu CRC errors, %lu dropped",
+             status == BT_TRANSFER_COMPLETE ? "complete" : "ended", current_transfer.filename,
+             (unsigned long)written, (unsigned long)current_transfer.file_size, (unsigned long)rx_base,
+             (unsigned long)current_transfer.throughput_kbs, (unsigned long)rx_crc_errors,
+             (unsigned long)rx_dropped);
+    
+    rx_exit(status);
+}
+// Session receive: the ring drains into the session decoder, which
+// writes the files itself in whole codec blocks
+static void rx_session_task(void *param)
+{
+    int rc = 0;
+    rx_ready = true;
+    rx_notify_info();
+    
+    while (rc == 0 && !rx_discard) {
+        uint32_t head = __atomic_load_n(&rx_head, __ATOMIC_ACQUIRE);
+        uint32_t pos = rx_tail & (BT_RX_RING_SIZE - 1);
+        uint32_t n = head - rx_tail;
+        if (n > BT_RX_RING_SIZE - pos) n = BT_RX_RING_SIZE - pos;
+        if (n == 0) {
+            if (rx_stop) break;
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+            continue;
+        }
+    
+        rc = bt_session_rx_feed(rx_session, rx_ring + pos, n);
+        __atomic_store_n(&rx_tail, rx_tail + n, __ATOMIC_RELEASE);
+        current_transfer.files_done = rx_session->files_done;
+        const char *name = bt_session_rx_current(rx_session);
+        if (name[0]) snprintf(current_transfer.filename, sizeof(current_transfer.filename), "%s", name);
+    }
+    if (rc != 1) bt_session_rx_abort(rx_session);
+    
+    bt_transfer_status_t status = BT_TRANSFER_IDLE;
+    if (rc == 1) {
+        status = BT_TRANSFER_COMPLETE;
+        current_transfer.files_total = rx_session->files_done;
+    } else if (rc < 0) {
+        status = BT_TRANSFER_ERROR;
+        ESP_LOGE(TAG, "Session stream failed at %llu: errno %d",
+                 (unsigned long long)rx_session->stream_bytes, rx_session->error);
+    }
+    
+    int64_t elapsed_us = esp_timer_get_time() - transfer_start_us;
+    if (elapsed_us > 0) {
+        current_transfer.throughput_kbs =
+            (uint32_t)((uint64_t)rx_session->raw_bytes * 1000000 / 1024 / elapsed_us);
+    }
+    ESP_LOGI(TAG, "Session receive %s: %u files, %llu bytes from %llu, %lu KB/s, %lu CRC errors, %lu dropped",
+             status == BT_TRANSFER_COMPLETE ? "complete" : "ended", rx_session->files_done,
+             (unsigned long long)rx_session->raw_bytes, (unsigned long long)rx_session->stream_bytes,
+             (unsigned long)current_transfer.throughput_kbs, (unsigned long)rx_crc_errors,
+             (unsigned long)rx_dropped);
+    
+    free(rx_session);
+    rx_session = NULL;
+    rx_exit(status);
+}
+
+// Stop taking data; the writer flushes what is queued and ends. With
+// discard the .part file is deleted, otherwise it is kept for a resume.
+static void rx_finish(bool discard)
+{
+    if (!rx_writer_running) return;
+    rx_ready = false;
+    rx_discard = discard;
+    rx_stop = true;
+    xTaskNotifyGive(rx_writer_handle);
+}
+
+// Allocate the ring, reset the receive state and start the writer task
+static int rx_begin(const char *name, uint32_t file_size, bool framed, TaskFunction_t writer)
+{
+    rx_ring = (uint8_t *)heap_caps_malloc(BT_RX_RING_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!rx_ring) rx_ring = (uint8_t *)heap_caps_malloc(BT_RX_RING_SIZE, MALLOC_CAP_8BIT);
+    if (!rx_ring) return -1;
+    
+    memset(&current_transfer, 0, sizeof(current_transfer));
+    snprintf(current_transfer.filename, sizeof(current_transfer.filename), "%s", name);
+    current_transfer.file_size = file_size;
+    current_transfer.transferred = rx_base;
+    current_transfer.status = BT_TRANSFER_RECEIVING;
+    current_transfer.direction = BT_DIR_RECEIVE;
+    current_transfer.chunk_size = bt_mtu - 3 - (framed ? BT_RX_FRAME_HEADER : 0);
+    transfer_start_us = esp_timer_get_time();
+    
+    rx_framed = framed;
+    rx_head = 0;
+    rx_tail = 0;
+    rx_next_offset = rx_base;
+    rx_crc_errors = 0;
+    rx_dropped = 0;
+    rx_resync = false;
+    rx_ready = false;
+    rx_stop = false;
+    rx_discard = false;
+    rx_writer_running = true;
+    if (xTaskCreate(writer, "bt_write", 4096, NULL, 5, &rx_writer_handle) != pdPASS) {
+        rx_writer_running = false;
+        heap_caps_free(rx_ring);
+        rx_ring = NULL;
+        current_transfer.status = BT_TRANSFER_ERROR;
+        return -1;
+    }
+    return 0;
+}
+
+// "filename|size[|crc32 hex]". Framed transfers resume from an existing
+// .part file; the next expected offset is reported in the info value.
+static int rx_start(char *args, bool framed)
+{
+    if (rx_writer_running) return -1;
+    
+    char *sep = strchr(args, '|');
+    if (!sep) return -2;
+    *sep = '\0';
+    
+    char *end = NULL;
+    unsigned long file_size = strtoul(sep + 1, &end, 10);
+    if (end == sep + 1 || (*end != '\0' && *end != '|')) return -2;
+    rx_check_file_crc = framed && *end == '|' && end[1] != '\0';
+    rx_file_crc = rx_check_file_crc ? strtoul(end + 1, NULL, 16) : 0;
+    
+    // Only a plain file name, no directories
+    const char *name = strrchr(args, '/');
+    name = name ? name + 1 : args;
+    if (name[0] == '\0' || strcmp(name, ".") == 0 || strcmp(name, "..") == 0) return -2;
+    
+    mkdir(receive_save_dir, 0755);
+    if (snprintf(rx_path, sizeof(rx_path), "%s/%s", receive_save_dir, name) >= (int)sizeof(rx_path)) return -2;
+    
+    rx_base = 0;
+    if (framed) {
+        char part[sizeof(rx_path) + 8];
+        struct stat st;
+        snprintf(part, sizeof(part), "%s.part", rx_path);
+        if (stat(part, &st) == 0 && (unsigned long)st.st_size <= file_size) {
+            rx_base = st.st_size & ~(uint32_t)(BT_RX_WRITE_SIZE - 1);
+        }
+    }
+    
+    if (rx_begin(name, file_size, framed, rx_writer_task) != 0) return -3;
+    
+    ESP_LOGI(TAG, "Receiving: %s (%lu bytes%s, from %lu)", name, file_size,
+             framed ? ", CRC framed" : "", (unsigned long)rx_base);
+    return 0;
+}
+
+// "[folder]": a bt_session stream into receive_save_dir/folder. Always
+// framed; an interrupted session is sent again from the start.
+static int rx_start_session(const char *folder)
+{
+    if (rx_writer_running) return -1;
+    if (folder[0] && (strstr(folder, "..") || strchr(folder, '/'))) return -2;
+    
+    char root[BT_SESSION_PATH_MAX];
+    mkdir(receive_save_dir, 0755);
+    if (snprintf(root, sizeof(root), "%s%s%s", receive_save_dir, folder[0] ? "/" : "", folder) >= (int)sizeof(root)) {
+        return -2;
+    }
+    mkdir(root, 0755);
+    
+    rx_session = (bt_session_rx_t *)malloc(sizeof(bt_session_rx_t));
+    if (!rx_session) return -3;
+    bt_session_rx_init(rx_session, root);
+    
+    rx_base = 0;
+    rx_check_file_crc = false;
+    if (rx_begin(folder[0] ? folder : "session", 0, true, rx_session_task) != 0) {
+        free(rx_session);
+        rx_session = NULL;
+        return -3;
+    }
+    ESP_LOGI(TAG, "Receiving session into %s", root);
+    return 0;
+}
+
+// One data write; runs in the host task, so it only copies into the ring
+static int rx_accept(struct os_mbuf *om)
+{
+    if (!rx_ready) return BLE_ATT_ERR_INSUFFICIENT_RES;     // Writer not set up yet
+    
+    uint16_t len = OS_MBUF_PKTLEN(om);
+    uint16_t hdr_len = 0;
+    uint32_t offset = rx_next_offset;
+    uint32_t crc = 0;
+    if (rx_framed) {
+        uint8_t hdr[BT_RX_FRAME_HEADER];
+        if (len <= BT_RX_FRAME_HEADER || os_mbuf_copydata(om, 0, BT_RX_FRAME_HEADER, hdr) != 0) {
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        offset = hdr[0] | (hdr[1] << 8) | (hdr[2] << 16) | ((uint32_t)hdr[3] << 24);
+        crc = hdr[4] | (hdr[5] << 8) | (hdr[6] << 16) | ((uint32_t)hdr[7] << 24);
+        hdr_len = BT_RX_FRAME_HEADER;
+    }
+    uint32_t n = len - hdr_len;
+    
+    // Anything but the next offset is dropped; the phone rewinds to the
+    // offset in the info value
+    if (offset != rx_next_offset) {
+        rx_dropped++;
+        rx_request_resync();
+        return BLE_ATT_ERR_INVALID_OFFSET;
+    }
+    if (!rx_session && n > current_transfer.file_size - rx_next_offset) return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    
+    uint32_t head = rx_head;
+    uint32_t tail = __atomic_load_n(&rx_tail, __ATOMIC_ACQUIRE);
+    if (BT_RX_RING_SIZE - (head - tail) < n) {
+        rx_dropped++;
+        rx_request_resync();
+        return BLE_ATT_ERR_INSUFFICIENT_RES;    // Writer behind: phone rewinds
+    }
+    
+    uint32_t pos = head & (BT_RX_RING_SIZE - 1);
+    uint32_t first = n < BT_RX_RING_SIZE - pos ? n : BT_RX_RING_SIZE - pos;
+    os_mbuf_copydata(om, hdr_len, first, rx_ring + pos);
+    if (n > first) os_mbuf_copydata(om, hdr_len + first, n - first, rx_ring);
+    
+    if (rx_framed) {
+        uint32_t actual = esp_rom_crc32_le(0, rx_ring + pos, first);
+        if (n > first) actual = esp_rom_crc32_le(actual, rx_ring, n - first);
+        if (actual != crc) {
+            rx_crc_errors++;
+            rx_request_resync();
+            return BT_ATT_ERR_CRC;
+        }
+    }
+    
+    __atomic_store_n(&rx_head, head + n, __ATOMIC_RELEASE);
+    rx_next_offset += n;
+    rx_resync = false;
+    xTaskNotifyGive(rx_writer_handle);
+    
+    current_transfer.transferred = rx_next_offset;
+    current_transfer.progress_percent = 
+        (current_transfer.file_size > 0) ?
+        ((uint64_t)current_transfer.transferred * 100 / current_transfer.file_size) : 0;
+    int64_t elapsed_us = esp_timer_get_time() - transfer_start_us;
+    if (elapsed_us > 0) {
+        current_transfer.throughput_kbs =
+            (uint32_t)((uint64_t)(rx_next_offset - rx_base) * 1000000 / 1024 / elapsed_us);
+    }
+    if (transfer_callback) transfer_callback(&current_transfer);
+    if (!rx_session && rx_next_offset >= current_transfer.file_size) rx_ready = false;
+    return 0;
+}
+
 // GATT callbacks
 static int file_info_access(uint16_t conn_handle, uint16_t attr_handle,
                             struct ble_gatt_access_ctxt *ctxt, void *arg)
 {
     if (ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
+        // "name|size|status|offset|files": offset is where a receive
+        // continues, files is non-zero for a bt_session stream
         char info[128];
-        snprintf(info, sizeof(info), "%s|%lu|%d",
+        snprintf(info, sizeof(info), "%s|%lu|%d|%lu|%u",
                  current_transfer.filename,
                  (unsigned long)current_transfer.file_size,
-                 current_transfer.status);
+                 current_transfer.status,
+                 (unsigned long)(current_transfer.direction == BT_DIR_RECEIVE ?
+                                 rx_next_offset : current_transfer.transferred),
+                 current_transfer.files_total);
         int rc = os_mbuf_append(ctxt->om, info, strlen(info));
         return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
     }
@@ -93,56 +785,27 @@ static int file_data_access(uint16_t conn_handle, uint16_t attr_handle,
                             struct ble_gatt_access_ctxt *ctxt, void *arg)
 {
     if (ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
-        if (current_transfer.status != BT_TRANSFER_SENDING || !transfer_file) {
+        // Read-driven send: hand out what the pre-read task has queued
+        if (current_transfer.status != BT_TRANSFER_SENDING || !tx_ring || tx_stream_task_handle) {
             return BLE_ATT_ERR_UNLIKELY;
         }
-        if (!transfer_buffer) {
-            transfer_buffer = (uint8_t *)malloc(CHUNK_SIZE);
-            if (!transfer_buffer) return BLE_ATT_ERR_INSUFFICIENT_RES;
-        }
-        size_t bytes_read = fread(transfer_buffer, 1, CHUNK_SIZE, transfer_file);
-        if (bytes_read > 0) {
-            current_transfer.transferred += bytes_read;
-            current_transfer.progress_percent = 
-                (current_transfer.file_size > 0) ?
-                (current_transfer.transferred * 100 / current_transfer.file_size) : 0;
-            if (transfer_callback) transfer_callback(&current_transfer);
-            int rc = os_mbuf_append(ctxt->om, transfer_buffer, bytes_read);
-            if (current_transfer.transferred >= current_transfer.file_size) {
-                current_transfer.status = BT_TRANSFER_COMPLETE;
-                fclose(transfer_file);
-                transfer_file = NULL;
-            }
-            return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
-        }
-        current_transfer.status = BT_TRANSFER_COMPLETE;
-        if (transfer_file) { fclose(transfer_file); transfer_file = NULL; }
-        return 0;
+        // One ATT read response: larger values would be fetched with read
+        // blob requests, each of which lands here again
+        current_transfer.chunk_size = (bt_mtu - 1 < (int)CHUNK_SIZE) ? bt_mtu - 1 : CHUNK_SIZE;
+        // Never wait in the host: the producer task ends the send
+        size_t len = 0;
+        uint8_t *data = (uint8_t *)xRingbufferReceiveUpTo(tx_ring, &len, 0, current_transfer.chunk_size);
+        if (!data) return 0;    // Not read yet: empty value, phone retries
+        int rc = os_mbuf_append(ctxt->om, data, len);
+        vRingbufferReturnItem(tx_ring, data);
+        tx_progress(len);
+        return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
     }
     else if (ctxt->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
-        if (current_transfer.status != BT_TRANSFER_RECEIVING || !transfer_file) {
+        if (current_transfer.status != BT_TRANSFER_RECEIVING || !rx_ring) {
             return BLE_ATT_ERR_UNLIKELY;
         }
-        uint16_t len = OS_MBUF_PKTLEN(ctxt->om);
-        if (len > 0) {
-            uint8_t *data = (uint8_t *)malloc(len);
-            if (!data) return BLE_ATT_ERR_INSUFFICIENT_RES;
-            uint16_t copied = 0;
-            ble_hs_mbuf_to_flat(ctxt->om, data, len, &copied);
-            size_t written = fwrite(data, 1, copied, transfer_file);
-            free(data);
-            current_transfer.transferred += written;
-            current_transfer.progress_percent = 
-                (current_transfer.file_size > 0) ?
-                (current_transfer.transferred * 100 / current_transfer.file_size) : 0;
-            if (transfer_callback) transfer_callback(&current_transfer);
-            if (current_transfer.transferred >= current_transfer.file_size) {
-                current_transfer.status = BT_TRANSFER_COMPLETE;
-                fclose(transfer_file);
-                transfer_file = NULL;
-            }
-        }
-        return 0;
+        return rx_accept(ctxt->om);
     }
     return BLE_ATT_ERR_UNLIKELY;
 }
@@ -156,49 +819,41 @@ static int file_control_access(uint16_t conn_handle, uint16_t attr_handle,
         return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
     }
     else if (ctxt->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+        // Commands are short: copy into a stack buffer, no allocation
+        uint8_t data[256];
         uint16_t len = OS_MBUF_PKTLEN(ctxt->om);
-        if (len >= 1) {
-            uint8_t *data = (uint8_t *)malloc(len);
-            if (!data) return BLE_ATT_ERR_INSUFFICIENT_RES;
-            uint16_t copied = 0;
-            ble_hs_mbuf_to_flat(ctxt->om, data, len, &copied);
-            
-            uint8_t cmd = data[0];
-            if (cmd == 0) {
-                // Cancel transfer
-                bt_cancel_transfer();
-            } else if (cmd == 1 && len > 1) {
-                // Start receive: cmd=1, then filename|size
-                // Format: 0x01 filename|size
-                char *info = (char *)(data + 1);
-                info[copied - 1] = '\0';
-                
-                char *sep = strchr(info, '|');
-                if (sep) {
-                    *sep = '\0';
-                    uint32_t file_size = atoi(sep + 1);
-                    
-                    // Create receive directory if needed
-                    mkdir(receive_save_dir, 0755);
-                    
-                    // Open file for writing
-                    char full_path[256];
-                    snprintf(full_path, sizeof(full_path), "%s/%s", receive_save_dir, info);
-                    
-                    if (transfer_file) fclose(transfer_file);
-                    transfer_file = fopen(full_path, "wb");
-                    
-                    if (transfer_file) {
-                        memset(&current_transfer, 0, sizeof(current_transfer));
-                        snprintf(current_transfer.filename, sizeof(current_transfer.filename), "%s", info);
-                        current_transfer.file_size = file_size;
-                        current_transfer.status = BT_TRANSFER_RECEIVING;
-                        current_transfer.direction = BT_DIR_RECEIVE;
-                        ESP_LOGI(TAG, "Receiving: %s (%lu bytes)", info, (unsigned long)file_size);
-                    }
-                }
-            }
-            free(data);
+        if (len < 1) return 0;
+        if (len >= sizeof(data)) return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        os_mbuf_copydata(ctxt->om, 0, len, data);
+        data[len] = '\0';
+        
+        uint8_t cmd = data[0];
+        if (cmd == BT_CMD_CANCEL) {
+            // Cancel transfer
+            bt_cancel_transfer();
+        } else if (cmd == BT_CMD_STREAM) {
+            uint32_t window = 0;
+            if (len >= 5) memcpy(&window, data + 1, sizeof(window));
+            if (tx_stream_start(window) != 0) return BLE_ATT_ERR_UNLIKELY;
+        } else if (cmd == BT_CMD_ACK && len >= 5) {
+            uint32_t acked;
+            memcpy(&acked, data + 1, sizeof(acked));
+            // Nothing past what was sent: the window math is unsigned
+            uint32_t sent = current_transfer.transferred;
+            tx_acked = acked < sent ? acked : sent;
+            if (tx_stream_task_handle) xTaskNotifyGive(tx_stream_task_handle);
+        } else if ((cmd == BT_CMD_RECEIVE || cmd == BT_CMD_RECEIVE_FRAMED) && len > 1) {
+            if (current_transfer.status == BT_TRANSFER_SENDING ||
+                current_transfer.status == BT_TRANSFER_RECEIVING) return BLE_ATT_ERR_UNLIKELY;
+            int rc = rx_start((char *)(data + 1), cmd == BT_CMD_RECEIVE_FRAMED);
+            if (rc == -2) return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+            if (rc != 0) return BLE_ATT_ERR_INSUFFICIENT_RES;
+        } else if (cmd == BT_CMD_RECEIVE_SESSION) {
+            if (current_transfer.status == BT_TRANSFER_SENDING ||
+                current_transfer.status == BT_TRANSFER_RECEIVING) return BLE_ATT_ERR_UNLIKELY;
+            int rc = rx_start_session((const char *)(data + 1));
+            if (rc == -2) return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+            if (rc != 0) return BLE_ATT_ERR_INSUFFICIENT_RES;
         }
         return 0;
     }
@@ -216,7 +871,8 @@ static struct ble_gatt_chr_def file_transfer_chars[] = {
     {
         .uuid = &file_data_uuid.u,
         .access_cb = file_data_access,
-        .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_NOTIFY,
+        .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP |
+                 BLE_GATT_CHR_F_NOTIFY,
         .val_handle = &file_data_handle,
     },
     {
@@ -238,6 +894,23 @@ static struct ble_gatt_svc_def gatt_svr_svcs[] = {
     { 0 } // Terminator
 };
 
+// Ask for the fastest link the phone accepts; each request may be
+// refused, the transfer then just runs at whatever was granted
+static void bt_request_fast_link(uint16_t conn)
+{
+    ble_gattc_exchange_mtu(conn, NULL, NULL);
+    ble_gap_set_data_len(conn, BT_DATA_LEN_OCTETS, BT_DATA_LEN_TIME_US);
+    ble_gap_set_prefered_le_phy(conn, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_CODED_ANY);
+    
+    struct ble_gap_upd_params params;
+    memset(&params, 0, sizeof(params));
+    params.itvl_min = BT_CONN_ITVL_MIN;
+    params.itvl_max = BT_CONN_ITVL_MAX;
+    params.latency = 0;
+    params.supervision_timeout = BT_SUPERVISION_TIMEOUT;
+    ble_gap_update_params(conn, &params);
+}
+
 static int bt_gap_event(struct ble_gap_event *event, void *arg)
 {
     struct ble_gap_conn_desc desc;
@@ -254,6 +927,7 @@ static int bt_gap_event(struct ble_gap_event *event, void *arg)
                              desc.peer_ota_addr.val[1], desc.peer_ota_addr.val[0]);
                 }
                 ESP_LOGI(TAG, "Connected: %s", bt_connected_device);
+                bt_request_fast_link(bt_conn_handle);
             } else {
                 bt_start_advertising();
             }
@@ -262,15 +936,37 @@ static int bt_gap_event(struct ble_gap_event *event, void *arg)
             ESP_LOGI(TAG, "Disconnected");
             bt_conn_handle = BLE_HS_CONN_HANDLE_NONE;
             bt_connected_device[0] = '\0';
-            if (current_transfer.status == BT_TRANSFER_SENDING ||
-                current_transfer.status == BT_TRANSFER_RECEIVING) {
+            bt_mtu = BLE_ATT_MTU_DFLT;
+            bt_data_subscribed = false;
+            // A half-received file stays as .part for the phone to resume
+            if (current_transfer.status == BT_TRANSFER_SENDING) {
                 bt_cancel_transfer();
+            } else if (current_transfer.status == BT_TRANSFER_RECEIVING) {
+                rx_finish(false);
             }
             bt_start_advertising();
             break;
         case BLE_GAP_EVENT_ADV_COMPLETE:
             bt_advertising = false;
             break;
+        case BLE_GAP_EVENT_MTU:
+            bt_mtu = event->mtu.value;
+            ESP_LOGI(TAG, "MTU %u", bt_mtu);
+            break;
+        case BLE_GAP_EVENT_PHY_UPDATE_COMPLETE:
+            ESP_LOGI(TAG, "PHY tx %d rx %d", event->phy_updated.tx_phy, event->phy_updated.rx_phy);
+            break;
+        case BLE_GAP_EVENT_SUBSCRIBE:
+            if (event->subscribe.attr_handle == file_data_handle) {
+                bt_data_subscribed = event->subscribe.cur_notify;
+            }
+            break;
+        case BLE_GAP_EVENT_NOTIFY_TX:
+            // One event per data notification once the host is done with it
+            if (!event->notify_tx.indication && event->notify_tx.attr_handle == file_data_handle) {
+                xSemaphoreGive(tx_credits);
+            }
+            break;
     }
     return 0;
 }
@@ -346,6 +1042,15 @@ int bt_init(void) {
         return -3;
     }
     
+    if (!tx_lock) tx_lock = xSemaphoreCreateMutex();
+    if (!tx_credits) tx_credits = xSemaphoreCreateCounting(BT_TX_MAX_IN_FLIGHT, BT_TX_MAX_IN_FLIGHT);
+    if (!tx_events) tx_events = xEventGroupCreate();
+    if (!tx_lock || !tx_credits || !tx_events) {
+        ESP_LOGE(TAG, "Failed to create transfer sync objects");
+        return -5;
+    }
+    ble_att_set_preferred_mtu(CONFIG_BT_NIMBLE_ATT_PREFERRED_MTU);
+    
     ble_hs_cfg.reset_cb = bt_on_reset;
     ble_hs_cfg.sync_cb = bt_on_sync;
     ble_hs_cfg.sm_bonding = 1;
@@ -444,11 +1149,19 @@ int bt_send_file(const char *path, bt_transfer_callback_t callback) {
     if (current_transfer.status == BT_TRANSFER_SENDING ||
         current_transfer.status == BT_TRANSFER_RECEIVING) return -3;
     
+    if (tx_ring) return -3;     // Previous send still shutting down
+    
     struct stat st;
     if (stat(path, &st) != 0) return -4;
     
-    transfer_file = fopen(path, "rb");
-    if (!transfer_file) return -5;
+    FILE *f = fopen(path, "rb");
+    if (!f) return -5;
+    
+    tx_ring = xRingbufferCreate(BT_TX_RING_SIZE, RINGBUF_TYPE_BYTEBUF);
+    if (!tx_ring) {
+        fclose(f);
+        return -6;
+    }
     
     const char *filename = strrchr(path, '/');
     filename = filename ? filename + 1 : path;
@@ -458,15 +1171,99 @@ int bt_send_file(const char *path, bt_transfer_callback_t callback) {
     current_transfer.file_size = st.st_size;
     current_transfer.status = BT_TRANSFER_SENDING;
     current_transfer.direction = BT_DIR_SEND;
+    current_transfer.chunk_size = CHUNK_SIZE;
     transfer_callback = callback;
+    transfer_start_us = esp_timer_get_time();
+    tx_stream_len = st.st_size;
+    
+    tx_stop = false;
+    tx_stream_task_handle = NULL;
+    xEventGroupClearBits(tx_events, BT_TX_READER_DONE);
+    xEventGroupSetBits(tx_events, BT_TX_STREAM_DONE);
+    if (xTaskCreate(tx_reader_task, "bt_read", 3072, f, 5, NULL) != pdPASS) {
+        fclose(f);
+        vRingbufferDelete(tx_ring);
+        tx_ring = NULL;
+        current_transfer.status = BT_TRANSFER_ERROR;
+        return -6;
+    }
+    
+    // Subscribed phones learn about the pending file without polling
+    ble_gatts_chr_updated(file_info_handle);
     
     ESP_LOGI(TAG, "Sending: %s (%lu bytes)", current_transfer.filename, (unsigned long)st.st_size);
     return 0;
 }
 
+int bt_send_files(const char *const *paths, int count, bt_transfer_callback_t callback) {
+    if (!bt_initialized) return -1;
+    if (bt_conn_handle == BLE_HS_CONN_HANDLE_NONE) return -2;
+    if (current_transfer.status == BT_TRANSFER_SENDING ||
+        current_transfer.status == BT_TRANSFER_RECEIVING) return -3;
+    
+    if (tx_ring) return -3;     // Previous send still shutting down
+    
+    bt_session_tx_t *session = (bt_session_tx_t *)malloc(sizeof(bt_session_tx_t));
+    if (!session) return -6;
+    bt_session_tx_init(session);
+    for (int i = 0; i < count; i++) {
+        if (bt_session_tx_add(session, paths[i]) < 0) {
+            ESP_LOGE(TAG, "Cannot queue %s", paths[i]);
+            bt_session_tx_free(session);
+            free(session);
+            return -4;
+        }
+    }
+    if (session->count == 0) {
+        bt_session_tx_free(session);
+        free(session);
+        return -4;
+    }
+    
+    tx_ring = xRingbufferCreate(BT_TX_RING_SIZE, RINGBUF_TYPE_BYTEBUF);
+    if (!tx_ring) {
+        bt_session_tx_free(session);
+        free(session);
+        return -6;
+    }
+    tx_session = session;
+    
+    memset(&current_transfer, 0, sizeof(current_transfer));
+    snprintf(current_transfer.filename, sizeof(current_transfer.filename), "%s",
+             session->entries[0].path + session->entries[0].name_ofs);
+    current_transfer.file_size = session->total_bytes > UINT32_MAX ? UINT32_MAX : (uint32_t)session->total_bytes;
+    current_transfer.status = BT_TRANSFER_SENDING;
+    current_transfer.direction = BT_DIR_SEND;
+    current_transfer.chunk_size = CHUNK_SIZE;
+    current_transfer.files_total = session->count;
+    transfer_callback = callback;
+    transfer_start_us = esp_timer_get_time();
+    tx_stream_len = UINT32_MAX;
+    
+    tx_stop = false;
+    tx_stream_task_handle = NULL;
+    xEventGroupClearBits(tx_events, BT_TX_READER_DONE);
+    xEventGroupSetBits(tx_events, BT_TX_STREAM_DONE);
+    if (xTaskCreate(tx_session_task, "bt_read", 4096, NULL, 5, NULL) != pdPASS) {
+        vRingbufferDelete(tx_ring);
+        tx_ring = NULL;
+        bt_session_tx_free(session);
+        free(session);
+        tx_session = NULL;
+        current_transfer.status = BT_TRANSFER_ERROR;
+        return -6;
+    }
+    
+    ble_gatts_chr_updated(file_info_handle);
+    
+    ESP_LOGI(TAG, "Sending session: %d files, %llu bytes", session->count,
+             (unsigned long long)session->total_bytes);
+    return 0;
+}
+
 int bt_cancel_transfer(void) {
-    if (transfer_file) { fclose(transfer_file); transfer_file = NULL; }
-    if (transfer_buffer) { free(transfer_buffer); transfer_buffer = NULL; }
+    if (tx_lock) tx_finish(BT_TRANSFER_IDLE);
+    rx_finish(true);
     current_transfer.status = BT_TRANSFER_IDLE;
     transfer_callback = NULL;
     return 0;
@@ -519,6 +1316,7 @@ int bt_stop_advertising(void) { return 0; }
 const char* bt_get_device_name(void) { return "BT Disabled"; }
 int bt_set_device_name(const char *name) { return -1; }
 int bt_send_file(const char *path, bt_transfer_callback_t callback) { return -1; }
+int bt_send_files(const char *const *paths, int count, bt_transfer_callback_t callback) { return -1; }
 int bt_receive_file(const char *save_dir, bt_transfer_callback_t callback) { return -1; }
 int bt_cancel_transfer(void) { return 0; }
 bt_transfer_info_t* bt_get_transfer_info(void) { 
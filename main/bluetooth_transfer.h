@@ -36,6 +36,10 @@ typedef struct {
     bt_transfer_status_t status;
     bt_transfer_dir_t direction;
     uint8_t progress_percent;
+    uint16_t chunk_size;        // Bytes per GATT read or notification
+    uint32_t throughput_kbs;    // KB/s since start (final once complete)
+    uint16_t files_total;       // Session transfers: files in the session (0 otherwise)
+    uint16_t files_done;
 } bt_transfer_info_t;
 
 // Callback for transfer progress
@@ -68,14 +72,42 @@ int bt_set_device_name(const char *name);
 
 // Send a file via Bluetooth
 // path: full path to file (e.g., "/littlefs/photos/photo_001.bmp")
-// callback: optional progress callback
+// callback: optional progress callback (called from BLE/transfer tasks)
 // Returns 0 on success, negative on error
+// The phone either reads the data characteristic repeatedly, or enables
+// its notifications and writes 0x02 [u32 window] to the control
+// characteristic to have the file streamed in MTU-sized notifications.
+// With a non-zero window it must write 0x03 <u32 bytes received> before
+// more than window bytes are outstanding.
 int bt_send_file(const char *path, bt_transfer_callback_t callback);
 
+// Send several files and/or folders (with their contents) in one session
+// paths: files or folders; a folder's files keep their path below it
+// Returns 0 on success, negative on error
+// The data is one bt_session stream (see bt_session.h), block-compressed
+// except for already-compressed formats, and leaves exactly like a
+// bt_send_file() transfer. The info value's last field holds the number
+// of files; filename is the file being encoded, file_size the total of
+// all files and transferred the stream bytes sent so far.
+int bt_send_files(const char *const *paths, int count, bt_transfer_callback_t callback);
+
 // Start receiving a file via Bluetooth
 // save_dir: directory to save received file (e.g., "/littlefs/received")
 // callback: optional progress callback
 // Returns 0 on success, negative on error
+// The phone starts a file by writing 0x04 "filename|size[|crc32 hex]" to
+// the control characteristic, then writes (preferably without response)
+// chunks of {u32 offset, u32 crc32, data} to the data characteristic;
+// offsets and CRC-32s are little endian, the CRC covers the chunk data.
+// Chunks not at the expected offset, failing their CRC or arriving while
+// the writer is behind are dropped, and the info characteristic
+// ("name|size|status|offset|files") is notified with the offset to continue
+// from. An interrupted file is kept as <name>.part and a later 0x04 for
+// the same name resumes at the last 4 KB boundary written; the optional
+// whole-file CRC is checked before the file is renamed into place.
+// 0x01 "filename|size" with raw data writes is still accepted.
+// 0x05 [folder] starts a session instead: the framed chunks carry a
+// bt_session stream whose files are saved below save_dir/folder.
 int bt_receive_file(const char *save_dir, bt_transfer_callback_t callback);
 
 // Cancel ongoing transfer
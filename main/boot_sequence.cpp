@@ -0,0 +1,255 @@
+/**
+ * Win32 OS - Boot Sequence Implementation
+ * Runs boot steps as a dependency graph across both cores and keeps a
+ * per-step start/end timeline that recovery mode can display
+ */
+
+#include "boot_sequence.h"
+#include "recovery_trigger.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include <string.h>
+#include <stdio.h>
+
+static const char *TAG = "BOOT";
+
+// NVS namespace and keys
+#define BOOT_NVS_NAMESPACE      "boot"
+#define BOOT_NVS_KEY_TIMELINE   "timeline"
+
+#define BOOT_TASK_PRIORITY      5
+#define BOOT_TASK_STACK_DEFAULT 4096
+#define BOOT_BAR_WIDTH          16
+
+// Event group layout: bits [0, MAX) = step finished, [MAX, 2*MAX) = step OK
+#define BOOT_OK_BIT(i)          BOOT_STEP_BIT((i) + BOOT_MAX_STEPS)
+
+static boot_timeline_t s_timeline = {};
+static bool s_lock_screen_marked = false;
+
+// State of the graph currently being run
+static const boot_step_t *s_steps = NULL;
+static int s_first_slot = 0;
+static EventGroupHandle_t s_events = NULL;
+static uint32_t s_ok_mask = 0;
+
+static void copy_name(char *dst, const char *src)
+{
+    strncpy(dst, src ? src : "?", BOOT_STEP_NAME_LEN - 1);
+    dst[BOOT_STEP_NAME_LEN - 1] = '\0';
+}
+
+// ============ GRAPH EXECUTION ============
+
+static void boot_step_task(void *arg)
+{
+    int i = (int)(intptr_t)arg;
+    const boot_step_t *step = &s_steps[i];
+    boot_timeline_entry_t *entry = &s_timeline.entries[s_first_slot + i];
+
+    uint32_t wait_bits = step->deps | step->after;
+    if (wait_bits) {
+        xEventGroupWaitBits(s_events, wait_bits, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+
+    uint32_t ok_bits = xEventGroupGetBits(s_events) >> BOOT_MAX_STEPS;
+    bool ok = false;
+
+    entry->core = (uint8_t)xPortGetCoreID();
+    entry->start_us = (uint32_t)esp_timer_get_time();
+
+    if ((ok_bits & step->deps) != step->deps) {
+        ESP_LOGW(TAG, "Skipping '%s' - dependency failed", step->name);
+        entry->state = BOOT_STEP_SKIPPED;
+    } else {
+        esp_err_t ret = step->fn();
+        ok = (ret == ESP_OK);
+        entry->state = ok ? BOOT_STEP_OK : BOOT_STEP_FAILED;
+        if (!ok) {
+            ESP_LOGW(TAG, "Step '%s' failed: %s", step->name, esp_err_to_name(ret));
+        }
+    }
+
+    entry->end_us = (uint32_t)esp_timer_get_time();
+    ESP_LOGI(TAG, "%-10s core %d  %6lu -> %6lu us", step->name, entry->core,
+             (unsigned long)entry->start_us, (unsigned long)entry->end_us);
+
+    // Done and OK bits are published together so dependents see a consistent state
+    xEventGroupSetBits(s_events, BOOT_STEP_BIT(i) | (ok ? BOOT_OK_BIT(i) : 0));
+    vTaskDelete(NULL);
+}
+
+esp_err_t boot_sequence_run(const boot_step_t *steps, int count, uint32_t skip_mask)
+{
+    if (!steps || count <= 0 || count > BOOT_MAX_STEPS ||
+        s_timeline.count + count > BOOT_TIMELINE_MAX) {
+        ESP_LOGE(TAG, "Invalid boot graph (%d steps)", count);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_events = xEventGroupCreate();
+    if (!s_events) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_steps = steps;
+    s_first_slot = s_timeline.count;
+    s_timeline.count += count;
+
+    int64_t t0 = esp_timer_get_time();
+    uint32_t all_bits = 0;
+
+    for (int i = 0; i < count; i++) {
+        boot_timeline_entry_t *entry = &s_timeline.entries[s_first_slot + i];
+        copy_name(entry->name, steps[i].name);
+        entry->state = BOOT_STEP_PENDING;
+        all_bits |= BOOT_STEP_BIT(i);
+    }
+
+    // Spawn every step up front; each one blocks until its inputs are ready
+    for (int i = 0; i < count; i++) {
+        boot_timeline_entry_t *entry = &s_timeline.entries[s_first_slot + i];
+
+        if (skip_mask & BOOT_STEP_BIT(i)) {
+            entry->start_us = entry->end_us = (uint32_t)esp_timer_get_time();
+            entry->state = BOOT_STEP_SKIPPED;
+            xEventGroupSetBits(s_events, BOOT_STEP_BIT(i));
+            continue;
+        }
+
+        uint32_t stack = steps[i].stack_size ? steps[i].stack_size : BOOT_TASK_STACK_DEFAULT;
+        char task_name[configMAX_TASK_NAME_LEN];
+        snprintf(task_name, sizeof(task_name), "boot_%s", steps[i].name);
+
+        if (xTaskCreatePinnedToCore(boot_step_task, task_name, stack, (void *)(intptr_t)i,
+                                    BOOT_TASK_PRIORITY, NULL, steps[i].core) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create task for '%s'", steps[i].name);
+            entry->start_us = entry->end_us = (uint32_t)esp_timer_get_time();
+            entry->state = BOOT_STEP_FAILED;
+            xEventGroupSetBits(s_events, BOOT_STEP_BIT(i));
+        }
+    }
+
+    EventBits_t bits = xEventGroupWaitBits(s_events, all_bits, pdFALSE, pdTRUE, portMAX_DELAY);
+    s_ok_mask = (uint32_t)(bits >> BOOT_MAX_STEPS) & all_bits;
+
+    vEventGroupDelete(s_events);
+    s_events = NULL;
+    s_steps = NULL;
+
+    ESP_LOGI(TAG, "Boot graph done in %lld ms", (esp_timer_get_time() - t0) / 1000);
+
+    return ((s_ok_mask | skip_mask) & all_bits) == all_bits ? ESP_OK : ESP_FAIL;
+}
+
+bool boot_sequence_step_ok(int index)
+{
+    if (index < 0 || index >= BOOT_MAX_STEPS) return false;
+    return (s_ok_mask & BOOT_STEP_BIT(index)) != 0;
+}
+
+// ============ TIMELINE ============
+
+void boot_timeline_record(const char *name, int64_t start_us, int64_t end_us, bool ok)
+{
+    if (s_timeline.count >= BOOT_TIMELINE_MAX) return;
+
+    boot_timeline_entry_t *entry = &s_timeline.entries[s_timeline.count++];
+    copy_name(entry->name, name);
+    entry->start_us = (uint32_t)start_us;
+    entry->end_us = (uint32_t)end_us;
+    entry->core = (uint8_t)xPortGetCoreID();
+    entry->state = ok ? BOOT_STEP_OK : BOOT_STEP_FAILED;
+}
+
+void boot_timeline_save(void)
+{
+    s_timeline.boot_count = recovery_get_boot_count();
+
+    nvs_handle_t handle;
+    if (nvs_open(BOOT_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGW(TAG, "Cannot open NVS to save boot timeline");
+        return;
+    }
+    nvs_set_blob(handle, BOOT_NVS_KEY_TIMELINE, &s_timeline, sizeof(s_timeline));
+    nvs_commit(handle);
+    nvs_close(handle);
+}
+
+void boot_timeline_mark_lock_screen(void)
+{
+    if (s_lock_screen_marked) return;
+    s_lock_screen_marked = true;
+
+    s_timeline.lock_screen_us = (uint32_t)esp_timer_get_time();
+    ESP_LOGI(TAG, "Time to lock screen: %lu ms", (unsigned long)(s_timeline.lock_screen_us / 1000));
+    boot_timeline_save();
+}
+
+int boot_timeline_load_last(boot_timeline_t *out)
+{
+    if (!out) return -1;
+
+    nvs_handle_t handle;
+    if (nvs_open(BOOT_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return -1;
+    }
+
+    size_t size = sizeof(*out);
+    esp_err_t err = nvs_get_blob(handle, BOOT_NVS_KEY_TIMELINE, out, &size);
+    nvs_close(handle);
+
+    if (err != ESP_OK || size != sizeof(*out) || out->count > BOOT_TIMELINE_MAX) {
+        return -1;
+    }
+    return 0;
+}
+
+int boot_timeline_format(const boot_timeline_t *tl, char *buf, size_t len)
+{
+    if (!tl || !buf || len == 0) return 0;
+
+    // Bar chart spans from app start to the lock screen (or the last step)
+    uint32_t span = tl->lock_screen_us;
+    for (int i = 0; i < tl->count; i++) {
+        if (tl->entries[i].end_us > span) span = tl->entries[i].end_us;
+    }
+    if (span == 0) span = 1;
+
+    static const char state_chr[] = {'?', ' ', '!', '-'};
+    int pos = snprintf(buf, len, "Boot #%lu timeline (ms):\n  step       c start   dur\n",
+                       (unsigned long)tl->boot_count);
+
+    for (int i = 0; i < tl->count && pos < (int)len; i++) {
+        const boot_timeline_entry_t *e = &tl->entries[i];
+        char bar[BOOT_BAR_WIDTH + 1];
+        int from = (int)((uint64_t)e->start_us * BOOT_BAR_WIDTH / span);
+        int to = (int)((uint64_t)e->end_us * BOOT_BAR_WIDTH / span);
+        for (int c = 0; c < BOOT_BAR_WIDTH; c++) {
+            bar[c] = (c >= from && (c < to || c == from)) ? '#' : '.';
+        }
+        bar[BOOT_BAR_WIDTH] = '\0';
+
+        pos += snprintf(buf + pos, len - pos, "%c %-10s %d %5lu %5lu %s\n",
+                        state_chr[e->state < 4 ? e->state : 0], e->name, e->core,
+                        (unsigned long)(e->start_us / 1000),
+                        (unsigned long)((e->end_us - e->start_us) / 1000), bar);
+    }
+
+    if (pos < (int)len) {
+        if (tl->lock_screen_us) {
+            pos += snprintf(buf + pos, len - pos, "Time to lock screen: %lu ms\n",
+                            (unsigned long)(tl->lock_screen_us / 1000));
+        } else {
+            pos += snprintf(buf + pos, len - pos, "Lock screen not reached\n");
+        }
+    }
+    if (pos < (int)len) {
+        pos += snprintf(buf + pos, len - pos, "(! = failed, - = skipped)\n");
+    }
+    return pos < (int)len ? pos : (int)len - 1;
+}
@@ -0,0 +1,112 @@
+/**
+ * Win32 OS - Boot Sequence
+ * Dependency-graph boot orchestrator with a persisted per-step timeline
+ *
+ * Each step declares which steps must succeed before it (deps) and which
+ * merely have to be finished (after, e.g. a shared bus). Independent steps
+ * run concurrently on their own short-lived tasks pinned to either core.
+ */
+
+#ifndef BOOT_SEQUENCE_H
+#define BOOT_SEQUENCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BOOT_MAX_STEPS          12      // Graph steps per boot_sequence_run()
+#define BOOT_TIMELINE_MAX       16      // Graph steps + manually recorded stages
+#define BOOT_STEP_NAME_LEN      12
+
+#define BOOT_STEP_BIT(i)        (1UL << (i))
+
+typedef esp_err_t (*boot_step_fn_t)(void);
+
+// Boot step definition
+typedef struct {
+    const char *name;           // Short name shown in the timeline
+    boot_step_fn_t fn;          // Step body, runs on its own task
+    uint32_t deps;              // Steps that must finish with ESP_OK first
+    uint32_t after;             // Steps that only need to have finished
+    int core;                   // 0, 1 or tskNO_AFFINITY
+    uint32_t stack_size;        // Task stack in bytes (0 = default)
+} boot_step_t;
+
+// Step result as recorded in the timeline
+typedef enum {
+    BOOT_STEP_PENDING = 0,
+    BOOT_STEP_OK,
+    BOOT_STEP_FAILED,
+    BOOT_STEP_SKIPPED           // Disabled by caller or a dependency failed
+} boot_step_state_t;
+
+// One timeline row (times are microseconds since app start)
+typedef struct {
+    char name[BOOT_STEP_NAME_LEN];
+    uint32_t start_us;
+    uint32_t end_us;
+    uint8_t core;
+    uint8_t state;              // boot_step_state_t
+} boot_timeline_entry_t;
+
+// Timeline of one boot, persisted to NVS
+typedef struct {
+    uint32_t boot_count;
+    uint32_t lock_screen_us;    // Time to lock screen (0 = not reached)
+    uint8_t count;
+    boot_timeline_entry_t entries[BOOT_TIMELINE_MAX];
+} boot_timeline_t;
+
+/**
+ * Run a boot graph and wait for every step to finish
+ * Steps whose deps failed (or which are in skip_mask) are recorded as skipped.
+ * @param steps Step table, indices are used by BOOT_STEP_BIT()
+ * @param count Number of steps (max BOOT_MAX_STEPS)
+ * @param skip_mask Steps not to run on this boot
+ * @return ESP_OK if all non-skipped steps succeeded, ESP_FAIL otherwise
+ */
+esp_err_t boot_sequence_run(const boot_step_t *steps, int count, uint32_t skip_mask);
+
+/**
+ * Check whether a step of the last boot_sequence_run() succeeded
+ * @param index Step index in the table passed to boot_sequence_run()
+ */
+bool boot_sequence_step_ok(int index);
+
+/**
+ * Record a stage that ran outside the graph (e.g. NVS init in app_main)
+ */
+void boot_timeline_record(const char *name, int64_t start_us, int64_t end_us, bool ok);
+
+/**
+ * Mark the lock screen as shown; first call per boot persists the timeline
+ */
+void boot_timeline_mark_lock_screen(void);
+
+/**
+ * Write the current timeline to NVS
+ */
+void boot_timeline_save(void);
+
+/**
+ * Load the timeline of the last normal boot from NVS
+ * @return 0 on success, -1 if none stored
+ */
+int boot_timeline_load_last(boot_timeline_t *out);
+
+/**
+ * Format a timeline as a text table with a per-step bar chart
+ * @return Number of characters written
+ */
+int boot_timeline_format(const boot_timeline_t *tl, char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_SEQUENCE_H
@@ -0,0 +1,194 @@
+/**
+ * Win32 OS - Bluetooth Transfer Codec Implementation
+ * A sequence is a token (literal count << 4 | match length - 4), the
+ * literals, a 16-bit little-endian match offset and the match; counts of
+ * 15 continue in following bytes of 255. The block ends with a
+ * literals-only sequence.
+ */
+
+#include "bt_codec.h"
+#include <string.h>
+#include <strings.h>
+
+#define MIN_MATCH       4
+#define MATCH_LIMIT     12      // No match starts in the last 12 bytes
+#define LAST_LITERALS   5       // ... or reaches into the last 5
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash32(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - BT_CODEC_HASH_BITS);
+}
+
+// Token nibble plus continuation bytes; false if out of room
+static bool put_length(uint8_t **op, const uint8_t *end, size_t len)
+{
+    len -= 15;
+    while (len >= 255) {
+        if (*op >= end) return false;
+        *(*op)++ = 255;
+        len -= 255;
+    }
+    if (*op >= end) return false;
+    *(*op)++ = (uint8_t)len;
+    return true;
+}
+
+static bool put_literals(uint8_t **op, const uint8_t *end, uint8_t *token, const uint8_t *lit, size_t len)
+{
+    *token = (uint8_t)((len < 15 ? len : 15) << 4);
+    if (len >= 15 && !put_length(op, end, len)) return false;
+    if ((size_t)(end - *op) < len) return false;
+    memcpy(*op, lit, len);
+    *op += len;
+    return true;
+}
+
+size_t bt_codec_compress(bt_codec_state_t *state, const uint8_t *src, size_t len,
+                         uint8_t *dst, size_t cap)
+{
+    if (len > BT_CODEC_BLOCK_SIZE || cap == 0) return 0;
+
+    const uint8_t *ip = src;
+    const uint8_t *anchor = src;
+    const uint8_t *end = src + len;
+    uint8_t *op = dst;
+    const uint8_t *op_end = dst + cap;
+
+    if (len > MATCH_LIMIT) {
+        memset(state->table, 0, sizeof(state->table));
+        const uint8_t *search_end = end - MATCH_LIMIT;
+        const uint8_t *match_end = end - LAST_LITERALS;
+        ip++;
+
+        while (ip < search_end) {
+            uint32_t seq = read32(ip);
+            uint32_t h = hash32(seq);
+            const uint8_t *ref = src + state->table[h];
+            state->table[h] = (uint16_t)(ip - src);
+            if (ref >= ip || read32(ref) != seq) {
+                ip++;
+                continue;
+            }
+
+            // Extend backwards over pending literals, then forwards
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const uint8_t *start = ip;
+            uint16_t offset = (uint16_t)(ip - ref);
+            ip += MIN_MATCH;
+            ref += MIN_MATCH;
+            while (ip < match_end && *ip == *ref) {
+                ip++;
+                ref++;
+            }
+
+            if (op >= op_end) return 0;
+            uint8_t *token = op++;
+            if (!put_literals(&op, op_end, token, anchor, start - anchor)) return 0;
+            if (op_end - op < 2) return 0;
+            *op++ = (uint8_t)offset;
+            *op++ = (uint8_t)(offset >> 8);
+            size_t match = ip - start - MIN_MATCH;
+            *token |= (uint8_t)(match < 15 ? match : 15);
+            if (match >= 15 && !put_length(&op, op_end, match)) return 0;
+            anchor = ip;
+
+            // Index a position inside the match so a repeat right after
+            // it is found too
+            if (ip - 2 > src) state->table[hash32(read32(ip - 2))] = (uint16_t)(ip - 2 - src);
+        }
+    }
+
+    if (op >= op_end) return 0;
+    uint8_t *token = op++;
+    if (!put_literals(&op, op_end, token, anchor, end - anchor)) return 0;
+    return op - dst;
+}
+
+// Token nibble plus continuation bytes; false if the input ends early
+static bool get_length(const uint8_t **ip, const uint8_t *end, size_t *len)
+{
+    if (*len != 15) return true;
+    uint8_t b;
+    do {
+        if (*ip >= end) return false;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+int bt_codec_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap)
+{
+    const uint8_t *ip = src;
+    const uint8_t *end = src + len;
+    uint8_t *op = dst;
+    uint8_t *op_end = dst + cap;
+
+    while (ip < end) {
+        uint8_t token = *ip++;
+
+        size_t lit = token >> 4;
+        if (!get_length(&ip, end, &lit)) return -1;
+        if ((size_t)(end - ip) < lit || (size_t)(op_end - op) < lit) return -1;
+        memcpy(op, ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == end) break;   // Literals-only final sequence
+
+        if (end - ip < 2) return -1;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) return -1;
+
+        size_t match = token & 0x0F;
+        if (!get_length(&ip, end, &match)) return -1;
+        match += MIN_MATCH;
+        if ((size_t)(op_end - op) < match) return -1;
+
+        // Byte by byte: the match may overlap its own output
+        const uint8_t *ref = op - offset;
+        while (match--) *op++ = *ref++;
+    }
+    return (int)(op - dst);
+}
+
+uint32_t bt_codec_crc32(uint32_t crc, const void *data, size_t len)
+{
+    static uint32_t table[256];
+    if (table[1] == 0) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+    }
+
+    const uint8_t *p = (const uint8_t *)data;
+    crc = ~crc;
+    while (len--) crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+bool bt_codec_is_compressed_name(const char *name)
+{
+    static const char *const exts[] = {
+        "jpg", "jpeg", "png", "gif", "webp", "mp3", "mp4", "m4a", "aac", "ogg",
+        "opus", "zip", "gz", "tgz", "7z", "rar", "bz2", "xz", "zst", "lz4", "apk",
+    };
+    const char *dot = strrchr(name, '.');
+    if (!dot || strchr(dot, '/')) return false;
+    for (size_t i = 0; i < sizeof(exts) / sizeof(exts[0]); i++) {
+        if (strcasecmp(dot + 1, exts[i]) == 0) return true;
+    }
+    return false;
+}
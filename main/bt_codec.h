@@ -0,0 +1,54 @@
+/**
+ * Win32 OS - Bluetooth Transfer Codec
+ * Block compressor for BLE transfers: LZ77 with a small hash table, in
+ * the LZ4 block format, one independent block of at most
+ * BT_CODEC_BLOCK_SIZE bytes at a time. Costs a 4 KB table and no heap;
+ * decoding needs no state at all.
+ *
+ * Plain C with no ESP-IDF dependencies, so it builds unchanged on a
+ * Linux host.
+ */
+
+#ifndef BT_CODEC_H
+#define BT_CODEC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BT_CODEC_BLOCK_SIZE     4096
+#define BT_CODEC_HASH_BITS      11
+
+typedef struct {
+    uint16_t table[1 << BT_CODEC_HASH_BITS];   // Last block offset per hash
+} bt_codec_state_t;
+
+/**
+ * Compress one block into dst. Returns the compressed length, or 0 if
+ * it would not fit in cap bytes: pass cap = len - 1 to only accept
+ * output that is smaller than the input.
+ */
+size_t bt_codec_compress(bt_codec_state_t *state, const uint8_t *src, size_t len,
+                         uint8_t *dst, size_t cap);
+
+/**
+ * Decompress one block. Returns the decompressed length, or -1 if the
+ * input is malformed or would overrun cap.
+ */
+int bt_codec_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+
+// CRC-32 (IEEE, as zlib): start with crc = 0
+uint32_t bt_codec_crc32(uint32_t crc, const void *data, size_t len);
+
+// True for formats that are compressed already (JPEG, PNG, MP3, ZIP, ...)
+bool bt_codec_is_compressed_name(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BT_CODEC_H
@@ -0,0 +1,489 @@
+/**
+ * Win32 OS - Bluetooth Transfer Sessions Implementation
+ * The sender builds one record at a time in tx->out and hands it out in
+ * whatever pieces the caller asks for. The receiver collects each record
+ * header, name and block payload into fixed buffers and acts on it once
+ * complete, so input can be split anywhere.
+ */
+
+#include "bt_session.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+enum {
+    TX_HELLO = 0,
+    TX_FILE,
+    TX_DATA,
+    TX_DONE,
+    TX_FAILED,
+};
+
+enum {
+    RX_TYPE = 0,
+    RX_FIELDS,
+    RX_NAME,
+    RX_DATA,
+    RX_DONE,
+    RX_FAILED,
+};
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// ============ SENDER ============
+
+void bt_session_tx_init(bt_session_tx_t *tx)
+{
+    memset(tx, 0, sizeof(*tx));
+    tx->fd = -1;
+}
+
+static bool tx_queue(bt_session_tx_t *tx, const char *path, uint16_t name_ofs, uint32_t size)
+{
+    if (tx->count >= BT_SESSION_MAX_FILES) return false;
+    if (strlen(path) - name_ofs >= BT_SESSION_NAME_MAX) return false;
+    if (tx->count == tx->capacity) {
+        int capacity = tx->capacity ? tx->capacity * 2 : 8;
+        bt_session_entry_t *entries =
+            (bt_session_entry_t *)realloc(tx->entries, capacity * sizeof(bt_session_entry_t));
+        if (!entries) return false;
+        tx->entries = entries;
+        tx->capacity = capacity;
+    }
+
+    bt_session_entry_t *e = &tx->entries[tx->count++];
+    snprintf(e->path, sizeof(e->path), "%s", path);
+    e->name_ofs = name_ofs;
+    e->size = size;
+    tx->total_bytes += size;
+    return true;
+}
+
+// path is a buffer of BT_SESSION_PATH_MAX holding the folder; entries
+// are appended to it in place while walking
+static int tx_add_dir(bt_session_tx_t *tx, char *path, uint16_t name_ofs, int depth)
+{
+    DIR *dir = opendir(path);
+    if (!dir) return -1;
+
+    size_t len = strlen(path);
+    int added = 0;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (ent->d_name[0] == '.') continue;    // ".", ".." and hidden files
+        size_t name_len = strlen(ent->d_name);
+        if (len + 1 + name_len >= BT_SESSION_PATH_MAX) continue;
+        path[len] = '/';
+        memcpy(path + len + 1, ent->d_name, name_len + 1);
+
+        struct stat st;
+        if (stat(path, &st) != 0) continue;
+        if (S_ISDIR(st.st_mode)) {
+            if (depth < BT_SESSION_MAX_DEPTH) {
+                int n = tx_add_dir(tx, path, name_ofs, depth + 1);
+                if (n < 0) added = -1;
+                else added += n;
+            }
+        } else if (S_ISREG(st.st_mode)) {
+            if (tx_queue(tx, path, name_ofs, (uint32_t)st.st_size)) added++;
+            else added = -1;
+        }
+        path[len] = '\0';
+        if (added < 0) break;
+    }
+    closedir(dir);
+    return added;
+}
+
+int bt_session_tx_add(bt_session_tx_t *tx, const char *path)
+{
+    char buf[BT_SESSION_PATH_MAX];
+    size_t len = strlen(path);
+    while (len > 1 && path[len - 1] == '/') len--;
+    if (len >= sizeof(buf)) return -1;
+    memcpy(buf, path, len);
+    buf[len] = '\0';
+
+    struct stat st;
+    if (stat(buf, &st) != 0) return -1;
+    const char *slash = strrchr(buf, '/');
+    uint16_t name_ofs = slash ? (uint16_t)(slash - buf + 1) : 0;
+    if (buf[name_ofs] == '\0') return -1;   // "/" itself
+
+    if (S_ISDIR(st.st_mode)) return tx_add_dir(tx, buf, name_ofs, 0);
+    return tx_queue(tx, buf, name_ofs, (uint32_t)st.st_size) ? 1 : -1;
+}
+
+static void tx_fail(bt_session_tx_t *tx, int error)
+{
+    if (tx->fd >= 0) close(tx->fd);
+    tx->fd = -1;
+    tx->error = error;
+    tx->state = TX_FAILED;
+}
+
+static bool tx_read_block(bt_session_tx_t *tx, size_t len)
+{
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = read(tx->fd, tx->raw + got, len - got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        got += n;
+    }
+    return true;
+}
+
+// Build the next record in tx->out; false once there is none
+static bool tx_next_record(bt_session_tx_t *tx)
+{
+    uint8_t *out = tx->out;
+
+    switch (tx->state) {
+        case TX_HELLO:
+            out[0] = BT_SESSION_REC_HELLO;
+            out[1] = BT_SESSION_VERSION;
+            tx->out_len = 2;
+            tx->state = TX_FILE;
+            return true;
+
+        case TX_FILE: {
+            if (tx->index >= tx->count) {
+                out[0] = BT_SESSION_REC_END;
+                put16(out + 1, (uint16_t)tx->count);
+                tx->out_len = 3;
+                tx->state = TX_DONE;
+                return true;
+            }
+            const bt_session_entry_t *e = &tx->entries[tx->index];
+            const char *name = e->path + e->name_ofs;
+            tx->fd = open(e->path, O_RDONLY);
+            if (tx->fd < 0) {
+                tx_fail(tx, errno);
+                return false;
+            }
+            tx->file_done = 0;
+            tx->crc = 0;
+            tx->compress = !bt_codec_is_compressed_name(name);
+            tx->file_blocks = 0;
+            tx->file_shrunk = 0;
+
+            size_t name_len = strlen(name);
+            out[0] = BT_SESSION_REC_FILE;
+            put32(out + 1, e->size);
+            out[5] = tx->compress ? BT_SESSION_F_COMPRESS : 0;
+            out[6] = (uint8_t)name_len;
+            memcpy(out + 7, name, name_len);
+            tx->out_len = 7 + name_len;
+            tx->state = TX_DATA;
+            return true;
+        }
+
+        case TX_DATA: {
+            const bt_session_entry_t *e = &tx->entries[tx->index];
+            if (tx->file_done >= e->size) {
+                close(tx->fd);
+                tx->fd = -1;
+                out[0] = BT_SESSION_REC_EOF;
+                put32(out + 1, tx->crc);
+                tx->out_len = 5;
+                tx->index++;
+                tx->state = TX_FILE;
+                return true;
+            }
+
+            size_t n = e->size - tx->file_done;
+            if (n > BT_CODEC_BLOCK_SIZE) n = BT_CODEC_BLOCK_SIZE;
+            if (!tx_read_block(tx, n)) {
+                tx_fail(tx, EIO);   // Shorter than when it was queued
+                return false;
+            }
+            tx->crc = bt_codec_crc32(tx->crc, tx->raw, n);
+            tx->file_done += n;
+            tx->raw_done += n;
+
+            size_t data_len = 0;
+            if (tx->compress) {
+                data_len = bt_codec_compress(&tx->codec, tx->raw, n, out + BT_SESSION_BLOCK_HEADER, n - 1);
+                if (tx->file_blocks < 255) tx->file_blocks++;
+                if (data_len && tx->file_shrunk < 255) tx->file_shrunk++;
+                // Data that does not shrink at the start of a file is
+                // unlikely to further on: stop spending CPU on it
+                if (tx->file_blocks >= BT_SESSION_PROBE_BLOCKS && tx->file_shrunk == 0) tx->compress = false;
+            }
+            if (data_len) {
+                tx->blocks_compressed++;
+            } else {
+                memcpy(out + BT_SESSION_BLOCK_HEADER, tx->raw, n);
+                data_len = n;
+                tx->blocks_stored++;
+            }
+            out[0] = BT_SESSION_REC_BLOCK;
+            put16(out + 1, (uint16_t)n);
+            put16(out + 3, (uint16_t)data_len);
+            tx->out_len = BT_SESSION_BLOCK_HEADER + data_len;
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+size_t bt_session_tx_read(bt_session_tx_t *tx, uint8_t *buf, size_t len)
+{
+    size_t done = 0;
+    while (done < len) {
+        if (tx->out_pos == tx->out_len) {
+            if (!tx_next_record(tx)) break;
+            tx->out_pos = 0;
+        }
+        size_t n = tx->out_len - tx->out_pos;
+        if (n > len - done) n = len - done;
+        memcpy(buf + done, tx->out + tx->out_pos, n);
+        tx->out_pos += n;
+        done += n;
+    }
+    tx->stream_bytes += done;
+    return done;
+}
+
+bool bt_session_tx_done(const bt_session_tx_t *tx)
+{
+    return tx->state == TX_DONE && tx->out_pos == tx->out_len;
+}
+
+const char *bt_session_tx_current(const bt_session_tx_t *tx)
+{
+    if (tx->index >= tx->count || tx->state == TX_HELLO) return "";
+    const bt_session_entry_t *e = &tx->entries[tx->index];
+    return e->path + e->name_ofs;
+}
+
+void bt_session_tx_free(bt_session_tx_t *tx)
+{
+    if (tx->fd >= 0) close(tx->fd);
+    tx->fd = -1;
+    free(tx->entries);
+    tx->entries = NULL;
+    tx->count = 0;
+    tx->capacity = 0;
+}
+
+// ============ RECEIVER ============
+
+void bt_session_rx_init(bt_session_rx_t *rx, const char *root)
+{
+    memset(rx, 0, sizeof(*rx));
+    snprintf(rx->root, sizeof(rx->root), "%s", root);
+    rx->fd = -1;
+    rx->state = RX_TYPE;
+    rx->dst = rx->hdr;
+    rx->need = 1;
+}
+
+static int rx_fail(bt_session_rx_t *rx, int error)
+{
+    bt_session_rx_abort(rx);
+    rx->error = error;
+    rx->state = RX_FAILED;
+    return -1;
+}
+
+static void rx_expect(bt_session_rx_t *rx, int state, uint8_t *dst, size_t need)
+{
+    rx->state = state;
+    rx->dst = dst;
+    rx->need = need;
+    rx->have = 0;
+}
+
+// Relative, no empty, "." or ".." components
+static bool rx_name_valid(const char *name)
+{
+    if (name[0] == '\0' || name[0] == '/') return false;
+    for (const char *p = name; *p; ) {
+        const char *end = strchr(p, '/');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len == 0 || (len == 1 && p[0] == '.') || (len == 2 && p[0] == '.' && p[1] == '.')) return false;
+        if (!end) break;
+        p = end + 1;
+        if (*p == '\0') return false;
+    }
+    return true;
+}
+
+static bool rx_open_file(bt_session_rx_t *rx, const char *name)
+{
+    if (!rx_name_valid(name)) return false;
+    int len = snprintf(rx->path, sizeof(rx->path) - 5, "%s/%s", rx->root, name);
+    if (len < 0 || len >= (int)sizeof(rx->path) - 5) return false;
+
+    // Subfolders of the name
+    for (char *p = rx->path + strlen(rx->root) + 1; (p = strchr(p, '/')) != NULL; p++) {
+        *p = '\0';
+        mkdir(rx->path, 0755);
+        *p = '/';
+    }
+
+    strcat(rx->path, ".part");
+    rx->fd = open(rx->path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    rx->path[len] = '\0';
+    return rx->fd >= 0;
+}
+
+static bool rx_write(bt_session_rx_t *rx, const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(rx->fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+// A record part is complete: act on it and say what comes next
+static int rx_complete(bt_session_rx_t *rx)
+{
+    uint8_t type = rx->hdr[0];
+
+    switch (rx->state) {
+        case RX_TYPE: {
+            static const uint8_t field_len[] = { 1, 6, 4, 4, 2 };
+            if (type > BT_SESSION_REC_END) return rx_fail(rx, EPROTO);
+            // HELLO first and only first
+            if ((rx->stream_bytes == 1) != (type == BT_SESSION_REC_HELLO)) return rx_fail(rx, EPROTO);
+            rx_expect(rx, RX_FIELDS, rx->hdr + 1, field_len[type]);
+            return 0;
+        }
+
+        case RX_FIELDS:
+            if (type == BT_SESSION_REC_HELLO) {
+                if (rx->hdr[1] != BT_SESSION_VERSION) return rx_fail(rx, EPROTONOSUPPORT);
+            } else if (type == BT_SESSION_REC_FILE) {
+                if (rx->fd >= 0 || rx->hdr[6] == 0) return rx_fail(rx, EPROTO);
+                rx->file_size = get32(rx->hdr + 1);
+                rx_expect(rx, RX_NAME, rx->hdr + 7, rx->hdr[6]);
+                return 0;
+            } else if (type == BT_SESSION_REC_BLOCK) {
+                rx->raw_len = get16(rx->hdr + 1);
+                rx->data_len = get16(rx->hdr + 3);
+                if (rx->fd < 0 || rx->raw_len == 0 || rx->raw_len > BT_CODEC_BLOCK_SIZE ||
+                    rx->data_len == 0 || rx->data_len > rx->raw_len ||
+                    rx->raw_len > rx->file_size - rx->file_done) {
+                    return rx_fail(rx, EPROTO);
+                }
+                rx_expect(rx, RX_DATA, rx->data, rx->data_len);
+                return 0;
+            } else if (type == BT_SESSION_REC_EOF) {
+                if (rx->fd < 0 || rx->file_done != rx->file_size) return rx_fail(rx, EPROTO);
+                if (get32(rx->hdr + 1) != rx->crc) return rx_fail(rx, EBADMSG);
+                bool ok = fsync(rx->fd) == 0;
+                ok = close(rx->fd) == 0 && ok;
+                rx->fd = -1;
+
+                char part[sizeof(rx->path) + 5];
+                snprintf(part, sizeof(part), "%s.part", rx->path);
+                unlink(rx->path);   // FAT rename() does not replace
+                if (!ok || rename(part, rx->path) != 0) {
+                    unlink(part);
+                    return rx_fail(rx, EIO);
+                }
+                rx->files_done++;
+            } else {
+                if (rx->fd >= 0 || get16(rx->hdr + 1) != rx->files_done) return rx_fail(rx, EPROTO);
+                rx->state = RX_DONE;
+                return 1;
+            }
+            break;
+
+        case RX_NAME:
+            rx->hdr[7 + rx->hdr[6]] = '\0';
+            if (!rx_open_file(rx, (const char *)rx->hdr + 7)) return rx_fail(rx, EACCES);
+            rx->file_done = 0;
+            rx->crc = 0;
+            break;
+
+        case RX_DATA: {
+            const uint8_t *raw = rx->data;
+            if (rx->data_len < rx->raw_len) {
+                int n = bt_codec_decompress(rx->data, rx->data_len, rx->raw, sizeof(rx->raw));
+                if (n != rx->raw_len) return rx_fail(rx, EBADMSG);
+                raw = rx->raw;
+            }
+            if (!rx_write(rx, raw, rx->raw_len)) return rx_fail(rx, EIO);
+            rx->crc = bt_codec_crc32(rx->crc, raw, rx->raw_len);
+            rx->file_done += rx->raw_len;
+            rx->raw_bytes += rx->raw_len;
+            break;
+        }
+    }
+
+    rx_expect(rx, RX_TYPE, rx->hdr, 1);
+    return 0;
+}
+
+int bt_session_rx_feed(bt_session_rx_t *rx, const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        if (rx->state == RX_DONE) return 1;     // Trailing bytes are ignored
+        if (rx->state == RX_FAILED) return -1;
+
+        size_t n = rx->need - rx->have;
+        if (n > len) n = len;
+        memcpy(rx->dst + rx->have, data, n);
+        rx->have += n;
+        rx->stream_bytes += n;
+        data += n;
+        len -= n;
+
+        if (rx->have == rx->need) {
+            int rc = rx_complete(rx);
+            if (rc != 0) return rc;
+        }
+    }
+    return rx->state == RX_DONE ? 1 : (rx->state == RX_FAILED ? -1 : 0);
+}
+
+const char *bt_session_rx_current(const bt_session_rx_t *rx)
+{
+    if (rx->fd < 0) return "";
+    return rx->path + strlen(rx->root) + 1;
+}
+
+void bt_session_rx_abort(bt_session_rx_t *rx)
+{
+    if (rx->fd < 0) return;
+    close(rx->fd);
+    rx->fd = -1;
+
+    char part[sizeof(rx->path) + 5];
+    snprintf(part, sizeof(part), "%s.part", rx->path);
+    unlink(part);
+}
@@ -0,0 +1,157 @@
+/**
+ * Win32 OS - Bluetooth Transfer Sessions
+ * One BLE transfer carrying several files or whole folders as a single
+ * byte stream, compressed block by block with bt_codec. The sender turns
+ * its file queue into the stream with bt_session_tx_read(); the receiver
+ * passes stream bytes, split up any way, to bt_session_rx_feed().
+ *
+ * Stream records (little endian):
+ *   HELLO  0x00, u8 version
+ *   FILE   0x01, u32 size, u8 flags, u8 name_len, name
+ *   BLOCK  0x02, u16 raw_len, u16 data_len, data   (stored if data_len == raw_len)
+ *   EOF    0x03, u32 CRC-32 of the file
+ *   END    0x04, u16 file count
+ * Names are relative ("Photos/img_001.bmp"); one FILE, its BLOCKs and
+ * its EOF follow each other, then the next FILE or END.
+ *
+ * POSIX file I/O only, no ESP-IDF APIs: sender and receiver build
+ * unchanged on a Linux host and can be run against each other there.
+ */
+
+#ifndef BT_SESSION_H
+#define BT_SESSION_H
+
+#include "bt_codec.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BT_SESSION_VERSION      1
+#define BT_SESSION_PATH_MAX     160
+#define BT_SESSION_NAME_MAX     128
+#define BT_SESSION_MAX_FILES    256
+#define BT_SESSION_MAX_DEPTH    4       // Folder levels below a queued folder
+#define BT_SESSION_PROBE_BLOCKS 2       // Blocks tried before giving up on compressing a file
+
+#define BT_SESSION_REC_HELLO    0x00
+#define BT_SESSION_REC_FILE     0x01
+#define BT_SESSION_REC_BLOCK    0x02
+#define BT_SESSION_REC_EOF      0x03
+#define BT_SESSION_REC_END      0x04
+
+#define BT_SESSION_F_COMPRESS   0x01    // FILE flag: blocks may be compressed
+
+#define BT_SESSION_BLOCK_HEADER 5
+#define BT_SESSION_RECORD_MAX   (BT_SESSION_BLOCK_HEADER + BT_CODEC_BLOCK_SIZE)
+
+typedef struct {
+    char path[BT_SESSION_PATH_MAX];
+    uint16_t name_ofs;              // path + name_ofs is the name sent
+    uint32_t size;
+} bt_session_entry_t;
+
+// Sender: the queue and the encoder position in it
+typedef struct {
+    bt_session_entry_t *entries;
+    int count;
+    int capacity;
+    uint64_t total_bytes;           // Sum of the queued file sizes
+
+    int state;
+    int index;                      // File being encoded
+    int fd;
+    uint32_t file_done;
+    uint32_t crc;
+    bool compress;
+    uint8_t file_blocks;            // Blocks of this file so far, saturating
+    uint8_t file_shrunk;
+    int error;                      // errno value once the stream failed
+
+    // Statistics
+    uint64_t raw_done;              // File bytes encoded
+    uint64_t stream_bytes;          // Stream bytes handed out
+    uint32_t blocks_compressed;
+    uint32_t blocks_stored;
+
+    bt_codec_state_t codec;
+    uint8_t raw[BT_CODEC_BLOCK_SIZE];
+    uint8_t out[BT_SESSION_RECORD_MAX];
+    size_t out_len;
+    size_t out_pos;
+} bt_session_tx_t;
+
+// Receiver: parser state and the file being written
+typedef struct {
+    char root[BT_SESSION_PATH_MAX]; // Directory the names are relative to
+    int state;
+    int error;                      // errno value once the stream failed
+
+    uint8_t *dst;                   // Where the bytes being collected go
+    size_t need;
+    size_t have;
+    uint8_t hdr[8 + 255];
+
+    int fd;
+    char path[BT_SESSION_PATH_MAX + BT_SESSION_NAME_MAX];
+    uint32_t file_size;
+    uint32_t file_done;
+    uint32_t crc;
+    uint16_t raw_len;
+    uint16_t data_len;
+
+    // Statistics
+    uint16_t files_done;
+    uint64_t raw_bytes;             // File bytes written
+    uint64_t stream_bytes;          // Stream bytes consumed
+
+    uint8_t data[BT_CODEC_BLOCK_SIZE];
+    uint8_t raw[BT_CODEC_BLOCK_SIZE];
+} bt_session_rx_t;
+
+void bt_session_tx_init(bt_session_tx_t *tx);
+
+/**
+ * Queue a file, or a folder with everything below it (names then start
+ * with the folder's own name). Returns the number of files queued, or -1
+ * if the path does not exist or the queue is full.
+ */
+int bt_session_tx_add(bt_session_tx_t *tx, const char *path);
+
+/**
+ * Produce up to len stream bytes. Returns 0 once the stream is complete
+ * or has failed (tx->error set); files are opened and read lazily here.
+ */
+size_t bt_session_tx_read(bt_session_tx_t *tx, uint8_t *buf, size_t len);
+
+bool bt_session_tx_done(const bt_session_tx_t *tx);
+
+// Name of the file being encoded, or "" before the first/after the last
+const char *bt_session_tx_current(const bt_session_tx_t *tx);
+
+// Close the current file and free the queue
+void bt_session_tx_free(bt_session_tx_t *tx);
+
+void bt_session_rx_init(bt_session_rx_t *rx, const char *root);
+
+/**
+ * Consume stream bytes. Returns 1 once END was received, 0 if more is
+ * needed, -1 on a malformed stream or file error (rx->error set).
+ * Files are written as <name>.part and renamed after their CRC matched.
+ */
+int bt_session_rx_feed(bt_session_rx_t *rx, const uint8_t *data, size_t len);
+
+// Name of the file being written, or ""
+const char *bt_session_rx_current(const bt_session_rx_t *rx);
+
+// Stop early: the partial file is deleted, completed ones are kept
+void bt_session_rx_abort(bt_session_rx_t *rx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BT_SESSION_H
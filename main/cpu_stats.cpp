@@ -0,0 +1,344 @@
+/**
+ * Win32 OS - CPU Statistics Implementation
+ * One low priority task diffs the run time counters of every task against
+ * the run time clock each period. The busiest CPU_STATS_MAX_TASKS are
+ * reported and keep a history column (slot) while they stay among them; a
+ * task joining them takes over a free column and clears it.
+ */
+
+#include "cpu_stats.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "CPU_STATS";
+
+#define CPU_STATS_PERIOD_MS         1000
+#define CPU_STATS_MAX_PERIOD_MS     8000
+#define CPU_STATS_BUDGET_X100       100     // Sampler may use 1% of one core
+#define CPU_STATS_TASK_STACK        3072
+#define CPU_STATS_TASK_PRIORITY     2       // Above idle, below everything interactive
+
+// History columns: cores first, then one per task slot. Values are 0.5%
+// steps so a byte holds 0..100%.
+#define CPU_STATS_COLUMNS           (portNUM_PROCESSORS + CPU_STATS_MAX_TASKS)
+
+#define CPU_STATS_SPARE_TASKS       8       // Headroom for tasks created mid-pass
+
+typedef struct {
+    bool used;
+    bool seen;                  // Among the reported tasks this pass
+    UBaseType_t number;
+} slot_t;
+
+// Run time counter of a task at the last pass, sorted by task number
+typedef struct {
+    UBaseType_t number;
+    configRUN_TIME_COUNTER_TYPE runtime;
+} baseline_t;
+
+static TaskHandle_t s_task = NULL;
+static SemaphoreHandle_t s_lock = NULL;
+
+// Sampler-private state. The per-task arrays hold every task, not just the
+// reported ones, so they grow with the task count.
+static TaskStatus_t *s_status = NULL;
+static cpu_stats_task_t *s_scratch = NULL;
+static baseline_t *s_base = NULL;
+static UBaseType_t s_capacity = 0;
+static UBaseType_t s_base_count = 0;
+static slot_t s_slots[CPU_STATS_MAX_TASKS];
+static configRUN_TIME_COUNTER_TYPE s_last_clock = 0;
+static configRUN_TIME_COUNTER_TYPE s_last_idle[portNUM_PROCESSORS];
+
+// Results, guarded by s_lock
+static cpu_stats_task_t s_tasks[CPU_STATS_MAX_TASKS];  // Busiest first
+static int s_task_count = 0;
+static uint16_t s_core_x10[portNUM_PROCESSORS];
+static uint8_t *s_history = NULL;      // [CPU_STATS_HISTORY][CPU_STATS_COLUMNS]
+static int s_head = 0;                  // Next row to write
+static int s_filled = 0;
+static cpu_stats_overhead_t s_overhead = {};
+
+static uint16_t load_x10(configRUN_TIME_COUNTER_TYPE busy, configRUN_TIME_COUNTER_TYPE elapsed)
+{
+    if (elapsed == 0) return 0;
+    uint64_t x10 = (uint64_t)busy * 1000 / elapsed;
+    return x10 > 1000 ? 1000 : (uint16_t)x10;
+}
+
+// Make room for at least `want` tasks; on failure the old arrays stay
+static bool reserve(UBaseType_t want)
+{
+    if (want <= s_capacity) return true;
+
+    TaskStatus_t *status = (TaskStatus_t *)heap_caps_realloc(s_status, want * sizeof(s_status[0]), MALLOC_CAP_SPIRAM);
+    if (!status) return false;
+    s_status = status;
+    cpu_stats_task_t *scratch = (cpu_stats_task_t *)heap_caps_realloc(s_scratch, want * sizeof(s_scratch[0]), MALLOC_CAP_SPIRAM);
+    if (!scratch) return false;
+    s_scratch = scratch;
+    baseline_t *base = (baseline_t *)heap_caps_realloc(s_base, want * sizeof(s_base[0]), MALLOC_CAP_SPIRAM);
+    if (!base) return false;
+    s_base = base;
+
+    s_capacity = want;
+    return true;
+}
+
+static int compare_number(const void *a, const void *b)
+{
+    UBaseType_t na = ((const baseline_t *)a)->number;
+    UBaseType_t nb = ((const baseline_t *)b)->number;
+    return na < nb ? -1 : na > nb;
+}
+
+static const baseline_t *find_baseline(UBaseType_t number)
+{
+    baseline_t key = { number, 0 };
+    return (const baseline_t *)bsearch(&key, s_base, s_base_count, sizeof(s_base[0]), compare_number);
+}
+
+static int find_slot(UBaseType_t number)
+{
+    for (int i = 0; i < CPU_STATS_MAX_TASKS; i++) {
+        if (s_slots[i].used && s_slots[i].number == number) return i;
+    }
+    return -1;
+}
+
+// Claim a free column for a new task and wipe what the last owner left
+static int claim_slot(UBaseType_t number)
+{
+    for (int i = 0; i < CPU_STATS_MAX_TASKS; i++) {
+        if (s_slots[i].used) continue;
+        s_slots[i].used = true;
+        s_slots[i].number = number;
+        for (int row = 0; row < CPU_STATS_HISTORY; row++) {
+            s_history[row * CPU_STATS_COLUMNS + portNUM_PROCESSORS + i] = 0;
+        }
+        return i;
+    }
+    return -1;
+}
+
+static int compare_cpu(const void *a, const void *b)
+{
+    const cpu_stats_task_t *ta = (const cpu_stats_task_t *)a;
+    const cpu_stats_task_t *tb = (const cpu_stats_task_t *)b;
+    if (ta->cpu_x10 != tb->cpu_x10) return (int)tb->cpu_x10 - (int)ta->cpu_x10;
+    return (int)ta->number - (int)tb->number;
+}
+
+static void sample(void)
+{
+    // Room for every task plus a few created before the snapshot is taken;
+    // uxTaskGetSystemState() fills nothing when the array is too small
+    reserve(uxTaskGetNumberOfTasks() + CPU_STATS_SPARE_TASKS);
+    UBaseType_t count = uxTaskGetSystemState(s_status, s_capacity, NULL);
+    if (count == 0) {
+        // Out of memory: keep the last results and the clock baseline, so
+        // the next pass measures over the whole gap
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        s_overhead.stale = true;
+        xSemaphoreGive(s_lock);
+        return;
+    }
+    configRUN_TIME_COUNTER_TYPE clock = portGET_RUN_TIME_COUNTER_VALUE();
+    configRUN_TIME_COUNTER_TYPE elapsed = clock - s_last_clock;
+    s_last_clock = clock;
+
+    // Load of every task; a task new since the last pass only gets its
+    // baseline, the lifetime total is not a load
+    cpu_stats_task_t *tasks = s_scratch;
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t *st = &s_status[i];
+        const baseline_t *base = find_baseline(st->xTaskNumber);
+        configRUN_TIME_COUNTER_TYPE busy = base ? st->ulRunTimeCounter - base->runtime : 0;
+
+        cpu_stats_task_t *t = &tasks[i];
+        strncpy(t->name, st->pcTaskName, sizeof(t->name) - 1);
+        t->name[sizeof(t->name) - 1] = '\0';
+        t->handle = st->xHandle;
+        t->number = st->xTaskNumber;
+        t->core = st->xCoreID < portNUM_PROCESSORS ? (int8_t)st->xCoreID : -1;
+        t->state = st->eCurrentState;
+        t->priority = st->uxCurrentPriority;
+        t->stack_free = st->usStackHighWaterMark;
+        t->cpu_x10 = load_x10(busy, elapsed);
+    }
+    for (UBaseType_t i = 0; i < count; i++) {
+        s_base[i].number = s_status[i].xTaskNumber;
+        s_base[i].runtime = s_status[i].ulRunTimeCounter;
+    }
+    qsort(s_base, count, sizeof(s_base[0]), compare_number);
+    s_base_count = count;
+
+    // Sorted here, once a second, so readers only copy. Only the busiest
+    // keep a report entry and a history column.
+    qsort(tasks, count, sizeof(tasks[0]), compare_cpu);
+    int n = count < CPU_STATS_MAX_TASKS ? (int)count : CPU_STATS_MAX_TASKS;
+
+    // Match tasks to their columns first, so the columns of tasks that
+    // ended or dropped out are free before new ones claim one
+    int slots[CPU_STATS_MAX_TASKS];
+    for (int i = 0; i < CPU_STATS_MAX_TASKS; i++) s_slots[i].seen = false;
+    for (int i = 0; i < n; i++) {
+        slots[i] = find_slot(tasks[i].number);
+        if (slots[i] >= 0) s_slots[slots[i]].seen = true;
+    }
+    for (int i = 0; i < CPU_STATS_MAX_TASKS; i++) {
+        if (!s_slots[i].seen) s_slots[i].used = false;
+    }
+    for (int i = 0; i < n; i++) {
+        // Always finds one: n <= CPU_STATS_MAX_TASKS
+        tasks[i].slot = (uint8_t)(slots[i] >= 0 ? slots[i] : claim_slot(tasks[i].number));
+    }
+
+    uint16_t cores[portNUM_PROCESSORS];
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        configRUN_TIME_COUNTER_TYPE idle = ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(c));
+        cores[c] = 1000 - load_x10(idle - s_last_idle[c], elapsed);
+        s_last_idle[c] = idle;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    memcpy(s_tasks, tasks, n * sizeof(tasks[0]));
+    s_task_count = n;
+    memcpy(s_core_x10, cores, sizeof(cores));
+    s_overhead.untracked = (uint16_t)(count - n);
+    s_overhead.stale = false;
+
+    uint8_t *row = &s_history[s_head * CPU_STATS_COLUMNS];
+    memset(row, 0, CPU_STATS_COLUMNS);
+    for (int c = 0; c < portNUM_PROCESSORS; c++) row[c] = (uint8_t)(cores[c] / 5);
+    for (int i = 0; i < n; i++) row[portNUM_PROCESSORS + tasks[i].slot] = (uint8_t)(tasks[i].cpu_x10 / 5);
+    s_head = (s_head + 1) % CPU_STATS_HISTORY;
+    if (s_filled < CPU_STATS_HISTORY) s_filled++;
+    xSemaphoreGive(s_lock);
+}
+
+static void sampler_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t period_ms = CPU_STATS_PERIOD_MS;
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(period_ms));
+
+        int64_t start = esp_timer_get_time();
+        sample();
+        uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        uint32_t avg_us = s_overhead.avg_us ? (s_overhead.avg_us * 7 + us) / 8 : us;
+        s_overhead.avg_us = avg_us;
+        if (us > s_overhead.max_us) s_overhead.max_us = us;
+        s_overhead.load_x100 = (uint16_t)(avg_us * 10 / period_ms);
+        // Over budget: sample less often rather than cost more
+        bool slow_down = s_overhead.load_x100 > CPU_STATS_BUDGET_X100 && period_ms < CPU_STATS_MAX_PERIOD_MS;
+        if (slow_down) period_ms *= 2;
+        s_overhead.period_ms = period_ms;
+        xSemaphoreGive(s_lock);
+
+        if (slow_down) {
+            ESP_LOGW(TAG, "Sampling takes %lu us, slowing down to every %lu ms",
+                     (unsigned long)avg_us, (unsigned long)period_ms);
+        }
+    }
+}
+
+void cpu_stats_start(void)
+{
+    if (s_task) return;
+
+    bool reserved = reserve(uxTaskGetNumberOfTasks() + CPU_STATS_SPARE_TASKS);
+    s_history = (uint8_t *)heap_caps_calloc(CPU_STATS_HISTORY, CPU_STATS_COLUMNS, MALLOC_CAP_SPIRAM);
+    s_lock = xSemaphoreCreateMutex();
+    if (!reserved || !s_history || !s_lock) {
+        ESP_LOGE(TAG, "Out of memory");
+        return;
+    }
+
+    s_last_clock = portGET_RUN_TIME_COUNTER_VALUE();
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        s_last_idle[c] = ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(c));
+    }
+    s_overhead.period_ms = CPU_STATS_PERIOD_MS;
+
+    if (xTaskCreate(sampler_task, "cpu_stats", CPU_STATS_TASK_STACK, NULL,
+                    CPU_STATS_TASK_PRIORITY, &s_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create sampler task");
+        s_task = NULL;
+        return;
+    }
+    ESP_LOGI(TAG, "Sampling every %d ms, %d tasks, %d s history",
+             CPU_STATS_PERIOD_MS, CPU_STATS_MAX_TASKS, CPU_STATS_HISTORY);
+}
+
+// ============ QUERIES ============
+
+int cpu_stats_get_tasks(cpu_stats_task_t *out, int max)
+{
+    if (!s_lock || !out || max <= 0) return 0;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    int n = s_task_count < max ? s_task_count : max;
+    memcpy(out, s_tasks, n * sizeof(out[0]));
+    xSemaphoreGive(s_lock);
+    return n;
+}
+
+int cpu_stats_get_cores(uint16_t *out_x10, int max)
+{
+    if (!s_lock || !out_x10) return 0;
+
+    int n = max < portNUM_PROCESSORS ? max : portNUM_PROCESSORS;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    memcpy(out_x10, s_core_x10, n * sizeof(out_x10[0]));
+    xSemaphoreGive(s_lock);
+    return n;
+}
+
+static int column_history(int column, uint8_t *out, int max)
+{
+    if (!s_lock || !out || max <= 0) return 0;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    int n = s_filled < max ? s_filled : max;
+    // Newest n rows, oldest first
+    int row = (s_head - n + CPU_STATS_HISTORY) % CPU_STATS_HISTORY;
+    for (int i = 0; i < n; i++) {
+        out[i] = s_history[row * CPU_STATS_COLUMNS + column] / 2;
+        row = (row + 1) % CPU_STATS_HISTORY;
+    }
+    xSemaphoreGive(s_lock);
+    return n;
+}
+
+int cpu_stats_core_history(int core, uint8_t *out, int max)
+{
+    if (core < 0 || core >= portNUM_PROCESSORS) return 0;
+    return column_history(core, out, max);
+}
+
+int cpu_stats_task_history(int slot, uint8_t *out, int max)
+{
+    if (slot < 0 || slot >= CPU_STATS_MAX_TASKS) return 0;
+    return column_history(portNUM_PROCESSORS + slot, out, max);
+}
+
+void cpu_stats_get_overhead(cpu_stats_overhead_t *out)
+{
+    if (!out) return;
+    if (!s_lock) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *out = s_overhead;
+    xSemaphoreGive(s_lock);
+}
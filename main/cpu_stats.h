@@ -0,0 +1,81 @@
+/**
+ * Win32 OS - CPU Statistics
+ * Background sampler that turns the FreeRTOS run time counters into CPU
+ * load per task and per core once a second, and keeps the last minute of
+ * both in a small ring buffer for graphs.
+ *
+ * Task load is a share of one core (a task busy on core 1 for the whole
+ * second shows 100%), core load is 100% minus that core's idle task.
+ */
+
+#ifndef CPU_STATS_H
+#define CPU_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CPU_STATS_MAX_TASKS     48      // Tasks reported; with more, the busiest ones
+#define CPU_STATS_HISTORY       60      // Samples kept per task and per core
+#define CPU_STATS_NAME_LEN      configMAX_TASK_NAME_LEN
+
+// One task over the last sample period
+typedef struct {
+    char name[CPU_STATS_NAME_LEN];
+    TaskHandle_t handle;
+    UBaseType_t number;         // FreeRTOS task number, unique for the session
+    int8_t core;                // -1 when not pinned
+    eTaskState state;
+    UBaseType_t priority;
+    uint32_t stack_free;        // Stack high water mark (bytes)
+    uint16_t cpu_x10;           // Load in 0.1% of one core
+    uint8_t slot;               // History column, see cpu_stats_task_history()
+} cpu_stats_task_t;
+
+// Cost of the sampler itself
+typedef struct {
+    uint32_t period_ms;         // Current period; backs off if sampling gets expensive
+    uint32_t avg_us;            // Average time of one pass
+    uint32_t max_us;
+    uint16_t load_x100;         // avg_us against the period, in 0.01%
+    uint16_t untracked;         // Tasks left out of the report, beyond CPU_STATS_MAX_TASKS
+    bool stale;                 // Last pass got no snapshot (out of memory), results are older
+} cpu_stats_overhead_t;
+
+/**
+ * Start the sampler task; safe to call more than once
+ */
+void cpu_stats_start(void);
+
+/**
+ * Copy the tasks of the last sample, busiest first
+ * @return Number of entries written
+ */
+int cpu_stats_get_tasks(cpu_stats_task_t *out, int max);
+
+/**
+ * Load of each core in the last sample (0.1%)
+ * @return Number of cores written
+ */
+int cpu_stats_get_cores(uint16_t *out_x10, int max);
+
+/**
+ * Load history, oldest first, in whole percent
+ * @return Number of samples written
+ */
+int cpu_stats_core_history(int core, uint8_t *out, int max);
+int cpu_stats_task_history(int slot, uint8_t *out, int max);
+
+void cpu_stats_get_overhead(cpu_stats_overhead_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CPU_STATS_H
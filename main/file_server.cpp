@@ -0,0 +1,168 @@
+/**
+ * Win32 OS - Wi-Fi File Server Implementation
+ * Listening socket and server task; each accepted connection is handed
+ * to file_server_handle_connection() with the shared transfer buffer.
+ */
+
+#include "file_server.h"
+#include "file_server_http.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+
+static const char *TAG = "FILE_SRV";
+
+#define FILE_SERVER_BUF_SIZE        (32 * 1024)
+#define FILE_SERVER_TASK_STACK      6144
+#define FILE_SERVER_TASK_PRIORITY   5
+#define FILE_SERVER_ACCEPT_MS       1000    // Accept timeout, to notice file_server_stop()
+#define FILE_SERVER_IDLE_MS         2000    // Keep-alive wait between requests
+#define FILE_SERVER_RANDOM_TOKEN    12      // Hex digits of a generated token
+
+static const file_server_root_t s_roots[] = {
+    { "/littlefs", "/littlefs" },
+    { "/sdcard",   "/sdcard" },
+};
+
+static file_server_ctx_t s_ctx;
+static uint16_t s_port = 0;
+static char s_token[FILE_SERVER_TOKEN_LEN + 1];
+static uint32_t s_connections = 0;
+static volatile bool s_running = false;
+static volatile bool s_stop = false;
+
+static void file_server_task(void *arg)
+{
+    int listen_sock = (int)(intptr_t)arg;
+
+    while (!s_stop) {
+        struct sockaddr_in peer;
+        socklen_t peer_len = sizeof(peer);
+        int sock = accept(listen_sock, (struct sockaddr *)&peer, &peer_len);
+        if (sock < 0) continue;     // Timeout: check s_stop
+
+        char ip[16];
+        inet_ntoa_r(peer.sin_addr, ip, sizeof(ip));
+        uint64_t sent = s_ctx.bytes_sent;
+        uint64_t received = s_ctx.bytes_received;
+        int64_t start = esp_timer_get_time();
+
+        s_connections++;
+        file_server_handle_connection(&s_ctx, sock);
+        close(sock);
+
+        // Idle keep-alive time is included, so this is a lower bound
+        int64_t ms = (esp_timer_get_time() - start) / 1000;
+        uint64_t bytes = (s_ctx.bytes_sent - sent) + (s_ctx.bytes_received - received);
+        ESP_LOGI(TAG, "%s: %llu KB out, %llu KB in, %lld ms (%llu KB/s)", ip,
+                 (unsigned long long)((s_ctx.bytes_sent - sent) / 1024),
+                 (unsigned long long)((s_ctx.bytes_received - received) / 1024), ms,
+                 (unsigned long long)(ms > 0 ? bytes * 1000 / 1024 / ms : 0));
+    }
+
+    close(listen_sock);
+    heap_caps_free(s_ctx.buf);
+    s_ctx.buf = NULL;
+    ESP_LOGI(TAG, "Stopped");
+    s_running = false;
+    vTaskDelete(NULL);
+}
+
+esp_err_t file_server_start(uint16_t port, const char *token)
+{
+    if (s_running) return ESP_ERR_INVALID_STATE;
+    if (port == 0) port = FILE_SERVER_DEFAULT_PORT;
+
+    // Letters, digits, '-' and '_' only, so it goes into a URL as is
+    if (token && token[0]) {
+        if (strlen(token) > FILE_SERVER_TOKEN_LEN) return ESP_ERR_INVALID_ARG;
+        for (const char *p = token; *p; p++) {
+            if (!isalnum((unsigned char)*p) && *p != '-' && *p != '_') return ESP_ERR_INVALID_ARG;
+        }
+        strcpy(s_token, token);
+    } else {
+        for (int i = 0; i < FILE_SERVER_RANDOM_TOKEN; i++) {
+            s_token[i] = "0123456789abcdef"[esp_random() & 0xF];
+        }
+        s_token[FILE_SERVER_RANDOM_TOKEN] = '\0';
+    }
+
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) return ESP_FAIL;
+    int one = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(sock, 2) != 0) {
+        ESP_LOGE(TAG, "bind/listen on port %u failed: errno %d", port, errno);
+        close(sock);
+        return ESP_FAIL;
+    }
+    struct timeval tv = { FILE_SERVER_ACCEPT_MS / 1000, 0 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    // DMA-capable internal RAM lets SD card reads and writes skip the
+    // driver's bounce buffer
+    uint8_t *buf = (uint8_t *)heap_caps_malloc(FILE_SERVER_BUF_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!buf) buf = (uint8_t *)heap_caps_malloc(FILE_SERVER_BUF_SIZE, MALLOC_CAP_8BIT);
+    if (!buf) {
+        close(sock);
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(&s_ctx, 0, sizeof(s_ctx));
+    s_ctx.roots = s_roots;
+    s_ctx.root_count = sizeof(s_roots) / sizeof(s_roots[0]);
+    s_ctx.buf = buf;
+    s_ctx.buf_size = FILE_SERVER_BUF_SIZE;
+    s_ctx.idle_timeout_ms = FILE_SERVER_IDLE_MS;
+    s_ctx.stop = &s_stop;
+    s_ctx.token = s_token;
+    s_port = port;
+    s_connections = 0;
+    s_stop = false;
+    s_running = true;
+
+    if (xTaskCreate(file_server_task, "file_srv", FILE_SERVER_TASK_STACK, (void *)(intptr_t)sock,
+                    FILE_SERVER_TASK_PRIORITY, NULL) != pdPASS) {
+        s_running = false;
+        heap_caps_free(buf);
+        s_ctx.buf = NULL;
+        close(sock);
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Listening on port %u", port);
+    return ESP_OK;
+}
+
+void file_server_stop(void)
+{
+    if (s_running) s_stop = true;
+}
+
+bool file_server_is_running(void)
+{
+    return s_running;
+}
+
+void file_server_get_stats(file_server_stats_t *stats)
+{
+    stats->running = s_running;
+    stats->port = s_port;
+    stats->connections = s_connections;
+    stats->requests = s_ctx.requests;
+    stats->files_uploaded = s_ctx.files_uploaded;
+    stats->bytes_sent = s_ctx.bytes_sent;
+    stats->bytes_received = s_ctx.bytes_received;
+    strcpy(stats->token, s_token);
+}
@@ -0,0 +1,62 @@
+/**
+ * Win32 OS - Wi-Fi File Server
+ * Serves /littlefs and /sdcard over HTTP on the local network for bulk
+ * transfers: browse in a browser, or script it with curl:
+ *   curl http://<ip>/sdcard/?json              list a directory
+ *   curl -r 0-1023 -O http://<ip>/sdcard/x     (range) download
+ *   curl -T file -H "Authorization: Bearer <token>" http://<ip>/sdcard/file
+ *   curl -F f=@a -F f=@b "http://<ip>/sdcard/?token=<token>"
+ *   curl -X DELETE -H "Authorization: Bearer <token>" http://<ip>/sdcard/file
+ * Uploads and deletes need the token shown by the console "fileserver"
+ * command; hidden (dot) files and directories are not served at all.
+ * One connection is served at a time. Request handling lives in
+ * file_server_http.cpp.
+ */
+
+#ifndef FILE_SERVER_H
+#define FILE_SERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "file_server_http.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FILE_SERVER_DEFAULT_PORT    80
+
+typedef struct {
+    bool running;
+    uint16_t port;
+    uint32_t connections;
+    uint32_t requests;
+    uint32_t files_uploaded;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    char token[FILE_SERVER_TOKEN_LEN + 1];  // Needed for uploads and deletes
+} file_server_stats_t;
+
+/**
+ * Start the server task (port 0 = FILE_SERVER_DEFAULT_PORT)
+ * @param token Write token; NULL or "" picks a random one
+ * @return ESP_ERR_INVALID_STATE if already running, ESP_ERR_INVALID_ARG
+ *         if the token is too long or not URL safe
+ */
+esp_err_t file_server_start(uint16_t port, const char *token);
+
+/**
+ * Stop after the current request; returns without waiting
+ */
+void file_server_stop(void);
+
+bool file_server_is_running(void);
+
+void file_server_get_stats(file_server_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FILE_SERVER_H
@@ -0,0 +1,850 @@
+/**
+ * Win32 OS - File Server Request Handling Implementation
+ * The request header is read into the front of ctx->buf; body bytes that
+ * arrived with it stay in place and the rest of the body is received
+ * into the same buffer, which is only written out once it is full.
+ */
+
+#include "file_server_http.h"
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#define FS_PATH_LEN         256
+#define FS_LOCAL_LEN        320
+#define FS_BOUNDARY_LEN     72
+#define FS_LISTING_FLUSH    512     // Flush a listing chunk when less room is left
+
+typedef struct {
+    char method[8];
+    char path[FS_PATH_LEN];         // Decoded, without query
+    bool json;                      // ?json
+    char token[FILE_SERVER_TOKEN_LEN + 1];  // ?token= or Authorization: Bearer
+    int64_t content_length;         // -1 if absent
+    bool chunked;
+    bool keep_alive;
+    bool expect_continue;
+    bool has_range;
+    int64_t range_start;            // -1: suffix range ("bytes=-N")
+    int64_t range_end;              // -1: to end of file
+    char boundary[FS_BOUNDARY_LEN];
+} fs_request_t;
+
+// Request body: bytes already in ctx->buf plus what is still on the socket
+typedef struct {
+    size_t len;                     // Valid bytes at ctx->buf
+    int64_t remaining;              // Not yet received
+} fs_body_t;
+
+// ============ SOCKET HELPERS ============
+
+static bool send_all(file_server_ctx_t *ctx, int sock, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (len > 0) {
+        ssize_t n = send(sock, p, len, 0);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        len -= n;
+        ctx->bytes_sent += n;
+    }
+    return true;
+}
+
+static void set_recv_timeout(int sock, int ms)
+{
+    struct timeval tv;
+    tv.tv_sec = ms / 1000;
+    tv.tv_usec = (ms % 1000) * 1000;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+// Receive until the buffer is full or the body is complete
+static bool body_fill(file_server_ctx_t *ctx, int sock, fs_body_t *body)
+{
+    while (body->len < ctx->buf_size && body->remaining > 0) {
+        size_t want = ctx->buf_size - body->len;
+        if ((int64_t)want > body->remaining) want = (size_t)body->remaining;
+        ssize_t n = recv(sock, ctx->buf + body->len, want, 0);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        body->len += n;
+        body->remaining -= n;
+        ctx->bytes_received += n;
+    }
+    return true;
+}
+
+// Discard the unread part of a body so the connection can be reused
+static bool body_drain(file_server_ctx_t *ctx, int sock, fs_body_t *body)
+{
+    while (body->remaining > 0) {
+        body->len = 0;
+        if (!body_fill(ctx, sock, body)) return false;
+    }
+    body->len = 0;
+    return true;
+}
+
+static bool write_all(int fd, const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+static const uint8_t *find_bytes(const uint8_t *hay, size_t hay_len, const char *needle, size_t needle_len)
+{
+    if (needle_len == 0 || hay_len < needle_len) return NULL;
+    const uint8_t *end = hay + hay_len - needle_len;
+    for (const uint8_t *p = hay; p <= end; p++) {
+        p = (const uint8_t *)memchr(p, needle[0], end - p + 1);
+        if (!p) return NULL;
+        if (memcmp(p, needle, needle_len) == 0) return p;
+    }
+    return NULL;
+}
+
+// ============ RESPONSES ============
+
+static const char *status_text(int status)
+{
+    switch (status) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 301: return "Moved Permanently";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 411: return "Length Required";
+        case 416: return "Range Not Satisfiable";
+        case 507: return "Insufficient Storage";
+        default:  return "Internal Server Error";
+    }
+}
+
+// length < 0 sends a chunked body
+static bool send_header(file_server_ctx_t *ctx, int sock, const fs_request_t *req, int status,
+                        const char *type, int64_t length, const char *extra)
+{
+    char head[512];
+    int n = snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\nServer: WinESP32\r\nConnection: %s\r\n",
+                     status, status_text(status), req->keep_alive ? "keep-alive" : "close");
+    if (type) {
+        n += snprintf(head + n, sizeof(head) - n, "Content-Type: %s\r\n", type);
+    }
+    if (length >= 0) {
+        n += snprintf(head + n, sizeof(head) - n, "Content-Length: %lld\r\n", (long long)length);
+    } else {
+        n += snprintf(head + n, sizeof(head) - n, "Transfer-Encoding: chunked\r\n");
+    }
+    if (extra) {
+        n += snprintf(head + n, sizeof(head) - n, "%s", extra);
+    }
+    n += snprintf(head + n, sizeof(head) - n, "\r\n");
+    if (n >= (int)sizeof(head)) return false;
+    return send_all(ctx, sock, head, n);
+}
+
+static bool send_text(file_server_ctx_t *ctx, int sock, const fs_request_t *req, int status, const char *text)
+{
+    size_t len = strlen(text);
+    if (!send_header(ctx, sock, req, status, "text/plain", len, NULL)) return false;
+    if (strcmp(req->method, "HEAD") == 0) return true;
+    return send_all(ctx, sock, text, len);
+}
+
+static bool send_chunk(file_server_ctx_t *ctx, int sock, const uint8_t *data, size_t len)
+{
+    char size_line[16];
+    int n = snprintf(size_line, sizeof(size_line), "%x\r\n", (unsigned)len);
+    return send_all(ctx, sock, size_line, n) &&
+           (len == 0 || send_all(ctx, sock, data, len)) &&
+           send_all(ctx, sock, "\r\n", 2);
+}
+
+static const char *content_type(const char *path)
+{
+    static const struct { const char *ext; const char *type; } types[] = {
+        { ".html", "text/html" }, { ".htm", "text/html" }, { ".txt", "text/plain" },
+        { ".log", "text/plain" }, { ".csv", "text/plain" }, { ".js", "text/javascript" },
+        { ".json", "application/json" }, { ".png", "image/png" }, { ".jpg", "image/jpeg" },
+        { ".jpeg", "image/jpeg" }, { ".bmp", "image/bmp" }, { ".gif", "image/gif" },
+        { ".wav", "audio/wav" }, { ".mp3", "audio/mpeg" },
+    };
+    const char *dot = strrchr(path, '.');
+    if (dot) {
+        for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+            if (strcasecmp(dot, types[i].ext) == 0) return types[i].type;
+        }
+    }
+    return "application/octet-stream";
+}
+
+// ============ REQUEST PARSING ============
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    c = tolower((unsigned char)c);
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// Decode %XX in place; NUL bytes are rejected
+static bool url_decode(char *s)
+{
+    char *out = s;
+    for (char *in = s; *in; in++) {
+        if (*in == '%') {
+            int hi = hex_value(in[1]);
+            int lo = hi >= 0 ? hex_value(in[2]) : -1;
+            if (lo < 0 || (hi == 0 && lo == 0)) return false;
+            *out++ = (char)(hi * 16 + lo);
+            in += 2;
+        } else {
+            *out++ = *in;
+        }
+    }
+    *out = '\0';
+    return true;
+}
+
+static void parse_range(fs_request_t *req, const char *value)
+{
+    if (strncasecmp(value, "bytes=", 6) != 0 || strchr(value, ',')) return;   // Multi-range: send it all
+    const char *spec = value + 6;
+    char *end = NULL;
+    if (*spec == '-') {
+        req->range_start = -1;
+        req->range_end = strtoll(spec + 1, &end, 10);
+        if (end == spec + 1 || req->range_end <= 0) return;
+    } else {
+        req->range_start = strtoll(spec, &end, 10);
+        if (end == spec || *end != '-') return;
+        const char *last = end + 1;
+        req->range_end = *last ? strtoll(last, &end, 10) : -1;
+        if (*last && (end == last || req->range_end < req->range_start)) return;
+    }
+    req->has_range = true;
+}
+
+// Parse "METHOD /path?query HTTP/1.x" plus the headers we act on
+static bool parse_request(fs_request_t *req, char *head)
+{
+    memset(req, 0, sizeof(*req));
+    req->content_length = -1;
+
+    char *save = NULL;
+    char *line = strtok_r(head, "\r\n", &save);
+    if (!line) return false;
+
+    char *sp1 = strchr(line, ' ');
+    char *sp2 = sp1 ? strchr(sp1 + 1, ' ') : NULL;
+    if (!sp1 || !sp2 || sp1 - line >= (int)sizeof(req->method)) return false;
+    memcpy(req->method, line, sp1 - line);
+    *sp2 = '\0';
+    req->keep_alive = strcmp(sp2 + 1, "HTTP/1.0") != 0;
+
+    char *target = sp1 + 1;
+    char *query = strchr(target, '?');
+    if (query) {
+        *query++ = '\0';
+        for (char *arg = query; arg; arg = strchr(arg, '&') ? strchr(arg, '&') + 1 : NULL) {
+            size_t n = strcspn(arg, "&");
+            if (strncmp(arg, "json", 4) == 0 && (n == 4 || arg[4] == '=')) {
+                req->json = true;
+            } else if (strncmp(arg, "token=", 6) == 0 && n - 6 <= FILE_SERVER_TOKEN_LEN) {
+                memcpy(req->token, arg + 6, n - 6);
+                req->token[n - 6] = '\0';
+            }
+        }
+    }
+    if (target[0] != '/' || strlen(target) >= sizeof(req->path)) return false;
+    strcpy(req->path, target);
+    if (!url_decode(req->path)) return false;
+
+    while ((line = strtok_r(NULL, "\r\n", &save)) != NULL) {
+        char *colon = strchr(line, ':');
+        if (!colon) continue;
+        *colon = '\0';
+        char *value = colon + 1;
+        while (*value == ' ' || *value == '\t') value++;
+
+        if (strcasecmp(line, "Content-Length") == 0) {
+            req->content_length = strtoll(value, NULL, 10);
+        } else if (strcasecmp(line, "Transfer-Encoding") == 0) {
+            req->chunked = strcasestr(value, "chunked") != NULL;
+        } else if (strcasecmp(line, "Connection") == 0) {
+            if (strcasecmp(value, "close") == 0) req->keep_alive = false;
+            else if (strcasecmp(value, "keep-alive") == 0) req->keep_alive = true;
+        } else if (strcasecmp(line, "Expect") == 0) {
+            req->expect_continue = strcasecmp(value, "100-continue") == 0;
+        } else if (strcasecmp(line, "Authorization") == 0) {
+            if (strncasecmp(value, "Bearer ", 7) == 0 && strlen(value + 7) <= FILE_SERVER_TOKEN_LEN) {
+                strcpy(req->token, value + 7);
+            }
+        } else if (strcasecmp(line, "Range") == 0) {
+            parse_range(req, value);
+        } else if (strcasecmp(line, "Content-Type") == 0) {
+            const char *b = strcasestr(value, "boundary=");
+            if (b && strncasecmp(value, "multipart/form-data", 19) == 0) {
+                b += 9;
+                if (*b == '"') b++;
+                size_t len = strcspn(b, "\";");
+                if (len > 0 && len < sizeof(req->boundary)) memcpy(req->boundary, b, len);
+            }
+        }
+    }
+    return true;
+}
+
+// Compare in constant time so the reply time does not leak the token
+static bool token_ok(const file_server_ctx_t *ctx, const fs_request_t *req)
+{
+    if (!ctx->token || !ctx->token[0]) return false;
+    size_t len = strlen(ctx->token);
+    if (strlen(req->token) != len) return false;
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++) diff |= (uint8_t)(ctx->token[i] ^ req->token[i]);
+    return diff == 0;
+}
+
+// Map a URL path to a local path; false if outside every root or any
+// segment starts with a dot. That covers "." and "..", and keeps remote
+// clients out of hidden system directories such as the JS bytecode
+// cache, which is loaded without further checks.
+static bool map_path(const file_server_ctx_t *ctx, const char *url, char *local, size_t len)
+{
+    for (const char *p = url; (p = strchr(p, '/')) != NULL; p++) {
+        if (p[1] == '.') return false;
+    }
+    for (int i = 0; i < ctx->root_count; i++) {
+        size_t n = strlen(ctx->roots[i].url);
+        if (strncmp(url, ctx->roots[i].url, n) == 0 && (url[n] == '\0' || url[n] == '/')) {
+            int w = snprintf(local, len, "%s%s", ctx->roots[i].path, url + n);
+            if (w < 0 || w >= (int)len) return false;
+            // Trailing slash: opendir() on some VFS drivers refuses it
+            size_t l = strlen(local);
+            while (l > 1 && local[l - 1] == '/') local[--l] = '\0';
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============ LISTINGS ============
+
+typedef struct {
+    file_server_ctx_t *ctx;
+    int sock;
+    size_t len;
+    bool ok;
+} fs_listing_t;
+
+static void listing_flush(fs_listing_t *out, bool force)
+{
+    if (!out->ok) return;
+    if (out->len > 0 && (force || out->ctx->buf_size - out->len < FS_LISTING_FLUSH)) {
+        out->ok = send_chunk(out->ctx, out->sock, out->ctx->buf, out->len);
+        out->len = 0;
+    }
+}
+
+static void listing_add(fs_listing_t *out, const char *text)
+{
+    size_t len = strlen(text);
+    if (len > out->ctx->buf_size - out->len) {
+        listing_flush(out, true);
+        if (len > out->ctx->buf_size) return;
+    }
+    memcpy(out->ctx->buf + out->len, text, len);
+    out->len += len;
+}
+
+// escape: 'h' for HTML text, 'u' for a URL path, 'j' for a JSON string
+static void listing_add_escaped(fs_listing_t *out, const char *text, char escape)
+{
+    char tmp[8];
+    for (const unsigned char *p = (const unsigned char *)text; *p; p++) {
+        if (escape == 'h' && (*p == '<' || *p == '>' || *p == '&' || *p == '"')) {
+            snprintf(tmp, sizeof(tmp), "&#%d;", *p);
+        } else if (escape == 'u' && !(isalnum(*p) || strchr("/-_.~", *p))) {
+            snprintf(tmp, sizeof(tmp), "%%%02X", *p);
+        } else if (escape == 'j' && (*p == '"' || *p == '\\' || *p < 0x20)) {
+            snprintf(tmp, sizeof(tmp), "\\u%04x", *p);
+        } else {
+            tmp[0] = (char)*p;
+            tmp[1] = '\0';
+        }
+        listing_add(out, tmp);
+    }
+}
+
+static void listing_entry(fs_listing_t *out, const fs_request_t *req, const char *name,
+                          bool is_dir, int64_t size, bool first)
+{
+    char num[32];
+    if (req->json) {
+        listing_add(out, first ? "{\"name\":\"" : ",{\"name\":\"");
+        listing_add_escaped(out, name, 'j');
+        snprintf(num, sizeof(num), "%lld", (long long)size);
+        listing_add(out, "\",\"dir\":");
+        listing_add(out, is_dir ? "true" : "false");
+        listing_add(out, ",\"size\":");
+        listing_add(out, num);
+        listing_add(out, "}");
+    } else {
+        listing_add(out, "<tr><td><a href=\"");
+        listing_add_escaped(out, req->path, 'u');
+        if (req->path[strlen(req->path) - 1] != '/') listing_add(out, "/");
+        listing_add_escaped(out, name, 'u');
+        listing_add(out, is_dir ? "/\">" : "\">");
+        listing_add_escaped(out, name, 'h');
+        listing_add(out, is_dir ? "/</a></td><td></td></tr>\n" : "</a></td><td>");
+        if (!is_dir) {
+            snprintf(num, sizeof(num), "%lld</td></tr>\n", (long long)size);
+            listing_add(out, num);
+        }
+    }
+    listing_flush(out, false);
+}
+
+// dir == NULL lists the roots
+static bool send_listing(file_server_ctx_t *ctx, int sock, const fs_request_t *req, const char *dir)
+{
+    DIR *d = NULL;
+    if (dir) {
+        d = opendir(dir);
+        if (!d) return send_text(ctx, sock, req, 404, "Not found\n");
+    }
+
+    bool ok = send_header(ctx, sock, req, 200, req->json ? "application/json" : "text/html; charset=utf-8", -1, NULL);
+    if (strcmp(req->method, "HEAD") == 0) {
+        if (d) closedir(d);
+        return ok;
+    }
+    fs_listing_t out = { ctx, sock, 0, ok };
+
+    if (req->json) {
+        listing_add(&out, "[");
+    } else {
+        listing_add(&out, "<!DOCTYPE html><html><head><meta charset=\"utf-8\"><title>");
+        listing_add_escaped(&out, req->path, 'h');
+        listing_add(&out, "</title></head><body><h2>");
+        listing_add_escaped(&out, req->path, 'h');
+        listing_add(&out, "</h2>");
+        if (dir) {
+            listing_add(&out, "<form method=\"POST\" enctype=\"multipart/form-data\" action=\"");
+            listing_add_escaped(&out, req->path, 'u');
+            if (req->token[0]) {
+                listing_add(&out, "?token=");
+                listing_add_escaped(&out, req->token, 'u');
+            }
+            listing_add(&out, "\"><input type=\"file\" name=\"file\" multiple> "
+                              "<input type=\"submit\" value=\"Upload\"></form>"
+                              "<p><a href=\"..\">..</a></p>");
+        }
+        listing_add(&out, "<table><tr><th align=\"left\">Name</th><th align=\"left\">Size</th></tr>\n");
+    }
+
+    bool first = true;
+    if (d) {
+        char full[FS_LOCAL_LEN];
+        struct dirent *entry;
+        while (out.ok && (entry = readdir(d)) != NULL) {
+            if (entry->d_name[0] == '.') continue;     // Not reachable, see map_path()
+            struct stat st;
+            snprintf(full, sizeof(full), "%s/%s", dir, entry->d_name);
+            bool have_stat = stat(full, &st) == 0;
+            bool is_dir = have_stat ? S_ISDIR(st.st_mode) : entry->d_type == DT_DIR;
+            listing_entry(&out, req, entry->d_name, is_dir, have_stat && !is_dir ? st.st_size : 0, first);
+            first = false;
+        }
+        closedir(d);
+    } else {
+        for (int i = 0; i < ctx->root_count; i++) {
+            listing_entry(&out, req, ctx->roots[i].url + 1, true, 0, first);
+            first = false;
+        }
+    }
+
+    listing_add(&out, req->json ? "]\n" : "</table></body></html>\n");
+    listing_flush(&out, true);
+    return out.ok && send_chunk(ctx, sock, NULL, 0);
+}
+
+// ============ FILES ============
+
+static bool send_file(file_server_ctx_t *ctx, int sock, const fs_request_t *req, const char *local, int64_t size)
+{
+    int fd = open(local, O_RDONLY);
+    if (fd < 0) return send_text(ctx, sock, req, 404, "Not found\n");
+
+    int64_t start = 0, end = size - 1;
+    int status = 200;
+    char extra[96] = "Accept-Ranges: bytes\r\n";
+    if (req->has_range) {
+        if (req->range_start < 0) {
+            start = req->range_end < size ? size - req->range_end : 0;
+        } else {
+            start = req->range_start;
+            if (req->range_end >= 0 && req->range_end < end) end = req->range_end;
+        }
+        if (start >= size) {
+            close(fd);
+            snprintf(extra, sizeof(extra), "Content-Range: bytes */%lld\r\n", (long long)size);
+            return send_header(ctx, sock, req, 416, NULL, 0, extra);
+        }
+        status = 206;
+        snprintf(extra, sizeof(extra), "Accept-Ranges: bytes\r\nContent-Range: bytes %lld-%lld/%lld\r\n",
+                 (long long)start, (long long)end, (long long)size);
+    }
+
+    int64_t left = end - start + 1;
+    bool ok = send_header(ctx, sock, req, status, content_type(local), left, extra);
+    if (ok && strcmp(req->method, "HEAD") == 0) left = 0;
+    if (ok && start > 0 && lseek(fd, start, SEEK_SET) != start) ok = false;
+
+    while (ok && left > 0) {
+        size_t want = left < (int64_t)ctx->buf_size ? (size_t)left : ctx->buf_size;
+        ssize_t n = read(fd, ctx->buf, want);
+        if (n <= 0) {
+            ok = false;     // File shrank: the length already went out
+            break;
+        }
+        ok = send_all(ctx, sock, ctx->buf, n);
+        left -= n;
+    }
+    close(fd);
+    return ok;
+}
+
+// Bodies are written to "<path>.part" and renamed into place when complete
+static int open_part(const char *local, char *part, size_t len)
+{
+    if (snprintf(part, len, "%s.part", local) >= (int)len) return -1;
+    return open(part, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+static bool commit_part(const char *part, const char *local)
+{
+    unlink(local);      // FAT rename() does not replace
+    return rename(part, local) == 0;
+}
+
+static bool receive_put(file_server_ctx_t *ctx, int sock, fs_request_t *req, fs_body_t *body, const char *local)
+{
+    char part[FS_LOCAL_LEN + 8];
+    int fd = open_part(local, part, sizeof(part));
+    if (fd < 0) {
+        req->keep_alive = false;
+        return send_text(ctx, sock, req, 409, "Cannot create file\n");
+    }
+
+    bool ok = true;
+    while (ok) {
+        if (!body_fill(ctx, sock, body)) {
+            close(fd);
+            unlink(part);
+            return false;
+        }
+        if (body->len == 0) break;
+        ok = write_all(fd, ctx->buf, body->len);
+        body->len = 0;
+    }
+    close(fd);
+
+    if (!ok || !commit_part(part, local)) {
+        unlink(part);
+        req->keep_alive = false;
+        return send_text(ctx, sock, req, 507, "Write failed\n");
+    }
+    ctx->files_uploaded++;
+    return send_text(ctx, sock, req, 201, "Created\n");
+}
+
+enum {
+    MP_PREAMBLE = 0,    // Before the first delimiter
+    MP_AFTER_DELIM,     // "--" ends the body, CRLF starts a part
+    MP_HEADERS,         // Part headers up to the blank line
+    MP_DATA,            // Part content up to the next delimiter
+    MP_DONE
+};
+
+// Take the file name from a part's Content-Disposition, without any path
+static bool part_filename(char *headers, char *name, size_t len)
+{
+    char *fn = strcasestr(headers, "filename=\"");
+    if (!fn) return false;
+    fn += 10;
+    char *end = strchr(fn, '"');
+    if (!end) return false;
+    *end = '\0';
+    char *base = fn;
+    for (char *p = fn; *p; p++) {
+        if (*p == '/' || *p == '\\') base = p + 1;
+    }
+    if (base[0] == '\0' || base[0] == '.' || strlen(base) >= len) return false;
+    strcpy(name, base);
+    return true;
+}
+
+// multipart/form-data: every part with a filename becomes <dir>/<filename>
+static bool receive_multipart(file_server_ctx_t *ctx, int sock, fs_request_t *req, fs_body_t *body, const char *dir)
+{
+    char delim[FS_BOUNDARY_LEN + 4];
+    size_t delim_len = snprintf(delim, sizeof(delim), "\r\n--%s", req->boundary);
+
+    // The first delimiter has no leading CRLF: supply one
+    memmove(ctx->buf + 2, ctx->buf, body->len);
+    ctx->buf[0] = '\r';
+    ctx->buf[1] = '\n';
+    body->len += 2;
+
+    int state = MP_PREAMBLE;
+    int fd = -1;
+    char local[FS_LOCAL_LEN], part[FS_LOCAL_LEN + 8], name[96];
+    int saved = 0;
+    const char *error = NULL;
+
+    while (state != MP_DONE && !error) {
+        if (!body_fill(ctx, sock, body)) {
+            error = "";
+            break;
+        }
+        uint8_t *buf = ctx->buf;
+        size_t pos = 0;
+        bool need_more = false;
+
+        while (!need_more && state != MP_DONE && !error) {
+            size_t avail = body->len - pos;
+            if (state == MP_PREAMBLE || state == MP_DATA) {
+                const uint8_t *hit = find_bytes(buf + pos, avail, delim, delim_len);
+                size_t data_len = hit ? (size_t)(hit - (buf + pos)) :
+                                  avail > delim_len - 1 ? avail - (delim_len - 1) : 0;
+                if (body->remaining == 0 && !hit) {
+                    error = "Truncated multipart body\n";
+                    break;
+                }
+                if (state == MP_DATA && fd >= 0 && data_len > 0 && !write_all(fd, buf + pos, data_len)) {
+                    error = "Write failed\n";
+                    break;
+                }
+                pos += data_len;
+                if (!hit) {
+                    need_more = true;
+                } else {
+                    pos += delim_len;
+                    if (state == MP_DATA && fd >= 0) {
+                        close(fd);
+                        fd = -1;
+                        if (!commit_part(part, local)) {
+                            error = "Write failed\n";
+                            break;
+                        }
+                        saved++;
+                    }
+                    state = MP_AFTER_DELIM;
+                }
+            } else if (state == MP_AFTER_DELIM) {
+                if (avail < 2) {
+                    if (body->remaining == 0) error = "Truncated multipart body\n";
+                    need_more = true;
+                } else if (buf[pos] == '-' && buf[pos + 1] == '-') {
+                    state = MP_DONE;
+                } else if (buf[pos] == '\r' && buf[pos + 1] == '\n') {
+                    pos += 2;
+                    state = MP_HEADERS;
+                } else {
+                    error = "Bad multipart delimiter\n";
+                }
+            } else {    // MP_HEADERS
+                const uint8_t *hit = find_bytes(buf + pos, avail, "\r\n\r\n", 4);
+                if (!hit) {
+                    if (avail >= FILE_SERVER_MIN_BUF / 2 || body->remaining == 0) error = "Bad part headers\n";
+                    need_more = true;
+                    continue;
+                }
+                char *headers = (char *)buf + pos;
+                ((uint8_t *)hit)[0] = '\0';
+                pos = hit - buf + 4;
+                state = MP_DATA;
+                if (!part_filename(headers, name, sizeof(name))) continue;  // Form field: discarded
+                if (snprintf(local, sizeof(local), "%s/%s", dir, name) >= (int)sizeof(local) ||
+                    (fd = open_part(local, part, sizeof(part))) < 0) {
+                    error = "Cannot create file\n";
+                    break;
+                }
+            }
+        }
+
+        // Keep the unconsumed tail (a possible partial delimiter) at the front
+        memmove(buf, buf + pos, body->len - pos);
+        body->len -= pos;
+    }
+
+    if (fd >= 0) {
+        close(fd);
+        unlink(part);
+    }
+    ctx->files_uploaded += saved;
+
+    if (error) {
+        req->keep_alive = false;
+        return error[0] && send_text(ctx, sock, req, 400, error);
+    }
+    if (!body_drain(ctx, sock, body)) return false;
+
+    char msg[64];
+    snprintf(msg, sizeof(msg), "Uploaded %d file%s\n", saved, saved == 1 ? "" : "s");
+    return send_text(ctx, sock, req, 200, msg);
+}
+
+// ============ DISPATCH ============
+
+static bool handle_request(file_server_ctx_t *ctx, int sock, fs_request_t *req, fs_body_t *body)
+{
+    bool is_get = strcmp(req->method, "GET") == 0 || strcmp(req->method, "HEAD") == 0;
+    bool is_put = strcmp(req->method, "PUT") == 0;
+    bool is_post = strcmp(req->method, "POST") == 0;
+
+    // Bodies are only accepted with a length; anything else is not read
+    if (req->chunked || ((is_put || is_post) && req->content_length < 0)) {
+        req->keep_alive = false;
+        return send_text(ctx, sock, req, 411, "Content-Length required\n");
+    }
+    if (!is_put && !is_post && body->remaining > 0 && !body_drain(ctx, sock, body)) return false;
+
+    // Anything that changes storage needs the token; the body is not read
+    if (!is_get && !token_ok(ctx, req)) {
+        req->keep_alive = false;
+        static const char text[] = "Token required\n";
+        return send_header(ctx, sock, req, 401, "text/plain", sizeof(text) - 1, "WWW-Authenticate: Bearer\r\n") &&
+               send_all(ctx, sock, text, sizeof(text) - 1);
+    }
+
+    if (strcmp(req->path, "/") == 0) {
+        if (is_get) return send_listing(ctx, sock, req, NULL);
+        return send_text(ctx, sock, req, 405, "Method not allowed\n");
+    }
+
+    char local[FS_LOCAL_LEN];
+    if (!map_path(ctx, req->path, local, sizeof(local))) {
+        req->keep_alive = false;
+        return send_text(ctx, sock, req, 404, "Not found\n");
+    }
+
+    struct stat st;
+    bool exists = stat(local, &st) == 0;
+    bool is_dir = exists && S_ISDIR(st.st_mode);
+
+    if ((is_put || is_post) && req->expect_continue) {
+        static const char cont[] = "HTTP/1.1 100 Continue\r\n\r\n";
+        if (!send_all(ctx, sock, cont, sizeof(cont) - 1)) return false;
+    }
+
+    if (is_get) {
+        if (!exists) return send_text(ctx, sock, req, 404, "Not found\n");
+        if (is_dir) return send_listing(ctx, sock, req, local);
+        return send_file(ctx, sock, req, local, st.st_size);
+    }
+    if (is_put) {
+        if (is_dir) {
+            req->keep_alive = false;
+            return send_text(ctx, sock, req, 409, "Is a directory\n");
+        }
+        return receive_put(ctx, sock, req, body, local);
+    }
+    if (is_post) {
+        if (!is_dir || req->boundary[0] == '\0') {
+            req->keep_alive = false;
+            return send_text(ctx, sock, req, 400, "POST multipart/form-data to a directory\n");
+        }
+        return receive_multipart(ctx, sock, req, body, local);
+    }
+    if (strcmp(req->method, "DELETE") == 0) {
+        if (!exists) return send_text(ctx, sock, req, 404, "Not found\n");
+        if ((is_dir ? rmdir(local) : unlink(local)) != 0) {
+            return send_text(ctx, sock, req, 409, "Delete failed\n");
+        }
+        return send_header(ctx, sock, req, 204, NULL, 0, NULL);
+    }
+    return send_text(ctx, sock, req, 405, "Method not allowed\n");
+}
+
+void file_server_handle_connection(file_server_ctx_t *ctx, int sock)
+{
+    size_t len = 0;     // Bytes of the next request already in the buffer
+
+    while (!(ctx->stop && *ctx->stop)) {
+        // Read the request header; pipelined bytes from the previous
+        // request are already at the front of the buffer
+        set_recv_timeout(sock, ctx->idle_timeout_ms);
+        const uint8_t *end = NULL;
+        while (!(end = find_bytes(ctx->buf, len, "\r\n\r\n", 4))) {
+            if (len >= FILE_SERVER_MIN_BUF - 1) return;     // Header too large
+            ssize_t n = recv(sock, ctx->buf + len, FILE_SERVER_MIN_BUF - 1 - len, 0);
+            if (n <= 0) return;
+            len += n;
+            ctx->bytes_received += n;
+            set_recv_timeout(sock, FILE_SERVER_BODY_TIMEOUT_MS);
+        }
+
+        // Parse in place; fs_request_t keeps copies of what is needed, so
+        // the body can then take over the whole buffer
+        size_t head_len = end - ctx->buf + 4;
+        ctx->buf[head_len - 4] = '\0';
+
+        fs_request_t req;
+        if (!parse_request(&req, (char *)ctx->buf)) {
+            req.keep_alive = false;
+            strcpy(req.method, "GET");
+            send_text(ctx, sock, &req, 400, "Bad request\n");
+            return;
+        }
+
+        // Split what was read into this request's body and any next request
+        fs_body_t body;
+        int64_t body_len = req.content_length > 0 ? req.content_length : 0;
+        size_t extra = len - head_len;
+        size_t in_buf = (int64_t)extra < body_len ? extra : (size_t)body_len;
+        memmove(ctx->buf, ctx->buf + head_len, extra);
+        body.len = in_buf;
+        body.remaining = body_len - in_buf;
+        size_t pipelined = extra - in_buf;
+        if (pipelined > 0) req.keep_alive = false;  // Not supported: answer this one and close
+
+        set_recv_timeout(sock, FILE_SERVER_BODY_TIMEOUT_MS);
+        bool ok = handle_request(ctx, sock, &req, &body);
+        ctx->requests++;
+        if (!ok || !req.keep_alive) return;
+        len = 0;
+    }
+}
@@ -0,0 +1,64 @@
+/**
+ * Win32 OS - File Server Request Handling
+ * HTTP/1.1 on a connected socket: directory listings (HTML or ?json),
+ * GET/HEAD with single byte ranges, PUT of a raw body, multi-file
+ * multipart/form-data upload into a directory, and DELETE.
+ *
+ * PUT, POST and DELETE need the server token, either as
+ * "Authorization: Bearer <token>" or as ?token=<token> (the listing's
+ * upload form carries it over from the page URL). Path segments starting
+ * with a dot are never served.
+ *
+ * Uses only BSD sockets and POSIX file I/O (no stdio buffering, no
+ * per-request allocation): all transfers go through the caller's buffer,
+ * so it builds unchanged on a Linux host for testing with curl.
+ */
+
+#ifndef FILE_SERVER_HTTP_H
+#define FILE_SERVER_HTTP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FILE_SERVER_MIN_BUF         4096    // Also the request header limit
+#define FILE_SERVER_BODY_TIMEOUT_MS 10000
+#define FILE_SERVER_TOKEN_LEN       32      // Longest token accepted
+
+// URL prefix and the directory it serves
+typedef struct {
+    const char *url;            // e.g. "/sdcard"
+    const char *path;           // e.g. "/sdcard"
+} file_server_root_t;
+
+typedef struct {
+    const file_server_root_t *roots;
+    int root_count;
+    uint8_t *buf;               // I/O buffer, at least FILE_SERVER_MIN_BUF
+    size_t buf_size;
+    int idle_timeout_ms;        // Keep-alive wait for the next request
+    volatile bool *stop;        // Optional: end the connection between requests
+    const char *token;          // Required for writes; NULL or "" refuses them all
+
+    // Statistics, updated as requests complete
+    uint32_t requests;
+    uint32_t files_uploaded;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+} file_server_ctx_t;
+
+/**
+ * Serve requests on a connected socket until the peer closes, sends
+ * "Connection: close", errors out or stays idle. The socket is not closed.
+ */
+void file_server_handle_connection(file_server_ctx_t *ctx, int sock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FILE_SERVER_HTTP_H
@@ -412,6 +412,7 @@ void hw_sdcard_unmount(void)
 #define CAM_BUF_COUNT       2
 #define CAM_WIDTH           480           // Scaled for display
 #define CAM_HEIGHT          800           // Scaled for display
+#define CAM_BUS_WAIT_MS     100           // Touch read in progress on the shared bus
 
 static bool camera_initialized = false;
 static bool camera_video_initialized = false;
@@ -423,6 +424,16 @@ static uint32_t camera_height = 0;
 static struct v4l2_buffer current_v4l2_buf;
 static bool frame_acquired = false;
 
+// Calls that write sensor register sequences hold the shared I2C bus so
+// touch reads wait instead of landing in between
+static int camera_ioctl_locked(int request, void *arg)
+{
+    bool locked = gt911_bus_lock(CAM_BUS_WAIT_MS);
+    int ret = ioctl(camera_fd, request, arg);
+    if (locked) gt911_bus_unlock();
+    return ret;
+}
+
 esp_err_t hw_camera_init(void)
 {
     if (camera_initialized) return ESP_OK;
@@ -475,7 +486,9 @@ esp_err_t hw_camera_init(void)
         };
         
         ESP_LOGI(TAG, "Calling esp_video_init with init_sccb=%d", csi_config.sccb_config.init_sccb);
+        bool locked = gt911_bus_lock(CAM_BUS_WAIT_MS);
         esp_err_t ret = esp_video_init(&cam_config);
+        if (locked) gt911_bus_unlock();
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "esp_video_init failed: %s", esp_err_to_name(ret));
             ESP_LOGE(TAG, "Camera sensor may not be detected");
@@ -487,7 +500,9 @@ esp_err_t hw_camera_init(void)
     
     // Open video device
     ESP_LOGI(TAG, "Opening camera device: %s", ESP_VIDEO_MIPI_CSI_DEVICE_NAME);
+    bool locked = gt911_bus_lock(CAM_BUS_WAIT_MS);
     camera_fd = open(ESP_VIDEO_MIPI_CSI_DEVICE_NAME, O_RDONLY);
+    if (locked) gt911_bus_unlock();
     if (camera_fd < 0) {
         ESP_LOGE(TAG, "Failed to open camera device: %s", ESP_VIDEO_MIPI_CSI_DEVICE_NAME);
         ESP_LOGE(TAG, "errno: %d (%s)", errno, strerror(errno));
@@ -521,7 +536,7 @@ esp_err_t hw_camera_init(void)
     
     // Set RGB565 format for display compatibility
     fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_RGB565;
-    if (ioctl(camera_fd, VIDIOC_S_FMT, &fmt) != 0) {
+    if (camera_ioctl_locked(VIDIOC_S_FMT, &fmt) != 0) {
         ESP_LOGW(TAG, "Failed to set RGB565 format, using default");
     }
     
@@ -575,7 +590,7 @@ esp_err_t hw_camera_init(void)
     
     // Start streaming
     int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    if (ioctl(camera_fd, VIDIOC_STREAMON, &type) != 0) {
+    if (camera_ioctl_locked(VIDIOC_STREAMON, &type) != 0) {
         ESP_LOGE(TAG, "Failed to start camera stream");
         close(camera_fd);
         camera_fd = -1;
@@ -777,7 +792,7 @@ void hw_camera_deinit(void)
     
     if (camera_fd >= 0) {
         int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        ioctl(camera_fd, VIDIOC_STREAMOFF, &type);
+        camera_ioctl_locked(VIDIOC_STREAMOFF, &type);
         close(camera_fd);
         camera_fd = -1;
     }
@@ -0,0 +1,451 @@
+/**
+ * Win32 OS - Shared HTTP Client Service Implementation
+ * A small pool of esp_http_client handles, one host each. A handle is left
+ * connected after a fully read response and handed to the next request
+ * for the same host; each handle keeps its TLS session ticket so even a
+ * reconnect after the server's idle timeout resumes instead of redoing the
+ * full handshake.
+ */
+
+#include "http_service.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *TAG = "HTTP_SVC";
+
+#define HTTP_POOL_SIZE          4
+#define HTTP_POOL_IDLE_MS       30000   // Reconnect instead of trusting older connections
+#define HTTP_HOST_KEY_LEN       96
+#define HTTP_MAX_REDIRECTS      3
+#define HTTP_READ_CHUNK         2048
+#define HTTP_RX_BUFFER          2048
+#define HTTP_TX_BUFFER          1024
+#define HTTP_QUEUE_LEN          8
+#define HTTP_TASK_STACK         8192
+#define HTTP_TASK_PRIORITY      5
+
+// One pooled connection
+typedef struct {
+    esp_http_client_handle_t client;
+    char host[HTTP_HOST_KEY_LEN];   // "scheme://host[:port]" the handle is connected to
+    int64_t last_used_us;
+    bool in_use;
+    bool connected;                 // Left open by the last request
+    bool server_close;              // Response carried "Connection: close"
+    bool temporary;                 // Pool was full; freed after the request
+} http_conn_t;
+
+// Queued async request; strings and body are stored after the struct
+typedef struct {
+    http_service_request_t req;
+    http_service_header_t headers[HTTP_SERVICE_MAX_HEADERS];
+} http_job_t;
+
+static http_conn_t s_pool[HTTP_POOL_SIZE] = {};
+static SemaphoreHandle_t s_lock = NULL;
+static QueueHandle_t s_queue = NULL;
+static http_service_stats_t s_stats = {};
+
+// ============ CONNECTION POOL ============
+
+static void host_key(const char *url, char *out, size_t len)
+{
+    const char *sep = strstr(url, "://");
+    const char *authority = sep ? sep + 3 : url;
+    size_t n = (authority - url) + strcspn(authority, "/?#");
+    snprintf(out, len, "%.*s", (int)n, url);
+}
+
+static esp_err_t conn_event_handler(esp_http_client_event_t *evt)
+{
+    http_conn_t *conn = (http_conn_t *)evt->user_data;
+
+    if (evt->event_id == HTTP_EVENT_ON_HEADER && conn &&
+        strcasecmp(evt->header_key, "Connection") == 0 &&
+        strcasecmp(evt->header_value, "close") == 0) {
+        conn->server_close = true;
+    }
+    return ESP_OK;
+}
+
+static bool conn_create(http_conn_t *conn, const char *url)
+{
+    esp_http_client_config_t config = {};
+    config.url = url;
+    config.event_handler = conn_event_handler;
+    config.user_data = conn;
+    config.timeout_ms = HTTP_SERVICE_TIMEOUT_MS;
+    config.buffer_size = HTTP_RX_BUFFER;
+    config.buffer_size_tx = HTTP_TX_BUFFER;
+    // Certificate checks are disabled globally (CONFIG_ESP_TLS_INSECURE)
+    config.skip_cert_common_name_check = true;
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    config.save_client_session = true;
+#endif
+
+    conn->client = esp_http_client_init(&config);
+    conn->connected = false;
+    host_key(url, conn->host, sizeof(conn->host));
+    return conn->client != NULL;
+}
+
+// Counter updates from outside the pool lock
+static void stats_closed(void)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.open--;
+    xSemaphoreGive(s_lock);
+}
+
+static void conn_destroy(http_conn_t *conn)
+{
+    if (conn->client) {
+        esp_http_client_cleanup(conn->client);
+        if (conn->connected) stats_closed();
+    }
+    conn->client = NULL;
+    conn->connected = false;
+    conn->host[0] = '\0';
+}
+
+static http_conn_t *pool_acquire(const char *url)
+{
+    char key[HTTP_HOST_KEY_LEN];
+    host_key(url, key, sizeof(key));
+
+    http_conn_t *conn = NULL;
+    http_conn_t *victim = NULL;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < HTTP_POOL_SIZE; i++) {
+        http_conn_t *c = &s_pool[i];
+        if (c->in_use) continue;
+        if (c->client && strcasecmp(c->host, key) == 0) {
+            conn = c;
+            break;
+        }
+        // Prefer an empty slot, else the least recently used idle one
+        if (!victim || (victim->client && (!c->client || c->last_used_us < victim->last_used_us))) {
+            victim = c;
+        }
+    }
+    if (!conn) conn = victim;
+    if (conn) conn->in_use = true;
+    xSemaphoreGive(s_lock);
+
+    if (!conn) {
+        conn = (http_conn_t *)calloc(1, sizeof(http_conn_t));
+        if (!conn) return NULL;
+        conn->temporary = true;
+        conn->in_use = true;
+    }
+
+    if (conn->client && strcasecmp(conn->host, key) != 0) {
+        conn_destroy(conn);
+    }
+
+    if (!conn->client) {
+        if (!conn_create(conn, url)) {
+            ESP_LOGE(TAG, "Failed to init HTTP client");
+            if (conn->temporary) {
+                free(conn);
+            } else {
+                conn->in_use = false;
+            }
+            return NULL;
+        }
+    } else {
+        if (conn->connected && esp_timer_get_time() - conn->last_used_us > HTTP_POOL_IDLE_MS * 1000LL) {
+            esp_http_client_close(conn->client);
+            conn->connected = false;
+            stats_closed();
+        }
+        esp_http_client_set_url(conn->client, url);
+    }
+    return conn;
+}
+
+static void pool_release(http_conn_t *conn, bool keep)
+{
+    if (conn->connected && (!keep || conn->server_close)) {
+        esp_http_client_close(conn->client);
+        conn->connected = false;
+        stats_closed();
+    }
+
+    if (conn->temporary) {
+        conn_destroy(conn);
+        free(conn);
+        return;
+    }
+
+    // A redirect may have moved the handle to another host
+    char url[HTTP_HOST_KEY_LEN * 2];
+    if (esp_http_client_get_url(conn->client, url, sizeof(url)) == ESP_OK) {
+        host_key(url, conn->host, sizeof(conn->host));
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    conn->last_used_us = esp_timer_get_time();
+    conn->in_use = false;
+    xSemaphoreGive(s_lock);
+}
+
+void http_service_close_idle(void)
+{
+    if (!s_lock) return;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < HTTP_POOL_SIZE; i++) {
+        if (!s_pool[i].in_use && s_pool[i].connected) {
+            esp_http_client_close(s_pool[i].client);
+            s_pool[i].connected = false;
+            s_stats.open--;
+        }
+    }
+    xSemaphoreGive(s_lock);
+}
+
+// ============ REQUESTS ============
+
+// Send the request and read the response headers; a pooled connection the
+// server already dropped fails here, so retry once on a fresh one
+static esp_err_t open_request(http_conn_t *conn, const http_service_request_t *req,
+                              int64_t *content_length, bool *reused)
+{
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool was_connected = conn->connected;
+        conn->server_close = false;
+
+        esp_err_t err = esp_http_client_open(conn->client, (int)req->body_len);
+        if (err == ESP_OK && !was_connected) {
+            conn->connected = true;
+            xSemaphoreTake(s_lock, portMAX_DELAY);
+            s_stats.open++;
+            s_stats.connects++;
+            xSemaphoreGive(s_lock);
+        }
+        if (err == ESP_OK && req->body_len > 0 &&
+            esp_http_client_write(conn->client, req->body, (int)req->body_len) != (int)req->body_len) {
+            err = ESP_FAIL;
+        }
+        if (err == ESP_OK) {
+            int64_t len = esp_http_client_fetch_headers(conn->client);
+            if (len >= 0) {
+                *content_length = esp_http_client_is_chunked_response(conn->client) ? -1 : len;
+                *reused = *reused || was_connected;
+                return ESP_OK;
+            }
+            err = ESP_FAIL;
+        }
+
+        if (conn->connected) {
+            esp_http_client_close(conn->client);
+            conn->connected = false;
+            stats_closed();
+        }
+        if (!was_connected) return err;
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        s_stats.stale_retries++;
+        xSemaphoreGive(s_lock);
+    }
+    return ESP_FAIL;
+}
+
+static bool is_redirect(int status)
+{
+    return status == 301 || status == 302 || status == 303 || status == 307 || status == 308;
+}
+
+esp_err_t http_service_init(void)
+{
+    static portMUX_TYPE init_lock = portMUX_INITIALIZER_UNLOCKED;
+    if (s_lock) return ESP_OK;
+
+    // Boot creates it; should a request come first, two tasks may race
+    // here: the mutex is made outside the spinlock and only one is kept
+    SemaphoreHandle_t lock = xSemaphoreCreateMutex();
+    if (!lock) return ESP_ERR_NO_MEM;
+    portENTER_CRITICAL(&init_lock);
+    bool installed = s_lock == NULL;
+    if (installed) s_lock = lock;
+    portEXIT_CRITICAL(&init_lock);
+    if (!installed) vSemaphoreDelete(lock);
+    return ESP_OK;
+}
+
+esp_err_t http_service_perform(const http_service_request_t *req, http_service_result_t *result)
+{
+    if (!req || !req->url || req->header_count > HTTP_SERVICE_MAX_HEADERS) return ESP_ERR_INVALID_ARG;
+    if (http_service_init() != ESP_OK) return ESP_ERR_NO_MEM;
+
+    http_service_result_t res = {};
+    int64_t t0 = esp_timer_get_time();
+
+    http_conn_t *conn = pool_acquire(req->url);
+    if (!conn) return ESP_ERR_NO_MEM;
+
+    esp_http_client_handle_t client = conn->client;
+    esp_http_client_set_method(client, req->method);
+    esp_http_client_set_timeout_ms(client, req->timeout_ms ? req->timeout_ms : HTTP_SERVICE_TIMEOUT_MS);
+    for (int i = 0; i < req->header_count; i++) {
+        esp_http_client_set_header(client, req->headers[i].name, req->headers[i].value);
+    }
+
+    esp_err_t err = ESP_FAIL;
+    for (int redirects = 0; ; redirects++) {
+        err = open_request(conn, req, &res.content_length, &res.reused);
+        if (err != ESP_OK) break;
+
+        res.status = esp_http_client_get_status_code(client);
+        if (!is_redirect(res.status) || redirects >= HTTP_MAX_REDIRECTS) break;
+
+        esp_http_client_flush_response(client, NULL);
+        if (esp_http_client_set_redirection(client) != ESP_OK) break;
+        ESP_LOGD(TAG, "Redirect %d", res.status);
+    }
+
+    bool complete = false;
+    if (err == ESP_OK) {
+        if (req->on_headers && req->on_headers(res.status, res.content_length, req->user) < 0) {
+            res.aborted = true;
+        } else {
+            char *buf = (char *)malloc(HTTP_READ_CHUNK);
+            if (!buf) {
+                err = ESP_ERR_NO_MEM;
+            } else {
+                int n;
+                while ((n = esp_http_client_read(client, buf, HTTP_READ_CHUNK)) > 0) {
+                    res.bytes += n;
+                    if (req->on_body && req->on_body(buf, n, req->user) < 0) {
+                        res.aborted = true;
+                        break;
+                    }
+                }
+                if (n < 0) err = ESP_FAIL;
+                free(buf);
+            }
+            complete = !res.aborted && err == ESP_OK && esp_http_client_is_complete_data_received(client);
+        }
+    }
+
+    // Headers stick to the handle; don't leak them into the next request
+    for (int i = 0; i < req->header_count; i++) {
+        esp_http_client_delete_header(client, req->headers[i].name);
+    }
+
+    // Only a fully drained response leaves the connection reusable
+    pool_release(conn, complete);
+
+    res.elapsed_us = esp_timer_get_time() - t0;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.requests++;
+    s_stats.bytes += res.bytes;
+    if (res.reused) s_stats.reused++;
+    if (err != ESP_OK) s_stats.failures++;
+    xSemaphoreGive(s_lock);
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "%s failed: %s", req->url, esp_err_to_name(err));
+    } else {
+        ESP_LOGD(TAG, "%s -> %d, %llu bytes in %lld ms%s", req->url, res.status,
+                 (unsigned long long)res.bytes, (long long)(res.elapsed_us / 1000),
+                 res.reused ? " (reused)" : "");
+    }
+
+    if (result) *result = res;
+    return err;
+}
+
+// ============ ASYNC ============
+
+static void http_service_task(void *arg)
+{
+    (void)arg;
+    http_job_t *job;
+
+    for (;;) {
+        if (xQueueReceive(s_queue, &job, portMAX_DELAY) != pdTRUE) continue;
+
+        http_service_result_t result = {};
+        esp_err_t err = http_service_perform(&job->req, &result);
+        if (job->req.on_done) job->req.on_done(err, &result, job->req.user);
+        free(job);
+    }
+}
+
+static char *copy_str(char **dst, const char *src)
+{
+    char *out = *dst;
+    size_t n = strlen(src) + 1;
+    memcpy(out, src, n);
+    *dst += n;
+    return out;
+}
+
+esp_err_t http_service_perform_async(const http_service_request_t *req)
+{
+    if (!req || !req->url || req->header_count > HTTP_SERVICE_MAX_HEADERS) return ESP_ERR_INVALID_ARG;
+    if (http_service_init() != ESP_OK) return ESP_ERR_NO_MEM;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (!s_queue) {
+        s_queue = xQueueCreate(HTTP_QUEUE_LEN, sizeof(http_job_t *));
+        if (s_queue && xTaskCreate(http_service_task, "http_svc", HTTP_TASK_STACK, NULL,
+                                   HTTP_TASK_PRIORITY, NULL) != pdPASS) {
+            vQueueDelete(s_queue);
+            s_queue = NULL;
+        }
+    }
+    xSemaphoreGive(s_lock);
+    if (!s_queue) return ESP_ERR_NO_MEM;
+
+    // One allocation holds the job and copies of everything it points to
+    size_t size = sizeof(http_job_t) + strlen(req->url) + 1 + req->body_len;
+    for (int i = 0; i < req->header_count; i++) {
+        size += strlen(req->headers[i].name) + strlen(req->headers[i].value) + 2;
+    }
+
+    http_job_t *job = (http_job_t *)malloc(size);
+    if (!job) return ESP_ERR_NO_MEM;
+
+    char *p = (char *)(job + 1);
+    job->req = *req;
+    job->req.url = copy_str(&p, req->url);
+    for (int i = 0; i < req->header_count; i++) {
+        job->headers[i].name = copy_str(&p, req->headers[i].name);
+        job->headers[i].value = copy_str(&p, req->headers[i].value);
+    }
+    job->req.headers = job->headers;
+    if (req->body_len) {
+        memcpy(p, req->body, req->body_len);
+        job->req.body = p;
+    }
+
+    if (xQueueSend(s_queue, &job, 0) != pdTRUE) {
+        free(job);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void http_service_get_stats(http_service_stats_t *stats)
+{
+    if (!stats) return;
+    if (!s_lock) {
+        *stats = s_stats;
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_lock);
+}
@@ -0,0 +1,120 @@
+/**
+ * Win32 OS - Shared HTTP Client Service
+ * Pools keep-alive connections per host so repeated requests skip the
+ * TCP connect and TLS handshake; when a pooled connection has to be
+ * re-opened its saved TLS session ticket is used for an abbreviated
+ * handshake. Response bodies are streamed to a callback in chunks.
+ *
+ * Requests run either in the calling task (http_service_perform) or on
+ * the service task (http_service_perform_async).
+ */
+
+#ifndef HTTP_SERVICE_H
+#define HTTP_SERVICE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_http_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTTP_SERVICE_MAX_HEADERS    4
+#define HTTP_SERVICE_TIMEOUT_MS     10000   // Default per-request timeout
+
+typedef struct {
+    const char *name;
+    const char *value;
+} http_service_header_t;
+
+// Outcome of one request
+typedef struct {
+    int status;                 // HTTP status of the final response (after redirects)
+    int64_t content_length;     // -1 if chunked or unknown
+    uint64_t bytes;             // Body bytes delivered
+    int64_t elapsed_us;         // Acquire to last byte
+    bool reused;                // Served on a kept-alive connection
+    bool aborted;               // A callback returned < 0
+} http_service_result_t;
+
+/**
+ * Called once the final response headers are in; return < 0 to abort
+ * (e.g. unexpected status). The connection is then closed, not pooled.
+ */
+typedef int (*http_service_headers_cb_t)(int status, int64_t content_length, void *user);
+
+/**
+ * Called for each body chunk; return < 0 to abort
+ */
+typedef int (*http_service_body_cb_t)(const char *data, size_t len, void *user);
+
+/**
+ * Async completion, runs on the service task
+ */
+typedef void (*http_service_done_cb_t)(esp_err_t err, const http_service_result_t *result, void *user);
+
+typedef struct {
+    const char *url;
+    esp_http_client_method_t method;    // HTTP_METHOD_GET if zero-initialised
+    const http_service_header_t *headers;
+    int header_count;                   // Up to HTTP_SERVICE_MAX_HEADERS
+    const char *body;                   // Request body (POST/PUT), may be NULL
+    size_t body_len;
+    int timeout_ms;                     // 0 = HTTP_SERVICE_TIMEOUT_MS
+    http_service_headers_cb_t on_headers;
+    http_service_body_cb_t on_body;
+    http_service_done_cb_t on_done;     // Async only
+    void *user;
+} http_service_request_t;
+
+// Counters since boot
+typedef struct {
+    uint32_t requests;
+    uint32_t failures;
+    uint32_t connects;          // New TCP/TLS connections opened
+    uint32_t reused;            // Requests that skipped connect + handshake
+    uint32_t stale_retries;     // Pooled connection found closed by the server
+    uint32_t open;              // Connections currently held open
+    uint64_t bytes;
+} http_service_stats_t;
+
+/**
+ * Create the pool lock; called once at boot (the other functions also
+ * create it on first use, safely from any task)
+ */
+esp_err_t http_service_init(void);
+
+/**
+ * Run a request in the calling task, streaming the body to req->on_body
+ * Follows up to 3 redirects.
+ * @param result Receives status and timing (may be NULL)
+ * @return ESP_OK if a response was received (check result->status),
+ *         ESP_ERR_NO_MEM or ESP_FAIL on connection errors
+ */
+esp_err_t http_service_perform(const http_service_request_t *req, http_service_result_t *result);
+
+/**
+ * Queue a request for the service task
+ * URL, headers and body are copied; callbacks run on the service task.
+ * @return ESP_OK if queued
+ */
+esp_err_t http_service_perform_async(const http_service_request_t *req);
+
+/**
+ * Close every idle pooled connection (e.g. after Wi-Fi drops)
+ */
+void http_service_close_idle(void);
+
+/**
+ * Get request and connection counters
+ */
+void http_service_get_stats(http_service_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HTTP_SERVICE_H
@@ -0,0 +1,480 @@
+/**
+ * Win32 OS - iperf Throughput Test Implementation
+ * Speaks the iperf 2 wire format: TCP is a plain byte stream; UDP datagrams
+ * start with a sequence number and send time, the client ends with a
+ * negative sequence number and the server answers it with its report
+ * (bytes, jitter, loss) so the desktop side prints the board's view too.
+ */
+
+#include "iperf.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <sys/time.h>
+
+static const char *TAG = "IPERF";
+
+#define IPERF_TASK_STACK        4096
+#define IPERF_TASK_PRIORITY     4
+#define IPERF_TCP_LEN           (16 * 1024)
+#define IPERF_UDP_LEN           1470
+#define IPERF_UDP_MAX_LEN       65507   // Largest IPv4 UDP payload
+#define IPERF_SOCKET_TIMEOUT_MS 1000    // Lets blocking calls notice iperf_stop()
+#define IPERF_UDP_IDLE_US       2000000 // UDP stream without FIN counts as ended
+#define IPERF_UDP_FIN_TRIES     10
+#define IPERF_HEADER_VERSION1   0x80000000
+
+// iperf 2 UDP datagram header (network byte order)
+typedef struct {
+    int32_t id;
+    uint32_t tv_sec;
+    uint32_t tv_usec;
+} iperf_udp_hdr_t;
+
+// iperf 2 server report, sent back after the client's FIN datagram
+typedef struct {
+    int32_t flags;
+    int32_t total_len1;
+    int32_t total_len2;
+    int32_t stop_sec;
+    int32_t stop_usec;
+    int32_t error_cnt;
+    int32_t outorder_cnt;
+    int32_t datagrams;
+    int32_t jitter1;
+    int32_t jitter2;
+} iperf_server_report_t;
+
+// Byte counter with interval reports
+typedef struct {
+    int64_t start_us;
+    int64_t last_us;
+    uint64_t total;
+    uint64_t last_total;
+} iperf_meter_t;
+
+static iperf_config_t s_cfg;
+static iperf_report_cb_t s_report = NULL;
+static uint8_t *s_buf = NULL;
+static volatile bool s_running = false;
+static volatile bool s_stop = false;
+
+static void report(const char *fmt, ...)
+{
+    char line[160];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    ESP_LOGI(TAG, "%s", line);
+    if (s_report) s_report(line);
+}
+
+static void set_timeout(int sock, int opt, int ms)
+{
+    struct timeval tv;
+    tv.tv_sec = ms / 1000;
+    tv.tv_usec = (ms % 1000) * 1000;
+    setsockopt(sock, SOL_SOCKET, opt, &tv, sizeof(tv));
+}
+
+// ============ REPORTING ============
+
+static void meter_start(iperf_meter_t *m)
+{
+    memset(m, 0, sizeof(*m));
+    m->start_us = m->last_us = esp_timer_get_time();
+}
+
+static void print_span(int64_t from_us, int64_t to_us, uint64_t bytes, const char *suffix)
+{
+    double secs = (to_us - from_us) / 1e6;
+    double mbits = secs > 0 ? bytes * 8.0 / secs / 1e6 : 0;
+    report("%5.1f-%5.1f sec  %7.2f MBytes  %6.2f Mbits/sec%s\n",
+           from_us / 1e6, to_us / 1e6, bytes / 1048576.0, mbits, suffix ? suffix : "");
+}
+
+static void meter_tick(iperf_meter_t *m, int64_t now)
+{
+    if (s_cfg.interval_s == 0 || now - m->last_us < (int64_t)s_cfg.interval_s * 1000000) return;
+    print_span(m->last_us - m->start_us, now - m->start_us, m->total - m->last_total, NULL);
+    m->last_us = now;
+    m->last_total = m->total;
+}
+
+// ============ CLIENT ============
+
+static void tcp_client(const struct sockaddr_in *addr)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        report("socket() failed: errno %d\n", errno);
+        return;
+    }
+    set_timeout(sock, SO_SNDTIMEO, IPERF_SOCKET_TIMEOUT_MS);
+
+    if (connect(sock, (const struct sockaddr *)addr, sizeof(*addr)) != 0) {
+        report("connect failed: errno %d\n", errno);
+        close(sock);
+        return;
+    }
+    report("Connected to %s port %u (TCP, %lu byte writes)\n",
+           s_cfg.host, s_cfg.port, (unsigned long)s_cfg.len);
+
+    iperf_meter_t m;
+    meter_start(&m);
+    int64_t end_us = m.start_us + (int64_t)s_cfg.time_s * 1000000;
+    int64_t now = m.start_us;
+
+    while (!s_stop && now < end_us) {
+        int n = send(sock, s_buf, s_cfg.len, 0);
+        now = esp_timer_get_time();
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) continue;
+            report("send failed: errno %d\n", errno);
+            break;
+        }
+        m.total += n;
+        meter_tick(&m, now);
+    }
+    close(sock);
+    print_span(0, now - m.start_us, m.total, " (sender)\n");
+}
+
+static void udp_client(const struct sockaddr_in *addr)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        report("socket() failed: errno %d\n", errno);
+        return;
+    }
+
+    uint32_t len = s_cfg.len;     // Clamped to the buffer in iperf_start()
+    int64_t period_us = (int64_t)len * 8 * 1000000 / s_cfg.bandwidth_bps;
+    report("Sending to %s port %u (UDP, %lu byte datagrams, %lu kbit/s)\n",
+           s_cfg.host, s_cfg.port, (unsigned long)len, (unsigned long)(s_cfg.bandwidth_bps / 1000));
+
+    iperf_meter_t m;
+    meter_start(&m);
+    int64_t end_us = m.start_us + (int64_t)s_cfg.time_s * 1000000;
+    int64_t next_us = m.start_us;
+    int64_t now = m.start_us;
+    int32_t seq = 0;
+    iperf_udp_hdr_t *hdr = (iperf_udp_hdr_t *)s_buf;
+
+    while (!s_stop && now < end_us) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        hdr->id = htonl(seq);
+        hdr->tv_sec = htonl((uint32_t)tv.tv_sec);
+        hdr->tv_usec = htonl((uint32_t)tv.tv_usec);
+
+        int n = sendto(sock, s_buf, len, 0, (const struct sockaddr *)addr, sizeof(*addr));
+        now = esp_timer_get_time();
+        if (n < 0) {
+            if (errno == ENOMEM || errno == ENOBUFS) {
+                // lwIP out of pbufs: the link is saturated, back off a tick
+                vTaskDelay(1);
+                continue;
+            }
+            report("sendto failed: errno %d\n", errno);
+            break;
+        }
+        seq++;
+        m.total += n;
+        meter_tick(&m, now);
+
+        // Pace to the target rate; sub-tick gaps are absorbed by the next send
+        next_us += period_us;
+        int64_t wait_us = next_us - now;
+        if (wait_us >= 1000) {
+            vTaskDelay(pdMS_TO_TICKS(wait_us / 1000));
+            now = esp_timer_get_time();
+        }
+    }
+    print_span(0, now - m.start_us, m.total, NULL);
+    report("Sent %ld datagrams\n", (long)seq);
+
+    // FIN: negative sequence number, repeated until the server reports back
+    set_timeout(sock, SO_RCVTIMEO, 250);
+    hdr->id = htonl(-seq);
+    bool acked = false;
+    for (int i = 0; i < IPERF_UDP_FIN_TRIES && !acked; i++) {
+        sendto(sock, s_buf, len, 0, (const struct sockaddr *)addr, sizeof(*addr));
+        int n = recv(sock, s_buf, len, 0);
+        if (n >= (int)(sizeof(iperf_udp_hdr_t) + sizeof(iperf_server_report_t))) {
+            acked = true;
+            iperf_server_report_t rep;
+            memcpy(&rep, s_buf + sizeof(iperf_udp_hdr_t), sizeof(rep));
+            if (ntohl(rep.flags) & IPERF_HEADER_VERSION1) {
+                uint64_t bytes = ((uint64_t)ntohl(rep.total_len1) << 32) | ntohl(rep.total_len2);
+                int32_t datagrams = ntohl(rep.datagrams);
+                int32_t lost = ntohl(rep.error_cnt);
+                report("Server report: %.2f MBytes, jitter %.3f ms, lost %ld/%ld\n",
+                       bytes / 1048576.0,
+                       ntohl(rep.jitter1) * 1000.0 + ntohl(rep.jitter2) / 1000.0,
+                       (long)lost, (long)datagrams);
+            }
+        }
+    }
+    if (!acked) report("No report from server\n");
+    close(sock);
+}
+
+// ============ SERVER ============
+
+static int server_socket(int type)
+{
+    int sock = socket(AF_INET, type, type == SOCK_STREAM ? IPPROTO_TCP : IPPROTO_UDP);
+    if (sock < 0) {
+        report("socket() failed: errno %d\n", errno);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(s_cfg.port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        (type == SOCK_STREAM && listen(sock, 1) != 0)) {
+        report("bind/listen on port %u failed: errno %d\n", s_cfg.port, errno);
+        close(sock);
+        return -1;
+    }
+    set_timeout(sock, SO_RCVTIMEO, IPERF_SOCKET_TIMEOUT_MS);
+    return sock;
+}
+
+static void tcp_server(void)
+{
+    int listen_sock = server_socket(SOCK_STREAM);
+    if (listen_sock < 0) return;
+    report("Server listening on TCP port %u\n", s_cfg.port);
+
+    while (!s_stop) {
+        struct sockaddr_in peer;
+        socklen_t peer_len = sizeof(peer);
+        int sock = accept(listen_sock, (struct sockaddr *)&peer, &peer_len);
+        if (sock < 0) continue;     // Timeout: check s_stop
+
+        char ip[16];
+        inet_ntoa_r(peer.sin_addr, ip, sizeof(ip));
+        report("Connection from %s port %u\n", ip, ntohs(peer.sin_port));
+        set_timeout(sock, SO_RCVTIMEO, IPERF_SOCKET_TIMEOUT_MS);
+
+        iperf_meter_t m;
+        meter_start(&m);
+        int64_t now = m.start_us;
+        while (!s_stop) {
+            int n = recv(sock, s_buf, s_cfg.len, 0);
+            now = esp_timer_get_time();
+            if (n > 0) {
+                m.total += n;
+                meter_tick(&m, now);
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                meter_tick(&m, now);
+            } else {
+                break;
+            }
+        }
+        close(sock);
+        print_span(0, now - m.start_us, m.total, " (receiver)\n");
+    }
+    close(listen_sock);
+}
+
+// Receiver state of one UDP stream
+typedef struct {
+    bool active;
+    struct sockaddr_in peer;
+    iperf_meter_t meter;
+    int64_t last_rx_us;
+    int32_t next_id;
+    uint32_t datagrams;
+    uint32_t lost;
+    uint32_t out_of_order;
+    double jitter_us;           // RFC 3550 interarrival jitter
+    int64_t last_transit_us;
+} udp_stream_t;
+
+static void udp_stream_end(int sock, udp_stream_t *st, bool send_report, int64_t now)
+{
+    int64_t dur_us = now - st->meter.start_us;
+    uint32_t expected = st->datagrams + st->lost;
+    char suffix[80];
+    snprintf(suffix, sizeof(suffix), "  %.3f ms  %lu/%lu (%.1f%%)\n",
+             st->jitter_us / 1000.0, (unsigned long)st->lost, (unsigned long)expected,
+             expected ? 100.0 * st->lost / expected : 0.0);
+    print_span(0, dur_us, st->meter.total, suffix);
+    if (st->out_of_order) report("%lu datagrams out of order\n", (unsigned long)st->out_of_order);
+
+    if (send_report) {
+        // Echo the FIN header followed by our statistics
+        iperf_server_report_t rep = {};
+        rep.flags = htonl(IPERF_HEADER_VERSION1);
+        rep.total_len1 = htonl((uint32_t)(st->meter.total >> 32));
+        rep.total_len2 = htonl((uint32_t)(st->meter.total & 0xFFFFFFFF));
+        rep.stop_sec = htonl((uint32_t)(dur_us / 1000000));
+        rep.stop_usec = htonl((uint32_t)(dur_us % 1000000));
+        rep.error_cnt = htonl(st->lost);
+        rep.outorder_cnt = htonl(st->out_of_order);
+        rep.datagrams = htonl(st->next_id);
+        rep.jitter1 = htonl((uint32_t)(st->jitter_us / 1000000));
+        rep.jitter2 = htonl((uint32_t)((int64_t)st->jitter_us % 1000000));
+        memcpy(s_buf + sizeof(iperf_udp_hdr_t), &rep, sizeof(rep));
+        sendto(sock, s_buf, sizeof(iperf_udp_hdr_t) + sizeof(rep), 0,
+               (struct sockaddr *)&st->peer, sizeof(st->peer));
+    }
+    st->active = false;
+}
+
+static void udp_server(void)
+{
+    int sock = server_socket(SOCK_DGRAM);
+    if (sock < 0) return;
+    report("Server listening on UDP port %u\n", s_cfg.port);
+
+    udp_stream_t st = {};
+    while (!s_stop) {
+        struct sockaddr_in peer;
+        socklen_t peer_len = sizeof(peer);
+        int n = recvfrom(sock, s_buf, s_cfg.len, 0, (struct sockaddr *)&peer, &peer_len);
+        int64_t now = esp_timer_get_time();
+
+        if (n < (int)sizeof(iperf_udp_hdr_t)) {
+            if (st.active && now - st.last_rx_us > IPERF_UDP_IDLE_US) {
+                udp_stream_end(sock, &st, false, st.last_rx_us);
+            }
+            continue;
+        }
+
+        const iperf_udp_hdr_t *hdr = (const iperf_udp_hdr_t *)s_buf;
+        int32_t id = (int32_t)ntohl(hdr->id);
+
+        if (!st.active) {
+            // FIN retry for a stream that already ended
+            if (id < 0) continue;
+            memset(&st, 0, sizeof(st));
+            st.active = true;
+            st.peer = peer;
+            meter_start(&st.meter);
+            char ip[16];
+            inet_ntoa_r(peer.sin_addr, ip, sizeof(ip));
+            report("UDP stream from %s port %u\n", ip, ntohs(peer.sin_port));
+        }
+        st.last_rx_us = now;
+
+        if (id < 0) {
+            udp_stream_end(sock, &st, true, now);
+            continue;
+        }
+
+        st.meter.total += n;
+        st.datagrams++;
+        if (id >= st.next_id) {
+            st.lost += id - st.next_id;
+            st.next_id = id + 1;
+        } else {
+            st.out_of_order++;
+            if (st.lost > 0) st.lost--;
+        }
+
+        // Transit time carries the clock offset between the hosts, but only
+        // its variation is used
+        int64_t sent_us = (int64_t)ntohl(hdr->tv_sec) * 1000000 + ntohl(hdr->tv_usec);
+        int64_t transit = now - sent_us;
+        if (st.datagrams > 1) {
+            int64_t d = transit - st.last_transit_us;
+            if (d < 0) d = -d;
+            st.jitter_us += (d - st.jitter_us) / 16.0;
+        }
+        st.last_transit_us = transit;
+
+        meter_tick(&st.meter, now);
+    }
+    if (st.active) udp_stream_end(sock, &st, false, st.last_rx_us);
+    close(sock);
+}
+
+// ============ TASK ============
+
+static void iperf_task(void *arg)
+{
+    if (s_cfg.server) {
+        if (s_cfg.udp) udp_server();
+        else tcp_server();
+    } else {
+        struct addrinfo hints = {};
+        struct addrinfo *res = NULL;
+        hints.ai_family = AF_INET;
+        if (getaddrinfo(s_cfg.host, NULL, &hints, &res) != 0 || !res) {
+            report("Could not resolve %s\n", s_cfg.host);
+        } else {
+            struct sockaddr_in addr;
+            memcpy(&addr, res->ai_addr, sizeof(addr));
+            addr.sin_port = htons(s_cfg.port);
+            freeaddrinfo(res);
+            if (s_cfg.udp) udp_client(&addr);
+            else tcp_client(&addr);
+        }
+    }
+
+    report("iperf done\n");
+    free(s_buf);
+    s_buf = NULL;
+    s_running = false;
+    vTaskDelete(NULL);
+}
+
+esp_err_t iperf_start(const iperf_config_t *config, iperf_report_cb_t report_cb)
+{
+    if (s_running) return ESP_ERR_INVALID_STATE;
+
+    s_cfg = *config;
+    if (s_cfg.port == 0) s_cfg.port = IPERF_DEFAULT_PORT;
+    if (s_cfg.time_s == 0) s_cfg.time_s = IPERF_DEFAULT_TIME_S;
+    if (s_cfg.bandwidth_bps == 0) s_cfg.bandwidth_bps = IPERF_DEFAULT_UDP_BW;
+    if (s_cfg.len == 0) s_cfg.len = s_cfg.udp ? IPERF_UDP_LEN : IPERF_TCP_LEN;
+    if (s_cfg.udp) {
+        // A server must take the largest datagram the peer may send; a
+        // client's datagrams carry the header and must fit the server report
+        uint32_t min_len = sizeof(iperf_udp_hdr_t) + sizeof(iperf_server_report_t);
+        if (s_cfg.server || s_cfg.len > IPERF_UDP_MAX_LEN) s_cfg.len = IPERF_UDP_MAX_LEN;
+        else if (s_cfg.len < min_len) s_cfg.len = min_len;
+    }
+
+    s_buf = (uint8_t *)malloc(s_cfg.len);
+    if (!s_buf) return ESP_ERR_NO_MEM;
+    memset(s_buf, 0, s_cfg.len);
+
+    s_report = report_cb;
+    s_stop = false;
+    s_running = true;
+    if (xTaskCreate(iperf_task, "iperf", IPERF_TASK_STACK, NULL, IPERF_TASK_PRIORITY, NULL) != pdPASS) {
+        free(s_buf);
+        s_buf = NULL;
+        s_running = false;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void iperf_stop(void)
+{
+    if (s_running) s_stop = true;
+}
+
+bool iperf_is_running(void)
+{
+    return s_running;
+}
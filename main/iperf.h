@@ -0,0 +1,58 @@
+/**
+ * Win32 OS - iperf Throughput Test
+ * TCP/UDP client and server compatible with desktop iperf 2
+ * (iperf -s / iperf -c <board> [-u]). One test runs at a time on its own
+ * task; interval and summary lines are handed to a report callback.
+ */
+
+#ifndef IPERF_H
+#define IPERF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IPERF_DEFAULT_PORT      5001
+#define IPERF_DEFAULT_TIME_S    10
+#define IPERF_DEFAULT_UDP_BW    (1000 * 1000)   // bits/s, iperf 2 default
+
+typedef struct {
+    bool server;
+    bool udp;
+    char host[64];              // Client: server address
+    uint16_t port;              // 0 = IPERF_DEFAULT_PORT
+    uint32_t time_s;            // Client: test length, 0 = IPERF_DEFAULT_TIME_S
+    uint32_t interval_s;        // Report interval, 0 = summary only
+    uint32_t bandwidth_bps;     // UDP client target rate, 0 = IPERF_DEFAULT_UDP_BW
+    uint32_t len;               // Bytes per send, 0 = 16 KB TCP / 1470 UDP
+} iperf_config_t;
+
+/**
+ * Receives each report line. Runs on the iperf task without the LVGL
+ * lock, so it must only queue the line (the console uses
+ * console_print_async)
+ */
+typedef void (*iperf_report_cb_t)(const char *line);
+
+/**
+ * Start a client or server test in the background
+ * @return ESP_OK if started, ESP_ERR_INVALID_STATE if a test is running
+ */
+esp_err_t iperf_start(const iperf_config_t *config, iperf_report_cb_t report);
+
+/**
+ * Ask the running test to finish (it prints its summary first)
+ */
+void iperf_stop(void);
+
+bool iperf_is_running(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IPERF_H
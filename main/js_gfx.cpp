@@ -0,0 +1,552 @@
+/**
+ * Win32 OS - JavaScript Graphics Implementation
+ * Commands are clipped to the surface when drawn, not when recorded, so
+ * recording stays a bounds check and a 16-byte store per call.
+ */
+
+#include "js_gfx.h"
+#include "duktape_esp32.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define STASH_KEY       "gfx"
+
+static inline uint16_t rgb565(uint32_t rgb)
+{
+    return (uint16_t)(((rgb >> 8) & 0xF800) | ((rgb >> 5) & 0x07E0) | ((rgb >> 3) & 0x001F));
+}
+
+static inline int16_t clamp16(int v)
+{
+    return (int16_t)(v < -32768 ? -32768 : v > 32767 ? 32767 : v);
+}
+
+// ============ SURFACE ============
+
+js_gfx_t *js_gfx_create(int width, int height)
+{
+    js_gfx_t *gfx = (js_gfx_t *)calloc(1, sizeof(js_gfx_t));
+    if (!gfx) return NULL;
+    gfx->width = (uint16_t)width;
+    gfx->height = (uint16_t)height;
+    for (int i = 0; i < 2; i++) {
+        gfx->batch[i].cmds = (js_gfx_cmd_t *)heap_caps_malloc(JS_GFX_MAX_CMDS * sizeof(js_gfx_cmd_t), MALLOC_CAP_SPIRAM);
+        gfx->batch[i].data = (uint8_t *)heap_caps_malloc(JS_GFX_DATA_SIZE, MALLOC_CAP_SPIRAM);
+        if (!gfx->batch[i].cmds || !gfx->batch[i].data) {
+            js_gfx_destroy(gfx);
+            return NULL;
+        }
+    }
+    gfx->rec = &gfx->batch[0];
+    gfx->ready = &gfx->batch[1];
+    return gfx;
+}
+
+void js_gfx_destroy(js_gfx_t *gfx)
+{
+    if (!gfx) return;
+    for (int i = 0; i < 2; i++) {
+        heap_caps_free(gfx->batch[i].cmds);
+        heap_caps_free(gfx->batch[i].data);
+    }
+    free(gfx);
+}
+
+void js_gfx_reset(js_gfx_t *gfx)
+{
+    gfx->rec->count = 0;
+    gfx->rec->data_len = 0;
+    gfx->ready->count = 0;
+    gfx->ready->data_len = 0;
+    gfx->waiter = NULL;
+    __atomic_store_n(&gfx->ready_full, 0, __ATOMIC_RELEASE);
+}
+
+js_gfx_cmd_t *js_gfx_add(js_gfx_t *gfx, js_gfx_op_t op, uint32_t color_rgb)
+{
+    js_gfx_batch_t *b = gfx->rec;
+    if (b->count >= JS_GFX_MAX_CMDS) return NULL;
+    js_gfx_cmd_t *cmd = &b->cmds[b->count++];
+    cmd->op = (uint8_t)op;
+    cmd->color = rgb565(color_rgb);
+    return cmd;
+}
+
+// Room for len bytes of text or pixels (2-byte aligned); offset or -1
+static int32_t batch_data(js_gfx_batch_t *b, const void *src, size_t len)
+{
+    uint32_t at = (b->data_len + 1) & ~1u;
+    if (len > JS_GFX_DATA_SIZE - at) return -1;
+    memcpy(b->data + at, src, len);
+    b->data_len = at + (uint32_t)len;
+    return (int32_t)at;
+}
+
+// Swap the recorded batch in; the caller checked ready_full is clear
+static void swap_batches(js_gfx_t *gfx)
+{
+    js_gfx_batch_t *b = gfx->ready;
+    gfx->ready = gfx->rec;
+    gfx->rec = b;
+    b->count = 0;
+    b->data_len = 0;
+    __atomic_store_n(&gfx->ready_full, 1, __ATOMIC_RELEASE);
+}
+
+bool js_gfx_submit(js_gfx_t *gfx)
+{
+    if (!gfx || gfx->rec->count == 0) return false;
+    if (__atomic_load_n(&gfx->ready_full, __ATOMIC_ACQUIRE)) return false;
+    swap_batches(gfx);
+    return true;
+}
+
+// ============ RASTERIZER ============
+
+// n pixels of color c, two at a time
+static inline void fill16(uint16_t *p, int n, uint16_t c)
+{
+    if (n <= 0) return;
+    if ((uintptr_t)p & 2) {
+        *p++ = c;
+        n--;
+    }
+    uint32_t pair = c | ((uint32_t)c << 16);
+    for (int i = 0; i < n / 2; i++) memcpy(p + 2 * i, &pair, 4);
+    if (n & 1) p[n - 1] = c;
+}
+
+static inline void span(uint16_t *px, int w, int h, int y, int x0, int x1, uint16_t c)
+{
+    if (y < 0 || y >= h) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 >= w) x1 = w - 1;
+    fill16(px + (size_t)y * w + x0, x1 - x0 + 1, c);
+}
+
+static inline void plot(uint16_t *px, int w, int h, int x, int y, uint16_t c)
+{
+    if ((unsigned)x < (unsigned)w && (unsigned)y < (unsigned)h) px[(size_t)y * w + x] = c;
+}
+
+static void fill_rect(uint16_t *px, int w, int h, int x, int y, int rw, int rh, uint16_t c)
+{
+    int x0 = x < 0 ? 0 : x;
+    int y0 = y < 0 ? 0 : y;
+    int x1 = x + rw > w ? w : x + rw;
+    int y1 = y + rh > h ? h : y + rh;
+    if (x0 >= x1 || y0 >= y1) return;
+
+    // First row by hand, the others copied from it
+    uint16_t *first = px + (size_t)y0 * w + x0;
+    fill16(first, x1 - x0, c);
+    size_t bytes = (size_t)(x1 - x0) * 2;
+    for (int row = y0 + 1; row < y1; row++) {
+        memcpy(px + (size_t)row * w + x0, first, bytes);
+    }
+}
+
+// Bresenham; straight lines become rectangles
+static void line(uint16_t *px, int w, int h, int x0, int y0, int x1, int y1, uint16_t c)
+{
+    if (y0 == y1) {
+        span(px, w, h, y0, x0 < x1 ? x0 : x1, x0 < x1 ? x1 : x0, c);
+        return;
+    }
+    if (x0 == x1) {
+        int top = y0 < y1 ? y0 : y1;
+        fill_rect(px, w, h, x0, top, 1, abs(y1 - y0) + 1, c);
+        return;
+    }
+    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    for (;;) {
+        plot(px, w, h, x0, y0, c);
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+// Midpoint circle. Filled: the rows at +-y every step, the rows at +-x
+// once per x (when x is about to change, at their widest)
+static void circle(uint16_t *px, int w, int h, int cx, int cy, int r, bool filled, uint16_t c)
+{
+    if (r < 0) return;
+    if (cx + r < 0 || cx - r >= w || cy + r < 0 || cy - r >= h) return;
+    int x = r, y = 0, d = 1 - r;
+    while (x >= y) {
+        if (filled) {
+            span(px, w, h, cy + y, cx - x, cx + x, c);
+            if (y) span(px, w, h, cy - y, cx - x, cx + x, c);
+            if (d >= 0 && x != y) {
+                span(px, w, h, cy + x, cx - y, cx + y, c);
+                span(px, w, h, cy - x, cx - y, cx + y, c);
+            }
+        } else {
+            plot(px, w, h, cx + x, cy + y, c);
+            plot(px, w, h, cx - x, cy + y, c);
+            plot(px, w, h, cx + x, cy - y, c);
+            plot(px, w, h, cx - x, cy - y, c);
+            plot(px, w, h, cx + y, cy + x, c);
+            plot(px, w, h, cx - y, cy + x, c);
+            plot(px, w, h, cx + y, cy - x, c);
+            plot(px, w, h, cx - y, cy - x, c);
+        }
+        y++;
+        if (d < 0) {
+            d += 2 * y + 1;
+        } else {
+            x--;
+            d += 2 * (y - x) + 1;
+        }
+    }
+}
+
+static void blit(uint16_t *px, int w, int h, int x, int y, int bw, int bh, const uint16_t *src)
+{
+    int x0 = x < 0 ? 0 : x;
+    int x1 = x + bw > w ? w : x + bw;
+    if (x0 >= x1) return;
+    for (int row = 0; row < bh; row++) {
+        int dy = y + row;
+        if (dy < 0) continue;
+        if (dy >= h) break;
+        memcpy(px + (size_t)dy * w + x0, src + (size_t)row * bw + (x0 - x), (size_t)(x1 - x0) * 2);
+    }
+}
+
+void js_gfx_execute(const js_gfx_t *gfx, const js_gfx_batch_t *batch, uint16_t *pixels,
+                    js_gfx_text_cb_t text_cb, void *user)
+{
+    int w = gfx->width, h = gfx->height;
+    for (uint32_t i = 0; i < batch->count; i++) {
+        const js_gfx_cmd_t *cmd = &batch->cmds[i];
+        switch (cmd->op) {
+        case JS_GFX_CLEAR:
+            fill_rect(pixels, w, h, 0, 0, w, h, cmd->color);
+            break;
+        case JS_GFX_FILL_RECT:
+            fill_rect(pixels, w, h, cmd->x, cmd->y, cmd->w, cmd->h, cmd->color);
+            break;
+        case JS_GFX_LINE:
+            line(pixels, w, h, cmd->x, cmd->y, cmd->w, cmd->h, cmd->color);
+            break;
+        case JS_GFX_CIRCLE:
+        case JS_GFX_FILL_CIRCLE:
+            circle(pixels, w, h, cmd->x, cmd->y, cmd->w, cmd->op == JS_GFX_FILL_CIRCLE, cmd->color);
+            break;
+        case JS_GFX_BLIT:
+            blit(pixels, w, h, cmd->x, cmd->y, cmd->w, cmd->h, (const uint16_t *)(batch->data + cmd->data));
+            break;
+        case JS_GFX_TEXT:
+            if (text_cb) text_cb(user, pixels, cmd->x, cmd->y, (const char *)(batch->data + cmd->data), cmd->color);
+            break;
+        }
+    }
+}
+
+bool js_gfx_render(js_gfx_t *gfx, uint16_t *pixels, js_gfx_text_cb_t text_cb, void *user)
+{
+    if (!gfx || !__atomic_load_n(&gfx->ready_full, __ATOMIC_ACQUIRE)) return false;
+
+    int64_t start = esp_timer_get_time();
+    js_gfx_execute(gfx, gfx->ready, pixels, text_cb, user);
+    gfx->last_render_us = (uint32_t)(esp_timer_get_time() - start);
+    if (gfx->last_render_us > gfx->max_render_us) gfx->max_render_us = gfx->last_render_us;
+    gfx->last_cmds = gfx->ready->count;
+    gfx->frames++;
+
+    // Hand the batch back, then wake a script waiting in gfx.frame()
+    __atomic_store_n(&gfx->ready_full, 0, __ATOMIC_RELEASE);
+    void *waiter = __atomic_load_n(&gfx->waiter, __ATOMIC_ACQUIRE);
+    if (waiter) xTaskNotifyGive((TaskHandle_t)waiter);
+    return true;
+}
+
+// ============ SCRIPT BINDINGS ============
+
+static js_gfx_t *gfx_from_ctx(duk_context *ctx)
+{
+    duk_push_heap_stash(ctx);
+    duk_get_prop_string(ctx, -1, STASH_KEY);
+    js_gfx_t *gfx = (js_gfx_t *)duk_get_pointer(ctx, -1);
+    duk_pop_2(ctx);
+    return gfx;
+}
+
+// Next slot, or a RangeError in the script
+static js_gfx_cmd_t *gfx_cmd(duk_context *ctx, js_gfx_t *gfx, js_gfx_op_t op, duk_idx_t color_idx)
+{
+    js_gfx_cmd_t *cmd = js_gfx_add(gfx, op, duk_get_uint(ctx, color_idx));
+    if (!cmd) {
+        (void)duk_error(ctx, DUK_ERR_RANGE_ERROR, "gfx: more than %d calls in one frame", JS_GFX_MAX_CMDS);
+    }
+    return cmd;
+}
+
+// gfx.clear(color)
+static duk_ret_t gfx_clear(duk_context *ctx)
+{
+    gfx_cmd(ctx, gfx_from_ctx(ctx), JS_GFX_CLEAR, 0);
+    return 0;
+}
+
+// gfx.fillRect(x, y, w, h, color)
+static duk_ret_t gfx_fill_rect(duk_context *ctx)
+{
+    js_gfx_cmd_t *cmd = gfx_cmd(ctx, gfx_from_ctx(ctx), JS_GFX_FILL_RECT, 4);
+    cmd->x = clamp16(duk_get_int(ctx, 0));
+    cmd->y = clamp16(duk_get_int(ctx, 1));
+    cmd->w = clamp16(duk_get_int(ctx, 2));
+    cmd->h = clamp16(duk_get_int(ctx, 3));
+    return 0;
+}
+
+// gfx.line(x0, y0, x1, y1, color)
+static duk_ret_t gfx_line(duk_context *ctx)
+{
+    js_gfx_cmd_t *cmd = gfx_cmd(ctx, gfx_from_ctx(ctx), JS_GFX_LINE, 4);
+    cmd->x = clamp16(duk_get_int(ctx, 0));
+    cmd->y = clamp16(duk_get_int(ctx, 1));
+    cmd->w = clamp16(duk_get_int(ctx, 2));
+    cmd->h = clamp16(duk_get_int(ctx, 3));
+    return 0;
+}
+
+// gfx.circle(cx, cy, r, color[, fill])
+static duk_ret_t gfx_circle(duk_context *ctx)
+{
+    js_gfx_op_t op = duk_to_boolean(ctx, 4) ? JS_GFX_FILL_CIRCLE : JS_GFX_CIRCLE;
+    js_gfx_cmd_t *cmd = gfx_cmd(ctx, gfx_from_ctx(ctx), op, 3);
+    cmd->x = clamp16(duk_get_int(ctx, 0));
+    cmd->y = clamp16(duk_get_int(ctx, 1));
+    cmd->w = clamp16(duk_get_int(ctx, 2));
+    return 0;
+}
+
+// gfx.blit(x, y, w, h, pixels): pixels are copied into the batch
+static duk_ret_t gfx_blit(duk_context *ctx)
+{
+    js_gfx_t *gfx = gfx_from_ctx(ctx);
+    int w = duk_require_int(ctx, 2);
+    int h = duk_require_int(ctx, 3);
+    duk_size_t len = 0;
+    const void *src = duk_require_buffer_data(ctx, 4, &len);
+    if (w <= 0 || h <= 0 || w > gfx->width || h > gfx->height || len < (duk_size_t)w * h * 2) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "gfx.blit: need %dx%d pixels", w, h);
+    }
+    int32_t at = batch_data(gfx->rec, src, (size_t)w * h * 2);
+    if (at < 0) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "gfx: more than %d KB of pixels and text in one frame",
+                         JS_GFX_DATA_SIZE / 1024);
+    }
+    js_gfx_cmd_t *cmd = gfx_cmd(ctx, gfx, JS_GFX_BLIT, 5);
+    cmd->x = clamp16(duk_get_int(ctx, 0));
+    cmd->y = clamp16(duk_get_int(ctx, 1));
+    cmd->w = (int16_t)w;
+    cmd->h = (int16_t)h;
+    cmd->data = (uint32_t)at;
+    return 0;
+}
+
+// gfx.text(x, y, string, color)
+static duk_ret_t gfx_text(duk_context *ctx)
+{
+    js_gfx_t *gfx = gfx_from_ctx(ctx);
+    duk_size_t len = 0;
+    const char *str = duk_safe_to_lstring(ctx, 2, &len);
+    int32_t at = batch_data(gfx->rec, str, len + 1);
+    if (at < 0) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "gfx: more than %d KB of pixels and text in one frame",
+                         JS_GFX_DATA_SIZE / 1024);
+    }
+    js_gfx_cmd_t *cmd = gfx_cmd(ctx, gfx, JS_GFX_TEXT, 3);
+    cmd->x = clamp16(duk_get_int(ctx, 0));
+    cmd->y = clamp16(duk_get_int(ctx, 1));
+    cmd->data = (uint32_t)at;
+    return 0;
+}
+
+// gfx.frame(): submit the batch. Waits (without using up CPU budget)
+// while the previous one is still being drawn, so a script that draws
+// every frame is paced by the display.
+static duk_ret_t gfx_frame(duk_context *ctx)
+{
+    js_gfx_t *gfx = gfx_from_ctx(ctx);
+    duk_esp32_t *duk = duk_esp32_from_ctx(ctx);
+    int64_t start = esp_timer_get_time();
+
+    __atomic_store_n(&gfx->waiter, (void *)xTaskGetCurrentTaskHandle(), __ATOMIC_RELEASE);
+    while (__atomic_load_n(&gfx->ready_full, __ATOMIC_ACQUIRE)) {
+        if (duk->stop) {
+            __atomic_store_n(&gfx->waiter, NULL, __ATOMIC_RELEASE);
+            return duk_error(ctx, DUK_ERR_ERROR, "Stopped");
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+    }
+    __atomic_store_n(&gfx->waiter, NULL, __ATOMIC_RELEASE);
+    if (duk->deadline) duk->deadline += esp_timer_get_time() - start;
+
+    if (gfx->rec->count) swap_batches(gfx);
+    return 0;
+}
+
+// gfx.stats()
+static duk_ret_t gfx_stats(duk_context *ctx)
+{
+    js_gfx_t *gfx = gfx_from_ctx(ctx);
+    duk_push_object(ctx);
+    duk_push_uint(ctx, gfx->frames);
+    duk_put_prop_string(ctx, -2, "frames");
+    duk_push_uint(ctx, gfx->last_cmds);
+    duk_put_prop_string(ctx, -2, "commands");
+    duk_push_uint(ctx, gfx->last_render_us);
+    duk_put_prop_string(ctx, -2, "renderUs");
+    duk_push_uint(ctx, gfx->max_render_us);
+    duk_put_prop_string(ctx, -2, "maxRenderUs");
+    return 1;
+}
+
+void js_gfx_bind(js_gfx_t *gfx, duk_context *ctx)
+{
+    static const duk_function_list_entry funcs[] = {
+        { "clear", gfx_clear, 1 },
+        { "fillRect", gfx_fill_rect, 5 },
+        { "line", gfx_line, 5 },
+        { "circle", gfx_circle, 5 },
+        { "blit", gfx_blit, 5 },
+        { "text", gfx_text, 4 },
+        { "frame", gfx_frame, 0 },
+        { "stats", gfx_stats, 0 },
+        { NULL, NULL, 0 }
+    };
+
+    duk_push_heap_stash(ctx);
+    duk_push_pointer(ctx, gfx);
+    duk_put_prop_string(ctx, -2, STASH_KEY);
+    duk_pop(ctx);
+
+    duk_push_object(ctx);
+    duk_put_function_list(ctx, -1, funcs);
+    duk_push_uint(ctx, gfx->width);
+    duk_put_prop_string(ctx, -2, "width");
+    duk_push_uint(ctx, gfx->height);
+    duk_put_prop_string(ctx, -2, "height");
+    duk_put_global_string(ctx, "gfx");
+}
+
+// ============ BENCHMARK ============
+
+#define BENCH_W         320
+#define BENCH_H         240
+#define BENCH_PRIMS     4000
+
+static uint32_t bench_rand(uint32_t *seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed >> 8;
+}
+
+static void bench_result(js_gfx_bench_result_t *r, const char *name, int64_t us, int count)
+{
+    r->name = name;
+    r->ns = (uint32_t)(us * 1000 / count);
+    r->per_frame = r->ns ? (uint32_t)((uint64_t)JS_GFX_FRAME_US * 1000 / r->ns) : 0;
+}
+
+int js_gfx_bench(js_gfx_bench_result_t *results)
+{
+    static const struct {
+        const char *name;
+        js_gfx_op_t op;
+        int size;
+    } cases[] = {
+        { "fillRect 8x8", JS_GFX_FILL_RECT, 8 },
+        { "fillRect 64x64", JS_GFX_FILL_RECT, 64 },
+        { "line", JS_GFX_LINE, 64 },
+        { "circle r16", JS_GFX_CIRCLE, 16 },
+        { "fill circle r16", JS_GFX_FILL_CIRCLE, 16 },
+        { "blit 32x32", JS_GFX_BLIT, 32 },
+    };
+
+    js_gfx_t *gfx = js_gfx_create(BENCH_W, BENCH_H);
+    uint16_t *pixels = (uint16_t *)heap_caps_malloc(BENCH_W * BENCH_H * 2, MALLOC_CAP_SPIRAM);
+    if (!gfx || !pixels) {
+        js_gfx_destroy(gfx);
+        heap_caps_free(pixels);
+        return -1;
+    }
+
+    int n = 0;
+    uint32_t seed = 1;
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        js_gfx_reset(gfx);
+        uint16_t sprite[32 * 32];
+        for (int i = 0; i < 32 * 32; i++) sprite[i] = (uint16_t)i;
+        int size = cases[c].size;
+        for (int i = 0; i < BENCH_PRIMS; i++) {
+            js_gfx_cmd_t *cmd = js_gfx_add(gfx, cases[c].op, bench_rand(&seed));
+            cmd->x = (int16_t)(bench_rand(&seed) % (BENCH_W - size));
+            cmd->y = (int16_t)(bench_rand(&seed) % (BENCH_H - size));
+            cmd->w = (int16_t)size;
+            cmd->h = (int16_t)size;
+            if (cases[c].op == JS_GFX_LINE) {
+                // dx + dy = 64, any slope down and to the right
+                int dx = (int)(bench_rand(&seed) % (size + 1));
+                cmd->w = (int16_t)(cmd->x + dx);
+                cmd->h = (int16_t)(cmd->y + size - dx);
+            } else if (cases[c].op == JS_GFX_CIRCLE || cases[c].op == JS_GFX_FILL_CIRCLE) {
+                cmd->x += size;
+                cmd->y += size;
+            } else if (cases[c].op == JS_GFX_BLIT) {
+                cmd->data = (uint32_t)batch_data(gfx->rec, sprite, sizeof(sprite));
+                if (gfx->rec->data_len + sizeof(sprite) > JS_GFX_DATA_SIZE) gfx->rec->data_len = 0;
+            }
+        }
+        // Best of three, the first one also warms the caches
+        int64_t best = INT64_MAX;
+        for (int run = 0; run < 3; run++) {
+            int64_t start = esp_timer_get_time();
+            js_gfx_execute(gfx, gfx->rec, pixels, NULL, NULL);
+            int64_t us = esp_timer_get_time() - start;
+            if (us < best) best = us;
+        }
+        bench_result(&results[n++], cases[c].name, best, BENCH_PRIMS);
+    }
+
+    // A gfx call from a script: the Duktape call plus recording
+    duk_esp32_t *duk = duk_esp32_init();
+    if (duk) {
+        js_gfx_bind(gfx, duk->ctx);
+        static const char *script =
+            "for (var i = 0; i < 4000; i++) gfx.fillRect(i & 255, i & 127, 8, 8, 0xFF8000);";
+        int64_t best = INT64_MAX;
+        for (int run = 0; run < 3; run++) {
+            js_gfx_reset(gfx);
+            int64_t start = esp_timer_get_time();
+            free(duk_esp32_eval(duk, script));
+            int64_t us = esp_timer_get_time() - start;
+            if (us < best) best = us;
+        }
+        bench_result(&results[n++], "script fillRect call", best, BENCH_PRIMS);
+        duk_esp32_cleanup(duk);
+    }
+
+    js_gfx_destroy(gfx);
+    heap_caps_free(pixels);
+    return n;
+}
@@ -0,0 +1,136 @@
+/**
+ * Win32 OS - JavaScript Graphics
+ * The gfx module of the JS IDE. Scripts record drawing calls into a
+ * command batch; gfx.frame() hands the batch over and the LVGL side
+ * draws all of it in one go into an RGB565 canvas buffer (js_gfx_render),
+ * at most once per display refresh. One batch is recorded while the
+ * other is drawn, so a script runs at display rate without a cross-task
+ * call per primitive.
+ *
+ * Script API (colors are 0xRRGGBB, coordinates in canvas pixels):
+ *   gfx.width, gfx.height
+ *   gfx.clear(color)
+ *   gfx.fillRect(x, y, w, h, color)
+ *   gfx.line(x0, y0, x1, y1, color)
+ *   gfx.circle(cx, cy, r, color[, fill])
+ *   gfx.blit(x, y, w, h, pixels)    pixels: w * h RGB565 values (Uint16Array)
+ *   gfx.text(x, y, string, color)
+ *   gfx.frame()                     show what was drawn; waits while the
+ *                                   previous frame is still being drawn
+ *   gfx.stats()                     { frames, commands, renderUs, maxRenderUs }
+ *
+ * The rasterizer has no LVGL dependency (text goes through a callback),
+ * so it builds and benchmarks on a Linux host.
+ */
+
+#ifndef JS_GFX_H
+#define JS_GFX_H
+
+#include "duktape.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JS_GFX_MAX_CMDS     8192            // Per frame
+#define JS_GFX_DATA_SIZE    (64 * 1024)     // Text and blit pixels per frame
+#define JS_GFX_FRAME_US     16667           // 60 Hz, for the benchmark
+
+typedef enum {
+    JS_GFX_CLEAR = 0,
+    JS_GFX_FILL_RECT,
+    JS_GFX_LINE,
+    JS_GFX_CIRCLE,
+    JS_GFX_FILL_CIRCLE,
+    JS_GFX_BLIT,
+    JS_GFX_TEXT,
+} js_gfx_op_t;
+
+typedef struct {
+    uint8_t op;
+    uint8_t reserved;
+    uint16_t color;             // RGB565
+    int16_t x, y;
+    int16_t w, h;               // LINE: end point, CIRCLE: w = radius
+    uint32_t data;              // BLIT, TEXT: offset in the batch data
+} js_gfx_cmd_t;
+
+typedef struct {
+    js_gfx_cmd_t *cmds;
+    uint32_t count;
+    uint8_t *data;
+    uint32_t data_len;
+} js_gfx_batch_t;
+
+// Draws a TEXT command; pixels is the buffer being drawn into
+typedef void (*js_gfx_text_cb_t)(void *user, uint16_t *pixels, int x, int y, const char *text, uint16_t color);
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    js_gfx_batch_t batch[2];
+    js_gfx_batch_t *rec;        // Being recorded by the script
+    js_gfx_batch_t *ready;      // Submitted, waiting for js_gfx_render()
+    int ready_full;             // Set by the script, cleared by the renderer
+    void *waiter;               // TaskHandle_t blocked in gfx.frame()
+
+    // Statistics
+    uint32_t frames;            // Batches drawn
+    uint32_t last_cmds;
+    uint32_t last_render_us;
+    uint32_t max_render_us;
+} js_gfx_t;
+
+// Surface of width x height pixels with its two batches (PSRAM).
+// Returns NULL if out of memory.
+js_gfx_t *js_gfx_create(int width, int height);
+void js_gfx_destroy(js_gfx_t *gfx);
+
+// Install the global gfx object in a context; gfx must outlive it
+void js_gfx_bind(js_gfx_t *gfx, duk_context *ctx);
+
+// Drop anything recorded or submitted (no script may be running)
+void js_gfx_reset(js_gfx_t *gfx);
+
+// Submit what was recorded without gfx.frame() (after a run ended).
+// False if there is nothing, or a frame is still waiting to be drawn.
+bool js_gfx_submit(js_gfx_t *gfx);
+
+// Next command slot in the batch being recorded, NULL if it is full
+js_gfx_cmd_t *js_gfx_add(js_gfx_t *gfx, js_gfx_op_t op, uint32_t color_rgb);
+
+/**
+ * LVGL side, once per refresh: draw the submitted batch into pixels
+ * (width x height RGB565) and release the script. Returns false if no
+ * frame was waiting. text_cb may be NULL to skip text.
+ */
+bool js_gfx_render(js_gfx_t *gfx, uint16_t *pixels, js_gfx_text_cb_t text_cb, void *user);
+
+// Draw a batch into pixels (what js_gfx_render does, without the handover)
+void js_gfx_execute(const js_gfx_t *gfx, const js_gfx_batch_t *batch, uint16_t *pixels,
+                    js_gfx_text_cb_t text_cb, void *user);
+
+typedef struct {
+    const char *name;
+    uint32_t ns;                // Per primitive
+    uint32_t per_frame;         // Primitives that fit in a 60 Hz frame
+} js_gfx_bench_result_t;
+
+#define JS_GFX_BENCH_RESULTS    7
+
+/**
+ * Primitives per frame: each rasterizer primitive drawn into an
+ * offscreen surface, then fillRect recorded from a script (the cost of
+ * a gfx call in Duktape). Text is not included, it is drawn by LVGL.
+ * Returns the number of results, -1 if out of memory.
+ */
+int js_gfx_bench(js_gfx_bench_result_t *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JS_GFX_H
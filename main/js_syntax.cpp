@@ -0,0 +1,525 @@
+/**
+ * Win32 OS - JavaScript Syntax Highlighting Implementation
+ * A small JS lexer that works one line at a time: everything that can
+ * span lines (block comments, template strings, strings continued with a
+ * backslash, and whether a '/' starts a regex) is folded into one state
+ * byte per line.
+ */
+
+#include "js_syntax.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+// Line states
+#define ST_CODE         0
+#define ST_COMMENT      1       // In /* */
+#define ST_TEMPLATE     2       // In a `template`
+#define ST_SQUOTE       3       // In a 'string' continued with a backslash
+#define ST_DQUOTE       4       // Same for "string"
+#define ST_MODE         0x07
+#define ST_REGEX        0x08    // A '/' here starts a regex, not a division
+
+// ============ LEXER ============
+
+// Keywords and the literals colored like them; regex: a '/' after the
+// word starts a regex literal
+static const struct {
+    const char *word;
+    bool regex;
+} keywords[] = {
+    { "async", false }, { "await", true }, { "break", false }, { "case", true },
+    { "catch", false }, { "class", false }, { "const", false }, { "continue", false },
+    { "debugger", false }, { "default", false }, { "delete", true }, { "do", true },
+    { "else", true }, { "export", false }, { "extends", false }, { "false", false },
+    { "finally", false }, { "for", false }, { "function", false }, { "if", false },
+    { "import", false }, { "in", true }, { "instanceof", true }, { "let", false },
+    { "new", true }, { "null", false }, { "of", true }, { "return", true },
+    { "static", false }, { "super", false }, { "switch", false }, { "this", false },
+    { "throw", true }, { "true", false }, { "try", false }, { "typeof", true },
+    { "undefined", false }, { "var", false }, { "void", true }, { "while", false },
+    { "with", false }, { "yield", true },
+};
+
+#define KEYWORD_MAX_LEN 10
+
+// Index in keywords, -1 if the word is not one (binary search, the table is sorted)
+static int keyword_find(const char *s, uint32_t len)
+{
+    if (len > KEYWORD_MAX_LEN) return -1;
+    int lo = 0;
+    int hi = (int)(sizeof(keywords) / sizeof(keywords[0])) - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int c = strncmp(keywords[mid].word, s, len);
+        if (c == 0 && keywords[mid].word[len]) c = 1;
+        if (c == 0) return mid;
+        if (c < 0) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+static inline bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// UTF-8 bytes count as letters, so non-ASCII identifiers stay whole
+static inline bool is_ident(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || is_digit(c) ||
+           c == '_' || c == '$' || (uint8_t)c >= 0x80;
+}
+
+typedef struct {
+    js_syntax_token_t *tok;
+    int max;
+    int count;
+} token_out_t;
+
+// Tokens are contiguous: a run of the same class as the previous one
+// extends it, and once the array is full the last token takes the rest
+static void emit(token_out_t *out, uint32_t start, uint32_t end, uint8_t cls)
+{
+    if (!out || end <= start) return;
+    if (out->count > 0) {
+        js_syntax_token_t *last = &out->tok[out->count - 1];
+        if (last->cls == cls || out->count == out->max) {
+            last->len = end - last->start;
+            return;
+        }
+    }
+    js_syntax_token_t *t = &out->tok[out->count++];
+    t->start = start;
+    t->len = end - start;
+    t->cls = cls;
+}
+
+// From just after "/*"; sets *open if the comment goes on past the line
+static uint32_t scan_comment(const char *s, uint32_t n, uint32_t i, bool *open)
+{
+    for (; i + 1 < n; i++) {
+        if (s[i] == '*' && s[i + 1] == '/') {
+            *open = false;
+            return i + 2;
+        }
+    }
+    *open = true;
+    return n;
+}
+
+// From just after the opening quote. A quote string is open at the end of
+// the line only if it ends in a backslash; a template string always is.
+static uint32_t scan_string(const char *s, uint32_t n, uint32_t i, char quote, bool *open)
+{
+    while (i < n) {
+        if (s[i] == '\\') {
+            i += 2;
+            continue;
+        }
+        if (s[i] == quote) {
+            *open = false;
+            return i + 1;
+        }
+        i++;
+    }
+    *open = quote == '`' || i > n;
+    return n;
+}
+
+static uint32_t scan_number(const char *s, uint32_t n, uint32_t i)
+{
+    bool hex = s[i] == '0' && i + 1 < n && (s[i + 1] | 0x20) == 'x';
+    if (hex) i += 2;
+    while (i < n) {
+        char c = s[i];
+        if (is_ident(c) || c == '.') {
+            i++;
+        } else if (!hex && (c == '+' || c == '-') && (s[i - 1] | 0x20) == 'e') {
+            i++;
+        } else {
+            break;
+        }
+    }
+    return i;
+}
+
+// From just after the opening '/', including the flags
+static uint32_t scan_regex(const char *s, uint32_t n, uint32_t i)
+{
+    bool in_class = false;
+    while (i < n) {
+        char c = s[i];
+        if (c == '\\') {
+            i += 2;
+            continue;
+        }
+        if (c == '[') {
+            in_class = true;
+        } else if (c == ']') {
+            in_class = false;
+        } else if (c == '/' && !in_class) {
+            i++;
+            while (i < n && is_ident(s[i])) i++;
+            return i;
+        }
+        i++;
+    }
+    return n;
+}
+
+// Lex one line (n bytes, no '\n') starting in state; returns the state
+// the next line starts in. out may be NULL to only follow the state.
+static uint8_t lex_line(const char *s, uint32_t n, uint8_t state, token_out_t *out)
+{
+    bool regex = (state & ST_REGEX) != 0;
+    bool open = false;
+    uint32_t i = 0;
+
+    // Carried over from the previous line
+    switch (state & ST_MODE) {
+    case ST_COMMENT:
+        i = scan_comment(s, n, 0, &open);
+        emit(out, 0, i, JS_SYNTAX_COMMENT);
+        if (open) return state;
+        break;
+    case ST_TEMPLATE:
+    case ST_SQUOTE:
+    case ST_DQUOTE: {
+        char quote = (state & ST_MODE) == ST_TEMPLATE ? '`' : (state & ST_MODE) == ST_SQUOTE ? '\'' : '"';
+        i = scan_string(s, n, 0, quote, &open);
+        emit(out, 0, i, JS_SYNTAX_STRING);
+        if (open) return state;
+        regex = false;
+        break;
+    }
+    default:
+        break;
+    }
+
+    while (i < n) {
+        uint32_t start = i;
+        char c = s[i];
+
+        if (c == ' ' || c == '\t' || c == '\r') {
+            i++;
+            emit(out, start, i, JS_SYNTAX_TEXT);
+        } else if (c == '/' && i + 1 < n && s[i + 1] == '/') {
+            emit(out, start, n, JS_SYNTAX_COMMENT);
+            i = n;
+        } else if (c == '/' && i + 1 < n && s[i + 1] == '*') {
+            i = scan_comment(s, n, i + 2, &open);
+            emit(out, start, i, JS_SYNTAX_COMMENT);
+            if (open) return ST_COMMENT | (regex ? ST_REGEX : 0);
+        } else if (c == '\'' || c == '"' || c == '`') {
+            i = scan_string(s, n, i + 1, c, &open);
+            emit(out, start, i, JS_SYNTAX_STRING);
+            if (open) return c == '`' ? ST_TEMPLATE : c == '\'' ? ST_SQUOTE : ST_DQUOTE;
+            regex = false;
+        } else if (is_digit(c) || (c == '.' && i + 1 < n && is_digit(s[i + 1]))) {
+            i = scan_number(s, n, i);
+            emit(out, start, i, JS_SYNTAX_NUMBER);
+            regex = false;
+        } else if (is_ident(c)) {
+            while (i < n && is_ident(s[i])) i++;
+            int kw = keyword_find(s + start, i - start);
+            emit(out, start, i, kw >= 0 ? JS_SYNTAX_KEYWORD : JS_SYNTAX_TEXT);
+            regex = kw >= 0 && keywords[kw].regex;
+        } else if (c == '/' && regex) {
+            i = scan_regex(s, n, i + 1);
+            emit(out, start, i, JS_SYNTAX_STRING);
+            regex = false;
+        } else {
+            // Operators and punctuation: a '/' after a closing bracket divides
+            i++;
+            emit(out, start, i, JS_SYNTAX_TEXT);
+            regex = c != ')' && c != ']' && c != '}';
+        }
+    }
+    return ST_CODE | (regex ? ST_REGEX : 0);
+}
+
+// ============ LINE MODEL ============
+
+static bool reserve_text(js_syntax_t *syn, uint32_t size)
+{
+    if (size <= syn->cap) return true;
+    uint32_t cap = syn->cap ? syn->cap : 256;
+    while (cap < size) cap *= 2;
+    char *text = (char *)heap_caps_realloc(syn->text, cap, MALLOC_CAP_SPIRAM);
+    if (!text) return false;
+    syn->text = text;
+    syn->cap = cap;
+    return true;
+}
+
+static bool reserve_lines(js_syntax_t *syn, uint32_t lines)
+{
+    if (lines <= syn->line_cap) return true;
+    uint32_t cap = syn->line_cap ? syn->line_cap : 64;
+    while (cap < lines) cap *= 2;
+    uint32_t *start = (uint32_t *)heap_caps_realloc(syn->line_start, cap * sizeof(uint32_t), MALLOC_CAP_SPIRAM);
+    if (!start) return false;
+    syn->line_start = start;
+    uint8_t *state = (uint8_t *)heap_caps_realloc(syn->line_state, cap, MALLOC_CAP_SPIRAM);
+    if (!state) return false;
+    syn->line_state = state;
+    syn->line_cap = cap;
+    return true;
+}
+
+js_syntax_t *js_syntax_create(void)
+{
+    js_syntax_t *syn = (js_syntax_t *)calloc(1, sizeof(js_syntax_t));
+    if (!syn) return NULL;
+    if (!reserve_text(syn, 1) || !reserve_lines(syn, 1)) {
+        js_syntax_destroy(syn);
+        return NULL;
+    }
+    syn->text[0] = '\0';
+    syn->line_start[0] = 0;
+    syn->line_state[0] = ST_CODE | ST_REGEX;
+    syn->lines = 1;
+    return syn;
+}
+
+void js_syntax_destroy(js_syntax_t *syn)
+{
+    if (!syn) return;
+    heap_caps_free(syn->text);
+    heap_caps_free(syn->line_start);
+    heap_caps_free(syn->line_state);
+    free(syn);
+}
+
+// Last line starting at or before pos
+static uint32_t line_of(const js_syntax_t *syn, uint32_t pos)
+{
+    uint32_t lo = 0;
+    uint32_t hi = syn->lines - 1;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi + 1) / 2;
+        if (syn->line_start[mid] <= pos) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+static uint32_t common_prefix(const char *a, const char *b, uint32_t n)
+{
+    uint32_t i = 0;
+    while (i + 64 <= n && memcmp(a + i, b + i, 64) == 0) i += 64;
+    while (i < n && a[i] == b[i]) i++;
+    return i;
+}
+
+// Backwards from a_end and b_end
+static uint32_t common_suffix(const char *a_end, const char *b_end, uint32_t n)
+{
+    uint32_t i = 0;
+    while (i + 64 <= n && memcmp(a_end - i - 64, b_end - i - 64, 64) == 0) i += 64;
+    while (i < n && a_end[-1 - (ptrdiff_t)i] == b_end[-1 - (ptrdiff_t)i]) i++;
+    return i;
+}
+
+bool js_syntax_update(js_syntax_t *syn, const char *text)
+{
+    int64_t start_time = esp_timer_get_time();
+    uint32_t n = (uint32_t)strlen(text);
+    uint32_t m = syn->len;
+
+    // Changed range: [p, old_end) of the old text became [p, new_end)
+    uint32_t common = n < m ? n : m;
+    uint32_t p = common_prefix(syn->text, text, common);
+    if (p == n && n == m) {
+        syn->last_lexed = 0;
+        return true;
+    }
+    uint32_t s = common_suffix(syn->text + m, text + n, common - p);
+    uint32_t old_end = m - s;
+    uint32_t new_end = n - s;
+
+    // Lines starting in (p, old_end] are replaced by the ones starting in
+    // (p, new_end]; the line p is in keeps its start and start state
+    uint32_t first = line_of(syn, p);
+    uint32_t removed = line_of(syn, old_end) - first;
+    uint32_t added = 0;
+    for (uint32_t i = p; i < new_end; i++) {
+        if (text[i] == '\n') added++;
+    }
+    uint32_t lines = syn->lines - removed + added;
+    if (!reserve_lines(syn, lines) || !reserve_text(syn, n + 1)) return false;
+
+    uint32_t tail = first + 1 + removed;
+    uint32_t tail_count = syn->lines - tail;
+    memmove(syn->line_start + first + 1 + added, syn->line_start + tail, tail_count * sizeof(uint32_t));
+    memmove(syn->line_state + first + 1 + added, syn->line_state + tail, tail_count);
+    uint32_t delta = n - m;     // Wraps around for deletions, as does the sum
+    for (uint32_t k = first + 1 + added; k < lines; k++) {
+        syn->line_start[k] += delta;
+    }
+    uint32_t k = first + 1;
+    for (uint32_t i = p; i < new_end; i++) {
+        if (text[i] == '\n') syn->line_start[k++] = i + 1;
+    }
+    syn->lines = lines;
+
+    // The tail first: the changed range may grow over where it was
+    memmove(syn->text + new_end, syn->text + old_end, s);
+    memcpy(syn->text + p, text + p, new_end - p);
+    syn->text[n] = '\0';
+    syn->len = n;
+
+    // Lex from the first changed line on, past the last one, until a line
+    // starts in the same state as before the edit
+    uint32_t last_changed = first + added;
+    uint8_t state = syn->line_state[first];
+    uint32_t lexed = 0;
+    for (k = first; k < lines; k++) {
+        uint32_t len;
+        const char *line = js_syntax_line(syn, k, &len);
+        state = lex_line(line, len, state, NULL);
+        lexed++;
+        if (k + 1 == lines) break;
+        if (k + 1 > last_changed && syn->line_state[k + 1] == state) break;
+        syn->line_state[k + 1] = state;
+    }
+
+    syn->last_lexed = lexed;
+    syn->last_update_us = (uint32_t)(esp_timer_get_time() - start_time);
+    if (syn->last_update_us > syn->max_update_us) syn->max_update_us = syn->last_update_us;
+    return true;
+}
+
+const char *js_syntax_line(const js_syntax_t *syn, uint32_t line, uint32_t *len)
+{
+    if (line >= syn->lines) {
+        *len = 0;
+        return syn->text + syn->len;
+    }
+    uint32_t start = syn->line_start[line];
+    uint32_t end = line + 1 < syn->lines ? syn->line_start[line + 1] - 1 : syn->len;
+    *len = end - start;
+    return syn->text + start;
+}
+
+int js_syntax_tokens(const js_syntax_t *syn, uint32_t line, js_syntax_token_t *tokens, int max)
+{
+    if (line >= syn->lines || max <= 0) return 0;
+    uint32_t len;
+    const char *s = js_syntax_line(syn, line, &len);
+    token_out_t out = { tokens, max, 0 };
+    lex_line(s, len, syn->line_state[line], &out);
+    return out.count;
+}
+
+// ============ BENCHMARK ============
+
+#define BENCH_SCREEN    40      // Lines on screen
+
+// 12 lines with a bit of everything, repeated
+static const char *bench_chunk =
+    "/* Bouncing balls\n"
+    " * step() moves every ball once */\n"
+    "function step(balls, dt) {\n"
+    "    for (var i = 0; i < balls.length; i++) {\n"
+    "        var b = balls[i];   // position in pixels\n"
+    "        b.x += b.vx * dt / 1000;\n"
+    "        if (b.x < 0 || b.x > 0x1E0) b.vx = -b.vx * 0.95e0;\n"
+    "        var name = 'ball ' + i + \"\\\"\";\n"
+    "        var tag = `#${i}: ${b.x.toFixed(1)}`;\n"
+    "        if (/^ball [0-9]+$/.test(name)) print(tag);\n"
+    "    }\n"
+    "}\n";
+
+#define BENCH_CHUNK_LINES 12
+
+// Replace len bytes at pos of buf with ins; buf has room
+static void bench_edit(char *buf, uint32_t pos, uint32_t len, const char *ins)
+{
+    uint32_t ins_len = (uint32_t)strlen(ins);
+    uint32_t total = (uint32_t)strlen(buf);
+    memmove(buf + pos + ins_len, buf + pos + len, total - pos - len + 1);
+    memcpy(buf + pos, ins, ins_len);
+}
+
+static void bench_result(js_syntax_bench_result_t *r, const char *name, int64_t us, uint32_t lines)
+{
+    r->name = name;
+    r->us = (uint32_t)us;
+    r->lines = lines;
+}
+
+// Time an edit and its undo, best of three; reports the edit
+static int64_t bench_edit_undo(js_syntax_t *syn, char *buf, uint32_t pos, const char *ins, uint32_t *lexed)
+{
+    int64_t best = INT64_MAX;
+    for (int run = 0; run < 3; run++) {
+        bench_edit(buf, pos, 0, ins);
+        int64_t start = esp_timer_get_time();
+        js_syntax_update(syn, buf);
+        int64_t us = esp_timer_get_time() - start;
+        if (us < best) best = us;
+        *lexed = syn->last_lexed;
+        bench_edit(buf, pos, (uint32_t)strlen(ins), "");
+        js_syntax_update(syn, buf);
+    }
+    return best;
+}
+
+int js_syntax_bench(uint32_t lines, js_syntax_bench_result_t *results)
+{
+    uint32_t chunks = (lines + BENCH_CHUNK_LINES - 1) / BENCH_CHUNK_LINES;
+    size_t chunk_len = strlen(bench_chunk);
+    char *buf = (char *)heap_caps_malloc(chunks * chunk_len + 16, MALLOC_CAP_SPIRAM);
+    js_syntax_t *syn = js_syntax_create();
+    if (!buf || !syn) {
+        heap_caps_free(buf);
+        js_syntax_destroy(syn);
+        return -1;
+    }
+    for (uint32_t i = 0; i < chunks; i++) {
+        memcpy(buf + i * chunk_len, bench_chunk, chunk_len);
+    }
+    buf[chunks * chunk_len] = '\0';
+
+    int n = 0;
+    int64_t start = esp_timer_get_time();
+    if (!js_syntax_update(syn, buf)) {
+        heap_caps_free(buf);
+        js_syntax_destroy(syn);
+        return -1;
+    }
+    bench_result(&results[n++], "load", esp_timer_get_time() - start, syn->last_lexed);
+
+    // In the middle of the file, inside the for loop body
+    uint32_t mid = syn->line_start[(syn->lines / 2 / BENCH_CHUNK_LINES) * BENCH_CHUNK_LINES + 5] + 8;
+    uint32_t lexed;
+    int64_t us = bench_edit_undo(syn, buf, mid, "x", &lexed);
+    bench_result(&results[n++], "type a character", us, lexed);
+    us = bench_edit_undo(syn, buf, mid, "\n", &lexed);
+    bench_result(&results[n++], "new line", us, lexed);
+    // Before "function step": everything up to the next "*/" turns into a comment
+    us = bench_edit_undo(syn, buf, syn->line_start[2], "/*", &lexed);
+    bench_result(&results[n++], "open a comment", us, lexed);
+
+    js_syntax_token_t tokens[JS_SYNTAX_MAX_TOKENS];
+    uint32_t first = syn->lines / 2;
+    int64_t best = INT64_MAX;
+    for (int run = 0; run < 3; run++) {
+        start = esp_timer_get_time();
+        for (uint32_t i = first; i < first + BENCH_SCREEN; i++) {
+            js_syntax_tokens(syn, i, tokens, JS_SYNTAX_MAX_TOKENS);
+        }
+        us = esp_timer_get_time() - start;
+        if (us < best) best = us;
+    }
+    bench_result(&results[n++], "tokens for a screen", best, BENCH_SCREEN);
+
+    heap_caps_free(buf);
+    js_syntax_destroy(syn);
+    return n;
+}
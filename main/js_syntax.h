@@ -0,0 +1,94 @@
+/**
+ * Win32 OS - JavaScript Syntax Highlighting
+ * Line-based model of the JS IDE editor text. Every line keeps the lexer
+ * state it starts in (inside a block comment, a template string, ...),
+ * so after an edit only the changed lines are lexed again, plus the
+ * following ones until their start state comes out as before. Tokens are
+ * produced per line on demand, for the lines on screen.
+ *
+ * Colors are not decided here: a token has a class and the editor maps
+ * classes to its palette. No LVGL dependency, it builds on a Linux host.
+ */
+
+#ifndef JS_SYNTAX_H
+#define JS_SYNTAX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JS_SYNTAX_MAX_TOKENS    128     // Per line; the rest of a longer line is one token
+
+typedef enum {
+    JS_SYNTAX_TEXT = 0,         // Identifiers, operators, whitespace
+    JS_SYNTAX_KEYWORD,          // Also true, false, null, undefined, this
+    JS_SYNTAX_STRING,           // Strings, template strings, regex literals
+    JS_SYNTAX_COMMENT,
+    JS_SYNTAX_NUMBER,
+    JS_SYNTAX_CLASSES
+} js_syntax_class_t;
+
+typedef struct {
+    uint32_t start;             // Byte offset in the line
+    uint32_t len;
+    uint8_t cls;                // js_syntax_class_t
+} js_syntax_token_t;
+
+typedef struct {
+    char *text;                 // Copy of the editor text, to diff the next version against
+    uint32_t len;
+    uint32_t cap;
+    uint32_t *line_start;       // Byte offset of each line
+    uint8_t *line_state;        // Lexer state at the start of each line
+    uint32_t lines;
+    uint32_t line_cap;
+
+    // Statistics of the last js_syntax_update()
+    uint32_t last_lexed;        // Lines lexed again
+    uint32_t last_update_us;
+    uint32_t max_update_us;
+} js_syntax_t;
+
+// Empty model (one empty line); NULL if out of memory
+js_syntax_t *js_syntax_create(void);
+void js_syntax_destroy(js_syntax_t *syn);
+
+/**
+ * Bring the model up to date with the editor text. The new text is
+ * compared with the previous one and only the lines between the first and
+ * last difference are split and lexed again. Returns false if out of
+ * memory, the model then still describes the previous text.
+ */
+bool js_syntax_update(js_syntax_t *syn, const char *text);
+
+// Line text (not terminated, without the '\n') and its length
+const char *js_syntax_line(const js_syntax_t *syn, uint32_t line, uint32_t *len);
+
+// Tokens of a line, covering it from start to end; returns the count
+int js_syntax_tokens(const js_syntax_t *syn, uint32_t line, js_syntax_token_t *tokens, int max);
+
+typedef struct {
+    const char *name;
+    uint32_t us;
+    uint32_t lines;             // Lines lexed
+} js_syntax_bench_result_t;
+
+#define JS_SYNTAX_BENCH_RESULTS 5
+
+/**
+ * Editing a generated script of `lines` lines: loading it, typing one
+ * character in the middle, a new line, opening a block comment (the lines
+ * up to the next close are lexed again) and tokenizing a screen of lines.
+ * Returns the number of results, -1 if out of memory.
+ */
+int js_syntax_bench(uint32_t lines, js_syntax_bench_result_t *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JS_SYNTAX_H
@@ -0,0 +1,352 @@
+/**
+ * Win32 OS - Streaming JSON Reader Implementation
+ * Byte-at-a-time state machine; all state lives in json_stream_t so a
+ * token may be split across any number of feed() calls
+ */
+
+#include "json_stream.h"
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+enum {
+    JS_VALUE = 0,       // Expecting a value
+    JS_VALUE_OR_END,    // After '[': value or ']'
+    JS_KEY_OR_END,      // After '{': key or '}'
+    JS_KEY,             // After ',' in an object: key
+    JS_COLON,           // After a key
+    JS_AFTER_VALUE,     // Expecting ',' or a closing bracket
+    JS_STRING,          // Inside a string (key or value)
+    JS_LITERAL,         // Inside a number, true, false or null
+    JS_DONE             // Top-level value complete
+};
+
+void json_stream_init(json_stream_t *js, json_stream_value_cb_t cb, void *user)
+{
+    memset(js, 0, sizeof(*js));
+    js->on_value = cb;
+    js->user = user;
+    js->state = JS_VALUE;
+}
+
+bool json_stream_done(const json_stream_t *js)
+{
+    return js->state == JS_DONE && !js->error;
+}
+
+int json_stream_index(const json_stream_t *js)
+{
+    if (js->depth == 0 || !js->level[js->depth - 1].is_array) return -1;
+    return js->level[js->depth - 1].index;
+}
+
+bool json_stream_match(const json_stream_t *js, const char *path)
+{
+    int lvl = 0;
+    const char *p = path;
+
+    while (*p) {
+        const char *end = strchr(p, '.');
+        if (!end) end = p + strlen(p);
+
+        size_t name_len = end - p;
+        bool is_array = name_len >= 2 && p[name_len - 2] == '[' && p[name_len - 1] == ']';
+        if (is_array) name_len -= 2;
+
+        if (lvl >= js->depth || js->level[lvl].is_array) return false;
+        const char *key = js->level[lvl].key;
+        if (strlen(key) != name_len || strncmp(key, p, name_len) != 0) return false;
+        lvl++;
+
+        if (is_array) {
+            if (lvl >= js->depth || !js->level[lvl].is_array) return false;
+            lvl++;
+        }
+        p = *end ? end + 1 : end;
+    }
+    return lvl == js->depth;
+}
+
+// ============ TOKENIZER ============
+
+static void token_append(json_stream_t *js, char c)
+{
+    if (js->token_len < JSON_STREAM_TOKEN_LEN - 1) {
+        js->token[js->token_len++] = c;
+    }
+}
+
+// Whole sequences only: truncation never cuts an escaped character in half
+static void token_append_utf8(json_stream_t *js, uint32_t cp)
+{
+    char seq[4];
+    int n;
+    if (cp < 0x80) {
+        seq[0] = (char)cp;
+        n = 1;
+    } else if (cp < 0x800) {
+        seq[0] = (char)(0xC0 | (cp >> 6));
+        seq[1] = (char)(0x80 | (cp & 0x3F));
+        n = 2;
+    } else if (cp < 0x10000) {
+        seq[0] = (char)(0xE0 | (cp >> 12));
+        seq[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        seq[2] = (char)(0x80 | (cp & 0x3F));
+        n = 3;
+    } else {
+        seq[0] = (char)(0xF0 | (cp >> 18));
+        seq[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        seq[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        seq[3] = (char)(0x80 | (cp & 0x3F));
+        n = 4;
+    }
+    if (js->token_len + n > JSON_STREAM_TOKEN_LEN - 1) {
+        js->token_len = JSON_STREAM_TOKEN_LEN - 1;     // Nothing more fits after this
+        return;
+    }
+    memcpy(js->token + js->token_len, seq, n);
+    js->token_len += n;
+}
+
+// A \u escape is complete; pairs of UTF-16 halves become one code point
+static void unicode_done(json_stream_t *js)
+{
+    uint16_t cp = js->unicode;
+    if (cp >= 0xD800 && cp < 0xDC00) {
+        if (js->surrogate) token_append_utf8(js, 0xFFFD);
+        js->surrogate = cp;
+        return;
+    }
+    if (cp >= 0xDC00 && cp < 0xE000) {
+        token_append_utf8(js, js->surrogate ? 0x10000 + ((uint32_t)(js->surrogate - 0xD800) << 10) + (cp - 0xDC00)
+                                            : 0xFFFD);
+    } else {
+        if (js->surrogate) token_append_utf8(js, 0xFFFD);
+        token_append_utf8(js, cp);
+    }
+    js->surrogate = 0;
+}
+
+static void emit(json_stream_t *js, json_stream_type_t type)
+{
+    js->token[js->token_len] = '\0';
+    if (js->on_value) js->on_value(js, type, js->token, js->user);
+}
+
+static void value_done(json_stream_t *js)
+{
+    js->state = js->depth == 0 ? JS_DONE : JS_AFTER_VALUE;
+}
+
+static void push_level(json_stream_t *js, bool is_array)
+{
+    if (js->depth >= JSON_STREAM_MAX_DEPTH) {
+        js->error = true;
+        return;
+    }
+    json_stream_level_t *lvl = &js->level[js->depth++];
+    lvl->key[0] = '\0';
+    lvl->index = 0;
+    lvl->is_array = is_array;
+    js->state = is_array ? JS_VALUE_OR_END : JS_KEY_OR_END;
+}
+
+static void pop_level(json_stream_t *js, bool is_array)
+{
+    if (js->depth == 0 || js->level[js->depth - 1].is_array != is_array) {
+        js->error = true;
+        return;
+    }
+    js->depth--;
+    value_done(js);
+}
+
+static void start_token(json_stream_t *js, uint8_t state, bool is_key)
+{
+    js->token_len = 0;
+    js->escape = false;
+    js->unicode_left = 0;
+    js->surrogate = 0;
+    js->is_key = is_key;
+    js->state = state;
+}
+
+static void begin_value(json_stream_t *js, char c)
+{
+    if (c == '{') {
+        push_level(js, false);
+    } else if (c == '[') {
+        push_level(js, true);
+    } else if (c == '"') {
+        start_token(js, JS_STRING, false);
+    } else if (c == '-' || isdigit((unsigned char)c) || c == 't' || c == 'f' || c == 'n') {
+        start_token(js, JS_LITERAL, false);
+        token_append(js, c);
+    } else {
+        js->error = true;
+    }
+}
+
+static void string_char(json_stream_t *js, char c)
+{
+    if (js->unicode_left) {
+        if (!isxdigit((unsigned char)c)) {
+            js->error = true;
+            return;
+        }
+        int v = isdigit((unsigned char)c) ? c - '0' : (tolower((unsigned char)c) - 'a' + 10);
+        js->unicode = (uint16_t)((js->unicode << 4) | v);
+        if (--js->unicode_left == 0) unicode_done(js);
+        return;
+    }
+
+    // A high surrogate not followed by \u: replace it
+    if (js->surrogate && !(js->escape ? c == 'u' : c == '\\')) {
+        token_append_utf8(js, 0xFFFD);
+        js->surrogate = 0;
+    }
+
+    if (js->escape) {
+        js->escape = false;
+        switch (c) {
+            case '"': case '\\': case '/': token_append(js, c); break;
+            case 'b': token_append(js, '\b'); break;
+            case 'f': token_append(js, '\f'); break;
+            case 'n': token_append(js, '\n'); break;
+            case 'r': token_append(js, '\r'); break;
+            case 't': token_append(js, '\t'); break;
+            case 'u': js->unicode_left = 4; js->unicode = 0; break;
+            default: js->error = true; break;
+        }
+        return;
+    }
+
+    if (c == '\\') {
+        js->escape = true;
+    } else if (c == '"') {
+        if (js->is_key) {
+            js->token[js->token_len] = '\0';
+            json_stream_level_t *lvl = &js->level[js->depth - 1];
+            strncpy(lvl->key, js->token, JSON_STREAM_KEY_LEN - 1);
+            lvl->key[JSON_STREAM_KEY_LEN - 1] = '\0';
+            js->state = JS_COLON;
+        } else {
+            emit(js, JSON_STREAM_STRING);
+            value_done(js);
+        }
+    } else if ((unsigned char)c < 0x20) {
+        js->error = true;
+    } else {
+        token_append(js, c);
+    }
+}
+
+static void finish_literal(json_stream_t *js)
+{
+    js->token[js->token_len] = '\0';
+
+    if (strcmp(js->token, "true") == 0 || strcmp(js->token, "false") == 0) {
+        emit(js, JSON_STREAM_BOOL);
+    } else if (strcmp(js->token, "null") == 0) {
+        emit(js, JSON_STREAM_NULL);
+    } else {
+        char *end = NULL;
+        strtod(js->token, &end);
+        if (end == js->token || *end != '\0') {
+            js->error = true;
+            return;
+        }
+        emit(js, JSON_STREAM_NUMBER);
+    }
+    value_done(js);
+}
+
+int json_stream_feed(json_stream_t *js, const char *data, size_t len)
+{
+    size_t i = 0;
+
+    while (i < len && !js->error) {
+        char c = data[i];
+
+        if (js->state == JS_STRING) {
+            string_char(js, c);
+            i++;
+            continue;
+        }
+
+        if (js->state == JS_LITERAL) {
+            if (isalnum((unsigned char)c) || c == '+' || c == '-' || c == '.') {
+                token_append(js, c);
+                i++;
+            } else {
+                // Literal ends at the first foreign byte, which is then reprocessed
+                finish_literal(js);
+            }
+            continue;
+        }
+
+        i++;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') continue;
+
+        switch (js->state) {
+            case JS_VALUE_OR_END:
+                if (c == ']') {
+                    pop_level(js, true);
+                    break;
+                }
+                begin_value(js, c);
+                break;
+
+            case JS_VALUE:
+                begin_value(js, c);
+                break;
+
+            case JS_KEY_OR_END:
+                if (c == '}') {
+                    pop_level(js, false);
+                    break;
+                }
+                // fallthrough
+            case JS_KEY:
+                if (c == '"') {
+                    start_token(js, JS_STRING, true);
+                } else {
+                    js->error = true;
+                }
+                break;
+
+            case JS_COLON:
+                if (c == ':') {
+                    js->state = JS_VALUE;
+                } else {
+                    js->error = true;
+                }
+                break;
+
+            case JS_AFTER_VALUE: {
+                json_stream_level_t *top = &js->level[js->depth - 1];
+                if (c == ',') {
+                    if (top->is_array) {
+                        top->index++;
+                        js->state = JS_VALUE;
+                    } else {
+                        js->state = JS_KEY;
+                    }
+                } else if (c == ']' || c == '}') {
+                    pop_level(js, c == ']');
+                } else {
+                    js->error = true;
+                }
+                break;
+            }
+
+            default:
+                // Anything but whitespace after the top-level value
+                js->error = true;
+                break;
+        }
+    }
+
+    js->bytes += i;
+    return js->error ? -1 : 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * Win32 OS - Streaming JSON Reader
+ * Incremental SAX-style tokenizer: feed it network chunks of any size and
+ * it reports every scalar value together with its path. No response
+ * buffer and no DOM, so memory use is fixed regardless of body size.
+ *
+ * Strings longer than JSON_STREAM_TOKEN_LEN and keys longer than
+ * JSON_STREAM_KEY_LEN are truncated; nesting deeper than
+ * JSON_STREAM_MAX_DEPTH is an error.
+ */
+
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JSON_STREAM_MAX_DEPTH   8
+#define JSON_STREAM_KEY_LEN     32
+#define JSON_STREAM_TOKEN_LEN   64
+
+typedef enum {
+    JSON_STREAM_STRING = 0,
+    JSON_STREAM_NUMBER,
+    JSON_STREAM_BOOL,
+    JSON_STREAM_NULL
+} json_stream_type_t;
+
+typedef struct json_stream json_stream_t;
+
+/**
+ * Called for every scalar value; text is NUL-terminated and only valid
+ * during the call. Use json_stream_match()/json_stream_index() for the path.
+ */
+typedef void (*json_stream_value_cb_t)(json_stream_t *js, json_stream_type_t type,
+                                       const char *text, void *user);
+
+// One open object or array
+typedef struct {
+    char key[JSON_STREAM_KEY_LEN];  // Current member name (objects)
+    int index;                      // Current element index (arrays)
+    bool is_array;
+} json_stream_level_t;
+
+struct json_stream {
+    json_stream_value_cb_t on_value;
+    void *user;
+    json_stream_level_t level[JSON_STREAM_MAX_DEPTH];
+    int depth;                      // Number of open containers
+    char token[JSON_STREAM_TOKEN_LEN];
+    int token_len;
+    uint8_t state;
+    uint8_t unicode_left;           // Hex digits still expected after \u
+    uint16_t unicode;
+    uint16_t surrogate;             // High half of a \u pair, waiting for the low one
+    bool escape;
+    bool is_key;
+    bool error;
+    size_t bytes;                   // Total bytes consumed
+};
+
+/**
+ * Reset a reader
+ * @param cb Value callback (may be NULL to only validate)
+ */
+void json_stream_init(json_stream_t *js, json_stream_value_cb_t cb, void *user);
+
+/**
+ * Consume the next chunk of the document
+ * @return 0 on success, -1 on a syntax error (further input is ignored)
+ */
+int json_stream_feed(json_stream_t *js, const char *data, size_t len);
+
+/**
+ * Check whether one complete top-level value has been read
+ */
+bool json_stream_done(const json_stream_t *js);
+
+/**
+ * Match the path of the value being reported
+ * Path is dot-separated member names; "[]" after a name means the value is
+ * an element of that array, e.g. "current.temperature_2m" or "daily.time[]"
+ */
+bool json_stream_match(const json_stream_t *js, const char *path);
+
+/**
+ * Index of the value in its innermost array (-1 if not inside an array)
+ */
+int json_stream_index(const json_stream_t *js);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_STREAM_H
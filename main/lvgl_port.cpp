@@ -4,11 +4,15 @@
  */
 
 #include "lvgl_port.h"
+#include "src/display/lv_display_private.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "esp_lcd_panel_ops.h"
 #include "esp_lcd_mipi_dsi.h"
 #include "esp_lvgl_port.h"
+#include "esp_timer.h"
+#include "trace.h"
+#include "touch_latency.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
@@ -21,6 +25,27 @@ static esp_lcd_touch_handle_t touch_handle;
 static lv_display_t *lvgl_disp = NULL;
 static lv_indev_t *lvgl_touch_indev = NULL;
 
+// Frames and render time for the performance HUD (LVGL task only)
+static uint32_t render_frames = 0;
+static uint64_t render_total_us = 0;
+static int64_t render_start_us = 0;
+
+// Render start/end markers so LVGL frames line up with other tasks in traces
+static void lvgl_render_trace_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_RENDER_START) {
+        TRACE_BEGIN("lvgl_render");
+        render_start_us = esp_timer_get_time();
+    } else {
+        TRACE_END("lvgl_render");
+        if (render_start_us) {
+            render_total_us += esp_timer_get_time() - render_start_us;
+            render_frames++;
+            render_start_us = 0;
+        }
+    }
+}
+
 esp_err_t my_lvgl_port_init(void)
 {
     ESP_LOGI(TAG, "Initializing LVGL port with esp_lvgl_port (avoid_tearing)");
@@ -95,6 +120,12 @@ esp_err_t my_lvgl_port_init(void)
         return ESP_FAIL;
     }
 
+    if (lvgl_port_lock(0)) {
+        lv_display_add_event_cb(lvgl_disp, lvgl_render_trace_cb, LV_EVENT_RENDER_START, NULL);
+        lv_display_add_event_cb(lvgl_disp, lvgl_render_trace_cb, LV_EVENT_RENDER_READY, NULL);
+        lvgl_port_unlock();
+    }
+
     // Step 5: Add touch input
     ESP_LOGI(TAG, "Adding touch input");
     const lvgl_port_touch_cfg_t touch_cfg = {
@@ -108,6 +139,14 @@ esp_err_t my_lvgl_port_init(void)
         return ESP_FAIL;
     }
 
+    // With INT wired, the touch is read on new data only (polls otherwise)
+    gt911_enable_interrupt();
+
+    if (lvgl_port_lock(0)) {
+        touch_latency_attach(lvgl_disp, lvgl_touch_indev);
+        lvgl_port_unlock();
+    }
+
     ESP_LOGI(TAG, "LVGL port initialized successfully");
     ESP_LOGI(TAG, "Display: %dx%d, avoid_tearing: ON, direct_mode: ON", LCD_H_RES, LCD_V_RES);
     
@@ -123,3 +162,46 @@ void my_lvgl_port_unlock(void)
 {
     lvgl_port_unlock();
 }
+
+void my_lvgl_port_get_render_stats(my_lvgl_port_render_stats_t *stats)
+{
+    stats->frames = render_frames;
+    stats->render_us = render_total_us;
+}
+
+static lv_obj_tree_walk_res_t count_objects_cb(lv_obj_t *obj, void *user_data)
+{
+    (*(uint32_t *)user_data)++;
+    return LV_OBJ_TREE_WALK_NEXT;
+}
+
+uint32_t my_lvgl_port_count_tree(lv_obj_t *root)
+{
+    uint32_t count = 0;
+    if (root) lv_obj_tree_walk(root, count_objects_cb, &count);
+    return count;
+}
+
+uint32_t my_lvgl_port_get_screens(lv_obj_t **screens, uint32_t max)
+{
+    if (!lvgl_disp) return 0;
+    for (uint32_t i = 0; i < lvgl_disp->screen_cnt && i < max; i++) {
+        screens[i] = lvgl_disp->screens[i];
+    }
+    return lvgl_disp->screen_cnt;
+}
+
+uint32_t my_lvgl_port_count_objects(void)
+{
+    if (!lvgl_disp) return 0;
+
+    // Every screen, not just the active one: hidden app screens hold memory too
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < lvgl_disp->screen_cnt; i++) {
+        count += my_lvgl_port_count_tree(lvgl_disp->screens[i]);
+    }
+    count += my_lvgl_port_count_tree(lvgl_disp->bottom_layer);
+    count += my_lvgl_port_count_tree(lvgl_disp->top_layer);
+    count += my_lvgl_port_count_tree(lvgl_disp->sys_layer);
+    return count;
+}
@@ -31,6 +31,34 @@ bool my_lvgl_port_lock(uint32_t timeout_ms);
  */
 void my_lvgl_port_unlock(void);
 
+typedef struct {
+    uint32_t frames;        // Frames rendered since boot
+    uint64_t render_us;     // Time spent rendering them (RENDER_START to RENDER_READY)
+} my_lvgl_port_render_stats_t;
+
+/**
+ * @brief Read the render counters; sample twice and diff for FPS and
+ * average render time. Call with the LVGL lock held.
+ */
+void my_lvgl_port_get_render_stats(my_lvgl_port_render_stats_t *stats);
+
+/**
+ * @brief Count LVGL objects on every screen and layer. Walks the whole
+ * tree, so call it at most a few times a second, with the LVGL lock held.
+ */
+uint32_t my_lvgl_port_count_objects(void);
+
+/**
+ * @brief Count the objects of one tree, root included (LVGL lock held)
+ */
+uint32_t my_lvgl_port_count_tree(lv_obj_t *root);
+
+/**
+ * @brief List the display's screens, for per-screen object counts
+ * @return Total number of screens; at most max are stored
+ */
+uint32_t my_lvgl_port_get_screens(lv_obj_t **screens, uint32_t max);
+
 #ifdef __cplusplus
 }
 #endif
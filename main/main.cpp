@@ -4,6 +4,7 @@
 #include "esp_system.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 #include "lvgl.h"
 #include "lvgl_port.h"
@@ -14,6 +15,10 @@
 #include "boot_button.h"
 #include "recovery_trigger.h"
 #include "recovery_ui.h"
+#include "boot_sequence.h"
+#include "mem_diag.h"
+#include "cpu_stats.h"
+#include "http_service.h"
 
 static const char *TAG = "Win32";
 
@@ -24,6 +29,64 @@ static void on_app_launch(const char* app_name)
     app_launch(app_name);
 }
 
+// ============ BOOT STEPS ============
+
+enum {
+    STEP_BACKLIGHT = 0,
+    STEP_BATTERY,
+    STEP_LITTLEFS,
+    STEP_SDCARD,
+    STEP_SETTINGS,
+    STEP_LVGL,
+    STEP_UI,
+    STEP_WIFI,
+    STEP_COUNT
+};
+
+static esp_err_t step_settings(void)
+{
+    return settings_init() == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t step_ui(void)
+{
+    if (!lvgl_port_lock(0)) return ESP_ERR_TIMEOUT;
+    win32_ui_init();
+    win32_set_app_launch_callback(on_app_launch);
+    win32_show_boot_screen();
+    perf_hud_set_visible(settings_get_debug_mode());
+    mem_diag_start();
+    lvgl_port_unlock();
+    return ESP_OK;
+}
+
+static esp_err_t step_wifi(void)
+{
+    if (system_wifi_init() != 0) return ESP_FAIL;
+    // Before anything can issue a request from another task
+    http_service_init();
+    // Saved networks carry their channel/BSSID, so this usually skips the scan
+    system_wifi_autoconnect();
+    return ESP_OK;
+}
+
+// Display/UI chain stays on core 0 while storage probing and the C6
+// co-processor bring-up overlap it on core 1. SD and Wi-Fi are ordered
+// because both go through the SDMMC host (slot 0 card, slot 1 ESP-Hosted).
+#define DEP(s) BOOT_STEP_BIT(STEP_##s)
+
+static const boot_step_t boot_steps[STEP_COUNT] = {
+    // name, step, deps (must succeed), after (ordering only), core, stack
+    {"backlight", hw_backlight_init, 0,                         0,                           0,    0},
+    {"battery",   hw_battery_init,   0,                         0,                           1,    0},
+    {"littlefs",  hw_littlefs_init,  0,                         0,                           1,    0},
+    {"sdcard",    hw_sdcard_init,    0,                         0,                           1,    6144},
+    {"settings",  step_settings,     DEP(LITTLEFS),             0,                           1,    6144},
+    {"lvgl",      my_lvgl_port_init, 0,                         DEP(BACKLIGHT),              0,    8192},
+    {"ui",        step_ui,           DEP(LVGL) | DEP(SETTINGS), 0,                           0,    10240},
+    {"wifi",      step_wifi,         0,                         DEP(SDCARD) | DEP(SETTINGS), 1,    6144},
+};
+
 extern "C" void app_main(void)
 {
     ESP_LOGI(TAG, "=================================");
@@ -33,26 +96,21 @@ extern "C" void app_main(void)
     
     ESP_LOGI(TAG, "ESP-IDF Version: %s", esp_get_idf_version());
     
-    // Initialize NVS
+    // Initialize NVS (every other boot step depends on it)
     ESP_LOGI(TAG, "Initializing NVS");
+    int64_t t_nvs = esp_timer_get_time();
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_ERROR_CHECK(nvs_flash_erase());
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    boot_timeline_record("nvs", t_nvs, esp_timer_get_time(), true);
     
     // Print memory info
     ESP_LOGI(TAG, "Free heap: %u bytes", (unsigned int)esp_get_free_heap_size());
     ESP_LOGI(TAG, "Free PSRAM: %u bytes", (unsigned int)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
     
-    // Initialize hardware abstraction layer
-    ESP_LOGI(TAG, "Initializing hardware");
-    hw_backlight_init();
-    hw_battery_init();
-    hw_littlefs_init();
-    hw_sdcard_init();  // Will fail gracefully if no card
-    
     // Initialize BOOT button
     ESP_LOGI(TAG, "Initializing BOOT button");
     boot_button_init();
@@ -63,20 +121,22 @@ extern "C" void app_main(void)
         recovery_request_reboot();
     }
     
-    // Initialize system settings (after LittleFS)
-    ESP_LOGI(TAG, "Initializing system settings");
-    settings_init();
+    // Check if recovery mode was requested (via NVS flag)
+    bool recovery_mode = recovery_check_flag();
     
-    // Initialize LVGL port (display + touch + LVGL)
-    ESP_LOGI(TAG, "Initializing LVGL port");
-    ret = my_lvgl_port_init();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize LVGL port: %s", esp_err_to_name(ret));
+    // Bring up hardware, storage, settings, display and UI as a dependency graph.
+    // Recovery mode only needs the display; UI and WiFi are left out.
+    ESP_LOGI(TAG, "Running boot sequence");
+    uint32_t skip = recovery_mode ? (BOOT_STEP_BIT(STEP_UI) | BOOT_STEP_BIT(STEP_WIFI)) : 0;
+    boot_sequence_run(boot_steps, STEP_COUNT, skip);
+    
+    if (!boot_sequence_step_ok(STEP_LVGL)) {
+        ESP_LOGE(TAG, "Failed to initialize LVGL port");
+        if (!recovery_mode) boot_timeline_save();
         return;
     }
     
-    // Check if recovery mode was requested (via RTC flag)
-    if (recovery_check_flag()) {
+    if (recovery_mode) {
         ESP_LOGW(TAG, "Recovery flag set - entering Recovery Mode");
         if (lvgl_port_lock(0)) {
             recovery_ui_start();
@@ -100,21 +160,12 @@ extern "C" void app_main(void)
         return;
     }
     
-    // Normal boot - increment boot counter
+    // Normal boot - increment boot counter and keep this boot's timeline
+    // (saved again with time-to-lock-screen once the lock screen shows)
     recovery_increment_boot_count();
-    
-    // Initialize Win32 UI
-    ESP_LOGI(TAG, "Initializing Win32 UI");
-    if (lvgl_port_lock(0)) {
-        win32_ui_init();
-        win32_set_app_launch_callback(on_app_launch);
-        win32_show_boot_screen();
-        lvgl_port_unlock();
-    }
-    
-    // Initialize WiFi
-    ESP_LOGI(TAG, "Initializing WiFi");
-    system_wifi_init();
+    boot_timeline_save();
+    // Per-task CPU load for Task Manager and the console "top"
+    cpu_stats_start();
     
     ESP_LOGI(TAG, "=================================");
     ESP_LOGI(TAG, "   Win32 OS Started!");
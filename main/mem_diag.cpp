@@ -0,0 +1,325 @@
+/**
+ * Win32 OS - Memory Diagnostics Implementation
+ * Heap history on an LVGL timer, app close accounting hooked into the
+ * app window lifecycle, and an NVS copy for recovery mode
+ */
+
+#include "mem_diag.h"
+#include "lvgl_port.h"
+#include "recovery_trigger.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "nvs.h"
+#include <string.h>
+#include <stdio.h>
+
+static const char *TAG = "MEM_DIAG";
+
+// NVS namespace and keys
+#define MEM_DIAG_NVS_NAMESPACE  "memdiag"
+#define MEM_DIAG_NVS_KEY        "snapshot"
+
+#define MEM_DIAG_FIRST_INTERVAL_S   30
+#define MEM_DIAG_SAVE_PERIOD_S      600     // NVS copy at most this often (plus on restart)
+#define MEM_DIAG_NOISE_BYTES        512     // Smaller drops after a close are not counted
+#define MEM_DIAG_TREND_MIN_KB       8       // Session drop worth reporting
+#define MEM_DIAG_MAX_SCREENS        16
+
+static const uint32_t s_cap_flags[MEM_DIAG_CAP_COUNT] = {
+    MALLOC_CAP_INTERNAL, MALLOC_CAP_DMA, MALLOC_CAP_SPIRAM
+};
+static const char *s_cap_names[MEM_DIAG_CAP_COUNT] = { "internal", "dma", "psram" };
+
+static mem_diag_snapshot_t s_snap = {};
+static lv_timer_t *s_timer = NULL;
+static uint32_t s_last_save_s = 0;
+
+// App whose window is open, and its object count taken before deletion
+static char s_open_app[MEM_DIAG_APP_NAME_LEN] = "";
+static uint16_t s_window_objects = 0;
+
+static uint32_t uptime_s(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+static uint16_t to_kb(size_t bytes)
+{
+    size_t kb = bytes / 1024;
+    return kb > UINT16_MAX ? UINT16_MAX : (uint16_t)kb;
+}
+
+static uint16_t clamp_u16(uint32_t v)
+{
+    return v > UINT16_MAX ? UINT16_MAX : (uint16_t)v;
+}
+
+static void take_sample(mem_diag_sample_t *sample)
+{
+    sample->time_s = uptime_s();
+    sample->objects = clamp_u16(my_lvgl_port_count_objects());
+    for (int c = 0; c < MEM_DIAG_CAP_COUNT; c++) {
+        sample->heap[c].free_kb = to_kb(heap_caps_get_free_size(s_cap_flags[c]));
+        sample->heap[c].largest_kb = to_kb(heap_caps_get_largest_free_block(s_cap_flags[c]));
+        sample->heap[c].min_free_kb = to_kb(heap_caps_get_minimum_free_size(s_cap_flags[c]));
+    }
+}
+
+static void sample_timer_cb(lv_timer_t *t)
+{
+    // Full: keep every other sample and halve the rate, so the history
+    // always spans the whole session
+    if (s_snap.count == MEM_DIAG_HISTORY) {
+        for (int i = 0; i < MEM_DIAG_HISTORY / 2; i++) {
+            s_snap.history[i] = s_snap.history[2 * i + 1];
+        }
+        s_snap.count = MEM_DIAG_HISTORY / 2;
+        s_snap.interval_s *= 2;
+        lv_timer_set_period(t, s_snap.interval_s * 1000);
+    }
+    take_sample(&s_snap.history[s_snap.count++]);
+
+    if (uptime_s() - s_last_save_s >= MEM_DIAG_SAVE_PERIOD_S) {
+        mem_diag_save();
+    }
+}
+
+void mem_diag_start(void)
+{
+    if (s_timer) return;
+
+    s_snap.boot_count = recovery_get_boot_count();
+    s_snap.interval_s = MEM_DIAG_FIRST_INTERVAL_S;
+    s_last_save_s = uptime_s();
+    s_timer = lv_timer_create(sample_timer_cb, MEM_DIAG_FIRST_INTERVAL_S * 1000, NULL);
+    // Reboots (console, recovery request) keep the latest numbers for recovery mode
+    esp_register_shutdown_handler(mem_diag_save);
+    ESP_LOGI(TAG, "Sampling every %d s", MEM_DIAG_FIRST_INTERVAL_S);
+}
+
+// ============ APP CYCLES ============
+
+void mem_diag_app_opened(const char *name)
+{
+    if (!s_timer || !name) return;
+    strncpy(s_open_app, name, sizeof(s_open_app) - 1);
+    s_open_app[sizeof(s_open_app) - 1] = '\0';
+}
+
+void mem_diag_app_closing(lv_obj_t *window)
+{
+    s_window_objects = clamp_u16(my_lvgl_port_count_tree(window));
+}
+
+static mem_diag_app_t *find_app(const char *name)
+{
+    for (int i = 0; i < s_snap.app_count; i++) {
+        if (strcmp(s_snap.apps[i].name, name) == 0) return &s_snap.apps[i];
+    }
+    if (s_snap.app_count >= MEM_DIAG_APPS) return NULL;
+
+    mem_diag_app_t *app = &s_snap.apps[s_snap.app_count++];
+    memset(app, 0, sizeof(*app));
+    strcpy(app->name, name);
+    return app;
+}
+
+void mem_diag_app_closed(void)
+{
+    if (!s_open_app[0]) return;
+
+    mem_diag_app_t *app = find_app(s_open_app);
+    s_open_app[0] = '\0';
+    if (!app) return;
+
+    uint32_t free_now = heap_caps_get_free_size(MALLOC_CAP_INTERNAL) +
+                        heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    uint16_t objects = clamp_u16(my_lvgl_port_count_objects());
+
+    if (app->cycles == 0) {
+        app->free_first = free_now;
+        app->objects_first = objects;
+    } else {
+        bool heap_was = app->heap_rising >= MEM_DIAG_LEAK_CYCLES;
+        bool obj_was = app->obj_rising >= MEM_DIAG_LEAK_CYCLES;
+        if (free_now + MEM_DIAG_NOISE_BYTES < app->free_last) {
+            if (app->heap_rising < UINT8_MAX) app->heap_rising++;
+        } else {
+            app->heap_rising = 0;
+        }
+        if (objects > app->objects_last) {
+            if (app->obj_rising < UINT8_MAX) app->obj_rising++;
+        } else {
+            app->obj_rising = 0;
+        }
+
+        bool heap_now = app->heap_rising >= MEM_DIAG_LEAK_CYCLES;
+        bool obj_now = app->obj_rising >= MEM_DIAG_LEAK_CYCLES;
+        if ((heap_now && !heap_was) || (obj_now && !obj_was)) {
+            ESP_LOGW(TAG, "Suspected leak in %s: %ld bytes, %d objects since its first close",
+                     app->name, (long)app->free_first - (long)free_now,
+                     (int)objects - (int)app->objects_first);
+            mem_diag_save();
+        }
+    }
+    app->free_last = free_now;
+    app->objects_last = objects;
+    app->window_objects = s_window_objects;
+    app->cycles++;
+}
+
+// ============ PERSISTENCE ============
+
+void mem_diag_get(mem_diag_snapshot_t *out)
+{
+    if (out) *out = s_snap;
+}
+
+void mem_diag_save(void)
+{
+    if (!s_timer) return;
+
+    nvs_handle_t handle;
+    if (nvs_open(MEM_DIAG_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGW(TAG, "Cannot open NVS to save memory report");
+        return;
+    }
+    nvs_set_blob(handle, MEM_DIAG_NVS_KEY, &s_snap, sizeof(s_snap));
+    nvs_commit(handle);
+    nvs_close(handle);
+    s_last_save_s = uptime_s();
+}
+
+int mem_diag_load_last(mem_diag_snapshot_t *out)
+{
+    if (!out) return -1;
+
+    nvs_handle_t handle;
+    if (nvs_open(MEM_DIAG_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return -1;
+    }
+
+    size_t size = sizeof(*out);
+    esp_err_t err = nvs_get_blob(handle, MEM_DIAG_NVS_KEY, out, &size);
+    nvs_close(handle);
+
+    if (err != ESP_OK || size != sizeof(*out) ||
+        out->count > MEM_DIAG_HISTORY || out->app_count > MEM_DIAG_APPS) {
+        return -1;
+    }
+    return 0;
+}
+
+// ============ REPORT ============
+
+static void format_time(char *buf, size_t len, uint32_t s)
+{
+    snprintf(buf, len, "%lu:%02lu:%02lu", (unsigned long)(s / 3600),
+             (unsigned long)(s / 60 % 60), (unsigned long)(s % 60));
+}
+
+// Capability whose free size fell in most intervals by a real amount
+static int format_trend(const mem_diag_snapshot_t *snap, int cap, char *buf, size_t len)
+{
+    if (snap->count < 8) return 0;
+
+    int falls = 0;
+    for (int i = 1; i < snap->count; i++) {
+        if (snap->history[i].heap[cap].free_kb < snap->history[i - 1].heap[cap].free_kb) falls++;
+    }
+    int drop = (int)snap->history[0].heap[cap].free_kb - (int)snap->history[snap->count - 1].heap[cap].free_kb;
+    if (drop < MEM_DIAG_TREND_MIN_KB || falls * 4 < (snap->count - 1) * 3) return 0;
+
+    return snprintf(buf, len, "  session: %s free fell %d KB, in %d of %d intervals\n",
+                    s_cap_names[cap], drop, falls, snap->count - 1);
+}
+
+int mem_diag_format(const mem_diag_snapshot_t *snap, char *buf, size_t len)
+{
+    if (!snap || !buf || len == 0) return 0;
+
+    char t[16];
+    const mem_diag_sample_t *last = snap->count ? &snap->history[snap->count - 1] : NULL;
+    format_time(t, sizeof(t), last ? last->time_s : 0);
+    int pos = snprintf(buf, len, "Memory report, boot #%lu, up %s, every %lu s\n",
+                       (unsigned long)snap->boot_count, t, (unsigned long)snap->interval_s);
+
+    if (last && pos < (int)len) {
+        pos += snprintf(buf + pos, len - pos, "heap       free  largest  min ever (KB)\n");
+        for (int c = 0; c < MEM_DIAG_CAP_COUNT && pos < (int)len; c++) {
+            pos += snprintf(buf + pos, len - pos, "%-8s %6u %8u %9u\n", s_cap_names[c],
+                            last->heap[c].free_kb, last->heap[c].largest_kb, last->heap[c].min_free_kb);
+        }
+    }
+
+    if (pos < (int)len) {
+        pos += snprintf(buf + pos, len - pos, "\nSuspected leaks:\n");
+    }
+    int start = pos;
+    for (int i = 0; i < snap->app_count && pos < (int)len; i++) {
+        const mem_diag_app_t *a = &snap->apps[i];
+        if (a->heap_rising >= MEM_DIAG_LEAK_CYCLES) {
+            pos += snprintf(buf + pos, len - pos, "  %s: last %u closes each left less heap (%+ld KB)\n",
+                            a->name, a->heap_rising, ((long)a->free_first - (long)a->free_last) / 1024);
+        }
+        if (a->obj_rising >= MEM_DIAG_LEAK_CYCLES && pos < (int)len) {
+            pos += snprintf(buf + pos, len - pos, "  %s: last %u closes each left more objects (%+d)\n",
+                            a->name, a->obj_rising, (int)a->objects_last - (int)a->objects_first);
+        }
+    }
+    for (int c = 0; c < MEM_DIAG_CAP_COUNT && pos < (int)len; c++) {
+        pos += format_trend(snap, c, buf + pos, len - pos);
+    }
+    if (pos == start && pos < (int)len) {
+        pos += snprintf(buf + pos, len - pos, "  none\n");
+    }
+
+    if (snap->app_count && pos < (int)len) {
+        pos += snprintf(buf + pos, len - pos, "\nApps (left after close)  runs  heap   objs  window\n");
+    }
+    for (int i = 0; i < snap->app_count && pos < (int)len; i++) {
+        const mem_diag_app_t *a = &snap->apps[i];
+        long heap = ((long)a->free_first - (long)a->free_last) / 1024;
+        pos += snprintf(buf + pos, len - pos, "%-16s %12u %+5ldK %+5d %7u\n", a->name, a->cycles,
+                        heap, (int)a->objects_last - (int)a->objects_first, a->window_objects);
+    }
+
+    if (pos < (int)len) {
+        pos += snprintf(buf + pos, len - pos, "\nHistory (KB)  int  blk  dma  psram  blk  objs\n");
+    }
+    for (int i = 0; i < snap->count && pos < (int)len; i++) {
+        const mem_diag_sample_t *s = &snap->history[i];
+        format_time(t, sizeof(t), s->time_s);
+        pos += snprintf(buf + pos, len - pos, "%9s %6u %4u %4u %6u %4u %5u\n", t,
+                        s->heap[MEM_DIAG_CAP_INTERNAL].free_kb, s->heap[MEM_DIAG_CAP_INTERNAL].largest_kb,
+                        s->heap[MEM_DIAG_CAP_DMA].free_kb,
+                        s->heap[MEM_DIAG_CAP_SPIRAM].free_kb, s->heap[MEM_DIAG_CAP_SPIRAM].largest_kb,
+                        s->objects);
+    }
+    return pos < (int)len ? pos : (int)len - 1;
+}
+
+int mem_diag_format_screens(char *buf, size_t len)
+{
+    if (!buf || len == 0) return 0;
+
+    lv_obj_t *screens[MEM_DIAG_MAX_SCREENS];
+    uint32_t n = my_lvgl_port_get_screens(screens, MEM_DIAG_MAX_SCREENS);
+    if (n > MEM_DIAG_MAX_SCREENS) n = MEM_DIAG_MAX_SCREENS;
+
+    lv_obj_t *active = lv_screen_active();
+    int pos = snprintf(buf, len, "LVGL objects: %lu\n", (unsigned long)my_lvgl_port_count_objects());
+    for (uint32_t i = 0; i < n && pos < (int)len; i++) {
+        pos += snprintf(buf + pos, len - pos, "  screen %lu: %lu%s\n", (unsigned long)i,
+                        (unsigned long)my_lvgl_port_count_tree(screens[i]),
+                        screens[i] == active ? " (active)" : "");
+    }
+    if (pos < (int)len) {
+        pos += snprintf(buf + pos, len - pos, "  top layer: %lu, sys layer: %lu\n",
+                        (unsigned long)my_lvgl_port_count_tree(lv_layer_top()),
+                        (unsigned long)my_lvgl_port_count_tree(lv_layer_sys()));
+    }
+    return pos < (int)len ? pos : (int)len - 1;
+}
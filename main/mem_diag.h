@@ -0,0 +1,119 @@
+/**
+ * Win32 OS - Memory Diagnostics
+ * Samples free size, largest free block and minimum-ever free per heap
+ * capability over the whole session, counts LVGL objects, and records
+ * what every app leaves behind when its window closes. Apps whose closes
+ * keep leaving less free heap (or more objects) behind are reported as
+ * suspected leaks.
+ *
+ * The snapshot is persisted to NVS so recovery mode can print the report
+ * of the last session.
+ */
+
+#ifndef MEM_DIAG_H
+#define MEM_DIAG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEM_DIAG_HISTORY        48      // Samples; spacing doubles when full
+#define MEM_DIAG_APPS           16      // Apps tracked per session
+#define MEM_DIAG_APP_NAME_LEN   16
+#define MEM_DIAG_LEAK_CYCLES    3       // Rising closes in a row before an app is flagged
+
+typedef enum {
+    MEM_DIAG_CAP_INTERNAL = 0,
+    MEM_DIAG_CAP_DMA,
+    MEM_DIAG_CAP_SPIRAM,
+    MEM_DIAG_CAP_COUNT
+} mem_diag_cap_t;
+
+// One heap capability at one point in time (KB)
+typedef struct {
+    uint16_t free_kb;
+    uint16_t largest_kb;        // Largest free block
+    uint16_t min_free_kb;       // Lowest free since boot
+} mem_diag_heap_t;
+
+typedef struct {
+    uint32_t time_s;            // Uptime
+    uint16_t objects;           // LVGL objects on all screens and layers
+    mem_diag_heap_t heap[MEM_DIAG_CAP_COUNT];
+} mem_diag_sample_t;
+
+// What an app left behind, measured right after its window was deleted
+typedef struct {
+    char name[MEM_DIAG_APP_NAME_LEN];
+    uint16_t cycles;            // Open/close cycles
+    uint8_t heap_rising;        // Closes in a row that left less free heap than the one before
+    uint8_t obj_rising;         // Closes in a row that left more LVGL objects
+    uint16_t window_objects;    // Objects in the app window at its last close
+    uint16_t objects_first;     // LVGL objects left after the first close
+    uint16_t objects_last;
+    uint32_t free_first;        // Free heap (internal + PSRAM) after the first close
+    uint32_t free_last;
+} mem_diag_app_t;
+
+// Session snapshot, persisted to NVS
+typedef struct {
+    uint32_t boot_count;
+    uint32_t interval_s;        // Current spacing of the history samples
+    uint8_t count;
+    uint8_t app_count;
+    mem_diag_sample_t history[MEM_DIAG_HISTORY];
+    mem_diag_app_t apps[MEM_DIAG_APPS];
+} mem_diag_snapshot_t;
+
+/**
+ * Start sampling; call once from the LVGL task after the UI is up
+ */
+void mem_diag_start(void);
+
+/**
+ * Record app open/close cycles (LVGL task)
+ * closing() counts the window's objects before it is deleted, closed()
+ * measures what is left afterwards and updates the app's leak streaks.
+ */
+void mem_diag_app_opened(const char *name);
+void mem_diag_app_closing(lv_obj_t *window);
+void mem_diag_app_closed(void);
+
+/**
+ * Copy the current session's snapshot
+ */
+void mem_diag_get(mem_diag_snapshot_t *out);
+
+/**
+ * Write the current snapshot to NVS (also done periodically and on restart)
+ */
+void mem_diag_save(void);
+
+/**
+ * Load the snapshot of the last session that saved one
+ * @return 0 on success, -1 if none stored
+ */
+int mem_diag_load_last(mem_diag_snapshot_t *out);
+
+/**
+ * Format a snapshot: current heaps, history, per-app results, suspects
+ * @return Number of characters written
+ */
+int mem_diag_format(const mem_diag_snapshot_t *snap, char *buf, size_t len);
+
+/**
+ * Format live LVGL object counts per screen (LVGL lock held)
+ * @return Number of characters written
+ */
+int mem_diag_format_screens(char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEM_DIAG_H
@@ -6,6 +6,8 @@
 #include "recovery_ui.h"
 #include "recovery_trigger.h"
 #include "recovery_sysinfo.h"
+#include "boot_sequence.h"
+#include "mem_diag.h"
 #include "boot_button.h"
 #include "ui/fonts.h"
 #include "hardware/hardware.h"
@@ -88,6 +90,8 @@ static void cmd_partitions(void);
 static void cmd_memtest(void);
 static void cmd_displaytest(void);
 static void cmd_sdtest(void);
+static void cmd_boottime(void);
+static void cmd_memdiag(void);
 static void cmd_poweroff(void);
 static void cmd_ui(void);
 
@@ -540,6 +544,10 @@ void recovery_console_process_cmd(const char *cmd)
         cmd_displaytest();
     } else if (strcmp(cmd, "sdtest") == 0) {
         cmd_sdtest();
+    } else if (strcmp(cmd, "boottime") == 0) {
+        cmd_boottime();
+    } else if (strcmp(cmd, "memdiag") == 0) {
+        cmd_memdiag();
     } else if (strcmp(cmd, "poweroff") == 0) {
         cmd_poweroff();
     } else if (strcmp(cmd, "ui") == 0) {
@@ -568,6 +576,8 @@ static void cmd_help(void)
         "  memtest     - Run memory test\n"
         "  displaytest - Run display test\n"
         "  sdtest      - Test SD card\n"
+        "  boottime    - Show last boot timeline\n"
+        "  memdiag     - Memory report of last session\n"
         "  poweroff    - Shut down device\n"
         "  ui          - Switch to UI mode\n"
         "  clear       - Clear console\n"
@@ -643,6 +653,9 @@ static void cmd_wipe_data(void)
     // Unmount and format LittleFS
     esp_littlefs_format("storage");
     
+    // User settings live in NVS, reset them as well
+    settings_factory_reset();
+    
     recovery_console_print("User data wiped successfully.\n");
 }
 
@@ -676,11 +689,11 @@ static void cmd_wipe_lock(void)
         recovery_console_print("NVS lock settings cleared.\n");
     }
     
-    // Remove system config file to reset all user settings including password
-    if (remove("/littlefs/system.cfg") == 0) {
-        recovery_console_print("System config file removed.\n");
+    // Clear password/PIN in the settings store
+    if (settings_reset_lock() == 0) {
+        recovery_console_print("Lock settings cleared.\n");
     } else {
-        recovery_console_print("Config file not found or already removed.\n");
+        recovery_console_print("Failed to update settings store.\n");
     }
     
     recovery_console_print("Lock screen reset complete.\n");
@@ -914,6 +927,36 @@ static void cmd_sdtest(void)
     }
 }
 
+static void cmd_boottime(void)
+{
+    boot_timeline_t tl;
+    if (boot_timeline_load_last(&tl) != 0) {
+        recovery_console_print("No boot timeline recorded yet.\n");
+        return;
+    }
+    
+    char buf[1536];
+    boot_timeline_format(&tl, buf, sizeof(buf));
+    recovery_console_print(buf);
+}
+
+static void cmd_memdiag(void)
+{
+    mem_diag_snapshot_t *snap = (mem_diag_snapshot_t *)heap_caps_malloc(sizeof(*snap), MALLOC_CAP_SPIRAM);
+    // Leaves room in the 4 KB console buffer; the report ends with the oldest data
+    char *buf = (char *)heap_caps_malloc(3072, MALLOC_CAP_SPIRAM);
+    if (!snap || !buf) {
+        recovery_console_print("Out of memory\n");
+    } else if (mem_diag_load_last(snap) != 0) {
+        recovery_console_print("No memory report saved yet.\n");
+    } else {
+        mem_diag_format(snap, buf, 3072);
+        recovery_console_print(buf);
+    }
+    heap_caps_free(snap);
+    heap_caps_free(buf);
+}
+
 static void cmd_poweroff(void)
 {
     recovery_console_print("Shutting down...\n");
@@ -1010,6 +1053,7 @@ static void show_confirmation_dialog(const char *title, const char *msg, lv_even
 static void do_wipe_data(lv_event_t *e)
 {
     esp_littlefs_format("storage");
+    settings_factory_reset();
     ESP_LOGI(TAG, "User data wiped");
     // Show success message
     if (g_confirm_dialog) {
@@ -1043,39 +1087,9 @@ static void do_reset_lock(lv_event_t *e)
         nvs_close(nvs);
     }
     
-    // Method 2: Modify system.cfg file directly
-    // Read current settings, clear password, save back
-    FILE *f = fopen("/littlefs/system.cfg", "rb");
-    if (f) {
-        // Get file size
-        fseek(f, 0, SEEK_END);
-        long size = ftell(f);
-        fseek(f, 0, SEEK_SET);
-        
-        if (size > 0 && size < 4096) {
-            uint8_t *buf = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-            if (buf) {
-                fread(buf, 1, size, f);
-                fclose(f);
-                
-                // The settings structure has user profile with password
-                // We need to find and clear the password field
-                // For safety, we'll just delete the file and let system recreate with defaults
-                // Or we can try to patch it
-                
-                // Simple approach: delete the config file
-                // System will recreate with defaults on next boot
-                remove("/littlefs/system.cfg");
-                
-                heap_caps_free(buf);
-                ESP_LOGI(TAG, "Lock screen reset - config file removed");
-            } else {
-                fclose(f);
-            }
-        } else {
-            fclose(f);
-        }
-    }
+    // Method 2: Clear password/PIN in the settings store
+    settings_reset_lock();
+    ESP_LOGI(TAG, "Lock screen reset - password cleared");
     
     // Show success message
     if (g_confirm_dialog) {
@@ -1402,6 +1416,20 @@ static void run_sdtest_ui(void)
     show_diag_result("SD Card Test", result);
 }
 
+static void run_boottime_ui(void)
+{
+    char result[1536];
+    boot_timeline_t tl;
+    
+    if (boot_timeline_load_last(&tl) != 0) {
+        snprintf(result, sizeof(result), "No boot timeline recorded yet.\n\nBoot normally once and try again.\n");
+    } else {
+        boot_timeline_format(&tl, result, sizeof(result));
+    }
+    
+    show_diag_result("Boot Timeline", result);
+}
+
 static void diagnostics_item_cb(lv_event_t *e)
 {
     const char *action = (const char *)lv_event_get_user_data(e);
@@ -1422,6 +1450,8 @@ static void diagnostics_item_cb(lv_event_t *e)
         run_sdtest_ui();
     } else if (strcmp(action, "sysinfo") == 0) {
         run_sysinfo_ui();
+    } else if (strcmp(action, "boottime") == 0) {
+        run_boottime_ui();
     }
 }
 
@@ -1464,18 +1494,20 @@ static void show_diagnostics(void)
         "Memory Test",
         "Display Test",
         "SD Card Test",
-        "System Info"
+        "System Info",
+        "Boot Timeline"
     };
     static const char *descs[] = {
         "Test PSRAM read/write",
         "Test display colors",
         "Test SD card read/write",
-        "View hardware info"
+        "View hardware info",
+        "Startup time per stage"
     };
-    static const char *actions[] = {"memtest", "displaytest", "sdtest", "sysinfo"};
+    static const char *actions[] = {"memtest", "displaytest", "sdtest", "sysinfo", "boottime"};
     
     int y = 80;
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < 5; i++) {
         lv_obj_t *item = lv_obj_create(g_diagnostics_screen);
         lv_obj_set_size(item, SCREEN_WIDTH - 40, 70);
         lv_obj_set_pos(item, 20, y);
@@ -1,22 +1,135 @@
 /**
  * Win32 OS - System Settings Implementation
- * Persistent storage using LittleFS
+ * Persistent storage using a schema-versioned NVS key-value store
+ *
+ * Every field group is stored under its own NVS key, so a setter only
+ * rewrites the keys whose bytes actually changed. Keys are grouped into
+ * sections that are read from flash on first access, not at boot.
  */
 
 #include "system_settings.h"
+#include "trace.h"
 #include "esp_log.h"
-#include "esp_littlefs.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <stdlib.h>
 
 static const char *TAG = "SETTINGS";
-static const char *SETTINGS_FILE = "/littlefs/system.cfg";
+
+// NVS namespace and schema
+#define SETTINGS_NVS_NAMESPACE  "syscfg"
+#define SETTINGS_KEY_SCHEMA     "schema"
+#define SETTINGS_SCHEMA_VERSION 2       // 1 = legacy raw struct file
+#define SETTINGS_MAX_BLOB       128     // Largest single key value
+
+// Legacy v1 storage (raw struct dump), migrated on first boot
+#ifndef SETTINGS_LEGACY_PATH
+#define SETTINGS_LEGACY_PATH    "/littlefs/system.cfg"   // Host tests point this elsewhere
+#endif
+static const char *LEGACY_SETTINGS_FILE = SETTINGS_LEGACY_PATH;
+
+// wifi_credentials_t as written by v1; the current struct appends AP fields
+typedef struct {
+    char ssid[33];
+    char password[65];
+    bool valid;
+} wifi_credentials_v1_t;
+
+#define LEGACY_WIFI_GROWTH \
+    (sizeof(((system_settings_t *)0)->saved_wifi) - 5 * sizeof(wifi_credentials_v1_t))
+#define LEGACY_SETTINGS_SIZE (sizeof(system_settings_t) - LEGACY_WIFI_GROWTH)
+
+// Fields after saved_wifi keep their relative layout only if the growth is
+// a multiple of the largest alignment in the struct (int64_t)
+static_assert(LEGACY_WIFI_GROWTH % 8 == 0, "v1 settings layout no longer derivable");
 
 static system_settings_t g_settings = {0};
+static system_settings_t g_persisted = {0};  // Bytes last read from / written to NVS
 static bool g_initialized = false;
+static SemaphoreHandle_t g_lock = NULL;
+
+// Lazily loaded sections
+typedef enum {
+    SEC_DISPLAY = 0,
+    SEC_TIME,
+    SEC_WIFI,
+    SEC_KEYBOARD,
+    SEC_LOCATION,
+    SEC_USER,
+    SEC_SCORES,
+    SEC_PERSONALIZATION,
+    SEC_BLUETOOTH,
+    SEC_DEBUG,
+    SEC_COUNT
+} settings_section_t;
+
+static bool g_section_loaded[SEC_COUNT] = {false};
+
+// One NVS key = one field (or array element) of system_settings_t
+typedef struct {
+    const char *name;
+    settings_section_t section;
+    size_t offset;
+    size_t size;
+} settings_key_t;
+
+#define SETTINGS_KEY(name, sec, field) \
+    { name, sec, offsetof(system_settings_t, field), sizeof(((system_settings_t *)0)->field) }
+
+static const settings_key_t g_keys[] = {
+    SETTINGS_KEY("bright",    SEC_DISPLAY, brightness),
+    SETTINGS_KEY("wallpaper", SEC_DISPLAY, wallpaper_index),
+    SETTINGS_KEY("tz",        SEC_TIME, timezone_offset),
+    SETTINGS_KEY("fmt24",     SEC_TIME, time_24h_format),
+    SETTINGS_KEY("last_time", SEC_TIME, last_known_time),
+    SETTINGS_KEY("wifi0",     SEC_WIFI, saved_wifi[0]),
+    SETTINGS_KEY("wifi1",     SEC_WIFI, saved_wifi[1]),
+    SETTINGS_KEY("wifi2",     SEC_WIFI, saved_wifi[2]),
+    SETTINGS_KEY("wifi3",     SEC_WIFI, saved_wifi[3]),
+    SETTINGS_KEY("wifi4",     SEC_WIFI, saved_wifi[4]),
+    SETTINGS_KEY("wifi_cnt",  SEC_WIFI, saved_wifi_count),
+    SETTINGS_KEY("keyboard",  SEC_KEYBOARD, keyboard),
+    SETTINGS_KEY("location",  SEC_LOCATION, location),
+    SETTINGS_KEY("user",      SEC_USER, user),
+    SETTINGS_KEY("scores",    SEC_SCORES, scores),
+    SETTINGS_KEY("ui_style",  SEC_PERSONALIZATION, personalization.ui_style),
+    SETTINGS_KEY("grid_cols", SEC_PERSONALIZATION, personalization.desktop_grid_cols),
+    SETTINGS_KEY("grid_rows", SEC_PERSONALIZATION, personalization.desktop_grid_rows),
+    SETTINGS_KEY("pinned0",   SEC_PERSONALIZATION, personalization.pinned_apps[0]),
+    SETTINGS_KEY("pinned1",   SEC_PERSONALIZATION, personalization.pinned_apps[1]),
+    SETTINGS_KEY("pinned2",   SEC_PERSONALIZATION, personalization.pinned_apps[2]),
+    SETTINGS_KEY("icon0",     SEC_PERSONALIZATION, personalization.icon_positions[0]),
+    SETTINGS_KEY("icon1",     SEC_PERSONALIZATION, personalization.icon_positions[1]),
+    SETTINGS_KEY("icon2",     SEC_PERSONALIZATION, personalization.icon_positions[2]),
+    SETTINGS_KEY("icon3",     SEC_PERSONALIZATION, personalization.icon_positions[3]),
+    SETTINGS_KEY("icon4",     SEC_PERSONALIZATION, personalization.icon_positions[4]),
+    SETTINGS_KEY("icon5",     SEC_PERSONALIZATION, personalization.icon_positions[5]),
+    SETTINGS_KEY("icon6",     SEC_PERSONALIZATION, personalization.icon_positions[6]),
+    SETTINGS_KEY("icon7",     SEC_PERSONALIZATION, personalization.icon_positions[7]),
+    SETTINGS_KEY("icon8",     SEC_PERSONALIZATION, personalization.icon_positions[8]),
+    SETTINGS_KEY("icon9",     SEC_PERSONALIZATION, personalization.icon_positions[9]),
+    SETTINGS_KEY("icon10",    SEC_PERSONALIZATION, personalization.icon_positions[10]),
+    SETTINGS_KEY("icon11",    SEC_PERSONALIZATION, personalization.icon_positions[11]),
+    SETTINGS_KEY("icon12",    SEC_PERSONALIZATION, personalization.icon_positions[12]),
+    SETTINGS_KEY("icon13",    SEC_PERSONALIZATION, personalization.icon_positions[13]),
+    SETTINGS_KEY("icon14",    SEC_PERSONALIZATION, personalization.icon_positions[14]),
+    SETTINGS_KEY("icon15",    SEC_PERSONALIZATION, personalization.icon_positions[15]),
+    SETTINGS_KEY("icon16",    SEC_PERSONALIZATION, personalization.icon_positions[16]),
+    SETTINGS_KEY("icon17",    SEC_PERSONALIZATION, personalization.icon_positions[17]),
+    SETTINGS_KEY("icon18",    SEC_PERSONALIZATION, personalization.icon_positions[18]),
+    SETTINGS_KEY("icon19",    SEC_PERSONALIZATION, personalization.icon_positions[19]),
+    SETTINGS_KEY("icon_cnt",  SEC_PERSONALIZATION, personalization.icon_position_count),
+    SETTINGS_KEY("bt_en",     SEC_BLUETOOTH, bt_enabled),
+    SETTINGS_KEY("bt_name",   SEC_BLUETOOTH, bt_name),
+    SETTINGS_KEY("debug",     SEC_DEBUG, debug_mode),
+};
+#define NUM_SETTINGS_KEYS (sizeof(g_keys) / sizeof(g_keys[0]))
 
 // Apply timezone to system
 static void apply_timezone(int8_t tz_offset) {
@@ -79,122 +192,262 @@ static void settings_set_defaults(system_settings_t *s) {
     ESP_LOGI(TAG, "Settings set to defaults");
 }
 
-int settings_init(void) {
-    if (g_initialized) return 0;
+// ============ KEY-VALUE STORE ============
+
+static void settings_lock(void) {
+    if (g_lock) xSemaphoreTakeRecursive(g_lock, portMAX_DELAY);
+}
+
+static void settings_unlock(void) {
+    if (g_lock) xSemaphoreGiveRecursive(g_lock);
+}
+
+static void load_key(nvs_handle_t nvs, const settings_key_t *k) {
+    uint8_t *field = (uint8_t *)&g_settings + k->offset;
+    uint8_t buf[SETTINGS_MAX_BLOB];
+    size_t len = sizeof(buf);
     
-    ESP_LOGI(TAG, "Initializing system settings");
+    if (nvs_get_blob(nvs, k->name, buf, &len) == ESP_OK) {
+        // A blob written by another schema may be shorter or longer:
+        // take the common prefix, keep defaults for fields appended later
+        memcpy(field, buf, len < k->size ? len : k->size);
+    }
+    memcpy((uint8_t *)&g_persisted + k->offset, field, k->size);
+}
+
+// Write every changed key of a section (SEC_COUNT = all loaded sections)
+static int settings_commit(settings_section_t section) {
+    settings_lock();
     
-    // Try to load existing settings
-    if (settings_load(&g_settings) != 0) {
-        ESP_LOGW(TAG, "No saved settings found, using defaults");
-        settings_set_defaults(&g_settings);
-        settings_save(&g_settings);
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(SETTINGS_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open settings store: %s", esp_err_to_name(err));
+        settings_unlock();
+        return -1;
     }
     
-    // Validate keyboard settings (fix corrupted values)
-    if (g_settings.keyboard.height_percent < 17 || g_settings.keyboard.height_percent > 80) {
-        ESP_LOGW(TAG, "Invalid keyboard height %d%%, resetting to 62%%", g_settings.keyboard.height_percent);
-        g_settings.keyboard.height_percent = 62;
-        g_settings.keyboard.height = 496;
-        g_settings.keyboard.use_percent = true;
-        settings_save(&g_settings);
+    int keys_written = 0;
+    size_t bytes_written = 0;
+    for (size_t i = 0; i < NUM_SETTINGS_KEYS; i++) {
+        const settings_key_t *k = &g_keys[i];
+        if (section != SEC_COUNT && k->section != section) continue;
+        if (!g_section_loaded[k->section]) continue;
+        
+        const uint8_t *cur = (const uint8_t *)&g_settings + k->offset;
+        uint8_t *old = (uint8_t *)&g_persisted + k->offset;
+        if (memcmp(cur, old, k->size) == 0) continue;
+        
+        err = nvs_set_blob(nvs, k->name, cur, k->size);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to write key '%s': %s", k->name, esp_err_to_name(err));
+            break;
+        }
+        memcpy(old, cur, k->size);
+        keys_written++;
+        bytes_written += k->size;
     }
     
-    g_initialized = true;
-    ESP_LOGI(TAG, "Settings initialized: brightness=%d, wallpaper=%d, wifi_count=%d, kb_height=%d%%",
-             g_settings.brightness, g_settings.wallpaper_index, g_settings.saved_wifi_count,
-             g_settings.keyboard.height_percent);
+    if (keys_written > 0) {
+        esp_err_t commit_err = nvs_commit(nvs);
+        if (err == ESP_OK) err = commit_err;
+    }
+    nvs_close(nvs);
+    settings_unlock();
     
-    // Apply timezone from settings
-    apply_timezone(g_settings.timezone_offset);
+    if (keys_written > 0) {
+        ESP_LOGI(TAG, "Settings saved: %d key(s), %u bytes", keys_written, (unsigned int)bytes_written);
+    }
+    return err == ESP_OK ? 0 : -1;
+}
+
+// Sanity checks applied when a section is first read
+static void settings_validate_section(settings_section_t section) {
+    if (section == SEC_KEYBOARD) {
+        if (g_settings.keyboard.height_percent < 17 || g_settings.keyboard.height_percent > 80) {
+            ESP_LOGW(TAG, "Invalid keyboard height %d%%, resetting to 62%%", g_settings.keyboard.height_percent);
+            g_settings.keyboard.height_percent = 62;
+            g_settings.keyboard.height = 496;
+            g_settings.keyboard.use_percent = true;
+            settings_commit(SEC_KEYBOARD);
+        }
+    }
+}
+
+static void ensure_section(settings_section_t section) {
+    if (g_section_loaded[section] || !g_initialized) return;
     
-    return 0;
+    settings_lock();
+    if (!g_section_loaded[section]) {
+        nvs_handle_t nvs;
+        if (nvs_open(SETTINGS_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+            for (size_t i = 0; i < NUM_SETTINGS_KEYS; i++) {
+                if (g_keys[i].section == section) {
+                    load_key(nvs, &g_keys[i]);
+                }
+            }
+            nvs_close(nvs);
+        }
+        g_section_loaded[section] = true;
+        ESP_LOGD(TAG, "Section %d loaded", (int)section);
+        settings_validate_section(section);
+    }
+    settings_unlock();
 }
 
-int settings_load(system_settings_t *settings) {
-    FILE *f = fopen(SETTINGS_FILE, "rb");
+static void ensure_all_sections(void) {
+    for (int i = 0; i < SEC_COUNT; i++) {
+        ensure_section((settings_section_t)i);
+    }
+}
+
+static void settings_write_schema(void) {
+    nvs_handle_t nvs;
+    if (nvs_open(SETTINGS_NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
+        nvs_set_u8(nvs, SETTINGS_KEY_SCHEMA, SETTINGS_SCHEMA_VERSION);
+        nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+}
+
+// Import the v1 raw struct dump from LittleFS, if one exists
+// Returns false if it must be retried on the next boot
+static bool settings_migrate_legacy(void) {
+    FILE *f = fopen(LEGACY_SETTINGS_FILE, "rb");
     if (!f) {
-        ESP_LOGW(TAG, "Settings file not found: %s", SETTINGS_FILE);
-        return -1;
+        ESP_LOGI(TAG, "No legacy settings file, starting with defaults");
+        return true;
     }
     
-    // Read magic header
     char magic[8];
-    if (fread(magic, 1, 8, f) != 8 || memcmp(magic, "WIN32CFG", 8) != 0) {
-        ESP_LOGE(TAG, "Invalid settings file format");
-        fclose(f);
-        return -1;
-    }
-    
-    // Read version
-    uint8_t version;
-    fread(&version, 1, 1, f);
-    if (version != 1) {
-        ESP_LOGW(TAG, "Unknown settings version: %d", version);
+    uint8_t version = 0;
+    uint8_t *legacy = (uint8_t *)malloc(LEGACY_SETTINGS_SIZE);
+    if (!legacy) {
         fclose(f);
-        return -1;
+        return false;
     }
-    
-    // Read settings
-    size_t read = fread(settings, 1, sizeof(system_settings_t), f);
+    bool ok = fread(magic, 1, 8, f) == 8 && memcmp(magic, "WIN32CFG", 8) == 0 &&
+              fread(&version, 1, 1, f) == 1 && version == 1 &&
+              fread(legacy, 1, LEGACY_SETTINGS_SIZE, f) == LEGACY_SETTINGS_SIZE;
     fclose(f);
     
-    if (read != sizeof(system_settings_t)) {
-        ESP_LOGE(TAG, "Settings file corrupted (read %d, expected %d)", 
-                 (int)read, (int)sizeof(system_settings_t));
-        return -1;
+    if (ok) {
+        // v1 layout: everything up to saved_wifi is unchanged, the saved
+        // networks are shorter and the rest follows shifted down
+        const size_t wifi_off = offsetof(system_settings_t, saved_wifi);
+        const size_t tail_off = offsetof(system_settings_t, saved_wifi_count);
+        uint8_t *dst = (uint8_t *)&g_settings;
+        
+        memcpy(dst, legacy, wifi_off);
+        const wifi_credentials_v1_t *old_wifi = (const wifi_credentials_v1_t *)(legacy + wifi_off);
+        for (int i = 0; i < 5; i++) {
+            memset(&g_settings.saved_wifi[i], 0, sizeof(wifi_credentials_t));
+            memcpy(&g_settings.saved_wifi[i], &old_wifi[i], sizeof(wifi_credentials_v1_t));
+        }
+        memcpy(dst + tail_off, legacy + tail_off - LEGACY_WIFI_GROWTH, sizeof(system_settings_t) - tail_off);
+        
+        // Only keys that differ from defaults get written
+        for (int i = 0; i < SEC_COUNT; i++) g_section_loaded[i] = true;
+        ok = settings_commit(SEC_COUNT) == 0;
+        if (ok) {
+            remove(LEGACY_SETTINGS_FILE);
+            ESP_LOGI(TAG, "Migrated legacy settings from %s", LEGACY_SETTINGS_FILE);
+        } else {
+            ESP_LOGE(TAG, "Legacy settings migration failed, retrying next boot");
+        }
+    } else {
+        ESP_LOGW(TAG, "Legacy settings file unreadable, ignoring");
+        remove(LEGACY_SETTINGS_FILE);
+        ok = true;
     }
-    
-    ESP_LOGI(TAG, "Settings loaded successfully");
-    return 0;
+    free(legacy);
+    return ok;
 }
 
-int settings_save(const system_settings_t *settings) {
-    ESP_LOGI(TAG, "Saving settings to %s", SETTINGS_FILE);
+int settings_init(void) {
+    if (g_initialized) return 0;
     
-    FILE *f = fopen(SETTINGS_FILE, "wb");
-    if (!f) {
-        ESP_LOGE(TAG, "Failed to open settings file for writing");
-        return -1;
+    ESP_LOGI(TAG, "Initializing system settings");
+    
+    g_lock = xSemaphoreCreateRecursiveMutex();
+    settings_set_defaults(&g_settings);
+    memcpy(&g_persisted, &g_settings, sizeof(system_settings_t));
+    g_initialized = true;
+    
+    uint8_t schema = 0;
+    nvs_handle_t nvs;
+    if (nvs_open(SETTINGS_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+        nvs_get_u8(nvs, SETTINGS_KEY_SCHEMA, &schema);
+        nvs_close(nvs);
     }
     
-    // Write magic header
-    fwrite("WIN32CFG", 1, 8, f);
+    if (schema == 0) {
+        // No schema key until the import is in NVS, so a failed one reruns
+        if (settings_migrate_legacy()) settings_write_schema();
+    } else if (schema > SETTINGS_SCHEMA_VERSION) {
+        ESP_LOGW(TAG, "Settings schema v%d is newer than v%d, reading known keys only",
+                 schema, SETTINGS_SCHEMA_VERSION);
+    }
     
-    // Write version
-    uint8_t version = 1;
-    fwrite(&version, 1, 1, f);
+    // Timezone is needed before the first clock is drawn; everything else loads on demand
+    ensure_section(SEC_TIME);
+    apply_timezone(g_settings.timezone_offset);
     
-    // Write settings
-    fwrite(settings, 1, sizeof(system_settings_t), f);
-    fclose(f);
+    ESP_LOGI(TAG, "Settings initialized (schema v%d)", SETTINGS_SCHEMA_VERSION);
+    return 0;
+}
+
+int settings_load(system_settings_t *settings) {
+    if (!settings) return -1;
     
-    ESP_LOGI(TAG, "Settings saved successfully");
+    ensure_all_sections();
+    settings_lock();
+    memcpy(settings, &g_settings, sizeof(system_settings_t));
+    settings_unlock();
     return 0;
 }
 
+int settings_save(const system_settings_t *settings) {
+    if (!settings) return -1;
+    TRACE_SCOPE("settings_save");
+    
+    ensure_all_sections();
+    settings_lock();
+    if (settings != &g_settings) {
+        memcpy(&g_settings, settings, sizeof(system_settings_t));
+    }
+    int ret = settings_commit(SEC_COUNT);
+    settings_unlock();
+    return ret;
+}
+
 // Individual setting helpers
 int settings_set_brightness(uint8_t brightness) {
+    ensure_section(SEC_DISPLAY);
     g_settings.brightness = brightness;
     ESP_LOGD(TAG, "Brightness set to %d", brightness);
-    return settings_save(&g_settings);
+    return settings_commit(SEC_DISPLAY);
 }
 
 uint8_t settings_get_brightness(void) {
+    ensure_section(SEC_DISPLAY);
     return g_settings.brightness;
 }
 
 int settings_set_wallpaper(int index) {
+    ensure_section(SEC_DISPLAY);
     g_settings.wallpaper_index = index;
     ESP_LOGI(TAG, "Wallpaper set to %d", index);
-    return settings_save(&g_settings);
+    return settings_commit(SEC_DISPLAY);
 }
 
 int settings_get_wallpaper(void) {
+    ensure_section(SEC_DISPLAY);
     return g_settings.wallpaper_index;
 }
 
 int settings_set_time(int64_t timestamp, int8_t tz_offset) {
+    ensure_section(SEC_TIME);
     if (timestamp != 0) {
         g_settings.last_known_time = timestamp;
     }
@@ -204,20 +457,23 @@ int settings_set_time(int64_t timestamp, int8_t tz_offset) {
     apply_timezone(tz_offset);
     
     ESP_LOGI(TAG, "Timezone set to UTC%+d", tz_offset);
-    return settings_save(&g_settings);
+    return settings_commit(SEC_TIME);
 }
 
 int64_t settings_get_time(void) {
+    ensure_section(SEC_TIME);
     return g_settings.last_known_time;
 }
 
 int8_t settings_get_timezone(void) {
+    ensure_section(SEC_TIME);
     return g_settings.timezone_offset;
 }
 
 
 // WiFi credentials management
 int settings_save_wifi(const char *ssid, const char *password) {
+    ensure_section(SEC_WIFI);
     if (!ssid || strlen(ssid) == 0) {
         ESP_LOGE(TAG, "Invalid SSID");
         return -1;
@@ -232,7 +488,7 @@ int settings_save_wifi(const char *ssid, const char *password) {
             g_settings.saved_wifi[i].password[64] = '\0';
             g_settings.saved_wifi[i].valid = true;
             ESP_LOGI(TAG, "Updated existing WiFi entry at index %d", i);
-            return settings_save(&g_settings);
+            return settings_commit(SEC_WIFI);
         }
     }
     
@@ -247,6 +503,7 @@ int settings_save_wifi(const char *ssid, const char *password) {
     }
     
     int idx = g_settings.saved_wifi_count;
+    memset(&g_settings.saved_wifi[idx], 0, sizeof(wifi_credentials_t));
     strncpy(g_settings.saved_wifi[idx].ssid, ssid, 32);
     g_settings.saved_wifi[idx].ssid[32] = '\0';
     strncpy(g_settings.saved_wifi[idx].password, password ? password : "", 64);
@@ -255,10 +512,28 @@ int settings_save_wifi(const char *ssid, const char *password) {
     g_settings.saved_wifi_count++;
     
     ESP_LOGI(TAG, "Added new WiFi entry at index %d, total: %d", idx, g_settings.saved_wifi_count);
-    return settings_save(&g_settings);
+    return settings_commit(SEC_WIFI);
+}
+
+// Remember where a saved network was last found; only written when it moved
+int settings_set_wifi_ap(const char *ssid, const uint8_t bssid[6], uint8_t channel, uint8_t authmode) {
+    ensure_section(SEC_WIFI);
+    if (!ssid || !bssid) return -1;
+    
+    for (int i = 0; i < g_settings.saved_wifi_count; i++) {
+        wifi_credentials_t *w = &g_settings.saved_wifi[i];
+        if (strcmp(w->ssid, ssid) == 0) {
+            memcpy(w->bssid, bssid, 6);
+            w->channel = channel;
+            w->authmode = authmode;
+            return settings_commit(SEC_WIFI);
+        }
+    }
+    return -1;
 }
 
 int settings_get_wifi(int index, wifi_credentials_t *cred) {
+    ensure_section(SEC_WIFI);
     if (index < 0 || index >= g_settings.saved_wifi_count || !cred) {
         return -1;
     }
@@ -267,10 +542,12 @@ int settings_get_wifi(int index, wifi_credentials_t *cred) {
 }
 
 int settings_get_wifi_count(void) {
+    ensure_section(SEC_WIFI);
     return g_settings.saved_wifi_count;
 }
 
 int settings_find_wifi(const char *ssid, wifi_credentials_t *cred) {
+    ensure_section(SEC_WIFI);
     if (!ssid) return -1;
     
     for (int i = 0; i < g_settings.saved_wifi_count; i++) {
@@ -284,6 +561,7 @@ int settings_find_wifi(const char *ssid, wifi_credentials_t *cred) {
 }
 
 int settings_delete_wifi(const char *ssid) {
+    ensure_section(SEC_WIFI);
     if (!ssid) return -1;
     
     for (int i = 0; i < g_settings.saved_wifi_count; i++) {
@@ -294,18 +572,21 @@ int settings_delete_wifi(const char *ssid) {
             }
             g_settings.saved_wifi_count--;
             ESP_LOGI(TAG, "Deleted WiFi: %s", ssid);
-            return settings_save(&g_settings);
+            return settings_commit(SEC_WIFI);
         }
     }
     return -1;
 }
 
 system_settings_t* settings_get_global(void) {
+    // Callers may touch any field, so every section must be resident
+    ensure_all_sections();
     return &g_settings;
 }
 
 // Keyboard settings
 int settings_set_keyboard_height(uint8_t height_percent) {
+    ensure_section(SEC_KEYBOARD);
     if (height_percent < 17) height_percent = 17;  // Minimum like console (135px)
     if (height_percent > 80) height_percent = 80;
     
@@ -314,14 +595,16 @@ int settings_set_keyboard_height(uint8_t height_percent) {
     g_settings.keyboard.use_percent = true;
     
     ESP_LOGI(TAG, "Keyboard height set to %d%% (%dpx)", height_percent, g_settings.keyboard.height);
-    return settings_save(&g_settings);
+    return settings_commit(SEC_KEYBOARD);
 }
 
 uint8_t settings_get_keyboard_height(void) {
+    ensure_section(SEC_KEYBOARD);
     return g_settings.keyboard.height_percent;
 }
 
 uint16_t settings_get_keyboard_height_px(void) {
+    ensure_section(SEC_KEYBOARD);
     // Ensure valid range
     uint8_t pct = g_settings.keyboard.height_percent;
     if (pct < 17 || pct > 80) pct = 62;  // Default 62%
@@ -331,18 +614,22 @@ uint16_t settings_get_keyboard_height_px(void) {
 }
 
 int settings_set_keyboard_theme(keyboard_theme_t theme) {
+    ensure_section(SEC_KEYBOARD);
     g_settings.keyboard.theme = theme;
     ESP_LOGI(TAG, "Keyboard theme set to %s", theme == KEYBOARD_THEME_DARK ? "dark" : "light");
-    return settings_save(&g_settings);
+    return settings_commit(SEC_KEYBOARD);
 }
 
 keyboard_theme_t settings_get_keyboard_theme(void) {
+    ensure_section(SEC_KEYBOARD);
     return g_settings.keyboard.theme;
 }
 
 
 // Location settings
 int settings_set_location(const char *city, float lat, float lon, int8_t tz) {
+    ensure_section(SEC_LOCATION);
+    ensure_section(SEC_TIME);
     if (!city) return -1;
     
     strncpy(g_settings.location.city_name, city, sizeof(g_settings.location.city_name) - 1);
@@ -359,28 +646,33 @@ int settings_set_location(const char *city, float lat, float lon, int8_t tz) {
     apply_timezone(tz);
     
     ESP_LOGI(TAG, "Location set: %s (%.4f, %.4f) TZ=%+d", city, lat, lon, tz);
-    return settings_save(&g_settings);
+    settings_commit(SEC_TIME);
+    return settings_commit(SEC_LOCATION);
 }
 
 location_settings_t* settings_get_location(void) {
+    ensure_section(SEC_LOCATION);
     return &g_settings.location;
 }
 
 bool settings_has_location(void) {
+    ensure_section(SEC_LOCATION);
     return g_settings.location.valid;
 }
 
 
 // User profile settings
 int settings_set_username(const char *name) {
+    ensure_section(SEC_USER);
     if (!name) return -1;
     strncpy(g_settings.user.username, name, sizeof(g_settings.user.username) - 1);
     g_settings.user.username[sizeof(g_settings.user.username) - 1] = '\0';
     ESP_LOGI(TAG, "Username set to: %s", name);
-    return settings_save(&g_settings);
+    return settings_commit(SEC_USER);
 }
 
 const char* settings_get_username(void) {
+    ensure_section(SEC_USER);
     if (strlen(g_settings.user.username) == 0) {
         return "User";  // Default name
     }
@@ -388,12 +680,14 @@ const char* settings_get_username(void) {
 }
 
 int settings_set_avatar_color(uint32_t color) {
+    ensure_section(SEC_USER);
     g_settings.user.avatar_color = color;
     ESP_LOGI(TAG, "Avatar color set to: 0x%06X", (unsigned int)color);
-    return settings_save(&g_settings);
+    return settings_commit(SEC_USER);
 }
 
 uint32_t settings_get_avatar_color(void) {
+    ensure_section(SEC_USER);
     if (g_settings.user.avatar_color == 0) {
         return 0x4A90D9;  // Default blue
     }
@@ -401,6 +695,7 @@ uint32_t settings_get_avatar_color(void) {
 }
 
 int settings_set_password(const char *password) {
+    ensure_section(SEC_USER);
     if (!password) {
         // Clear password
         memset(g_settings.user.password, 0, sizeof(g_settings.user.password));
@@ -417,10 +712,11 @@ int settings_set_password(const char *password) {
         g_settings.user.password_enabled = true;
         ESP_LOGI(TAG, "Password set (length: %d)", (int)strlen(password));
     }
-    return settings_save(&g_settings);
+    return settings_commit(SEC_USER);
 }
 
 bool settings_check_password(const char *password) {
+    ensure_section(SEC_USER);
     if (!g_settings.user.password_enabled) {
         return true;  // No password required
     }
@@ -431,46 +727,54 @@ bool settings_check_password(const char *password) {
 }
 
 bool settings_has_password(void) {
+    ensure_section(SEC_USER);
     return g_settings.user.password_enabled && strlen(g_settings.user.password) > 0;
 }
 
 int settings_set_lock_type(lock_type_t type) {
+    ensure_section(SEC_USER);
     g_settings.user.lock_type = type;
     ESP_LOGI(TAG, "Lock type set to: %d", (int)type);
-    return settings_save(&g_settings);
+    return settings_commit(SEC_USER);
 }
 
 lock_type_t settings_get_lock_type(void) {
+    ensure_section(SEC_USER);
     return g_settings.user.lock_type;
 }
 
 // Game scores
 int settings_set_flappy_score(int32_t score) {
+    ensure_section(SEC_SCORES);
     if (score > g_settings.scores.flappy_best) {
         g_settings.scores.flappy_best = score;
         ESP_LOGI(TAG, "New Flappy Bird high score: %d", (int)score);
-        return settings_save(&g_settings);
+        return settings_commit(SEC_SCORES);
     }
     return 0;  // Not a new high score
 }
 
 int32_t settings_get_flappy_score(void) {
+    ensure_section(SEC_SCORES);
     return g_settings.scores.flappy_best;
 }
 
 // UI Style / Personalization
 int settings_set_ui_style(ui_style_t style) {
+    ensure_section(SEC_PERSONALIZATION);
     if (style > UI_STYLE_WIN11) style = UI_STYLE_WIN7;
     g_settings.personalization.ui_style = style;
     ESP_LOGI(TAG, "UI style set to: %d", (int)style);
-    return settings_save(&g_settings);
+    return settings_commit(SEC_PERSONALIZATION);
 }
 
 ui_style_t settings_get_ui_style(void) {
+    ensure_section(SEC_PERSONALIZATION);
     return g_settings.personalization.ui_style;
 }
 
 int settings_set_desktop_grid(uint8_t cols, uint8_t rows) {
+    ensure_section(SEC_PERSONALIZATION);
     if (cols < 3) cols = 3;
     if (cols > 10) cols = 10;
     if (rows < 3) rows = 3;
@@ -479,22 +783,25 @@ int settings_set_desktop_grid(uint8_t cols, uint8_t rows) {
     g_settings.personalization.desktop_grid_cols = cols;
     g_settings.personalization.desktop_grid_rows = rows;
     ESP_LOGI(TAG, "Desktop grid set to: %dx%d", cols, rows);
-    return settings_save(&g_settings);
+    return settings_commit(SEC_PERSONALIZATION);
 }
 
 uint8_t settings_get_desktop_grid_cols(void) {
+    ensure_section(SEC_PERSONALIZATION);
     uint8_t cols = g_settings.personalization.desktop_grid_cols;
     if (cols < 3 || cols > 10) cols = 4;  // Default
     return cols;
 }
 
 uint8_t settings_get_desktop_grid_rows(void) {
+    ensure_section(SEC_PERSONALIZATION);
     uint8_t rows = g_settings.personalization.desktop_grid_rows;
     if (rows < 3 || rows > 8) rows = 5;  // Default
     return rows;
 }
 
 int settings_set_pinned_app(int index, const char *app_name) {
+    ensure_section(SEC_PERSONALIZATION);
     if (index < 0 || index >= 3) return -1;
     
     if (app_name && app_name[0]) {
@@ -505,16 +812,18 @@ int settings_set_pinned_app(int index, const char *app_name) {
         g_settings.personalization.pinned_apps[index][0] = '\0';
         ESP_LOGI(TAG, "Pinned app %d cleared", index);
     }
-    return settings_save(&g_settings);
+    return settings_commit(SEC_PERSONALIZATION);
 }
 
 const char* settings_get_pinned_app(int index) {
+    ensure_section(SEC_PERSONALIZATION);
     if (index < 0 || index >= 3) return NULL;
     if (g_settings.personalization.pinned_apps[index][0] == '\0') return NULL;
     return g_settings.personalization.pinned_apps[index];
 }
 
 int settings_save_icon_position(const char *app_name, int8_t grid_x, int8_t grid_y) {
+    ensure_section(SEC_PERSONALIZATION);
     if (!app_name) return -1;
     
     // Check if already exists - update it
@@ -523,7 +832,7 @@ int settings_save_icon_position(const char *app_name, int8_t grid_x, int8_t grid
             g_settings.personalization.icon_positions[i].grid_x = grid_x;
             g_settings.personalization.icon_positions[i].grid_y = grid_y;
             ESP_LOGI(TAG, "Updated icon position: %s -> (%d, %d)", app_name, grid_x, grid_y);
-            return settings_save(&g_settings);
+            return settings_commit(SEC_PERSONALIZATION);
         }
     }
     
@@ -542,10 +851,11 @@ int settings_save_icon_position(const char *app_name, int8_t grid_x, int8_t grid
     g_settings.personalization.icon_position_count++;
     
     ESP_LOGI(TAG, "Saved icon position: %s -> (%d, %d)", app_name, grid_x, grid_y);
-    return settings_save(&g_settings);
+    return settings_commit(SEC_PERSONALIZATION);
 }
 
 bool settings_get_icon_position(const char *app_name, int8_t *grid_x, int8_t *grid_y) {
+    ensure_section(SEC_PERSONALIZATION);
     if (!app_name || !grid_x || !grid_y) return false;
     
     for (int i = 0; i < g_settings.personalization.icon_position_count; i++) {
@@ -560,24 +870,56 @@ bool settings_get_icon_position(const char *app_name, int8_t *grid_x, int8_t *gr
 }
 
 int settings_clear_icon_positions(void) {
+    ensure_section(SEC_PERSONALIZATION);
     memset(g_settings.personalization.icon_positions, 0, sizeof(g_settings.personalization.icon_positions));
     g_settings.personalization.icon_position_count = 0;
     ESP_LOGI(TAG, "Icon positions cleared");
-    return settings_save(&g_settings);
+    return settings_commit(SEC_PERSONALIZATION);
+}
+
+int settings_set_debug_mode(bool enabled) {
+    ensure_section(SEC_DEBUG);
+    g_settings.debug_mode = enabled;
+    ESP_LOGI(TAG, "Debug mode: %s", enabled ? "ON" : "OFF");
+    return settings_commit(SEC_DEBUG);
+}
+
+bool settings_get_debug_mode(void) {
+    ensure_section(SEC_DEBUG);
+    return g_settings.debug_mode;
+}
+
+int settings_reset_lock(void) {
+    ensure_section(SEC_USER);
+    memset(g_settings.user.password, 0, sizeof(g_settings.user.password));
+    g_settings.user.password_enabled = false;
+    g_settings.user.lock_type = LOCK_TYPE_SLIDE;
+    ESP_LOGI(TAG, "Lock screen reset to slide");
+    return settings_commit(SEC_USER);
 }
 
 // Factory reset
 int settings_factory_reset(void) {
     ESP_LOGW(TAG, "FACTORY RESET - Deleting all settings!");
     
-    // Delete settings file
-    remove(SETTINGS_FILE);
+    settings_lock();
+    
+    // Drop every stored key and any leftover legacy file
+    nvs_handle_t nvs;
+    if (nvs_open(SETTINGS_NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
+        nvs_erase_all(nvs);
+        nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    remove(LEGACY_SETTINGS_FILE);
     
-    // Reset to defaults
+    // Reset to defaults - absent keys read back as defaults, nothing else to write
     settings_set_defaults(&g_settings);
+    memcpy(&g_persisted, &g_settings, sizeof(system_settings_t));
+    for (int i = 0; i < SEC_COUNT; i++) g_section_loaded[i] = true;
+    settings_write_schema();
     
-    // Save clean defaults
-    settings_save(&g_settings);
+    settings_unlock();
     
     ESP_LOGI(TAG, "Factory reset complete");
     return 0;
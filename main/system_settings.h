@@ -1,6 +1,6 @@
 /**
  * Win32 OS - System Settings
- * Persistent storage for system configuration using LittleFS
+ * Persistent storage for system configuration (versioned NVS key-value store)
  */
 
 #ifndef SYSTEM_SETTINGS_H
@@ -14,6 +14,10 @@ typedef struct {
     char ssid[33];
     char password[65];
     bool valid;
+    // Last AP joined, for a direct connect without an all-channel scan
+    uint8_t bssid[6];
+    uint8_t channel;        // 0 = unknown
+    uint8_t authmode;       // wifi_auth_mode_t
 } wifi_credentials_t;
 
 // Keyboard theme
@@ -127,10 +131,10 @@ typedef struct {
 // Initialize settings system (call once at startup)
 int settings_init(void);
 
-// Load all settings from storage
+// Copy all settings into *settings (loads any section not read yet)
 int settings_load(system_settings_t *settings);
 
-// Save all settings to storage
+// Store settings - only keys whose value changed are written to flash
 int settings_save(const system_settings_t *settings);
 
 // Individual setting helpers
@@ -146,6 +150,7 @@ int8_t settings_get_timezone(void);
 
 // WiFi credentials management
 int settings_save_wifi(const char *ssid, const char *password);
+int settings_set_wifi_ap(const char *ssid, const uint8_t bssid[6], uint8_t channel, uint8_t authmode);
 int settings_get_wifi(int index, wifi_credentials_t *cred);
 int settings_get_wifi_count(void);
 int settings_find_wifi(const char *ssid, wifi_credentials_t *cred);
@@ -173,6 +178,7 @@ bool settings_check_password(const char *password);
 bool settings_has_password(void);
 int settings_set_lock_type(lock_type_t type);
 lock_type_t settings_get_lock_type(void);
+int settings_reset_lock(void);  // Clear password/PIN and fall back to slide unlock
 
 // Game scores
 int settings_set_flappy_score(int32_t score);
@@ -193,6 +199,10 @@ int settings_save_icon_position(const char *app_name, int8_t grid_x, int8_t grid
 bool settings_get_icon_position(const char *app_name, int8_t *grid_x, int8_t *grid_y);
 int settings_clear_icon_positions(void);
 
+// Debug mode (shows the performance HUD)
+int settings_set_debug_mode(bool enabled);
+bool settings_get_debug_mode(void);
+
 // Factory reset - deletes all settings
 int settings_factory_reset(void);
 
@@ -0,0 +1,280 @@
+/**
+ * Win32 OS - Touch to Display Latency Implementation
+ * Everything runs in the LVGL task: the wrapped indev read callback and
+ * read timer open an event per touch sample, display events carry the
+ * events through render and flush.
+ */
+
+#include "touch_latency.h"
+#include "gt911_driver.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+#include <stdio.h>
+
+static const char *TAG = "TOUCH_LAT";
+
+#define TOUCH_LATENCY_PENDING       8
+#define TOUCH_LATENCY_TIMEOUT_US    200000  // No frame by then: the sample changed nothing
+
+// DPI timing from st7701_lcd.cpp: 576 pixel clocks per line at 34 MHz,
+// the first visible line comes 10 lines after vsync
+#define TOUCH_LATENCY_LINE_NS       16941
+#define TOUCH_LATENCY_FIRST_LINE    10
+
+typedef enum {
+    EV_FREE = 0,
+    EV_READ,            // Read, waiting for LVGL to finish the indev
+    EV_INPUT,           // Handled, waiting for a frame
+    EV_FRAME            // In the frame being rendered
+} ev_state_t;
+
+typedef struct {
+    ev_state_t state;
+    uint16_t y;
+    int64_t poll_us;
+    int64_t read_us;
+    int64_t input_us;
+    int64_t render_us;
+    int64_t flush_us;
+} ev_t;
+
+static ev_t s_pending[TOUCH_LATENCY_PENDING];
+static touch_latency_stats_t s_stats = {};
+
+static lv_indev_read_cb_t s_orig_read_cb = NULL;
+static bool s_timer_wrapped = false;
+static uint32_t s_last_seq = 0;
+static lv_indev_state_t s_last_state = LV_INDEV_STATE_RELEASED;
+static lv_point_t s_last_point = {};
+
+static void drop_stale(int64_t now)
+{
+    for (int i = 0; i < TOUCH_LATENCY_PENDING; i++) {
+        if (s_pending[i].state != EV_FREE && s_pending[i].state != EV_FRAME &&
+            now - s_pending[i].poll_us > TOUCH_LATENCY_TIMEOUT_US) {
+            s_pending[i].state = EV_FREE;
+            s_stats.dropped++;
+        }
+    }
+}
+
+static ev_t *new_event(int64_t now)
+{
+    drop_stale(now);
+    for (int i = 0; i < TOUCH_LATENCY_PENDING; i++) {
+        if (s_pending[i].state == EV_FREE) return &s_pending[i];
+    }
+    s_stats.dropped++;
+    return NULL;
+}
+
+// Mark the events of the last read as handled by LVGL
+static void mark_input(int64_t now)
+{
+    for (int i = 0; i < TOUCH_LATENCY_PENDING; i++) {
+        if (s_pending[i].state == EV_READ) {
+            s_pending[i].input_us = now;
+            s_pending[i].state = EV_INPUT;
+        }
+    }
+}
+
+static void touch_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
+{
+    int64_t poll_us = esp_timer_get_time();
+    s_orig_read_cb(indev, data);
+
+    gt911_sample_t sample;
+    gt911_get_last_sample(&sample);
+    bool fresh = data->state == LV_INDEV_STATE_PRESSED && sample.seq != s_last_seq;
+    bool moved = s_last_state != LV_INDEV_STATE_PRESSED ||
+                 data->point.x != s_last_point.x || data->point.y != s_last_point.y;
+    s_last_seq = sample.seq;
+    s_last_state = data->state;
+    s_last_point = data->point;
+    if (!fresh || !moved) return;
+
+    s_stats.events++;
+    ev_t *ev = new_event(poll_us);
+    if (!ev) return;
+    ev->state = EV_READ;
+    ev->y = (uint16_t)data->point.y;
+    // With INT the sample starts at the edge, not at the read it triggered
+    ev->poll_us = sample.irq_us ? sample.irq_us : poll_us;
+    ev->read_us = sample.read_us;
+}
+
+// The indev timer reads and then runs all event callbacks; when it
+// returns, LVGL is done with the sample
+static void touch_timer_cb(lv_timer_t *timer)
+{
+    lv_indev_read_timer_cb(timer);
+    mark_input(esp_timer_get_time());
+}
+
+static void add_sample(const ev_t *ev, int64_t swap_us)
+{
+    uint32_t stage[TOUCH_LATENCY_STAGES];
+    stage[TOUCH_LATENCY_READ] = (uint32_t)(ev->read_us - ev->poll_us);
+    stage[TOUCH_LATENCY_INPUT] = (uint32_t)(ev->input_us - ev->read_us);
+    stage[TOUCH_LATENCY_WAIT] = (uint32_t)(ev->render_us - ev->input_us);
+    stage[TOUCH_LATENCY_RENDER] = (uint32_t)(ev->flush_us - ev->render_us);
+    stage[TOUCH_LATENCY_SWAP] = (uint32_t)(swap_us - ev->flush_us);
+    stage[TOUCH_LATENCY_SCANOUT] = (uint32_t)((TOUCH_LATENCY_FIRST_LINE + ev->y) * TOUCH_LATENCY_LINE_NS / 1000);
+
+    uint32_t total = 0;
+    for (int i = 0; i < TOUCH_LATENCY_STAGES; i++) {
+        total += stage[i];
+        s_stats.stage_us[i] += stage[i];
+        s_stats.last_us[i] = stage[i];
+    }
+
+    if (s_stats.matched == 0 || total < s_stats.min_us) s_stats.min_us = total;
+    if (total > s_stats.max_us) s_stats.max_us = total;
+    s_stats.total_us += total;
+    s_stats.matched++;
+
+    uint32_t bucket = total / (TOUCH_LATENCY_BUCKET_MS * 1000);
+    if (bucket >= TOUCH_LATENCY_BUCKETS) bucket = TOUCH_LATENCY_BUCKETS - 1;
+    s_stats.histogram[bucket]++;
+}
+
+static void display_event_cb(lv_event_t *e)
+{
+    lv_event_code_t code = lv_event_get_code(e);
+    int64_t now = esp_timer_get_time();
+
+    if (code == LV_EVENT_RENDER_START) {
+        // Without a read timer (event driven indev) LVGL handled the
+        // sample before this refresh at the latest
+        if (!s_timer_wrapped) mark_input(now);
+        drop_stale(now);
+        for (int i = 0; i < TOUCH_LATENCY_PENDING; i++) {
+            if (s_pending[i].state == EV_INPUT) {
+                s_pending[i].render_us = now;
+                s_pending[i].state = EV_FRAME;
+            }
+        }
+        return;
+    }
+
+    // Only the last area of a frame hands the buffer to the panel
+    lv_display_t *disp = (lv_display_t *)lv_event_get_target(e);
+    if (!lv_display_flush_is_last(disp)) return;
+
+    for (int i = 0; i < TOUCH_LATENCY_PENDING; i++) {
+        ev_t *ev = &s_pending[i];
+        if (ev->state != EV_FRAME) continue;
+        if (code == LV_EVENT_FLUSH_START) {
+            ev->flush_us = now;
+        } else {
+            // avoid_tearing: flush_cb returns once the DPI switched buffers
+            add_sample(ev, now);
+            ev->state = EV_FREE;
+        }
+    }
+}
+
+void touch_latency_attach(lv_display_t *disp, lv_indev_t *indev)
+{
+    if (!disp || !indev || s_orig_read_cb) return;
+
+    s_orig_read_cb = lv_indev_get_read_cb(indev);
+    if (!s_orig_read_cb) return;
+    lv_indev_set_read_cb(indev, touch_read_cb);
+
+    // In event mode (touch INT) the timer exists but is paused
+    lv_timer_t *timer = lv_indev_get_read_timer(indev);
+    if (timer && lv_indev_get_mode(indev) == LV_INDEV_MODE_TIMER) {
+        lv_timer_set_cb(timer, touch_timer_cb);
+        s_timer_wrapped = true;
+    }
+
+    lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_RENDER_START, NULL);
+    lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_FLUSH_START, NULL);
+    lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_FLUSH_FINISH, NULL);
+    ESP_LOGI(TAG, "Measuring touch latency (%s indev)", s_timer_wrapped ? "polled" : "event driven");
+}
+
+void touch_latency_get(touch_latency_stats_t *out)
+{
+    if (out) *out = s_stats;
+}
+
+void touch_latency_reset(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    memset(s_pending, 0, sizeof(s_pending));
+}
+
+// ============ REPORT ============
+
+uint32_t touch_latency_percentile(const touch_latency_stats_t *stats, int percent)
+{
+    if (!stats || stats->matched == 0) return 0;
+
+    uint64_t target = ((uint64_t)stats->matched * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (int b = 0; b < TOUCH_LATENCY_BUCKETS; b++) {
+        seen += stats->histogram[b];
+        if (seen >= target) return (b + 1) * TOUCH_LATENCY_BUCKET_MS;
+    }
+    return TOUCH_LATENCY_BUCKETS * TOUCH_LATENCY_BUCKET_MS;
+}
+
+int touch_latency_format(const touch_latency_stats_t *stats, char *buf, size_t len)
+{
+    static const char *stage_names[TOUCH_LATENCY_STAGES] = {
+        "read", "input", "wait", "render", "swap", "scanout"
+    };
+
+    if (!stats || !buf || len == 0) return 0;
+
+    int pos = snprintf(buf, len, "Touch to display: %lu samples, %lu on screen, %lu without a frame\n",
+                       (unsigned long)stats->events, (unsigned long)stats->matched,
+                       (unsigned long)stats->dropped);
+    if (stats->matched == 0) return pos;
+
+    if (pos < (int)len) {
+        pos += snprintf(buf + pos, len - pos,
+                        "total ms: min %.1f  avg %.1f  p50 <%lu  p95 <%lu  max %.1f\n",
+                        stats->min_us / 1000.0, stats->total_us / 1000.0 / stats->matched,
+                        (unsigned long)touch_latency_percentile(stats, 50),
+                        (unsigned long)touch_latency_percentile(stats, 95), stats->max_us / 1000.0);
+    }
+    if (pos < (int)len) {
+        pos += snprintf(buf + pos, len - pos, "avg ms:");
+    }
+    for (int i = 0; i < TOUCH_LATENCY_STAGES && pos < (int)len; i++) {
+        pos += snprintf(buf + pos, len - pos, " %s %.1f", stage_names[i],
+                        stats->stage_us[i] / 1000.0 / stats->matched);
+    }
+    if (pos < (int)len) {
+        pos += snprintf(buf + pos, len - pos, "\n");
+    }
+
+    // Histogram from the first to the last non-empty bucket
+    int first = 0, last = TOUCH_LATENCY_BUCKETS - 1;
+    while (first < last && stats->histogram[first] == 0) first++;
+    while (last > first && stats->histogram[last] == 0) last--;
+    uint32_t peak = 1;
+    for (int b = first; b <= last; b++) {
+        if (stats->histogram[b] > peak) peak = stats->histogram[b];
+    }
+    for (int b = first; b <= last && pos < (int)len; b++) {
+        char bar[33];
+        int n = (int)((uint64_t)stats->histogram[b] * 32 / peak);
+        if (n == 0 && stats->histogram[b]) n = 1;
+        memset(bar, '#', n);
+        bar[n] = '\0';
+        if (b == TOUCH_LATENCY_BUCKETS - 1) {
+            pos += snprintf(buf + pos, len - pos, "%3d+    %5lu %s\n", b * TOUCH_LATENCY_BUCKET_MS,
+                            (unsigned long)stats->histogram[b], bar);
+        } else {
+            pos += snprintf(buf + pos, len - pos, "%3d-%-3d %5lu %s\n", b * TOUCH_LATENCY_BUCKET_MS,
+                            (b + 1) * TOUCH_LATENCY_BUCKET_MS, (unsigned long)stats->histogram[b], bar);
+        }
+    }
+    return pos;
+}
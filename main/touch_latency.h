@@ -0,0 +1,88 @@
+/**
+ * Win32 OS - Touch to Display Latency
+ * Follows every touch sample that moved the point through the whole
+ * pipeline and measures how long it takes to reach the panel:
+ *
+ *   read     LVGL polls the touch (or the GT911 raises INT) until the
+ *            I2C read returned it
+ *   input    LVGL runs the indev and the event callbacks it triggers
+ *   wait     until the next frame starts rendering
+ *   render   drawing the frame
+ *   swap     flush until the DPI panel shows the new frame buffer
+ *   scanout  estimated time for the scan to reach the touched row
+ *
+ * The time between the finger landing and the next poll or INT edge is
+ * not visible to the firmware and is not included. With an event driven
+ * indev the input stage runs until the frame starts and wait stays 0.
+ *
+ * A frame is matched to every sample whose input was handled before it
+ * started, so samples that changed nothing on screen are counted against
+ * whatever redraws next. The calibration screen in the Debug app draws at
+ * the touch point, which makes every sample produce its own frame.
+ */
+
+#ifndef TOUCH_LATENCY_H
+#define TOUCH_LATENCY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TOUCH_LATENCY_BUCKET_MS     4
+#define TOUCH_LATENCY_BUCKETS       32      // Last bucket holds everything slower
+
+typedef enum {
+    TOUCH_LATENCY_READ = 0,
+    TOUCH_LATENCY_INPUT,
+    TOUCH_LATENCY_WAIT,
+    TOUCH_LATENCY_RENDER,
+    TOUCH_LATENCY_SWAP,
+    TOUCH_LATENCY_SCANOUT,
+    TOUCH_LATENCY_STAGES
+} touch_latency_stage_t;
+
+typedef struct {
+    uint32_t events;            // Samples that moved the point
+    uint32_t matched;           // Samples that reached the panel
+    uint32_t dropped;           // No frame followed in time
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint64_t stage_us[TOUCH_LATENCY_STAGES];    // Sums, divide by matched
+    uint32_t last_us[TOUCH_LATENCY_STAGES];     // Latest matched sample
+    uint32_t histogram[TOUCH_LATENCY_BUCKETS];
+} touch_latency_stats_t;
+
+/**
+ * Hook the touch indev and the display; called by my_lvgl_port_init()
+ * with the LVGL lock held
+ */
+void touch_latency_attach(lv_display_t *disp, lv_indev_t *indev);
+
+/**
+ * Copy or clear the statistics (LVGL lock held)
+ */
+void touch_latency_get(touch_latency_stats_t *out);
+void touch_latency_reset(void);
+
+/**
+ * Percentile of the total latency, from the histogram (upper bucket bound)
+ * @return Milliseconds, 0 without samples
+ */
+uint32_t touch_latency_percentile(const touch_latency_stats_t *stats, int percent);
+
+/**
+ * Format the statistics with stage averages and the histogram
+ * @return Number of characters written
+ */
+int touch_latency_format(const touch_latency_stats_t *stats, char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TOUCH_LATENCY_H
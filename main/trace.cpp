@@ -0,0 +1,254 @@
+/**
+ * Win32 OS - Trace Recorder Implementation
+ * One ring per core; writers reserve a slot with an atomic increment so
+ * tasks and ISRs sharing a core never block each other. Each writer is
+ * counted while it touches a ring, so the rings are only reset or freed
+ * once recording is off and the last one has left.
+ */
+
+#include "trace.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+static const char *TAG = "TRACE";
+
+#define TRACE_WRITE_BUF_SIZE    (32 * 1024)
+
+// 16 bytes per event; timestamp keeps the low 32 bits of esp_timer
+typedef struct {
+    uint32_t ts_us;
+    const char *name;
+    int32_t value;
+    uint16_t tid;
+    uint8_t type;
+    uint8_t core;
+} trace_event_t;
+
+typedef struct {
+    trace_event_t *events;
+    uint32_t head;              // Total events ever reserved (wraps via mask)
+} trace_ring_t;
+
+volatile bool g_trace_running = false;
+
+static trace_ring_t s_rings[portNUM_PROCESSORS] = {};
+static uint32_t s_writers[portNUM_PROCESSORS] = {};  // trace_record() calls in flight
+static uint32_t s_capacity = 0;
+static uint32_t s_mask = 0;
+
+static uint32_t round_pow2(size_t n)
+{
+    uint32_t p = 256;
+    while (p < n && p < (1u << 20)) p <<= 1;
+    return p;
+}
+
+// Stop recording and wait for writers that got past the flag check
+static void quiesce_writers(void)
+{
+    __atomic_store_n(&g_trace_running, false, __ATOMIC_SEQ_CST);
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        while (__atomic_load_n(&s_writers[c], __ATOMIC_SEQ_CST) != 0) {
+            vTaskDelay(1);
+        }
+    }
+}
+
+static void free_rings(void)
+{
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        heap_caps_free(s_rings[c].events);
+        s_rings[c].events = NULL;
+        s_rings[c].head = 0;
+    }
+    s_capacity = 0;
+    s_mask = 0;
+}
+
+esp_err_t trace_start(size_t events_per_core)
+{
+    if (g_trace_running) {
+        ESP_LOGW(TAG, "Already tracing, stop first");
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint32_t capacity = round_pow2(events_per_core ? events_per_core : TRACE_DEFAULT_EVENTS);
+
+    // trace_stop() does not wait: writers may still be finishing
+    quiesce_writers();
+    if (capacity != s_capacity) {
+        free_rings();
+
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            s_rings[c].events = (trace_event_t *)heap_caps_calloc(capacity, sizeof(trace_event_t),
+                                                                  MALLOC_CAP_SPIRAM);
+            if (!s_rings[c].events) {
+                ESP_LOGE(TAG, "Failed to allocate %lu events", (unsigned long)capacity);
+                free_rings();
+                return ESP_ERR_NO_MEM;
+            }
+        }
+        s_capacity = capacity;
+        s_mask = capacity - 1;
+    }
+
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        __atomic_store_n(&s_rings[c].head, 0, __ATOMIC_RELAXED);
+    }
+
+    ESP_LOGI(TAG, "Tracing started (%lu events/core, %u KB)", (unsigned long)s_capacity,
+             (unsigned)(s_capacity * sizeof(trace_event_t) * portNUM_PROCESSORS / 1024));
+    g_trace_running = true;
+    return ESP_OK;
+}
+
+void trace_stop(void)
+{
+    if (g_trace_running) {
+        g_trace_running = false;
+        ESP_LOGI(TAG, "Tracing stopped");
+    }
+}
+
+void trace_record(trace_event_type_t type, const char *name, int32_t value)
+{
+    // Counted before the flag check: once quiesce_writers() has cleared the
+    // flag, it either sees this writer or the writer sees the flag off
+    int core = xPortGetCoreID();
+    __atomic_fetch_add(&s_writers[core], 1, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&g_trace_running, __ATOMIC_SEQ_CST)) {
+        __atomic_fetch_sub(&s_writers[core], 1, __ATOMIC_RELEASE);
+        return;
+    }
+
+    trace_ring_t *ring = &s_rings[core];
+    uint32_t idx = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+    trace_event_t *ev = &ring->events[idx & s_mask];
+
+    ev->ts_us = (uint32_t)esp_timer_get_time();
+    ev->name = name;
+    ev->value = value;
+    ev->tid = (uint16_t)uxTaskGetTaskNumber(xTaskGetCurrentTaskHandle());
+    ev->type = (uint8_t)type;
+    ev->core = (uint8_t)core;
+    __atomic_fetch_sub(&s_writers[core], 1, __ATOMIC_RELEASE);
+}
+
+void trace_get_stats(uint32_t *held, uint32_t *dropped)
+{
+    uint32_t h = 0, d = 0;
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        uint32_t head = __atomic_load_n(&s_rings[c].head, __ATOMIC_RELAXED);
+        if (head > s_capacity) {
+            h += s_capacity;
+            d += head - s_capacity;
+        } else {
+            h += head;
+        }
+    }
+    if (held) *held = h;
+    if (dropped) *dropped = d;
+}
+
+// Emit one "thread_name" metadata record per live task so Chrome shows task names
+static void write_thread_names(FILE *f)
+{
+    UBaseType_t count = uxTaskGetNumberOfTasks();
+    TaskStatus_t *tasks = (TaskStatus_t *)malloc(count * sizeof(TaskStatus_t));
+    if (!tasks) return;
+
+    count = uxTaskGetSystemState(tasks, count, NULL);
+    for (UBaseType_t i = 0; i < count; i++) {
+        fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,"
+                   "\"args\":{\"name\":\"%s\"}},\n",
+                (unsigned)tasks[i].xTaskNumber, tasks[i].pcTaskName);
+    }
+    free(tasks);
+}
+
+int trace_dump(const char *path, char *out_path, size_t out_len)
+{
+    if (s_capacity == 0) {
+        ESP_LOGW(TAG, "Nothing to dump - tracing never started");
+        return -1;
+    }
+
+    bool was_running = g_trace_running;
+    quiesce_writers();
+
+    char auto_path[64];
+    if (!path) {
+        mkdir(TRACE_DUMP_DIR, 0755);
+        snprintf(auto_path, sizeof(auto_path), TRACE_DUMP_DIR "/trace_%lu.json",
+                 (unsigned long)(esp_timer_get_time() / 1000000));
+        path = auto_path;
+    }
+    if (out_path && out_len) {
+        strncpy(out_path, path, out_len - 1);
+        out_path[out_len - 1] = '\0';
+    }
+
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        ESP_LOGE(TAG, "Cannot open %s", path);
+        g_trace_running = was_running;
+        return -1;
+    }
+
+    // Large buffered writes - SD card throughput collapses with small fwrite()s
+    char *wbuf = (char *)heap_caps_malloc(TRACE_WRITE_BUF_SIZE, MALLOC_CAP_SPIRAM);
+    if (wbuf) setvbuf(f, wbuf, _IOFBF, TRACE_WRITE_BUF_SIZE);
+
+    uint32_t held = 0, dropped = 0;
+    trace_get_stats(&held, &dropped);
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%lu},\"traceEvents\":[\n",
+            (unsigned long)dropped);
+    write_thread_names(f);
+
+    // Rebuild 64-bit timestamps relative to now (valid for ~71 minutes of history)
+    int64_t now64 = esp_timer_get_time();
+    uint32_t now32 = (uint32_t)now64;
+    int written = 0;
+
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        trace_ring_t *ring = &s_rings[c];
+        uint32_t head = ring->head;
+        uint32_t n = head > s_capacity ? s_capacity : head;
+
+        for (uint32_t i = head - n; i != head; i++) {
+            const trace_event_t *ev = &ring->events[i & s_mask];
+            if (!ev->name) continue;
+
+            int64_t ts = now64 - (int64_t)(uint32_t)(now32 - ev->ts_us);
+            fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":0,\"tid\":%u",
+                    written ? ",\n" : "", ev->name, ev->type, (long long)ts, (unsigned)ev->tid);
+            if (ev->type == TRACE_EV_COUNTER) {
+                fprintf(f, ",\"args\":{\"value\":%ld}}", (long)ev->value);
+            } else if (ev->type == TRACE_EV_INSTANT) {
+                fprintf(f, ",\"s\":\"t\",\"args\":{\"core\":%u}}", (unsigned)ev->core);
+            } else {
+                fputc('}', f);
+            }
+            written++;
+        }
+        __atomic_store_n(&ring->head, 0, __ATOMIC_RELAXED);
+    }
+
+    // Metadata records above end with ",\n"; close with an empty metadata object if no events
+    if (!written) fputs("{\"name\":\"empty\",\"ph\":\"M\",\"pid\":0,\"tid\":0}", f);
+    fputs("\n]}\n", f);
+    fclose(f);
+    heap_caps_free(wbuf);
+
+    ESP_LOGI(TAG, "Dumped %d events to %s (%lu dropped)", written, path, (unsigned long)dropped);
+
+    g_trace_running = was_running;
+    return written;
+}
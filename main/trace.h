@@ -0,0 +1,99 @@
+/**
+ * Win32 OS - Trace Recorder
+ * Low-overhead begin/end/counter events in per-core ring buffers,
+ * dumped to SD card as Chrome trace JSON (chrome://tracing, Perfetto)
+ *
+ * Event names must be string literals - only the pointer is recorded.
+ * Recording is off until trace_start(); the macros then cost one flag
+ * check. Set WIN32_TRACE_ENABLED to 0 to compile them out entirely.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifndef WIN32_TRACE_ENABLED
+#define WIN32_TRACE_ENABLED 1
+#endif
+
+#define TRACE_DEFAULT_EVENTS    8192    // Ring capacity per core (power of two)
+#define TRACE_DUMP_DIR          "/sdcard/trace"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    TRACE_EV_BEGIN = 'B',
+    TRACE_EV_END = 'E',
+    TRACE_EV_COUNTER = 'C',
+    TRACE_EV_INSTANT = 'i'
+} trace_event_type_t;
+
+extern volatile bool g_trace_running;
+
+/**
+ * Allocate ring buffers (PSRAM) and start recording
+ * @param events_per_core Ring capacity, rounded up to a power of two (0 = default)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE while already recording
+ */
+esp_err_t trace_start(size_t events_per_core);
+
+/**
+ * Stop recording; buffered events are kept until the next start or dump
+ */
+void trace_stop(void);
+
+/**
+ * Record one event (use the TRACE_* macros instead)
+ */
+void trace_record(trace_event_type_t type, const char *name, int32_t value);
+
+/**
+ * Number of events currently held (both cores) and events lost to wraparound
+ */
+void trace_get_stats(uint32_t *held, uint32_t *dropped);
+
+/**
+ * Write buffered events as Chrome trace JSON
+ * Recording is paused while dumping and resumed afterwards.
+ * @param path Output file, or NULL for TRACE_DUMP_DIR/trace_<uptime>.json
+ * @param out_path Receives the path actually written (may be NULL)
+ * @return Number of events written, or -1 on error
+ */
+int trace_dump(const char *path, char *out_path, size_t out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if WIN32_TRACE_ENABLED
+#define TRACE_BEGIN(name)           do { if (g_trace_running) trace_record(TRACE_EV_BEGIN, (name), 0); } while (0)
+#define TRACE_END(name)             do { if (g_trace_running) trace_record(TRACE_EV_END, (name), 0); } while (0)
+#define TRACE_COUNTER(name, value)  do { if (g_trace_running) trace_record(TRACE_EV_COUNTER, (name), (int32_t)(value)); } while (0)
+#define TRACE_INSTANT(name)         do { if (g_trace_running) trace_record(TRACE_EV_INSTANT, (name), 0); } while (0)
+#else
+#define TRACE_BEGIN(name)           do { } while (0)
+#define TRACE_END(name)             do { } while (0)
+#define TRACE_COUNTER(name, value)  do { } while (0)
+#define TRACE_INSTANT(name)         do { } while (0)
+#endif
+
+#ifdef __cplusplus
+// Scoped begin/end pair for functions with several return paths
+struct trace_scope_t {
+    const char *name;
+    explicit trace_scope_t(const char *n) : name(n) { TRACE_BEGIN(name); }
+    ~trace_scope_t() { TRACE_END(name); }
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name)   trace_scope_t TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#endif
+
+#endif // TRACE_H
@@ -7,8 +7,15 @@
 #include "hardware/hardware.h"
 #include "system_settings.h"
 #include "bluetooth_transfer.h"
+#include "trace.h"
 #include "assets.h"
 #include "duktape_esp32.h"
+#include "js_gfx.h"
+#include "js_syntax.h"
+#include "mem_diag.h"
+#include "cpu_stats.h"
+#include "touch_latency.h"
+#include "gt911_driver.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_system.h"
@@ -17,7 +24,10 @@
 #include "esp_littlefs.h"
 #include "esp_wifi.h"
 #include "esp_netif.h"
-#include "esp_http_client.h"
+#include "http_service.h"
+#include "iperf.h"
+#include "file_server.h"
+#include "ping/ping_sock.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "lwip/sockets.h"
@@ -83,7 +93,7 @@ static lv_obj_t *weather_pressure_label = NULL;
 static lv_obj_t *weather_forecast_temps_hi[5] = {NULL};
 static lv_obj_t *weather_forecast_temps_lo[5] = {NULL};
 static lv_obj_t *weather_forecast_days[5] = {NULL};
-static bool weather_fetching = false;
+static lv_obj_t *weather_hourly_row = NULL;
 
 // Forward declarations
 static void close_app_window(void);
@@ -130,6 +140,8 @@ static void show_notification(const char* text, uint32_t duration_ms)
 
 static void close_app_window(void)
 {
+    mem_diag_app_closing(app_window);
+    
     if (clock_timer) {
         lv_timer_delete(clock_timer);
         clock_timer = NULL;
@@ -180,9 +192,13 @@ static void close_app_window(void)
         weather_forecast_temps_hi[i] = NULL;
         weather_forecast_temps_lo[i] = NULL;
     }
+    weather_hourly_row = NULL;
     
     // Reset settings page pointers since they were children of app_window
     settings_reset_pages();
+    
+    // What is still allocated now counts against the app that just closed
+    mem_diag_app_closed();
 }
 
 static lv_obj_t* create_app_window(const char* title)
@@ -1677,6 +1693,9 @@ static lv_obj_t* create_aero_glass_panel(lv_obj_t *parent, int w, int h, int x,
 
 static void weather_update_ui(void);
 
+// Copy of the cached data being displayed (too big for the LVGL task stack)
+static weather_data_t weather_view;
+
 // Callback for lv_async_call
 static void weather_async_update_cb(void *arg)
 {
@@ -1684,36 +1703,54 @@ static void weather_async_update_cb(void *arg)
     weather_update_ui();
 }
 
-static void weather_fetch_task(void *arg)
+// Runs on the weather refresh task
+static void weather_refresh_done(bool ok)
 {
-    location_settings_t *loc = settings_get_location();
-    weather_data_t data;
-    
-    if (!loc || !loc->valid) {
-        ESP_LOGW(TAG, "No location set, using Moscow");
-        weather_api_fetch(55.7558, 37.6173, &data);
-    } else {
-        weather_api_fetch(loc->latitude, loc->longitude, &data);
-    }
-    
-    weather_fetching = false;
-    
+    (void)ok;
     // Update UI from main thread
     lv_async_call(weather_async_update_cb, NULL);
-    
-    vTaskDelete(NULL);
 }
 
 static void weather_refresh_clicked(lv_event_t *e)
 {
-    if (weather_fetching) return;
-    
+    weather_api_request_refresh(true);
+
     if (weather_status_label) {
-        lv_label_set_text(weather_status_label, "Fetching weather data...");
+        lv_label_set_text(weather_status_label, system_wifi_is_connected() ?
+                          "Fetching weather data..." : "Waiting for WiFi...");
+    }
+}
+
+// Rebuild the next-24-hours strip, skipping hours already past
+static void weather_update_hourly(const weather_data_t *data)
+{
+    if (!weather_hourly_row || !lv_obj_is_valid(weather_hourly_row)) return;
+
+    lv_obj_clean(weather_hourly_row);
+    time_t now = time(NULL);
+
+    for (int i = 0; i < data->hourly_count; i++) {
+        const hourly_forecast_t *h = &data->hourly[i];
+        if (h->time + 3600 <= now) continue;
+
+        time_t local = (time_t)(h->time + data->utc_offset);
+        struct tm tm_hour;
+        gmtime_r(&local, &tm_hour);
+
+        char buf[32];
+        if (h->precipitation_prob >= 20) {
+            snprintf(buf, sizeof(buf), "%02d:00\n%.0f°\n%u%%", tm_hour.tm_hour, h->temperature,
+                     (unsigned)h->precipitation_prob);
+        } else {
+            snprintf(buf, sizeof(buf), "%02d:00\n%.0f°\n ", tm_hour.tm_hour, h->temperature);
+        }
+
+        lv_obj_t *lbl = lv_label_create(weather_hourly_row);
+        lv_label_set_text(lbl, buf);
+        lv_obj_set_width(lbl, 52);
+        lv_obj_set_style_text_align(lbl, LV_TEXT_ALIGN_CENTER, 0);
+        lv_obj_set_style_text_color(lbl, lv_color_hex(0x1A5090), 0);
     }
-    
-    weather_fetching = true;
-    xTaskCreate(weather_fetch_task, "weather_fetch", 8192, NULL, 5, NULL);
 }
 
 static void weather_update_ui(void)
@@ -1724,11 +1761,16 @@ static void weather_update_ui(void)
         return;
     }
     
-    weather_data_t *data = weather_api_get_cached();
+    weather_data_t *data = &weather_view;
     
-    if (!data || !data->valid) {
+    if (!weather_api_get_snapshot(data)) {
         if (weather_status_label && lv_obj_is_valid(weather_status_label)) {
-            lv_label_set_text(weather_status_label, "Failed to fetch weather");
+            if (weather_api_is_refreshing()) {
+                lv_label_set_text(weather_status_label, system_wifi_is_connected() ?
+                                  "Fetching weather data..." : "Waiting for WiFi...");
+            } else {
+                lv_label_set_text(weather_status_label, "Failed to fetch weather");
+            }
         }
         return;
     }
@@ -1771,30 +1813,47 @@ static void weather_update_ui(void)
         lv_label_set_text(weather_pressure_label, buf);
     }
     
-    for (int i = 0; i < 5 && i < data->daily_count; i++) {
-        if (weather_forecast_days[i] && lv_obj_is_valid(weather_forecast_days[i])) {
-            lv_label_set_text(weather_forecast_days[i], data->daily[i].day_name);
+    // A cache from an earlier day starts with days already past
+    int first_day = 0;
+    while (first_day < data->daily_count - 1 && data->daily[first_day].time + 86400 <= (int64_t)time(NULL)) {
+        first_day++;
+    }
+    
+    for (int n = 0; n < 5; n++) {
+        int i = first_day + n;
+        if (i >= data->daily_count) break;
+        if (weather_forecast_days[n] && lv_obj_is_valid(weather_forecast_days[n])) {
+            lv_label_set_text(weather_forecast_days[n], weather_day_label(data, i));
         }
-        if (weather_forecast_temps_hi[i] && lv_obj_is_valid(weather_forecast_temps_hi[i])) {
+        if (weather_forecast_temps_hi[n] && lv_obj_is_valid(weather_forecast_temps_hi[n])) {
             char buf[8];
             snprintf(buf, sizeof(buf), "%.0f°", data->daily[i].temp_max);
-            lv_label_set_text(weather_forecast_temps_hi[i], buf);
+            lv_label_set_text(weather_forecast_temps_hi[n], buf);
         }
-        if (weather_forecast_temps_lo[i] && lv_obj_is_valid(weather_forecast_temps_lo[i])) {
+        if (weather_forecast_temps_lo[n] && lv_obj_is_valid(weather_forecast_temps_lo[n])) {
             char buf[8];
             snprintf(buf, sizeof(buf), "%.0f°", data->daily[i].temp_min);
-            lv_label_set_text(weather_forecast_temps_lo[i], buf);
+            lv_label_set_text(weather_forecast_temps_lo[n], buf);
         }
     }
     
+    weather_update_hourly(data);
+    
     if (weather_status_label && lv_obj_is_valid(weather_status_label)) {
-        time_t now = time(NULL);
-        int mins_ago = (now - data->fetch_time) / 60;
+        int age = weather_api_cache_age();
         char buf[64];
-        if (mins_ago < 1) {
+        if (age < 0) {
+            snprintf(buf, sizeof(buf), "Showing saved forecast");
+        } else if (age < 60) {
             snprintf(buf, sizeof(buf), "Updated just now");
+        } else if (age < 2 * 3600) {
+            snprintf(buf, sizeof(buf), "Updated %d min ago", age / 60);
         } else {
-            snprintf(buf, sizeof(buf), "Updated %d min ago", mins_ago);
+            snprintf(buf, sizeof(buf), "Updated %d h ago", age / 3600);
+        }
+        if (weather_api_is_refreshing()) {
+            strncat(buf, system_wifi_is_connected() ? " - updating..." : " - waiting for WiFi",
+                    sizeof(buf) - strlen(buf) - 1);
         }
         lv_label_set_text(weather_status_label, buf);
     }
@@ -1806,6 +1865,7 @@ void app_weather_create(void)
     create_app_window("Weather");
     
     weather_api_init();
+    weather_api_set_update_cb(weather_refresh_done);
     
     // Vista style content area - light blue gradient like Settings
     weather_content = lv_obj_create(app_window);
@@ -1819,7 +1879,7 @@ void app_weather_create(void)
     lv_obj_set_style_pad_all(weather_content, 10, 0);
     lv_obj_set_flex_flow(weather_content, LV_FLEX_FLOW_COLUMN);
     lv_obj_set_style_pad_row(weather_content, 8, 0);
-    lv_obj_remove_flag(weather_content, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_scroll_dir(weather_content, LV_DIR_VER);
     
     // Header bar with location and refresh
     lv_obj_t *header = lv_obj_create(weather_content);
@@ -1977,6 +2037,20 @@ void app_weather_create(void)
     lv_obj_set_style_text_color(weather_pressure_label, lv_color_hex(0x1A5090), 0);
     lv_obj_align(weather_pressure_label, LV_ALIGN_BOTTOM_MID, 0, -8);
     
+    // Hourly strip - next 24 hours, scrolls sideways
+    weather_hourly_row = lv_obj_create(weather_content);
+    lv_obj_set_size(weather_hourly_row, lv_pct(100), 80);
+    lv_obj_set_style_bg_color(weather_hourly_row, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_border_color(weather_hourly_row, lv_color_hex(0x7EB4EA), 0);
+    lv_obj_set_style_border_width(weather_hourly_row, 1, 0);
+    lv_obj_set_style_radius(weather_hourly_row, 6, 0);
+    lv_obj_set_style_pad_all(weather_hourly_row, 6, 0);
+    lv_obj_set_style_pad_column(weather_hourly_row, 4, 0);
+    lv_obj_set_flex_flow(weather_hourly_row, LV_FLEX_FLOW_ROW);
+    lv_obj_set_flex_align(weather_hourly_row, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+    lv_obj_set_scroll_dir(weather_hourly_row, LV_DIR_HOR);
+    lv_obj_set_scrollbar_mode(weather_hourly_row, LV_SCROLLBAR_MODE_OFF);
+    
     // Forecast panel - white with blue border
     lv_obj_t *forecast = lv_obj_create(weather_content);
     lv_obj_set_size(forecast, lv_pct(100), 200);
@@ -2054,10 +2128,17 @@ void app_weather_create(void)
     lv_obj_set_style_text_color(weather_status_label, lv_color_hex(0x4A6080), 0);
     lv_obj_align(weather_status_label, LV_ALIGN_LEFT_MID, 25, 0);
     
-    if (weather_api_cache_valid()) {
+    // Show whatever is cached (even stale) right away, then revalidate
+    // in the background; the refresh is skipped while the cache is fresh
+    bool have_cache = weather_api_get_snapshot(&weather_view);
+    if (have_cache || (loc && loc->valid)) {
+        weather_api_request_refresh(false);
+    }
+    if (have_cache) {
         weather_update_ui();
     } else if (loc && loc->valid) {
-        weather_refresh_clicked(NULL);
+        lv_label_set_text(weather_status_label, system_wifi_is_connected() ?
+                          "Fetching weather data..." : "Waiting for WiFi...");
     }
 }
 
@@ -2566,9 +2647,12 @@ static void camera_frame_cb(uint8_t *data, uint16_t width, uint16_t height, void
     
     // Skip if previous frame not yet consumed (avoid overwriting)
     if (camera_new_frame) {
+        TRACE_INSTANT("camera_frame_skip");
         return;
     }
     
+    TRACE_BEGIN("camera_frame_cb");
+    
     // Apply digital zoom - crop center of image
     int zoom_factor = camera_digital_zoom;
     int crop_width = (width * 100) / zoom_factor;
@@ -2600,6 +2684,9 @@ static void camera_frame_cb(uint8_t *data, uint16_t width, uint16_t height, void
     // Signal that new frame is ready (atomic write)
     camera_frame_count++;
     camera_new_frame = true;
+    
+    TRACE_END("camera_frame_cb");
+    TRACE_COUNTER("camera_frames", camera_frame_count);
 }
 
 // Timer callback to update preview from LVGL thread (Core 0)
@@ -3928,6 +4015,7 @@ static void mycomp_drive_clicked(lv_event_t *e)
 static void mycomp_browse_path(const char *path)
 {
     if (!mycomp_content) return;
+    TRACE_SCOPE("mycomp_browse_path");
     
     // Clear content
     lv_obj_clean(mycomp_content);
@@ -6073,7 +6161,9 @@ void app_launch(const char* app_name)
         app_my_computer_open_path("Games");
     } else {
         ESP_LOGW(TAG, "Unknown app: %s", app_name);
+        return;
     }
+    mem_diag_app_opened(app_name);
 }
 
 // ============ CONSOLE APP ============
@@ -6142,6 +6232,63 @@ static void console_clear(void)
     }
 }
 
+// Output of background tasks (wget, ping, iperf, curl). They never touch
+// LVGL: lines are appended to one half of a double buffer under a
+// spinlock, and a timer on the LVGL side swaps the halves and prints.
+#define CONSOLE_ASYNC_SIZE      4096
+#define CONSOLE_ASYNC_PERIOD_MS 50
+
+static char console_async_buf[2][CONSOLE_ASYNC_SIZE];
+static size_t console_async_len = 0;
+static int console_async_fill = 0;          // Half the producers write to
+static uint32_t console_async_dropped = 0;
+static portMUX_TYPE console_async_lock = portMUX_INITIALIZER_UNLOCKED;
+static lv_timer_t *console_async_timer = NULL;
+
+static void console_async_drain_cb(lv_timer_t *t)
+{
+    portENTER_CRITICAL(&console_async_lock);
+    if (console_async_len == 0 && console_async_dropped == 0) {
+        portEXIT_CRITICAL(&console_async_lock);
+        return;
+    }
+    char *text = console_async_buf[console_async_fill];
+    text[console_async_len] = '\0';
+    uint32_t dropped = console_async_dropped;
+    console_async_fill ^= 1;
+    console_async_len = 0;
+    console_async_dropped = 0;
+    portEXIT_CRITICAL(&console_async_lock);
+    
+    console_print(text);
+    if (dropped) {
+        char note[48];
+        snprintf(note, sizeof(note), "[%lu bytes of output dropped]\n", (unsigned long)dropped);
+        console_print(note);
+    }
+}
+
+// Create the drain timer; called from the LVGL thread when a console opens
+static void console_async_start(void)
+{
+    if (!console_async_timer) {
+        console_async_timer = lv_timer_create(console_async_drain_cb, CONSOLE_ASYNC_PERIOD_MS, NULL);
+    }
+}
+
+// console_print() for background tasks: the text is queued and printed from LVGL
+static void console_print_async(const char *text)
+{
+    size_t len = strlen(text);
+    portENTER_CRITICAL(&console_async_lock);
+    size_t room = CONSOLE_ASYNC_SIZE - 1 - console_async_len;
+    size_t n = len < room ? len : room;
+    memcpy(console_async_buf[console_async_fill] + console_async_len, text, n);
+    console_async_len += n;
+    console_async_dropped += len - n;
+    portEXIT_CRITICAL(&console_async_lock);
+}
+
 static void console_fastfetch(void)
 {
     // ESP32 ASCII art logo (clean, no ANSI codes)
@@ -6235,10 +6382,21 @@ static void console_cmd_help(void)
         "  whoami           - Show current user\n"
         "  hostname         - Show hostname\n"
         "  date             - Show date/time\n"
+        "  trace <cmd>      - start|stop|dump|status\n"
+        "  js <file.js>     - Run a script (-c compile, clear, stop)\n"
+        "  gfxbench         - JS gfx primitives per frame\n"
+        "  synbench [lines] - JS editor highlighting cost\n"
+        "  memdiag [cmd]    - Memory report (save, last)\n"
+        "  top [n]          - Busiest tasks and load per core\n"
         "\n"
         "=== Network ===\n"
-        "  ping <host>      - Ping host\n"
+        "  ping <host>      - ICMP ping (-c, -i, stop)\n"
+        "  iperf -s|-c host - Bandwidth test (-u, -t, -b, stop)\n"
+        "  fileserver       - HTTP file server (start [port] [token], stop)\n"
+        "  btsend <path..>  - Send files/folders over BLE\n"
         "  curl <url>       - HTTP GET request\n"
+        "  wget <url> [..]  - Download to files (-c, -O, -i, stop)\n"
+        "  httpstat         - HTTP connection pool stats\n"
         "  ifconfig         - Show network info\n"
         "  wifi             - Show WiFi status\n"
         "\n"
@@ -6622,6 +6780,47 @@ static void console_cmd_ps(void)
     }
 }
 
+static void console_cmd_trace(const char *arg)
+{
+    char buf[160];
+    
+    if (!arg || strcmp(arg, "status") == 0) {
+        uint32_t held = 0, dropped = 0;
+        trace_get_stats(&held, &dropped);
+        snprintf(buf, sizeof(buf), "Trace: %s, %lu events buffered, %lu dropped\n",
+                 g_trace_running ? "recording" : "stopped",
+                 (unsigned long)held, (unsigned long)dropped);
+        console_print(buf);
+        if (!arg) console_print("Usage: trace start [events] | stop | dump [file] | status\n");
+    } else if (strncmp(arg, "start", 5) == 0) {
+        size_t events = (size_t)atoi(arg + 5);
+        esp_err_t ret = trace_start(events);
+        if (ret == ESP_OK) {
+            console_print("Tracing started\n");
+        } else if (ret == ESP_ERR_INVALID_STATE) {
+            console_print("Error: already tracing, run 'trace stop' first\n");
+        } else {
+            console_print("Error: not enough PSRAM for trace buffers\n");
+        }
+    } else if (strcmp(arg, "stop") == 0) {
+        trace_stop();
+        console_print("Tracing stopped\n");
+    } else if (strncmp(arg, "dump", 4) == 0) {
+        const char *file = arg + 4;
+        while (*file == ' ') file++;
+        char path[128];
+        int n = trace_dump(*file ? file : NULL, path, sizeof(path));
+        if (n < 0) {
+            console_print("Error: dump failed (tracing never started or SD card missing)\n");
+        } else {
+            snprintf(buf, sizeof(buf), "Wrote %d events to %s\n", n, path);
+            console_print(buf);
+        }
+    } else {
+        console_print("Usage: trace start [events] | stop | dump [file] | status\n");
+    }
+}
+
 static void console_cmd_date(void)
 {
     time_t now;
@@ -6697,226 +6896,1310 @@ static void console_cmd_wifi(void)
     }
 }
 
-static void console_cmd_ping(const char *host)
+// ping runs on its own task: resolving, the ICMP session and the summary
+// never block the UI thread; replies stream in through console_print_async
+#define PING_DEFAULT_COUNT      4
+#define PING_DEFAULT_INTERVAL   1000
+#define PING_TIMEOUT_MS         1000
+
+typedef struct {
+    char host[64];
+    uint32_t count;
+    uint32_t interval_ms;
+    TaskHandle_t waiter;
+    uint32_t replies;
+    uint32_t min_ms;
+    uint32_t max_ms;
+    uint32_t sum_ms;
+    uint32_t last_ms;
+    uint32_t jitter_sum_ms;     // Sum of |rtt[n] - rtt[n-1]|
+} ping_job_t;
+
+static volatile bool ping_active = false;
+static volatile bool ping_stop = false;
+
+static void ping_on_success(esp_ping_handle_t hdl, void *args)
 {
-    if (!host || strlen(host) == 0) {
-        console_print("Usage: ping <hostname or IP>\n");
-        return;
-    }
+    ping_job_t *job = (ping_job_t *)args;
+    uint16_t seqno;
+    uint8_t ttl;
+    uint32_t size, elapsed_ms;
+    ip_addr_t target;
+    esp_ping_get_profile(hdl, ESP_PING_PROF_SEQNO, &seqno, sizeof(seqno));
+    esp_ping_get_profile(hdl, ESP_PING_PROF_TTL, &ttl, sizeof(ttl));
+    esp_ping_get_profile(hdl, ESP_PING_PROF_IPADDR, &target, sizeof(target));
+    esp_ping_get_profile(hdl, ESP_PING_PROF_SIZE, &size, sizeof(size));
+    esp_ping_get_profile(hdl, ESP_PING_PROF_TIMEGAP, &elapsed_ms, sizeof(elapsed_ms));
+    
+    if (job->replies == 0 || elapsed_ms < job->min_ms) job->min_ms = elapsed_ms;
+    if (elapsed_ms > job->max_ms) job->max_ms = elapsed_ms;
+    if (job->replies > 0) {
+        job->jitter_sum_ms += elapsed_ms > job->last_ms ? elapsed_ms - job->last_ms : job->last_ms - elapsed_ms;
+    }
+    job->last_ms = elapsed_ms;
+    job->sum_ms += elapsed_ms;
+    job->replies++;
+    
+    char buf[96];
+    snprintf(buf, sizeof(buf), "%lu bytes from %s: icmp_seq=%u ttl=%u time=%lu ms\n",
+             (unsigned long)size, ipaddr_ntoa(&target), seqno, ttl, (unsigned long)elapsed_ms);
+    console_print_async(buf);
+}
+
+static void ping_on_timeout(esp_ping_handle_t hdl, void *args)
+{
+    uint16_t seqno;
+    esp_ping_get_profile(hdl, ESP_PING_PROF_SEQNO, &seqno, sizeof(seqno));
     
-    char buf[256];
-    snprintf(buf, sizeof(buf), "PING %s:\n", host);
-    console_print(buf);
+    char buf[48];
+    snprintf(buf, sizeof(buf), "Request timeout for icmp_seq=%u\n", seqno);
+    console_print_async(buf);
+}
+
+static void ping_on_end(esp_ping_handle_t hdl, void *args)
+{
+    ping_job_t *job = (ping_job_t *)args;
+    xTaskNotifyGive(job->waiter);
+}
+
+static void ping_task(void *arg)
+{
+    ping_job_t *job = (ping_job_t *)arg;
+    char buf[160];
     
-    // Resolve hostname
-    struct addrinfo hints = {}, *res;
+    struct addrinfo hints = {}, *res = NULL;
     hints.ai_family = AF_INET;
-    
-    int err = getaddrinfo(host, NULL, &hints, &res);
-    if (err != 0 || res == NULL) {
-        snprintf(buf, sizeof(buf), "Could not resolve hostname: %s\n", host);
-        console_print(buf);
+    if (getaddrinfo(job->host, NULL, &hints, &res) != 0 || res == NULL) {
+        snprintf(buf, sizeof(buf), "ping: could not resolve %s\n", job->host);
+        console_print_async(buf);
+        free(job);
+        ping_active = false;
+        vTaskDelete(NULL);
         return;
     }
     
-    struct in_addr *addr = &((struct sockaddr_in *)res->ai_addr)->sin_addr;
-    char ip_str[16];
-    inet_ntoa_r(*addr, ip_str, sizeof(ip_str));
+    esp_ping_config_t config = ESP_PING_DEFAULT_CONFIG();
+    struct in_addr addr4 = ((struct sockaddr_in *)res->ai_addr)->sin_addr;
+    inet_addr_to_ip4addr(ip_2_ip4(&config.target_addr), &addr4);
+    IP_SET_TYPE(&config.target_addr, IPADDR_TYPE_V4);
     freeaddrinfo(res);
+    config.count = job->count;
+    config.interval_ms = job->interval_ms;
+    config.timeout_ms = PING_TIMEOUT_MS;
+    
+    snprintf(buf, sizeof(buf), "PING %s (%s): %lu data bytes\n",
+             job->host, ipaddr_ntoa(&config.target_addr), (unsigned long)config.data_size);
+    console_print_async(buf);
+    
+    esp_ping_callbacks_t cbs = {};
+    cbs.cb_args = job;
+    cbs.on_ping_success = ping_on_success;
+    cbs.on_ping_timeout = ping_on_timeout;
+    cbs.on_ping_end = ping_on_end;
+    
+    job->waiter = xTaskGetCurrentTaskHandle();
+    esp_ping_handle_t hdl = NULL;
+    if (esp_ping_new_session(&config, &cbs, &hdl) != ESP_OK) {
+        console_print_async("ping: failed to create session\n");
+        free(job);
+        ping_active = false;
+        vTaskDelete(NULL);
+        return;
+    }
+    esp_ping_start(hdl);
     
-    snprintf(buf, sizeof(buf), "Resolved to: %s\n", ip_str);
-    console_print(buf);
-    
-    // Simple TCP connect test (not real ICMP ping, but works without raw sockets)
-    for (int i = 0; i < 3; i++) {
-        int64_t start = esp_timer_get_time();
-        
-        int sock = socket(AF_INET, SOCK_STREAM, 0);
-        if (sock < 0) {
-            console_print("Socket error\n");
-            return;
-        }
-        
-        struct sockaddr_in dest_addr;
-        dest_addr.sin_family = AF_INET;
-        dest_addr.sin_port = htons(80);
-        inet_pton(AF_INET, ip_str, &dest_addr.sin_addr);
-        
-        // Set timeout
-        struct timeval tv;
-        tv.tv_sec = 2;
-        tv.tv_usec = 0;
-        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-        setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
-        
-        int result = connect(sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-        int64_t elapsed = (esp_timer_get_time() - start) / 1000;
-        
-        close(sock);
-        
-        if (result == 0) {
-            snprintf(buf, sizeof(buf), "Reply from %s: time=%lldms\n", ip_str, elapsed);
-        } else {
-            snprintf(buf, sizeof(buf), "Request timeout for %s\n", ip_str);
+    // Wait for on_ping_end; "ping stop" is applied from here so the
+    // session is only ever touched by this task
+    bool stop_sent = false;
+    while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(200)) == 0) {
+        if (ping_stop && !stop_sent) {
+            esp_ping_stop(hdl);
+            stop_sent = true;
         }
-        console_print(buf);
-        
-        vTaskDelay(pdMS_TO_TICKS(500));
     }
+    
+    uint32_t transmitted = 0, received = 0;
+    esp_ping_get_profile(hdl, ESP_PING_PROF_REQUEST, &transmitted, sizeof(transmitted));
+    esp_ping_get_profile(hdl, ESP_PING_PROF_REPLY, &received, sizeof(received));
+    esp_ping_delete_session(hdl);
+    
+    uint32_t loss = transmitted ? (transmitted - received) * 100 / transmitted : 0;
+    snprintf(buf, sizeof(buf), "--- %s ping statistics ---\n"
+             "%lu packets transmitted, %lu received, %lu%% packet loss\n",
+             job->host, (unsigned long)transmitted, (unsigned long)received, (unsigned long)loss);
+    console_print_async(buf);
+    if (job->replies > 0) {
+        snprintf(buf, sizeof(buf), "rtt min/avg/max/jitter = %lu/%lu/%lu/%lu ms\n",
+                 (unsigned long)job->min_ms, (unsigned long)(job->sum_ms / job->replies),
+                 (unsigned long)job->max_ms,
+                 (unsigned long)(job->replies > 1 ? job->jitter_sum_ms / (job->replies - 1) : 0));
+        console_print_async(buf);
+    }
+    
+    free(job);
+    ping_active = false;
+    vTaskDelete(NULL);
 }
 
-static void console_cmd_curl(const char *url)
+static void console_cmd_ping(const char *arg)
 {
-    if (!url || strlen(url) == 0) {
-        console_print("Usage: curl <url>\n");
+    if (!arg || strlen(arg) == 0) {
+        console_print("Usage: ping [-c count] [-i interval_ms] <host>\n"
+                      "       ping stop\n"
+                      "  -c 0 pings until stopped\n");
         return;
     }
     
-    char buf[256];
-    snprintf(buf, sizeof(buf), "Fetching: %s\n", url);
-    console_print(buf);
-    
-    esp_http_client_config_t config = {};
-    config.url = url;
-    config.timeout_ms = 5000;
-    config.buffer_size = 1024;
-    
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (!client) {
-        console_print("Error: Failed to init HTTP client\n");
+    if (strcmp(arg, "stop") == 0) {
+        if (ping_active) {
+            ping_stop = true;
+        } else {
+            console_print("No ping running\n");
+        }
         return;
     }
     
-    esp_err_t err = esp_http_client_open(client, 0);
-    if (err != ESP_OK) {
-        snprintf(buf, sizeof(buf), "Error: Connection failed (%s)\n", esp_err_to_name(err));
-        console_print(buf);
-        esp_http_client_cleanup(client);
+    if (ping_active) {
+        console_print("ping: already running (ping stop)\n");
         return;
     }
     
-    int content_length = esp_http_client_fetch_headers(client);
-    int status = esp_http_client_get_status_code(client);
-    
-    snprintf(buf, sizeof(buf), "HTTP %d, Content-Length: %d\n\n", status, content_length);
-    console_print(buf);
-    
-    // Read response (limited to avoid buffer overflow)
-    char response[512];
-    int total_read = 0;
-    int read_len;
-    
-    while ((read_len = esp_http_client_read(client, response, sizeof(response) - 1)) > 0 && total_read < 2048) {
-        response[read_len] = '\0';
-        console_print(response);
-        total_read += read_len;
+    ping_job_t *job = (ping_job_t *)calloc(1, sizeof(ping_job_t));
+    if (!job) {
+        console_print("Error: Out of memory\n");
+        return;
+    }
+    job->count = PING_DEFAULT_COUNT;
+    job->interval_ms = PING_DEFAULT_INTERVAL;
+    
+    char args[128];
+    strncpy(args, arg, sizeof(args) - 1);
+    args[sizeof(args) - 1] = '\0';
+    
+    char *save = NULL;
+    for (char *tok = strtok_r(args, " ", &save); tok; tok = strtok_r(NULL, " ", &save)) {
+        if (strcmp(tok, "-c") == 0) {
+            const char *val = strtok_r(NULL, " ", &save);
+            if (val) job->count = strtoul(val, NULL, 10);
+        } else if (strcmp(tok, "-i") == 0) {
+            const char *val = strtok_r(NULL, " ", &save);
+            if (val) job->interval_ms = strtoul(val, NULL, 10);
+        } else {
+            strncpy(job->host, tok, sizeof(job->host) - 1);
+        }
     }
     
-    if (total_read >= 2048) {
-        console_print("\n... (truncated)\n");
+    if (job->host[0] == '\0') {
+        console_print("ping: no host given\n");
+        free(job);
+        return;
     }
+    if (job->interval_ms < 100) job->interval_ms = 100;
     
-    console_print("\n");
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
+    ping_stop = false;
+    ping_active = true;
+    if (xTaskCreate(ping_task, "ping", 4096, job, 5, NULL) != pdPASS) {
+        console_print("Error: Failed to start ping task\n");
+        ping_active = false;
+        free(job);
+    }
 }
 
-// ===== CONSOLE COMMANDS =====
+// "20M", "500K" or plain bits/s
+static uint32_t console_parse_rate(const char *val)
+{
+    char *end = NULL;
+    double rate = strtod(val, &end);
+    if (end && (*end == 'M' || *end == 'm')) rate *= 1000000;
+    else if (end && (*end == 'K' || *end == 'k')) rate *= 1000;
+    return rate > 0 ? (uint32_t)rate : 0;
+}
 
-static void console_cmd_color(const char *arg)
+static void console_cmd_iperf(const char *arg)
 {
     if (!arg || strlen(arg) == 0) {
-        console_print("Color schemes:\n");
-        console_print("  0: Black/Green (default)\n");
-        console_print("  1: Black/White\n");
-        console_print("  2: Navy/Yellow\n");
-        console_print("  3: Black/Cyan\n");
-        console_print("  4: Maroon/White\n");
-        console_print("  5: Green/White\n");
-        console_print("  6: Navy/White\n");
-        console_print("  7: Black/Red\n");
-        console_print("  8: Matrix (Dark Blue/Green)\n");
-        console_print("  9: Dracula\n");
-        console_print("Usage: color <0-9>\n");
+        console_print("Usage: iperf -s [-u] [-p port] [-i sec]\n"
+                      "       iperf -c <host> [-u] [-p port] [-t sec] [-i sec] [-b 20M] [-l len]\n"
+                      "       iperf stop\n"
+                      "  Peer: desktop iperf 2 (iperf -s / iperf -c <board ip>)\n");
         return;
     }
     
-    int scheme = atoi(arg);
-    if (scheme >= 0 && scheme <= 9) {
-        console_bg_color = color_presets[scheme][0];
-        console_text_color = color_presets[scheme][1];
-        console_prompt_color = (scheme == 0) ? 0xFFFF00 : console_text_color;
-        
-        // Apply colors
-        if (console_output) {
-            lv_obj_set_style_bg_color(console_output, lv_color_hex(console_bg_color), 0);
-            lv_obj_set_style_text_color(console_output, lv_color_hex(console_text_color), 0);
-        }
-        if (console_input) {
-            lv_obj_set_style_text_color(console_input, lv_color_hex(console_prompt_color), 0);
-            lv_obj_set_style_border_color(console_input, lv_color_hex(console_text_color), 0);
+    if (strcmp(arg, "stop") == 0) {
+        if (iperf_is_running()) {
+            iperf_stop();
+            console_print("Stopping iperf...\n");
+        } else {
+            console_print("No iperf running\n");
         }
-        if (console_window) {
-            lv_obj_set_style_bg_color(console_window, lv_color_hex(console_bg_color), 0);
+        return;
+    }
+    
+    if (!system_wifi_is_connected()) {
+        console_print("iperf: WiFi not connected\n");
+        return;
+    }
+    
+    iperf_config_t config = {};
+    bool mode_set = false;
+    char args[128];
+    strncpy(args, arg, sizeof(args) - 1);
+    args[sizeof(args) - 1] = '\0';
+    
+    char *save = NULL;
+    for (char *tok = strtok_r(args, " ", &save); tok; tok = strtok_r(NULL, " ", &save)) {
+        if (strcmp(tok, "-s") == 0) {
+            config.server = true;
+            mode_set = true;
+        } else if (strcmp(tok, "-u") == 0) {
+            config.udp = true;
+        } else {
+            const char *val = strtok_r(NULL, " ", &save);
+            if (!val) break;
+            if (strcmp(tok, "-c") == 0) {
+                strncpy(config.host, val, sizeof(config.host) - 1);
+                mode_set = true;
+            } else if (strcmp(tok, "-p") == 0) {
+                config.port = (uint16_t)atoi(val);
+            } else if (strcmp(tok, "-t") == 0) {
+                config.time_s = strtoul(val, NULL, 10);
+            } else if (strcmp(tok, "-i") == 0) {
+                config.interval_s = strtoul(val, NULL, 10);
+            } else if (strcmp(tok, "-b") == 0) {
+                config.bandwidth_bps = console_parse_rate(val);
+            } else if (strcmp(tok, "-l") == 0) {
+                config.len = strtoul(val, NULL, 10);
+            }
         }
-        
-        char buf[64];
-        snprintf(buf, sizeof(buf), "Color scheme %d applied.\n", scheme);
-        console_print(buf);
+    }
+    
+    if (!mode_set) {
+        console_print("iperf: need -s or -c <host>\n");
+        return;
+    }
+    
+    esp_err_t err = iperf_start(&config, console_print_async);
+    if (err == ESP_ERR_INVALID_STATE) {
+        console_print("iperf: a test is already running (iperf stop)\n");
+    } else if (err != ESP_OK) {
+        console_print("iperf: Out of memory\n");
+    }
+}
+
+// curl output is collected on the HTTP service task and printed from LVGL
+#define CURL_SHOW_MAX   2048
+
+typedef struct {
+    char text[CURL_SHOW_MAX + 256];
+    int len;
+    int status;
+    int64_t content_length;
+} curl_job_t;
+
+static int curl_on_headers(int status, int64_t content_length, void *user)
+{
+    curl_job_t *job = (curl_job_t *)user;
+    job->status = status;
+    job->content_length = content_length;
+    return 0;
+}
+
+// Keep the first CURL_SHOW_MAX bytes, drain the rest so the connection stays reusable
+static int curl_on_body(const char *data, size_t len, void *user)
+{
+    curl_job_t *job = (curl_job_t *)user;
+    size_t room = CURL_SHOW_MAX - job->len;
+    if (room > len) room = len;
+    memcpy(job->text + job->len, data, room);
+    job->len += room;
+    return 0;
+}
+
+static void curl_on_done(esp_err_t err, const http_service_result_t *result, void *user)
+{
+    curl_job_t *job = (curl_job_t *)user;
+    char body[CURL_SHOW_MAX + 1];
+    memcpy(body, job->text, job->len);
+    body[job->len] = '\0';
+    
+    if (err != ESP_OK) {
+        snprintf(job->text, sizeof(job->text), "Error: Connection failed (%s)\n", esp_err_to_name(err));
     } else {
-        console_print("Invalid color scheme. Use 0-9.\n");
+        int pos = snprintf(job->text, sizeof(job->text), "HTTP %d, Content-Length: %lld\n\n%s",
+                           job->status, (long long)job->content_length, body);
+        if (result->bytes > CURL_SHOW_MAX) {
+            pos += snprintf(job->text + pos, sizeof(job->text) - pos, "\n... (truncated)");
+        }
+        snprintf(job->text + pos, sizeof(job->text) - pos, "\n[%llu bytes in %lld ms%s]\n",
+                 (unsigned long long)result->bytes, (long long)(result->elapsed_us / 1000),
+                 result->reused ? ", connection reused" : "");
     }
+    console_print_async(job->text);
+    free(job);
 }
 
-static void console_cmd_free(void)
+static void console_cmd_curl(const char *url)
 {
+    if (!url || strlen(url) == 0) {
+        console_print("Usage: curl <url>\n");
+        return;
+    }
+    
     char buf[256];
+    snprintf(buf, sizeof(buf), "Fetching: %s\n", url);
+    console_print(buf);
     
-    size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
-    size_t total_heap = heap_caps_get_total_size(MALLOC_CAP_8BIT);
-    size_t free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
-    size_t total_psram = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
+    curl_job_t *job = (curl_job_t *)calloc(1, sizeof(curl_job_t));
+    if (!job) {
+        console_print("Error: Out of memory\n");
+        return;
+    }
     
-    console_print("Memory Info:\n");
-    snprintf(buf, sizeof(buf), "  Heap:  %8lu / %8lu bytes (%lu%% used)\n",
-             (unsigned long)(total_heap - free_heap),
-             (unsigned long)total_heap,
-             (unsigned long)((total_heap - free_heap) * 100 / total_heap));
-    console_print(buf);
+    // Runs on the shared HTTP service so the console stays responsive
+    http_service_request_t req = {};
+    req.url = url;
+    req.timeout_ms = 5000;
+    req.on_headers = curl_on_headers;
+    req.on_body = curl_on_body;
+    req.on_done = curl_on_done;
+    req.user = job;
     
-    snprintf(buf, sizeof(buf), "  PSRAM: %8lu / %8lu bytes (%lu%% used)\n",
-             (unsigned long)(total_psram - free_psram),
-             (unsigned long)total_psram,
-             (unsigned long)((total_psram - free_psram) * 100 / total_psram));
-    console_print(buf);
+    if (http_service_perform_async(&req) != ESP_OK) {
+        console_print("Error: Failed to queue request\n");
+        free(job);
+    }
 }
 
-static void console_cmd_uptime(void)
+static void console_cmd_httpstat(void)
 {
-    uint32_t uptime_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    uint32_t uptime_sec = uptime_ms / 1000;
-    uint32_t days = uptime_sec / 86400;
-    uint32_t hours = (uptime_sec % 86400) / 3600;
-    uint32_t mins = (uptime_sec % 3600) / 60;
-    uint32_t secs = uptime_sec % 60;
+    http_service_stats_t st;
+    http_service_get_stats(&st);
     
-    char buf[128];
-    snprintf(buf, sizeof(buf), "Uptime: %lud %02lu:%02lu:%02lu\n",
-             (unsigned long)days, (unsigned long)hours, 
-             (unsigned long)mins, (unsigned long)secs);
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "HTTP requests: %lu (%lu failed)\n"
+             "  new connections: %lu, reused: %lu, stale retries: %lu\n"
+             "  open now: %lu, received: %llu KB\n",
+             (unsigned long)st.requests, (unsigned long)st.failures,
+             (unsigned long)st.connects, (unsigned long)st.reused, (unsigned long)st.stale_retries,
+             (unsigned long)st.open, (unsigned long long)(st.bytes / 1024));
     console_print(buf);
 }
 
-static void console_process_cmd(const char *cmd)
+static void console_cmd_fileserver(const char *arg)
 {
-    if (!cmd) return;
+    char buf[256];
     
-    // Skip leading whitespace
-    while (*cmd == ' ') cmd++;
-    if (strlen(cmd) == 0) return;
+    if (arg && strncmp(arg, "start", 5) == 0) {
+        if (!system_wifi_is_connected()) {
+            console_print("fileserver: WiFi not connected\n");
+            return;
+        }
+        // start [port] [token]
+        char token[FILE_SERVER_TOKEN_LEN + 2] = "";
+        int port = 0;
+        if (sscanf(arg + 5, "%d %33s", &port, token) < 1) {
+            sscanf(arg + 5, "%33s", token);
+        }
+        esp_err_t err = file_server_start((uint16_t)port, token);
+        if (err == ESP_ERR_INVALID_STATE) {
+            console_print("fileserver: already running\n");
+            return;
+        } else if (err == ESP_ERR_INVALID_ARG) {
+            console_print("fileserver: token is up to 32 letters, digits, - or _\n");
+            return;
+        } else if (err != ESP_OK) {
+            snprintf(buf, sizeof(buf), "fileserver: start failed (%s)\n", esp_err_to_name(err));
+            console_print(buf);
+            return;
+        }
+    } else if (arg && strcmp(arg, "stop") == 0) {
+        if (file_server_is_running()) {
+            file_server_stop();
+            console_print("File server stopping\n");
+        } else {
+            console_print("File server not running\n");
+        }
+        return;
+    } else if (arg && arg[0] != '\0') {
+        console_print("Usage: fileserver [start [port] [token] | stop]\n");
+        return;
+    }
     
-    // Parse command and arguments
-    char cmd_buf[256];
+    file_server_stats_t st;
+    file_server_get_stats(&st);
+    if (!st.running) {
+        console_print("File server not running (fileserver start)\n");
+        return;
+    }
+    
+    char ip_str[16] = "?";
+    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    esp_netif_ip_info_t ip_info;
+    if (netif && esp_netif_get_ip_info(netif, &ip_info) == ESP_OK) {
+        snprintf(ip_str, sizeof(ip_str), IPSTR, IP2STR(&ip_info.ip));
+    }
+    char port_str[8] = "";
+    if (st.port != 80) snprintf(port_str, sizeof(port_str), ":%u", st.port);
+    snprintf(buf, sizeof(buf),
+             "File server: http://%s%s/ (/littlefs, /sdcard)\n"
+             "  token for uploads and deletes: %s\n"
+             "  connections: %lu, requests: %lu, uploaded files: %lu\n"
+             "  sent: %llu KB, received: %llu KB\n",
+             ip_str, port_str, st.token,
+             (unsigned long)st.connections, (unsigned long)st.requests, (unsigned long)st.files_uploaded,
+             (unsigned long long)(st.bytes_sent / 1024), (unsigned long long)(st.bytes_received / 1024));
+    console_print(buf);
+}
+
+// One line of heap arena and GC figures for a finished script
+static void js_format_heap(duk_esp32_t *duk, char *buf, size_t size)
+{
+    duk_arena_stats_t st;
+    if (!duk_esp32_get_arena_stats(duk, &st)) {
+        snprintf(buf, size, "heap: system allocator, %lu GCs", (unsigned long)duk->gc.count);
+        return;
+    }
+    snprintf(buf, size, "heap: %u/%u KB, peak %u KB, frag %u%%, %lu GCs (max %lu us)",
+             (unsigned)(st.used / 1024), (unsigned)(st.size / 1024), (unsigned)(st.peak / 1024),
+             (unsigned)st.fragmentation, (unsigned long)duk->gc.count, (unsigned long)duk->gc.max_us);
+}
+
+// Script started by "js <file>": it runs on the context's worker task like
+// the IDE's, and a timer moves its output to the console until it is done
+static duk_esp32_t *console_js_duk = NULL;
+static lv_timer_t *console_js_timer = NULL;
+
+static void console_js_poll_cb(lv_timer_t *t)
+{
+    duk_esp32_t *duk = console_js_duk;
+    char buf[256];
+    while (duk_esp32_read_output(duk, buf, sizeof(buf)) > 0) {
+        console_print(buf);
+    }
+    if (duk_esp32_poll(duk) != DUK_ESP32_DONE) return;
+    
+    char *result = duk_esp32_take_result(duk);
+    if (duk->out_dropped) {
+        snprintf(buf, sizeof(buf), "js: %lu bytes of output dropped\n", (unsigned long)duk->out_dropped);
+        console_print(buf);
+    }
+    if (duk->end != DUK_ESP32_END_OK) {
+        snprintf(buf, sizeof(buf), "js: %.200s\n", duk_esp32_get_error(duk));
+    } else {
+        snprintf(buf, sizeof(buf), "=> %.120s (%s %lu us, run %lu us)\n", result ? result : "undefined",
+                 duk->cache.last_cached ? "cached, load" : "compile",
+                 (unsigned long)(duk->cache.last_cached ? duk->cache.last_load_us : duk->cache.last_compile_us),
+                 (unsigned long)duk->cache.last_run_us);
+    }
+    free(result);
+    console_print(buf);
+    js_format_heap(duk, buf, sizeof(buf));
+    console_print(buf);
+    console_print("\n");
+    
+    lv_timer_delete(console_js_timer);
+    console_js_timer = NULL;
+    console_js_duk = NULL;
+    duk_esp32_cleanup(duk);
+}
+
+// Run or precompile scripts from storage through the Duktape bytecode cache
+static void console_cmd_js(const char *arg)
+{
+    char buf[256];
+    
+    if (!arg || strlen(arg) == 0) {
+        console_print("Usage: js <file.js>      - Run a script\n"
+                      "       js -c <file.js>   - Compile into the cache only\n"
+                      "       js clear          - Empty the bytecode cache\n"
+                      "       js stop           - Stop the running script\n");
+        return;
+    }
+    
+    if (strcmp(arg, "stop") == 0) {
+        if (console_js_duk) duk_esp32_stop(console_js_duk);
+        else console_print("js: no script running\n");
+        return;
+    }
+    if (console_js_duk) {
+        console_print("js: a script is still running (js stop)\n");
+        return;
+    }
+    
+    duk_esp32_t *duk = duk_esp32_init();
+    if (!duk) {
+        console_print("js: cannot create JS context\n");
+        return;
+    }
+    
+    char full_path[160];
+    if (strcmp(arg, "clear") == 0) {
+        duk_esp32_cache_clear(duk);
+        console_print("Bytecode cache cleared\n");
+    } else if (strncmp(arg, "-c ", 3) == 0) {
+        console_build_path(full_path, sizeof(full_path), arg + 3);
+        if (duk_esp32_precompile(duk, full_path) == 0) {
+            snprintf(buf, sizeof(buf), "%s: %s in %lu us\n", full_path,
+                     duk->cache.last_cached ? "already cached, loaded" : "compiled",
+                     (unsigned long)(duk->cache.last_cached ? duk->cache.last_load_us : duk->cache.last_compile_us));
+        } else {
+            snprintf(buf, sizeof(buf), "js: %.200s\n", duk_esp32_get_error(duk));
+        }
+        console_print(buf);
+    } else {
+        console_build_path(full_path, sizeof(full_path), arg);
+        if (duk_esp32_start_file(duk, full_path) == 0) {
+            console_js_duk = duk;
+            console_js_timer = lv_timer_create(console_js_poll_cb, 50, NULL);
+            return;
+        }
+        snprintf(buf, sizeof(buf), "js: %.200s\n", duk_esp32_get_error(duk));
+        console_print(buf);
+    }
+    duk_esp32_cleanup(duk);
+}
+
+// Rasterizer and script call cost of the JS IDE's gfx module
+static void console_cmd_gfxbench(void)
+{
+    char buf[128];
+    js_gfx_bench_result_t results[JS_GFX_BENCH_RESULTS];
+    
+    console_print("Measuring gfx primitives...\n");
+    int n = js_gfx_bench(results);
+    if (n < 0) {
+        console_print("gfxbench: out of memory\n");
+        return;
+    }
+    snprintf(buf, sizeof(buf), "%-22s %8s %10s\n", "primitive", "ns", "per frame");
+    console_print(buf);
+    for (int i = 0; i < n; i++) {
+        snprintf(buf, sizeof(buf), "%-22s %8lu %10lu\n", results[i].name,
+                 (unsigned long)results[i].ns, (unsigned long)results[i].per_frame);
+        console_print(buf);
+    }
+    console_print("(per frame: 60 Hz; a script pays the call plus the primitive)\n");
+}
+
+static void console_cmd_synbench(const char *arg)
+{
+    char buf[128];
+    js_syntax_bench_result_t results[JS_SYNTAX_BENCH_RESULTS];
+    
+    int lines = (arg && strlen(arg) > 0) ? atoi(arg) : 5000;
+    if (lines < 1 || lines > 100000) {
+        console_print("Usage: synbench [lines]  (1-100000, default 5000)\n");
+        return;
+    }
+    snprintf(buf, sizeof(buf), "Highlighting a %d-line script...\n", lines);
+    console_print(buf);
+    int n = js_syntax_bench((uint32_t)lines, results);
+    if (n < 0) {
+        console_print("synbench: out of memory\n");
+        return;
+    }
+    snprintf(buf, sizeof(buf), "%-22s %8s %8s\n", "edit", "us", "lines");
+    console_print(buf);
+    for (int i = 0; i < n; i++) {
+        snprintf(buf, sizeof(buf), "%-22s %8lu %8lu\n", results[i].name,
+                 (unsigned long)results[i].us, (unsigned long)results[i].lines);
+        console_print(buf);
+    }
+    console_print("(a frame is 16667 us; lines: lexed again)\n");
+}
+
+// Heap history, per-screen objects and apps that leave memory behind
+static void console_cmd_memdiag(const char *arg)
+{
+    if (arg && strcmp(arg, "save") == 0) {
+        mem_diag_save();
+        console_print("Memory report saved for recovery mode\n");
+        return;
+    }
+    bool last = arg && strcmp(arg, "last") == 0;
+    if (arg && strlen(arg) > 0 && !last) {
+        console_print("Usage: memdiag [save|last]\n");
+        return;
+    }
+    
+    const size_t buf_size = 4096;
+    mem_diag_snapshot_t *snap = (mem_diag_snapshot_t *)heap_caps_malloc(sizeof(*snap), MALLOC_CAP_SPIRAM);
+    char *buf = (char *)heap_caps_malloc(buf_size, MALLOC_CAP_SPIRAM);
+    if (!snap || !buf) {
+        console_print("memdiag: out of memory\n");
+    } else if (last && mem_diag_load_last(snap) != 0) {
+        console_print("No saved memory report\n");
+    } else {
+        if (!last) mem_diag_get(snap);
+        mem_diag_format(snap, buf, buf_size);
+        console_print(buf);
+        if (!last) {
+            mem_diag_format_screens(buf, buf_size);
+            console_print(buf);
+        }
+    }
+    heap_caps_free(snap);
+    heap_caps_free(buf);
+}
+
+// Load per core and the busiest tasks over the last sample period
+static void console_cmd_top(const char *arg)
+{
+    int limit = (arg && *arg) ? atoi(arg) : 10;
+    if (limit < 1 || limit > CPU_STATS_MAX_TASKS) {
+        console_print("Usage: top [n]  (1-48, default 10)\n");
+        return;
+    }
+    
+    cpu_stats_task_t *tasks = (cpu_stats_task_t *)heap_caps_malloc(CPU_STATS_MAX_TASKS * sizeof(*tasks), MALLOC_CAP_SPIRAM);
+    if (!tasks) {
+        console_print("top: out of memory\n");
+        return;
+    }
+    
+    char buf[128];
+    uint16_t cores[portNUM_PROCESSORS];
+    int core_count = cpu_stats_get_cores(cores, portNUM_PROCESSORS);
+    int pos = snprintf(buf, sizeof(buf), "CPU");
+    for (int c = 0; c < core_count; c++) {
+        pos += snprintf(buf + pos, sizeof(buf) - pos, "  core%d %3d.%d%%", c, cores[c] / 10, cores[c] % 10);
+    }
+    snprintf(buf + pos, sizeof(buf) - pos, "\n");
+    console_print(buf);
+    
+    cpu_stats_overhead_t overhead;
+    cpu_stats_get_overhead(&overhead);
+    snprintf(buf, sizeof(buf), "Sampler: every %lu ms, %lu us avg, %lu us max, %u.%02u%% of a core\n",
+             (unsigned long)overhead.period_ms, (unsigned long)overhead.avg_us,
+             (unsigned long)overhead.max_us, overhead.load_x100 / 100, overhead.load_x100 % 100);
+    console_print(buf);
+    if (overhead.stale) {
+        console_print("Last sample failed (out of memory), figures are older\n");
+    }
+    if (overhead.untracked) {
+        snprintf(buf, sizeof(buf), "%u more tasks not shown, only the busiest %d are\n",
+                 overhead.untracked, CPU_STATS_MAX_TASKS);
+        console_print(buf);
+    }
+    
+    console_print("PID  Name                 Core   CPU%  State    Stack\n");
+    console_print("---  -------------------  ----  -----  -------  -----\n");
+    int count = cpu_stats_get_tasks(tasks, limit);
+    for (int i = 0; i < count; i++) {
+        const char *state;
+        switch (tasks[i].state) {
+            case eRunning: state = "Running"; break;
+            case eReady: state = "Ready"; break;
+            case eBlocked: state = "Blocked"; break;
+            case eSuspended: state = "Suspend"; break;
+            case eDeleted: state = "Deleted"; break;
+            default: state = "Unknown"; break;
+        }
+        char core[4];
+        if (tasks[i].core < 0) snprintf(core, sizeof(core), "-");
+        else snprintf(core, sizeof(core), "%d", tasks[i].core);
+        snprintf(buf, sizeof(buf), "%3lu  %-19.19s  %4s  %3d.%d  %-7s  %5lu\n",
+                 (unsigned long)tasks[i].number, tasks[i].name, core,
+                 tasks[i].cpu_x10 / 10, tasks[i].cpu_x10 % 10, state,
+                 (unsigned long)tasks[i].stack_free);
+        console_print(buf);
+    }
+    if (count == 0) console_print("(no samples yet)\n");
+    heap_caps_free(tasks);
+}
+
+// Touch to display latency; "reset" starts a new measurement
+static void console_cmd_touchlat(const char *arg)
+{
+    if (arg && strcmp(arg, "reset") == 0) {
+        touch_latency_reset();
+        console_print("Touch latency statistics cleared\n");
+        return;
+    }
+    if (arg && strlen(arg) > 0) {
+        console_print("Usage: touchlat [reset]\n");
+        return;
+    }
+    
+    const size_t buf_size = 4096;
+    char *buf = (char *)heap_caps_malloc(buf_size, MALLOC_CAP_SPIRAM);
+    if (!buf) {
+        console_print("touchlat: out of memory\n");
+        return;
+    }
+    touch_latency_stats_t stats;
+    touch_latency_get(&stats);
+    touch_latency_format(&stats, buf, buf_size);
+    console_print(buf);
+    
+    // Bus traffic: with INT an idle screen does no reads at all
+    gt911_stats_t bus;
+    gt911_get_stats(&bus);
+    snprintf(buf, buf_size, "GT911 %s: %lu I2C reads, %lu INT edges, %lu coalesced, %lu deferred (bus held)\n",
+             bus.interrupt_mode ? "on INT" : "polled", (unsigned long)bus.reads,
+             (unsigned long)bus.interrupts, (unsigned long)bus.skipped, (unsigned long)bus.deferred);
+    console_print(buf);
+    if (stats.matched == 0) console_print("(Debug > Latency draws under the finger for clean numbers)\n");
+    heap_caps_free(buf);
+}
+
+// Queue files and folders as one compressed BLE session to the phone
+#define BTSEND_MAX_PATHS    8
+
+static void console_cmd_btsend(const char *arg)
+{
+    char buf[160];
+    
+    if (!arg || strlen(arg) == 0) {
+        console_print("Usage: btsend <file|folder> [...]\n"
+                      "       btsend stop\n"
+                      "  Sends everything to the connected phone in one session\n");
+        return;
+    }
+    
+    if (strcmp(arg, "stop") == 0) {
+        bt_cancel_transfer();
+        console_print("Bluetooth transfer cancelled\n");
+        return;
+    }
+    
+    if (!bt_is_connected()) {
+        console_print("btsend: no Bluetooth device connected\n");
+        return;
+    }
+    
+    static char paths[BTSEND_MAX_PATHS][160];
+    const char *list[BTSEND_MAX_PATHS];
+    int count = 0;
+    char args[256];
+    strncpy(args, arg, sizeof(args) - 1);
+    args[sizeof(args) - 1] = '\0';
+    
+    char *save = NULL;
+    for (char *tok = strtok_r(args, " ", &save); tok && count < BTSEND_MAX_PATHS; tok = strtok_r(NULL, " ", &save)) {
+        console_build_path(paths[count], sizeof(paths[count]), tok);
+        list[count] = paths[count];
+        count++;
+    }
+    
+    int ret = bt_send_files(list, count, NULL);
+    if (ret == 0) {
+        const bt_transfer_info_t *ti = bt_get_transfer_info();
+        snprintf(buf, sizeof(buf), "Sending %u files (%lu KB) via Bluetooth\n",
+                 ti->files_total, (unsigned long)(ti->file_size / 1024));
+    } else if (ret == -3) {
+        snprintf(buf, sizeof(buf), "btsend: a transfer is already running (btsend stop)\n");
+    } else if (ret == -4) {
+        snprintf(buf, sizeof(buf), "btsend: path not found, empty or too many files\n");
+    } else {
+        snprintf(buf, sizeof(buf), "btsend: failed (%d)\n", ret);
+    }
+    console_print(buf);
+}
+
+// ===== wget: stream HTTP bodies to files =====
+// Downloads run one after another on their own task. The body is gathered in
+// a large DMA-capable buffer so the card sees few big writes instead of one
+// small write per network chunk.
+#define WGET_MAX_FILES      8
+#define WGET_BUF_SIZE       (32 * 1024)
+#define WGET_PROGRESS_US    1000000
+#define WGET_URL_MAX        256     // Console and list file line length
+
+typedef struct {
+    char url[WGET_URL_MAX];
+    char path[128];
+} wget_file_t;
+
+typedef struct {
+    wget_file_t files[WGET_MAX_FILES];
+    int file_count;
+    bool resume;
+    // Current file
+    const wget_file_t *cur;
+    FILE *f;
+    uint8_t *buf;
+    size_t buf_len;
+    int64_t offset;             // Bytes already on disk before this request
+    int64_t expected;           // Final file size, -1 if unknown
+    uint64_t received;          // Body bytes of this request
+    int64_t start_us;
+    int64_t write_us;           // Time spent in fwrite
+    int64_t last_report_us;
+    bool complete;              // Resume found nothing left to fetch
+    bool write_error;
+} wget_job_t;
+
+static volatile bool wget_active = false;
+static volatile bool wget_stop = false;
+
+static uint32_t wget_kbps(uint64_t bytes, int64_t us)
+{
+    return us > 0 ? (uint32_t)(bytes * 1000000ULL / (uint64_t)us / 1024) : 0;
+}
+
+static void wget_flush(wget_job_t *job)
+{
+    if (job->buf_len == 0 || !job->f) return;
+    int64_t t0 = esp_timer_get_time();
+    if (fwrite(job->buf, 1, job->buf_len, job->f) != job->buf_len) {
+        job->write_error = true;
+    }
+    job->write_us += esp_timer_get_time() - t0;
+    job->buf_len = 0;
+}
+
+static int wget_on_headers(int status, int64_t content_length, void *user)
+{
+    wget_job_t *job = (wget_job_t *)user;
+    char buf[160];
+    const char *mode = "wb";
+    
+    if (status == 416 && job->offset > 0) {
+        // Range starts at the end of the file: it is already complete
+        job->complete = true;
+        return -1;
+    } else if (status == 206) {
+        mode = "ab";
+        snprintf(buf, sizeof(buf), "  Resuming at %lld KB\n", (long long)(job->offset / 1024));
+        console_print_async(buf);
+    } else if (status == 200) {
+        if (job->offset > 0) {
+            console_print_async("  Server ignored Range, starting over\n");
+            job->offset = 0;
+        }
+    } else {
+        snprintf(buf, sizeof(buf), "  HTTP %d\n", status);
+        console_print_async(buf);
+        return -1;
+    }
+    
+    job->expected = content_length >= 0 ? job->offset + content_length : -1;
+    job->f = fopen(job->cur->path, mode);
+    if (!job->f) {
+        snprintf(buf, sizeof(buf), "  Cannot write %s (errno %d)\n", job->cur->path, errno);
+        console_print_async(buf);
+        return -1;
+    }
+    // We do our own buffering; let fwrite go straight to the filesystem
+    setvbuf(job->f, NULL, _IONBF, 0);
+    return 0;
+}
+
+static int wget_on_body(const char *data, size_t len, void *user)
+{
+    wget_job_t *job = (wget_job_t *)user;
+    if (wget_stop || job->write_error) return -1;
+    
+    job->received += len;
+    while (len > 0) {
+        size_t n = WGET_BUF_SIZE - job->buf_len;
+        if (n > len) n = len;
+        memcpy(job->buf + job->buf_len, data, n);
+        job->buf_len += n;
+        data += n;
+        len -= n;
+        if (job->buf_len == WGET_BUF_SIZE) wget_flush(job);
+    }
+    
+    int64_t now = esp_timer_get_time();
+    if (now - job->last_report_us >= WGET_PROGRESS_US) {
+        job->last_report_us = now;
+        uint64_t have = job->offset + job->received;
+        char buf[128];
+        if (job->expected > 0) {
+            snprintf(buf, sizeof(buf), "  %llu / %llu KB (%d%%), %lu KB/s\n",
+                     (unsigned long long)(have / 1024), (unsigned long long)(job->expected / 1024),
+                     (int)(have * 100 / job->expected),
+                     (unsigned long)wget_kbps(job->received, now - job->start_us));
+        } else {
+            snprintf(buf, sizeof(buf), "  %llu KB, %lu KB/s\n", (unsigned long long)(have / 1024),
+                     (unsigned long)wget_kbps(job->received, now - job->start_us));
+        }
+        console_print_async(buf);
+    }
+    return 0;
+}
+
+static bool wget_fetch(wget_job_t *job, const wget_file_t *file, uint64_t *bytes)
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s\n  -> %s\n", file->url, file->path);
+    console_print_async(buf);
+    
+    job->cur = file;
+    job->f = NULL;
+    job->buf_len = 0;
+    job->offset = 0;
+    job->expected = -1;
+    job->received = 0;
+    job->write_us = 0;
+    job->complete = false;
+    job->write_error = false;
+    
+    struct stat st;
+    if (job->resume && stat(file->path, &st) == 0 && st.st_size > 0) {
+        job->offset = st.st_size;
+    }
+    
+    char range[40];
+    http_service_header_t header = { "Range", range };
+    snprintf(range, sizeof(range), "bytes=%lld-", (long long)job->offset);
+    
+    http_service_request_t req = {};
+    req.url = file->url;
+    req.headers = &header;
+    req.header_count = job->offset > 0 ? 1 : 0;
+    req.timeout_ms = 15000;
+    req.on_headers = wget_on_headers;
+    req.on_body = wget_on_body;
+    req.user = job;
+    
+    job->start_us = job->last_report_us = esp_timer_get_time();
+    http_service_result_t result = {};
+    esp_err_t err = http_service_perform(&req, &result);
+    
+    if (job->f) {
+        wget_flush(job);
+        if (fclose(job->f) != 0) job->write_error = true;
+        job->f = NULL;
+    }
+    *bytes = job->received;
+    
+    if (job->complete) {
+        snprintf(buf, sizeof(buf), "  Already complete (%lld KB)\n", (long long)(job->offset / 1024));
+        console_print_async(buf);
+        return true;
+    }
+    
+    bool ok = err == ESP_OK && !result.aborted && !job->write_error &&
+              (job->expected < 0 || (int64_t)(job->offset + job->received) == job->expected);
+    if (ok) {
+        snprintf(buf, sizeof(buf), "  Saved %llu KB in %lld ms, %lu KB/s (disk %lld ms%s)\n",
+                 (unsigned long long)((job->offset + job->received) / 1024),
+                 (long long)(result.elapsed_us / 1000),
+                 (unsigned long)wget_kbps(job->received, result.elapsed_us),
+                 (long long)(job->write_us / 1000), result.reused ? ", connection reused" : "");
+    } else if (wget_stop) {
+        snprintf(buf, sizeof(buf), "  Stopped after %llu KB (wget -c resumes)\n",
+                 (unsigned long long)((job->offset + job->received) / 1024));
+    } else if (job->write_error) {
+        snprintf(buf, sizeof(buf), "  Write failed (card full?)\n");
+    } else if (err != ESP_OK) {
+        snprintf(buf, sizeof(buf), "  Failed: %s\n", esp_err_to_name(err));
+    } else if (!result.aborted) {
+        snprintf(buf, sizeof(buf), "  Incomplete: %llu of %lld KB (wget -c resumes)\n",
+                 (unsigned long long)((job->offset + job->received) / 1024),
+                 (long long)(job->expected / 1024));
+    } else {
+        buf[0] = '\0';  // Reason already printed from the header callback
+    }
+    if (buf[0]) console_print_async(buf);
+    return ok;
+}
+
+static void wget_task(void *arg)
+{
+    wget_job_t *job = (wget_job_t *)arg;
+    
+    job->buf = (uint8_t *)heap_caps_malloc(WGET_BUF_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!job->buf) job->buf = (uint8_t *)heap_caps_malloc(WGET_BUF_SIZE, MALLOC_CAP_8BIT);
+    
+    int ok_count = 0;
+    uint64_t total = 0;
+    int64_t t0 = esp_timer_get_time();
+    if (job->buf) {
+        for (int i = 0; i < job->file_count && !wget_stop; i++) {
+            uint64_t bytes = 0;
+            if (wget_fetch(job, &job->files[i], &bytes)) ok_count++;
+            total += bytes;
+        }
+    } else {
+        console_print_async("wget: Out of memory\n");
+    }
+    
+    if (job->file_count > 1) {
+        int64_t us = esp_timer_get_time() - t0;
+        char buf[128];
+        snprintf(buf, sizeof(buf), "wget: %d/%d files, %llu KB in %lld ms, %lu KB/s\n",
+                 ok_count, job->file_count, (unsigned long long)(total / 1024),
+                 (long long)(us / 1000), (unsigned long)wget_kbps(total, us));
+        console_print_async(buf);
+    }
+    
+    heap_caps_free(job->buf);
+    free(job);
+    wget_active = false;
+    vTaskDelete(NULL);
+}
+
+// False if the URL does not fit; a cut-off URL would fetch the wrong thing
+static bool wget_add(wget_job_t *job, const char *url, const char *out_name)
+{
+    wget_file_t *file = &job->files[job->file_count];
+    size_t url_len = strlen(url);
+    if (url_len >= sizeof(file->url)) return false;
+    memcpy(file->url, url, url_len + 1);
+    
+    // Name: -O argument, else the last path segment of the URL
+    char name[64];
+    if (out_name) {
+        strncpy(name, out_name, sizeof(name) - 1);
+        name[sizeof(name) - 1] = '\0';
+    } else {
+        const char *path = strstr(url, "://");
+        path = path ? strchr(path + 3, '/') : NULL;
+        const char *base = path ? strrchr(path, '/') + 1 : "";
+        size_t n = strcspn(base, "?#");
+        if (n == 0) {
+            strcpy(name, "index.html");
+        } else {
+            if (n >= sizeof(name)) n = sizeof(name) - 1;
+            memcpy(name, base, n);
+            name[n] = '\0';
+        }
+    }
+    
+    if (name[0] == '/') {
+        strncpy(file->path, name, sizeof(file->path) - 1);
+        file->path[sizeof(file->path) - 1] = '\0';
+    } else {
+        size_t cwd_len = strlen(console_cwd);
+        bool slash = cwd_len > 0 && console_cwd[cwd_len - 1] == '/';
+        snprintf(file->path, sizeof(file->path), "%.63s%s%s", console_cwd, slash ? "" : "/", name);
+    }
+    job->file_count++;
+    return true;
+}
+
+static void console_cmd_wget(const char *arg)
+{
+    if (!arg || strlen(arg) == 0) {
+        console_print("Usage: wget [-c] [-O file] <url> [url ...]\n"
+                      "       wget [-c] -i <list file>\n"
+                      "       wget stop\n"
+                      "  -c  resume partial files with HTTP Range\n");
+        return;
+    }
+    
+    if (strcmp(arg, "stop") == 0) {
+        if (wget_active) {
+            wget_stop = true;
+            console_print("Stopping download...\n");
+        } else {
+            console_print("No download running\n");
+        }
+        return;
+    }
+    
+    if (wget_active) {
+        console_print("wget: a download is already running (wget stop)\n");
+        return;
+    }
+    
+    wget_job_t *job = (wget_job_t *)calloc(1, sizeof(wget_job_t));
+    if (!job) {
+        console_print("Error: Out of memory\n");
+        return;
+    }
+    
+    char args[256];
+    strncpy(args, arg, sizeof(args) - 1);
+    args[sizeof(args) - 1] = '\0';
+    
+    const char *out_name = NULL;
+    const char *list_name = NULL;
+    const char *urls[WGET_MAX_FILES];
+    int url_count = 0;
+    bool too_many = false;
+    char *save = NULL;
+    for (char *tok = strtok_r(args, " ", &save); tok; tok = strtok_r(NULL, " ", &save)) {
+        if (strcmp(tok, "-c") == 0) {
+            job->resume = true;
+        } else if (strcmp(tok, "-O") == 0) {
+            out_name = strtok_r(NULL, " ", &save);
+        } else if (strcmp(tok, "-i") == 0) {
+            list_name = strtok_r(NULL, " ", &save);
+        } else if (url_count < WGET_MAX_FILES) {
+            urls[url_count++] = tok;
+        } else {
+            too_many = true;
+        }
+    }
+    
+    if (out_name && url_count != 1) {
+        console_print("wget: -O needs exactly one URL\n");
+        free(job);
+        return;
+    }
+    
+    for (int i = 0; i < url_count; i++) {
+        if (!wget_add(job, urls[i], out_name)) {
+            char buf[64];
+            snprintf(buf, sizeof(buf), "wget: URL longer than %d characters\n", WGET_URL_MAX - 1);
+            console_print(buf);
+            free(job);
+            return;
+        }
+    }
+    
+    if (list_name) {
+        char list_path[256];
+        console_build_path(list_path, sizeof(list_path), list_name);
+        FILE *f = fopen(list_path, "r");
+        if (!f) {
+            console_print("wget: cannot open list file\n");
+            free(job);
+            return;
+        }
+        char line[WGET_URL_MAX + 2];    // Room to tell an over-long line apart
+        bool too_long = false;
+        while (fgets(line, sizeof(line), f)) {
+            size_t len = strcspn(line, "\r\n");
+            if (line[len] == '\0' && !feof(f)) {
+                too_long = true;
+                break;
+            }
+            line[len] = '\0';
+            char *url = line;
+            while (*url == ' ') url++;
+            if (*url == '\0' || *url == '#') continue;
+            if (job->file_count >= WGET_MAX_FILES) {
+                too_many = true;
+                break;
+            }
+            if (!wget_add(job, url, NULL)) {
+                too_long = true;
+                break;
+            }
+        }
+        fclose(f);
+        if (too_long) {
+            char buf[80];
+            snprintf(buf, sizeof(buf), "wget: list file has a URL longer than %d characters\n", WGET_URL_MAX - 1);
+            console_print(buf);
+            free(job);
+            return;
+        }
+    }
+    
+    if (job->file_count == 0) {
+        console_print("wget: no URL given\n");
+        free(job);
+        return;
+    }
+    if (too_many) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "wget: only the first %d URLs are fetched\n", WGET_MAX_FILES);
+        console_print(buf);
+    }
+    
+    wget_stop = false;
+    wget_active = true;
+    if (xTaskCreate(wget_task, "wget", 8192, job, 5, NULL) != pdPASS) {
+        console_print("Error: Failed to start download task\n");
+        wget_active = false;
+        free(job);
+    }
+}
+
+// ===== CONSOLE COMMANDS =====
+
+static void console_cmd_color(const char *arg)
+{
+    if (!arg || strlen(arg) == 0) {
+        console_print("Color schemes:\n");
+        console_print("  0: Black/Green (default)\n");
+        console_print("  1: Black/White\n");
+        console_print("  2: Navy/Yellow\n");
+        console_print("  3: Black/Cyan\n");
+        console_print("  4: Maroon/White\n");
+        console_print("  5: Green/White\n");
+        console_print("  6: Navy/White\n");
+        console_print("  7: Black/Red\n");
+        console_print("  8: Matrix (Dark Blue/Green)\n");
+        console_print("  9: Dracula\n");
+        console_print("Usage: color <0-9>\n");
+        return;
+    }
+    
+    int scheme = atoi(arg);
+    if (scheme >= 0 && scheme <= 9) {
+        console_bg_color = color_presets[scheme][0];
+        console_text_color = color_presets[scheme][1];
+        console_prompt_color = (scheme == 0) ? 0xFFFF00 : console_text_color;
+        
+        // Apply colors
+        if (console_output) {
+            lv_obj_set_style_bg_color(console_output, lv_color_hex(console_bg_color), 0);
+            lv_obj_set_style_text_color(console_output, lv_color_hex(console_text_color), 0);
+        }
+        if (console_input) {
+            lv_obj_set_style_text_color(console_input, lv_color_hex(console_prompt_color), 0);
+            lv_obj_set_style_border_color(console_input, lv_color_hex(console_text_color), 0);
+        }
+        if (console_window) {
+            lv_obj_set_style_bg_color(console_window, lv_color_hex(console_bg_color), 0);
+        }
+        
+        char buf[64];
+        snprintf(buf, sizeof(buf), "Color scheme %d applied.\n", scheme);
+        console_print(buf);
+    } else {
+        console_print("Invalid color scheme. Use 0-9.\n");
+    }
+}
+
+static void console_cmd_free(void)
+{
+    char buf[256];
+    
+    size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t total_heap = heap_caps_get_total_size(MALLOC_CAP_8BIT);
+    size_t free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    size_t total_psram = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
+    
+    console_print("Memory Info:\n");
+    snprintf(buf, sizeof(buf), "  Heap:  %8lu / %8lu bytes (%lu%% used)\n",
+             (unsigned long)(total_heap - free_heap),
+             (unsigned long)total_heap,
+             (unsigned long)((total_heap - free_heap) * 100 / total_heap));
+    console_print(buf);
+    
+    snprintf(buf, sizeof(buf), "  PSRAM: %8lu / %8lu bytes (%lu%% used)\n",
+             (unsigned long)(total_psram - free_psram),
+             (unsigned long)total_psram,
+             (unsigned long)((total_psram - free_psram) * 100 / total_psram));
+    console_print(buf);
+}
+
+static void console_cmd_uptime(void)
+{
+    uint32_t uptime_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    uint32_t uptime_sec = uptime_ms / 1000;
+    uint32_t days = uptime_sec / 86400;
+    uint32_t hours = (uptime_sec % 86400) / 3600;
+    uint32_t mins = (uptime_sec % 3600) / 60;
+    uint32_t secs = uptime_sec % 60;
+    
+    char buf[128];
+    snprintf(buf, sizeof(buf), "Uptime: %lud %02lu:%02lu:%02lu\n",
+             (unsigned long)days, (unsigned long)hours, 
+             (unsigned long)mins, (unsigned long)secs);
+    console_print(buf);
+}
+
+static void console_process_cmd(const char *cmd)
+{
+    if (!cmd) return;
+    
+    // Skip leading whitespace
+    while (*cmd == ' ') cmd++;
+    if (strlen(cmd) == 0) return;
+    
+    // Parse command and arguments
+    char cmd_buf[256];
     strncpy(cmd_buf, cmd, sizeof(cmd_buf) - 1);
     cmd_buf[sizeof(cmd_buf) - 1] = '\0';
     
@@ -6978,6 +8261,20 @@ static void console_process_cmd(const char *cmd)
         console_cmd_whoami();
     } else if (strcmp(cmd_buf, "hostname") == 0) {
         console_cmd_hostname();
+    } else if (strcmp(cmd_buf, "js") == 0) {
+        console_cmd_js(arg);
+    } else if (strcmp(cmd_buf, "gfxbench") == 0) {
+        console_cmd_gfxbench();
+    } else if (strcmp(cmd_buf, "synbench") == 0) {
+        console_cmd_synbench(arg);
+    } else if (strcmp(cmd_buf, "memdiag") == 0) {
+        console_cmd_memdiag(arg);
+    } else if (strcmp(cmd_buf, "top") == 0) {
+        console_cmd_top(arg);
+    } else if (strcmp(cmd_buf, "touchlat") == 0) {
+        console_cmd_touchlat(arg);
+    } else if (strcmp(cmd_buf, "trace") == 0) {
+        console_cmd_trace(arg);
     }
     // === Network ===
     else if (strcmp(cmd_buf, "ifconfig") == 0 || strcmp(cmd_buf, "ipconfig") == 0) {
@@ -6986,8 +8283,18 @@ static void console_process_cmd(const char *cmd)
         console_cmd_wifi();
     } else if (strcmp(cmd_buf, "ping") == 0) {
         console_cmd_ping(arg);
-    } else if (strcmp(cmd_buf, "curl") == 0 || strcmp(cmd_buf, "wget") == 0) {
+    } else if (strcmp(cmd_buf, "iperf") == 0) {
+        console_cmd_iperf(arg);
+    } else if (strcmp(cmd_buf, "curl") == 0) {
         console_cmd_curl(arg);
+    } else if (strcmp(cmd_buf, "wget") == 0) {
+        console_cmd_wget(arg);
+    } else if (strcmp(cmd_buf, "httpstat") == 0) {
+        console_cmd_httpstat();
+    } else if (strcmp(cmd_buf, "fileserver") == 0) {
+        console_cmd_fileserver(arg);
+    } else if (strcmp(cmd_buf, "btsend") == 0) {
+        console_cmd_btsend(arg);
     }
     // === Console ===
     else if (strcmp(cmd_buf, "color") == 0) {
@@ -7184,6 +8491,7 @@ void app_console_create(void)
     
     // Console output area (scrollable)
     console_output = lv_textarea_create(app_window);
+    console_async_start();
     lv_obj_set_size(console_output, SCREEN_WIDTH - 30, output_height);
     lv_obj_align(console_output, LV_ALIGN_TOP_LEFT, 10, 40);
     lv_obj_set_style_bg_color(console_output, lv_color_hex(console_bg_color), 0);
@@ -7247,6 +8555,7 @@ static void app_console_create_fullscreen(void)
     
     // Console output area (larger in fullscreen, scrollable)
     console_output = lv_textarea_create(console_window);
+    console_async_start();
     lv_obj_set_size(console_output, SCREEN_WIDTH - 20, output_height);
     lv_obj_align(console_output, LV_ALIGN_TOP_MID, 0, 5);
     lv_obj_set_style_bg_color(console_output, lv_color_hex(console_bg_color), 0);
@@ -7551,6 +8860,8 @@ static lv_obj_t *sysmon_wifi_label = NULL;
 static lv_obj_t *sysmon_uptime_label = NULL;
 static lv_obj_t *sysmon_tasks_label = NULL;
 static lv_obj_t *sysmon_task_list = NULL;
+static lv_obj_t *sysmon_core_chart[portNUM_PROCESSORS] = {};
+static lv_chart_series_t *sysmon_core_series[portNUM_PROCESSORS] = {};
 static int sysmon_view_mode = 0;  // 0=overview, 1=processes
 
 // Protected task names that cannot be killed
@@ -7602,15 +8913,11 @@ static void sysmon_update_task_list(void) {
     // Clear existing items
     lv_obj_clean(sysmon_task_list);
     
-    // Get task count
-    UBaseType_t task_count = uxTaskGetNumberOfTasks();
-    if (task_count > 30) task_count = 30;  // Limit
-    
-    TaskStatus_t *task_array = (TaskStatus_t*)malloc(task_count * sizeof(TaskStatus_t));
+    // Last sample of the CPU sampler, busiest first
+    cpu_stats_task_t *task_array = (cpu_stats_task_t*)malloc(CPU_STATS_MAX_TASKS * sizeof(cpu_stats_task_t));
     if (!task_array) return;
     
-    uint32_t total_runtime;
-    UBaseType_t actual_count = uxTaskGetSystemState(task_array, task_count, &total_runtime);
+    int actual_count = cpu_stats_get_tasks(task_array, CPU_STATS_MAX_TASKS);
     
     // Create header
     lv_obj_t *header = lv_obj_create(sysmon_task_list);
@@ -7626,27 +8933,33 @@ static void sysmon_update_task_list(void) {
     lv_obj_set_style_text_font(h1, UI_FONT, 0);
     lv_obj_align(h1, LV_ALIGN_LEFT_MID, 0, 0);
     
+    lv_obj_t *h_cpu = lv_label_create(header);
+    lv_label_set_text(h_cpu, "CPU");
+    lv_obj_set_style_text_color(h_cpu, lv_color_hex(0x00AAFF), 0);
+    lv_obj_set_style_text_font(h_cpu, UI_FONT, 0);
+    lv_obj_align(h_cpu, LV_ALIGN_LEFT_MID, 120, 0);
+    
     lv_obj_t *h2 = lv_label_create(header);
     lv_label_set_text(h2, "State");
     lv_obj_set_style_text_color(h2, lv_color_hex(0x00AAFF), 0);
     lv_obj_set_style_text_font(h2, UI_FONT, 0);
-    lv_obj_align(h2, LV_ALIGN_LEFT_MID, 140, 0);
+    lv_obj_align(h2, LV_ALIGN_LEFT_MID, 180, 0);
     
     lv_obj_t *h3 = lv_label_create(header);
     lv_label_set_text(h3, "Stack");
     lv_obj_set_style_text_color(h3, lv_color_hex(0x00AAFF), 0);
     lv_obj_set_style_text_font(h3, UI_FONT, 0);
-    lv_obj_align(h3, LV_ALIGN_LEFT_MID, 210, 0);
+    lv_obj_align(h3, LV_ALIGN_LEFT_MID, 235, 0);
     
     lv_obj_t *h4 = lv_label_create(header);
     lv_label_set_text(h4, "Pri");
     lv_obj_set_style_text_color(h4, lv_color_hex(0x00AAFF), 0);
     lv_obj_set_style_text_font(h4, UI_FONT, 0);
-    lv_obj_align(h4, LV_ALIGN_LEFT_MID, 280, 0);
+    lv_obj_align(h4, LV_ALIGN_LEFT_MID, 295, 0);
     
     // Create task rows
     for (int i = 0; i < actual_count; i++) {
-        bool is_protected = is_protected_task(task_array[i].pcTaskName);
+        bool is_protected = is_protected_task(task_array[i].name);
         
         lv_obj_t *row = lv_obj_create(sysmon_task_list);
         lv_obj_set_size(row, lv_pct(100), 35);
@@ -7660,39 +8973,50 @@ static void sysmon_update_task_list(void) {
         
         // Task name
         lv_obj_t *name_lbl = lv_label_create(row);
-        lv_label_set_text(name_lbl, task_array[i].pcTaskName);
+        lv_label_set_text(name_lbl, task_array[i].name);
+        lv_label_set_long_mode(name_lbl, LV_LABEL_LONG_CLIP);
+        lv_obj_set_width(name_lbl, 115);
         lv_obj_set_style_text_color(name_lbl, is_protected ? lv_color_hex(0x888888) : lv_color_white(), 0);
         lv_obj_set_style_text_font(name_lbl, UI_FONT, 0);
         lv_obj_align(name_lbl, LV_ALIGN_LEFT_MID, 0, 0);
         
+        // CPU over the last second, share of one core
+        char cpu_buf[12];
+        snprintf(cpu_buf, sizeof(cpu_buf), "%d.%d", task_array[i].cpu_x10 / 10, task_array[i].cpu_x10 % 10);
+        lv_obj_t *cpu_lbl = lv_label_create(row);
+        lv_label_set_text(cpu_lbl, cpu_buf);
+        lv_obj_set_style_text_color(cpu_lbl, lv_color_hex(task_array[i].cpu_x10 >= 200 ? 0xFFAA00 : 0xAAAAAA), 0);
+        lv_obj_set_style_text_font(cpu_lbl, UI_FONT, 0);
+        lv_obj_align(cpu_lbl, LV_ALIGN_LEFT_MID, 120, 0);
+        
         // State
         lv_obj_t *state_lbl = lv_label_create(row);
-        lv_label_set_text(state_lbl, task_state_str(task_array[i].eCurrentState));
+        lv_label_set_text(state_lbl, task_state_str(task_array[i].state));
         uint32_t state_color = 0xFFFFFF;
-        if (task_array[i].eCurrentState == eRunning) state_color = 0x00FF00;
-        else if (task_array[i].eCurrentState == eBlocked) state_color = 0xFFAA00;
-        else if (task_array[i].eCurrentState == eSuspended) state_color = 0xFF4444;
+        if (task_array[i].state == eRunning) state_color = 0x00FF00;
+        else if (task_array[i].state == eBlocked) state_color = 0xFFAA00;
+        else if (task_array[i].state == eSuspended) state_color = 0xFF4444;
         lv_obj_set_style_text_color(state_lbl, lv_color_hex(state_color), 0);
         lv_obj_set_style_text_font(state_lbl, UI_FONT, 0);
-        lv_obj_align(state_lbl, LV_ALIGN_LEFT_MID, 140, 0);
+        lv_obj_align(state_lbl, LV_ALIGN_LEFT_MID, 180, 0);
         
         // Stack high water mark
         char stack_buf[16];
-        snprintf(stack_buf, sizeof(stack_buf), "%d", (int)task_array[i].usStackHighWaterMark);
+        snprintf(stack_buf, sizeof(stack_buf), "%d", (int)task_array[i].stack_free);
         lv_obj_t *stack_lbl = lv_label_create(row);
         lv_label_set_text(stack_lbl, stack_buf);
         lv_obj_set_style_text_color(stack_lbl, lv_color_hex(0xAAAAAA), 0);
         lv_obj_set_style_text_font(stack_lbl, UI_FONT, 0);
-        lv_obj_align(stack_lbl, LV_ALIGN_LEFT_MID, 210, 0);
+        lv_obj_align(stack_lbl, LV_ALIGN_LEFT_MID, 235, 0);
         
         // Priority
         char pri_buf[8];
-        snprintf(pri_buf, sizeof(pri_buf), "%d", (int)task_array[i].uxCurrentPriority);
+        snprintf(pri_buf, sizeof(pri_buf), "%d", (int)task_array[i].priority);
         lv_obj_t *pri_lbl = lv_label_create(row);
         lv_label_set_text(pri_lbl, pri_buf);
         lv_obj_set_style_text_color(pri_lbl, lv_color_hex(0xAAAAAA), 0);
         lv_obj_set_style_text_font(pri_lbl, UI_FONT, 0);
-        lv_obj_align(pri_lbl, LV_ALIGN_LEFT_MID, 280, 0);
+        lv_obj_align(pri_lbl, LV_ALIGN_LEFT_MID, 295, 0);
         
         // Kill button (only for non-protected tasks)
         if (!is_protected) {
@@ -7701,7 +9025,7 @@ static void sysmon_update_task_list(void) {
             lv_obj_align(kill_btn, LV_ALIGN_RIGHT_MID, -5, 0);
             lv_obj_set_style_bg_color(kill_btn, lv_color_hex(0xCC3333), 0);
             lv_obj_set_style_radius(kill_btn, 4, 0);
-            lv_obj_add_event_cb(kill_btn, sysmon_kill_task_cb, LV_EVENT_CLICKED, (void*)task_array[i].xHandle);
+            lv_obj_add_event_cb(kill_btn, sysmon_kill_task_cb, LV_EVENT_CLICKED, (void*)task_array[i].handle);
             
             lv_obj_t *kill_lbl = lv_label_create(kill_btn);
             lv_label_set_text(kill_lbl, "End");
@@ -7725,9 +9049,26 @@ static void sysmon_timer_cb(lv_timer_t *timer) {
     // Calculate RAM usage percentage
     int ram_percent = 100 - (free_heap * 100 / total_heap);
     
-    // Simulated CPU usage (based on LVGL task time)
-    static int cpu_percent = 0;
-    cpu_percent = 10 + (rand() % 30);  // Simulated 10-40%
+    // CPU usage from the run time stats sampler, average over the cores
+    uint16_t core_load[portNUM_PROCESSORS];
+    int core_count = cpu_stats_get_cores(core_load, portNUM_PROCESSORS);
+    int cpu_percent = 0;
+    for (int c = 0; c < core_count; c++) cpu_percent += core_load[c];
+    cpu_percent = core_count ? cpu_percent / core_count / 10 : 0;
+    
+    // Per-core history graphs
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        if (!sysmon_core_chart[c]) continue;
+        uint8_t history[CPU_STATS_HISTORY];
+        int n = cpu_stats_core_history(c, history, CPU_STATS_HISTORY);
+        int32_t *points = lv_chart_get_y_array(sysmon_core_chart[c], sysmon_core_series[c]);
+        // Newest sample on the right, no line before the first one
+        for (int i = 0; i < CPU_STATS_HISTORY; i++) {
+            int idx = i - (CPU_STATS_HISTORY - n);
+            points[i] = idx >= 0 ? history[idx] : LV_CHART_POINT_NONE;
+        }
+        lv_chart_refresh(sysmon_core_chart[c]);
+    }
     
     // Update bars
     if (sysmon_cpu_bar) {
@@ -7800,6 +9141,10 @@ static void sysmon_cleanup(void) {
     sysmon_uptime_label = NULL;
     sysmon_tasks_label = NULL;
     sysmon_task_list = NULL;
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        sysmon_core_chart[c] = NULL;
+        sysmon_core_series[c] = NULL;
+    }
     sysmon_view_mode = 0;
 }
 
@@ -8122,6 +9467,44 @@ void app_system_monitor_create(void) {
         lv_obj_set_style_text_color(sysmon_wifi_label, lv_color_hex(0x000000), 0);
         lv_obj_set_style_text_font(sysmon_wifi_label, UI_FONT, 0);
         lv_obj_align(sysmon_wifi_label, LV_ALIGN_TOP_LEFT, 5, y_pos);
+        
+        y_pos += 35;
+        
+        // CPU history per core, Win7 style green on black
+        lv_obj_t *hist_title = lv_label_create(content_area);
+        lv_label_set_text(hist_title, "CPU Usage History");
+        lv_obj_set_style_text_color(hist_title, lv_color_hex(0x000000), 0);
+        lv_obj_set_style_text_font(hist_title, UI_FONT, 0);
+        lv_obj_align(hist_title, LV_ALIGN_TOP_LEFT, 5, y_pos);
+        
+        y_pos += 25;
+        
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            lv_obj_t *chart = lv_chart_create(content_area);
+            lv_obj_set_size(chart, lv_pct(100 / portNUM_PROCESSORS - 3), 140);
+            lv_obj_align(chart, LV_ALIGN_TOP_LEFT, 5 + c * (SCREEN_WIDTH - 30) / portNUM_PROCESSORS, y_pos);
+            lv_chart_set_type(chart, LV_CHART_TYPE_LINE);
+            lv_chart_set_point_count(chart, CPU_STATS_HISTORY);
+            lv_chart_set_range(chart, LV_CHART_AXIS_PRIMARY_Y, 0, 100);
+            lv_chart_set_div_line_count(chart, 5, 6);
+            lv_obj_set_style_bg_color(chart, lv_color_black(), 0);
+            lv_obj_set_style_border_color(chart, lv_color_hex(0xAAAAAA), 0);
+            lv_obj_set_style_border_width(chart, 1, 0);
+            lv_obj_set_style_radius(chart, 0, 0);
+            lv_obj_set_style_pad_all(chart, 0, 0);
+            lv_obj_set_style_line_color(chart, lv_color_hex(0x006400), LV_PART_MAIN);
+            lv_obj_set_style_line_width(chart, 2, LV_PART_ITEMS);
+            // No point markers, only the line
+            lv_obj_set_style_size(chart, 0, 0, LV_PART_INDICATOR);
+            sysmon_core_series[c] = lv_chart_add_series(chart, lv_color_hex(0x00FF00), LV_CHART_AXIS_PRIMARY_Y);
+            sysmon_core_chart[c] = chart;
+            
+            lv_obj_t *core_lbl = lv_label_create(chart);
+            lv_label_set_text_fmt(core_lbl, "CPU %d", c);
+            lv_obj_set_style_text_color(core_lbl, lv_color_hex(0x00FF00), 0);
+            lv_obj_set_style_text_font(core_lbl, UI_FONT, 0);
+            lv_obj_align(core_lbl, LV_ALIGN_TOP_LEFT, 4, 2);
+        }
     }
     
     // Start update timer
@@ -8523,6 +9906,14 @@ static lv_obj_t *js_console_panel = NULL;
 static lv_obj_t *js_content = NULL;
 static lv_obj_t *js_sidebar = NULL;
 static lv_obj_t *js_statusbar = NULL;
+static lv_obj_t *js_run_btn = NULL;
+static lv_obj_t *js_stop_btn = NULL;
+static lv_timer_t *js_poll_timer = NULL;
+static js_gfx_t *js_gfx = NULL;
+static lv_obj_t *js_gfx_canvas = NULL;
+static uint16_t *js_gfx_buf = NULL;
+static lv_timer_t *js_gfx_timer = NULL;
+static js_syntax_t *js_syntax = NULL;
 static bool js_console_expanded = true;
 static char js_console_buffer[4096] = {0};
 static int js_console_len = 0;
@@ -8546,6 +9937,11 @@ static int js_console_len = 0;
 #define VSCODE_BORDER       0x3C3C3C
 #define VSCODE_STATUSBAR    0x007ACC
 
+// Editor colors by js_syntax_class_t
+static const uint32_t js_syntax_colors[JS_SYNTAX_CLASSES] = {
+    VSCODE_TEXT, VSCODE_KEYWORD, VSCODE_STRING, VSCODE_COMMENT, VSCODE_NUMBER,
+};
+
 static void js_console_print(const char *msg) {
     if (!msg) return;
     int len = strlen(msg);
@@ -8571,8 +9967,102 @@ static void js_console_print(const char *msg) {
     }
 }
 
+// Run and Stop follow the worker's state
+static void js_set_running(bool running) {
+    if (js_run_btn) {
+        if (running) lv_obj_add_state(js_run_btn, LV_STATE_DISABLED);
+        else lv_obj_remove_state(js_run_btn, LV_STATE_DISABLED);
+    }
+    if (js_stop_btn) {
+        if (running) lv_obj_remove_state(js_stop_btn, LV_STATE_DISABLED);
+        else lv_obj_add_state(js_stop_btn, LV_STATE_DISABLED);
+    }
+}
+
+static void js_report_result(void) {
+    char *result = duk_esp32_take_result(js_duk);
+    const duk_esp32_cache_stats_t *cs = &js_duk->cache;
+    char timing[128];
+    if (cs->last_cached) {
+        snprintf(timing, sizeof(timing), "[cached] load %lu us, run %lu us",
+                 (unsigned long)cs->last_load_us, (unsigned long)cs->last_run_us);
+    } else {
+        snprintf(timing, sizeof(timing), "[compiled] %lu us, run %lu us",
+                 (unsigned long)cs->last_compile_us, (unsigned long)cs->last_run_us);
+    }
+    js_console_print(timing);
+    js_format_heap(js_duk, timing, sizeof(timing));
+    js_console_print(timing);
+    if (js_duk->out_dropped) {
+        snprintf(timing, sizeof(timing), "[!] %lu bytes of output dropped", (unsigned long)js_duk->out_dropped);
+        js_console_print(timing);
+        js_duk->out_dropped = 0;
+    }
+    // A run stopped while waiting on timers still has the script's result
+    if (js_duk->end == DUK_ESP32_END_STOPPED) {
+        js_console_print("[!] Stopped");
+    } else if (js_duk->end != DUK_ESP32_END_OK) {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "[ERROR] %s", duk_esp32_get_error(js_duk));
+        js_console_print(buf);
+    } else if (result) {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "=> %s", result);
+        js_console_print(buf);
+    } else {
+        js_console_print("=> undefined");
+    }
+    free(result);
+}
+
+// gfx.text(): drawn by LVGL into the canvas between the raw primitives
+static void js_gfx_text_cb(void *user, uint16_t *pixels, int x, int y, const char *text, uint16_t color) {
+    lv_layer_t layer;
+    lv_canvas_init_layer(js_gfx_canvas, &layer);
+    
+    lv_draw_label_dsc_t dsc;
+    lv_draw_label_dsc_init(&dsc);
+    dsc.color = lv_color_make((color >> 8) & 0xF8, (color >> 3) & 0xFC, (color << 3) & 0xF8);
+    dsc.font = UI_FONT;
+    dsc.text = text;
+    lv_area_t area = { x, y, js_gfx->width - 1, y + lv_font_get_line_height(UI_FONT) - 1 };
+    lv_draw_label(&layer, &dsc, &area);
+    
+    lv_canvas_finish_layer(js_gfx_canvas, &layer);
+}
+
+// Once per display refresh: draw the frame the script submitted, if any.
+// The canvas covers the editor from the first frame until it is tapped.
+static void js_gfx_timer_cb(lv_timer_t *t) {
+    if (!js_gfx || !js_gfx_canvas) return;
+    if (js_gfx_render(js_gfx, js_gfx_buf, js_gfx_text_cb, NULL)) {
+        lv_obj_remove_flag(js_gfx_canvas, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_invalidate(js_gfx_canvas);
+    }
+}
+
+// Moves the script's queued output into the console and picks up the
+// result once the worker is done
+static void js_poll_cb(lv_timer_t *t) {
+    if (!js_duk) return;
+    
+    char buf[512];
+    while (duk_esp32_read_output(js_duk, buf, sizeof(buf)) > 0) {
+        size_t len = strlen(buf);
+        if (len > 0 && buf[len - 1] == '\n') buf[len - 1] = '\0';
+        js_console_print(buf);
+    }
+    if (duk_esp32_poll(js_duk) == DUK_ESP32_DONE) {
+        // Drawing left without a final gfx.frame() is still shown
+        js_gfx_submit(js_gfx);
+        js_report_result();
+        js_set_running(false);
+    }
+}
+
 static void js_run_code(void) {
     if (!js_editor || !js_duk) return;
+    if (duk_esp32_poll(js_duk) == DUK_ESP32_RUNNING) return;
     
     const char *code = lv_textarea_get_text(js_editor);
     if (!code || strlen(code) == 0) {
@@ -8580,24 +10070,26 @@ static void js_run_code(void) {
         return;
     }
     
-    js_console_print(">>> Running...");
+    if (js_gfx) {
+        js_gfx_reset(js_gfx);
+        lv_obj_add_flag(js_gfx_canvas, LV_OBJ_FLAG_HIDDEN);
+    }
     
-    // Use duk_esp32_eval API
-    char *result = duk_esp32_eval(js_duk, code);
-    if (result) {
+    // The script runs on the JS worker task; unchanged code is loaded as
+    // bytecode instead of being compiled again
+    if (duk_esp32_start(js_duk, code, "main.js") != 0) {
         char buf[256];
-        snprintf(buf, sizeof(buf), "=> %s", result);
+        snprintf(buf, sizeof(buf), "[ERROR] %s", duk_esp32_get_error(js_duk) ? duk_esp32_get_error(js_duk) : "busy");
         js_console_print(buf);
-        free(result);
-    } else {
-        const char *err = duk_esp32_get_error(js_duk);
-        if (err) {
-            char buf[256];
-            snprintf(buf, sizeof(buf), "[ERROR] %s", err);
-            js_console_print(buf);
-        } else {
-            js_console_print("=> undefined");
-        }
+        return;
+    }
+    js_console_print(">>> Running...");
+    js_set_running(true);
+}
+
+static void js_stop_code(void) {
+    if (js_duk && duk_esp32_poll(js_duk) == DUK_ESP32_RUNNING) {
+        duk_esp32_stop(js_duk);
     }
 }
 
@@ -8629,6 +10121,65 @@ static void js_keyboard_event_cb(lv_event_t *e) {
     }
 }
 
+// Every edit: only the lines between the first and last change are lexed again
+static void js_editor_changed_cb(lv_event_t *e) {
+    if (js_syntax && js_editor) {
+        js_syntax_update(js_syntax, lv_textarea_get_text(js_editor));
+    }
+}
+
+// The editor label draws nothing itself (transparent text); the lines in
+// the area being redrawn are drawn here, one lv_draw_label per token
+static void js_editor_draw_cb(lv_event_t *e) {
+    if (!js_syntax) return;
+    lv_obj_t *label = (lv_obj_t*)lv_event_get_target(e);
+    lv_layer_t *layer = lv_event_get_layer(e);
+    
+    lv_area_t coords;
+    lv_obj_get_content_coords(label, &coords);
+    const lv_area_t *clip = &layer->_clip_area;
+    if (clip->y2 < coords.y1) return;
+    const lv_font_t *font = lv_obj_get_style_text_font(label, LV_PART_MAIN);
+    int32_t letter_space = lv_obj_get_style_text_letter_space(label, LV_PART_MAIN);
+    int32_t line_h = lv_font_get_line_height(font) + lv_obj_get_style_text_line_space(label, LV_PART_MAIN);
+    uint32_t first = clip->y1 > coords.y1 ? (uint32_t)((clip->y1 - coords.y1) / line_h) : 0;
+    uint32_t last = (uint32_t)((clip->y2 - coords.y1) / line_h);
+    
+    lv_draw_label_dsc_t dsc;
+    lv_draw_label_dsc_init(&dsc);
+    dsc.font = font;
+    dsc.letter_space = letter_space;
+    dsc.flag = LV_TEXT_FLAG_EXPAND;
+    dsc.text_local = 1;
+    
+    js_syntax_token_t tokens[JS_SYNTAX_MAX_TOKENS];
+    char piece[128];
+    for (uint32_t line = first; line <= last && line < js_syntax->lines; line++) {
+        uint32_t len;
+        const char *text = js_syntax_line(js_syntax, line, &len);
+        int count = js_syntax_tokens(js_syntax, line, tokens, JS_SYNTAX_MAX_TOKENS);
+        int32_t y = coords.y1 + (int32_t)line * line_h;
+        int32_t x = coords.x1;
+        for (int i = 0; i < count && x <= clip->x2; i++) {
+            // Measured from the line start, so kerning matches the label's
+            uint32_t end = tokens[i].start + tokens[i].len;
+            int32_t x_end = coords.x1 + lv_text_get_width(text, end, font, letter_space) + letter_space;
+            int32_t x_start = x;
+            x = x_end;
+            if (x_end < clip->x1) continue;
+            
+            uint32_t n = tokens[i].len < sizeof(piece) - 1 ? tokens[i].len : sizeof(piece) - 1;
+            while (n > 0 && n < tokens[i].len && ((uint8_t)text[tokens[i].start + n] & 0xC0) == 0x80) n--;
+            memcpy(piece, text + tokens[i].start, n);
+            piece[n] = '\0';
+            dsc.text = piece;
+            dsc.color = lv_color_hex(js_syntax_colors[tokens[i].cls]);
+            lv_area_t area = { x_start, y, x_end, y + line_h - 1 };
+            lv_draw_label(layer, &dsc, &area);
+        }
+    }
+}
+
 static void js_editor_focus_cb(lv_event_t *e) {
     if (js_keyboard) {
         lv_obj_remove_flag(js_keyboard, LV_OBJ_FLAG_HIDDEN);
@@ -8637,10 +10188,29 @@ static void js_editor_focus_cb(lv_event_t *e) {
 }
 
 static void js_cleanup(void) {
+    if (js_poll_timer) {
+        lv_timer_delete(js_poll_timer);
+        js_poll_timer = NULL;
+    }
+    if (js_gfx_timer) {
+        lv_timer_delete(js_gfx_timer);
+        js_gfx_timer = NULL;
+    }
     if (js_duk) {
         duk_esp32_cleanup(js_duk);
         js_duk = NULL;
     }
+    
+    // The worker is gone, nothing records into the batches any more
+    js_gfx_destroy(js_gfx);
+    js_gfx = NULL;
+    if (js_gfx_buf) {
+        heap_caps_free(js_gfx_buf);
+        js_gfx_buf = NULL;
+    }
+    js_gfx_canvas = NULL;
+    js_syntax_destroy(js_syntax);
+    js_syntax = NULL;
     js_editor = NULL;
     js_console = NULL;
     js_keyboard = NULL;
@@ -8648,6 +10218,8 @@ static void js_cleanup(void) {
     js_content = NULL;
     js_sidebar = NULL;
     js_statusbar = NULL;
+    js_run_btn = NULL;
+    js_stop_btn = NULL;
 }
 
 void app_js_ide_create(void) {
@@ -8665,8 +10237,8 @@ void app_js_ide_create(void) {
         return;
     }
     
-    // Set console callback
-    duk_esp32_set_console_callback(js_duk, js_console_print);
+    // Script output arrives through duk_esp32_read_output(), polled here
+    js_poll_timer = lv_timer_create(js_poll_cb, 50, NULL);
     
     // Clear console buffer
     js_console_buffer[0] = '\0';
@@ -8802,19 +10374,34 @@ void app_js_ide_create(void) {
     lv_obj_align(tab_label, LV_ALIGN_LEFT_MID, 18, 0);
     
     // Run button in tabs bar (right side)
-    lv_obj_t *run_btn = lv_btn_create(tabs_bar);
-    lv_obj_set_size(run_btn, 70, 28);
-    lv_obj_set_style_bg_color(run_btn, lv_color_hex(0x388E3C), 0);
-    lv_obj_set_style_bg_color(run_btn, lv_color_hex(0x2E7D32), LV_STATE_PRESSED);
-    lv_obj_set_style_radius(run_btn, 4, 0);
-    lv_obj_add_event_cb(run_btn, [](lv_event_t *e) { js_run_code(); }, LV_EVENT_CLICKED, NULL);
-    
-    lv_obj_t *run_lbl = lv_label_create(run_btn);
+    js_run_btn = lv_btn_create(tabs_bar);
+    lv_obj_set_size(js_run_btn, 70, 28);
+    lv_obj_set_style_bg_color(js_run_btn, lv_color_hex(0x388E3C), 0);
+    lv_obj_set_style_bg_color(js_run_btn, lv_color_hex(0x2E7D32), LV_STATE_PRESSED);
+    lv_obj_set_style_radius(js_run_btn, 4, 0);
+    lv_obj_add_event_cb(js_run_btn, [](lv_event_t *e) { js_run_code(); }, LV_EVENT_CLICKED, NULL);
+    
+    lv_obj_t *run_lbl = lv_label_create(js_run_btn);
     lv_label_set_text(run_lbl, LV_SYMBOL_PLAY " Run");
     lv_obj_set_style_text_color(run_lbl, lv_color_white(), 0);
     lv_obj_set_style_text_font(run_lbl, &lv_font_montserrat_14, 0);
     lv_obj_center(run_lbl);
     
+    // Stop button: interrupts the script on the worker task
+    js_stop_btn = lv_btn_create(tabs_bar);
+    lv_obj_set_size(js_stop_btn, 70, 28);
+    lv_obj_set_style_bg_color(js_stop_btn, lv_color_hex(0xC62828), 0);
+    lv_obj_set_style_bg_color(js_stop_btn, lv_color_hex(0xB71C1C), LV_STATE_PRESSED);
+    lv_obj_set_style_radius(js_stop_btn, 4, 0);
+    lv_obj_add_event_cb(js_stop_btn, [](lv_event_t *e) { js_stop_code(); }, LV_EVENT_CLICKED, NULL);
+    lv_obj_add_state(js_stop_btn, LV_STATE_DISABLED);
+    
+    lv_obj_t *stop_lbl = lv_label_create(js_stop_btn);
+    lv_label_set_text(stop_lbl, LV_SYMBOL_STOP " Stop");
+    lv_obj_set_style_text_color(stop_lbl, lv_color_white(), 0);
+    lv_obj_set_style_text_font(stop_lbl, &lv_font_montserrat_14, 0);
+    lv_obj_center(stop_lbl);
+    
     // Editor textarea
     js_editor = lv_textarea_create(js_content);
     lv_obj_set_size(js_editor, editor_w, editor_h);
@@ -8825,9 +10412,48 @@ void app_js_ide_create(void) {
     lv_obj_set_style_border_width(js_editor, 0, 0);
     lv_obj_set_style_radius(js_editor, 0, 0);
     lv_textarea_set_placeholder_text(js_editor, "// Enter JavaScript code here...");
-    lv_textarea_set_text(js_editor, "// Hello World\nprint('Hello from ESP32!');\n");
     lv_obj_add_event_cb(js_editor, js_editor_focus_cb, LV_EVENT_FOCUSED, NULL);
     
+    // Syntax highlighting: lines do not wrap (the editor scrolls sideways)
+    // so line n is at n line heights, and the label's text is drawn by
+    // js_editor_draw_cb instead
+    js_syntax = js_syntax_create();
+    if (js_syntax) {
+        lv_obj_t *label = lv_textarea_get_label(js_editor);
+        lv_obj_set_width(label, LV_SIZE_CONTENT);
+        lv_obj_set_style_min_width(label, lv_pct(100), 0);
+        lv_obj_set_style_text_opa(label, LV_OPA_TRANSP, 0);
+        lv_obj_add_event_cb(label, js_editor_draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+        lv_obj_add_event_cb(js_editor, js_editor_changed_cb, LV_EVENT_VALUE_CHANGED, NULL);
+    } else {
+        ESP_LOGW(TAG, "No memory for syntax highlighting");
+    }
+    lv_textarea_set_text(js_editor, "// Hello World\nprint('Hello from ESP32!');\n");
+    
+    // gfx surface over the editor, RGB565 in PSRAM; frames are drawn
+    // into it by js_gfx_timer_cb at the display refresh rate
+    js_gfx_buf = (uint16_t*)heap_caps_malloc(editor_w * editor_h * 2, MALLOC_CAP_SPIRAM);
+    js_gfx = js_gfx_buf ? js_gfx_create(editor_w, editor_h) : NULL;
+    if (js_gfx) {
+        memset(js_gfx_buf, 0, editor_w * editor_h * 2);
+        js_gfx_canvas = lv_canvas_create(js_content);
+        lv_canvas_set_buffer(js_gfx_canvas, js_gfx_buf, editor_w, editor_h, LV_COLOR_FORMAT_RGB565);
+        lv_obj_set_pos(js_gfx_canvas, editor_x, tabs_h);
+        lv_obj_add_flag(js_gfx_canvas, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_add_flag(js_gfx_canvas, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_add_event_cb(js_gfx_canvas, [](lv_event_t *e) {
+            lv_obj_add_flag(js_gfx_canvas, LV_OBJ_FLAG_HIDDEN);
+        }, LV_EVENT_CLICKED, NULL);
+        js_gfx_bind(js_gfx, js_duk->ctx);
+        js_gfx_timer = lv_timer_create(js_gfx_timer_cb, LV_DEF_REFR_PERIOD, NULL);
+    } else {
+        ESP_LOGW(TAG, "No memory for the gfx surface");
+        if (js_gfx_buf) {
+            heap_caps_free(js_gfx_buf);
+            js_gfx_buf = NULL;
+        }
+    }
+    
     // Terminal panel
     js_console_panel = lv_obj_create(js_content);
     lv_obj_set_size(js_console_panel, editor_w, terminal_h);
@@ -8911,6 +10537,9 @@ void app_js_ide_create(void) {
     
     js_console_print("JavaScript IDE Ready.");
     js_console_print("Use print() or console.log() for output.");
+    if (js_gfx) {
+        js_console_print("Draw with gfx.fillRect/line/circle/blit/text, show with gfx.frame().");
+    }
 }
 
 // ============ TETRIS GAME ============
@@ -0,0 +1,152 @@
+/**
+ * Win32 OS - Touch Latency Calibration Screen
+ * Full screen drawing surface from the Debug app: a marker jumps to every
+ * touch sample, so each sample produces a frame of its own and the
+ * touch_latency numbers cover the whole path from the I2C read to the
+ * pixels under the finger. Live figures sit at the top, the histogram
+ * goes to the log when the screen closes.
+ */
+
+#include "win32_ui.h"
+#include "touch_latency.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+// Custom font with Cyrillic support
+#include "assets.h"
+#define UI_FONT &CodeProVariable
+
+static const char *TAG = "LAT_SCREEN";
+
+#define LATENCY_SCREEN_PERIOD_MS    500
+#define LATENCY_MARKER_SIZE         24
+
+static lv_obj_t *lat_screen = NULL;
+static lv_obj_t *lat_marker = NULL;
+static lv_obj_t *lat_label = NULL;
+static lv_timer_t *lat_timer = NULL;
+static char lat_text[256];
+
+static void lat_timer_cb(lv_timer_t *t)
+{
+    touch_latency_stats_t stats;
+    touch_latency_get(&stats);
+
+    char text[sizeof(lat_text)];
+    if (stats.matched == 0) {
+        snprintf(text, sizeof(text), "Drag a finger slowly over the screen\nSamples: %lu",
+                 (unsigned long)stats.events);
+    } else {
+        snprintf(text, sizeof(text),
+                 "Samples %lu  on screen %lu  no frame %lu\n"
+                 "min %.1f  avg %.1f  p95 <%lu  max %.1f ms\n"
+                 "last: read %.1f input %.1f wait %.1f\n"
+                 "render %.1f swap %.1f scanout %.1f ms",
+                 (unsigned long)stats.events, (unsigned long)stats.matched, (unsigned long)stats.dropped,
+                 stats.min_us / 1000.0, stats.total_us / 1000.0 / stats.matched,
+                 (unsigned long)touch_latency_percentile(&stats, 95), stats.max_us / 1000.0,
+                 stats.last_us[TOUCH_LATENCY_READ] / 1000.0, stats.last_us[TOUCH_LATENCY_INPUT] / 1000.0,
+                 stats.last_us[TOUCH_LATENCY_WAIT] / 1000.0, stats.last_us[TOUCH_LATENCY_RENDER] / 1000.0,
+                 stats.last_us[TOUCH_LATENCY_SWAP] / 1000.0, stats.last_us[TOUCH_LATENCY_SCANOUT] / 1000.0);
+    }
+
+    if (strcmp(text, lat_text) != 0) {
+        strcpy(lat_text, text);
+        lv_label_set_text(lat_label, text);
+    }
+}
+
+// Move the marker to the finger: two small invalidated areas per sample
+static void lat_touch_cb(lv_event_t *e)
+{
+    lv_point_t point;
+    lv_indev_get_point(lv_indev_active(), &point);
+    lv_obj_set_pos(lat_marker, point.x - LATENCY_MARKER_SIZE / 2, point.y - LATENCY_MARKER_SIZE / 2);
+    lv_obj_remove_flag(lat_marker, LV_OBJ_FLAG_HIDDEN);
+}
+
+static void lat_close(void)
+{
+    touch_latency_stats_t stats;
+    touch_latency_get(&stats);
+    char buf[1536];
+    touch_latency_format(&stats, buf, sizeof(buf));
+    ESP_LOGI(TAG, "\n%s", buf);
+
+    lv_timer_delete(lat_timer);
+    lv_obj_delete(lat_screen);
+    lat_timer = NULL;
+    lat_screen = NULL;
+    lat_marker = NULL;
+    lat_label = NULL;
+}
+
+static lv_obj_t *lat_button(const char *text, lv_align_t align, int32_t x, lv_event_cb_t cb)
+{
+    lv_obj_t *btn = lv_btn_create(lat_screen);
+    lv_obj_set_size(btn, 120, 44);
+    lv_obj_align(btn, align, x, -16);
+    lv_obj_set_style_bg_color(btn, lv_color_hex(0x333333), 0);
+    lv_obj_set_style_radius(btn, 4, 0);
+    lv_obj_add_event_cb(btn, cb, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t *lbl = lv_label_create(btn);
+    lv_label_set_text(lbl, text);
+    lv_obj_set_style_text_color(lbl, lv_color_white(), 0);
+    lv_obj_set_style_text_font(lbl, UI_FONT, 0);
+    lv_obj_center(lbl);
+    return btn;
+}
+
+void latency_screen_show(void)
+{
+    if (lat_screen) return;
+
+    // Top layer: above the app windows and the taskbar, below the HUD
+    lat_screen = lv_obj_create(lv_layer_top());
+    lv_obj_set_size(lat_screen, SCREEN_WIDTH, SCREEN_HEIGHT);
+    lv_obj_set_pos(lat_screen, 0, 0);
+    lv_obj_set_style_bg_color(lat_screen, lv_color_black(), 0);
+    lv_obj_set_style_bg_opa(lat_screen, LV_OPA_COVER, 0);
+    lv_obj_set_style_border_width(lat_screen, 0, 0);
+    lv_obj_set_style_radius(lat_screen, 0, 0);
+    lv_obj_set_style_pad_all(lat_screen, 0, 0);
+    lv_obj_remove_flag(lat_screen, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(lat_screen, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(lat_screen, lat_touch_cb, LV_EVENT_PRESSED, NULL);
+    lv_obj_add_event_cb(lat_screen, lat_touch_cb, LV_EVENT_PRESSING, NULL);
+
+    lat_label = lv_label_create(lat_screen);
+    lv_obj_set_width(lat_label, SCREEN_WIDTH - 20);
+    lv_obj_align(lat_label, LV_ALIGN_TOP_LEFT, 10, 10);
+    lv_obj_set_style_text_color(lat_label, lv_color_hex(0x00FF66), 0);
+    lv_obj_set_style_text_font(lat_label, UI_FONT, 0);
+    lv_label_set_long_mode(lat_label, LV_LABEL_LONG_CLIP);
+    lv_label_set_text(lat_label, "");
+    lv_obj_remove_flag(lat_label, LV_OBJ_FLAG_CLICKABLE);
+
+    lat_marker = lv_obj_create(lat_screen);
+    lv_obj_set_size(lat_marker, LATENCY_MARKER_SIZE, LATENCY_MARKER_SIZE);
+    lv_obj_set_style_radius(lat_marker, LV_RADIUS_CIRCLE, 0);
+    lv_obj_set_style_bg_opa(lat_marker, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_color(lat_marker, lv_color_white(), 0);
+    lv_obj_set_style_border_width(lat_marker, 3, 0);
+    lv_obj_remove_flag(lat_marker, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_remove_flag(lat_marker, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(lat_marker, LV_OBJ_FLAG_HIDDEN);
+
+    lat_button("Reset", LV_ALIGN_BOTTOM_LEFT, 16, [](lv_event_t *e) {
+        touch_latency_reset();
+    });
+    lat_button("Close", LV_ALIGN_BOTTOM_RIGHT, -16, [](lv_event_t *e) {
+        lat_close();
+    });
+
+    // Fresh numbers for this run only
+    touch_latency_reset();
+    lat_text[0] = '\0';
+    lat_timer = lv_timer_create(lat_timer_cb, LATENCY_SCREEN_PERIOD_MS, NULL);
+    lat_timer_cb(lat_timer);
+    ESP_LOGI(TAG, "Touch latency calibration started");
+}
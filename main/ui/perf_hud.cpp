@@ -0,0 +1,140 @@
+/**
+ * Win32 OS - Performance HUD
+ * Small always-on-top overlay with rendered FPS, LVGL render time, load
+ * per core, free SRAM/PSRAM with their largest blocks and the LVGL
+ * object count. Toggled from the system tray; shown at boot when the
+ * debug_mode setting is on.
+ *
+ * The HUD sits on the system layer above every screen and overlay. It
+ * refreshes twice a second and only sets its label when the text
+ * changed, so it costs at most two small partial redraws per second -
+ * an idle screen shows ~2 FPS because of it, anything above that is real.
+ */
+
+#include "win32_ui.h"
+#include "lvgl_port.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <string.h>
+
+// Custom font with Cyrillic support
+#include "assets.h"
+#define UI_FONT &CodeProVariable
+
+static const char *TAG = "PERF_HUD";
+
+#define PERF_HUD_PERIOD_MS  500
+#define PERF_HUD_WIDTH      200
+
+static lv_obj_t *hud_label = NULL;
+static lv_timer_t *hud_timer = NULL;
+
+// Previous sample; counters are diffed over one period
+static my_lvgl_port_render_stats_t last_render;
+static configRUN_TIME_COUNTER_TYPE last_idle[portNUM_PROCESSORS];
+static configRUN_TIME_COUNTER_TYPE last_clock;
+static char last_text[192];
+
+static void sample_idle(configRUN_TIME_COUNTER_TYPE idle[portNUM_PROCESSORS])
+{
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        idle[c] = ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(c));
+    }
+}
+
+// KB below 10 MB, else MB with one decimal
+static void format_size(char *buf, size_t len, size_t bytes)
+{
+    if (bytes < 10 * 1024 * 1024) {
+        snprintf(buf, len, "%uK", (unsigned)(bytes / 1024));
+    } else {
+        snprintf(buf, len, "%.1fM", bytes / (1024.0 * 1024.0));
+    }
+}
+
+static void hud_timer_cb(lv_timer_t *t)
+{
+    my_lvgl_port_render_stats_t render;
+    my_lvgl_port_get_render_stats(&render);
+    configRUN_TIME_COUNTER_TYPE idle[portNUM_PROCESSORS];
+    sample_idle(idle);
+    // Same clock the run time counters use, so the ratio needs no scaling
+    configRUN_TIME_COUNTER_TYPE clock = portGET_RUN_TIME_COUNTER_VALUE();
+
+    configRUN_TIME_COUNTER_TYPE elapsed = clock - last_clock;
+    uint32_t frames = render.frames - last_render.frames;
+    float fps = elapsed ? frames * 1000000.0f / elapsed : 0;
+    float render_ms = frames ? (render.render_us - last_render.render_us) / 1000.0f / frames : 0;
+
+    char text[sizeof(last_text)];
+    int n = snprintf(text, sizeof(text), "FPS %.0f  render %.1f ms\nCPU", fps, render_ms);
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        configRUN_TIME_COUNTER_TYPE idle_delta = idle[c] - last_idle[c];
+        int load = elapsed ? 100 - (int)((uint64_t)idle_delta * 100 / elapsed) : 0;
+        if (load < 0) load = 0;
+        n += snprintf(text + n, sizeof(text) - n, "%s%d%%", c ? " / " : " ", load);
+    }
+
+    char sram[12], sram_blk[12], psram[12], psram_blk[12];
+    format_size(sram, sizeof(sram), heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    format_size(sram_blk, sizeof(sram_blk), heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+    format_size(psram, sizeof(psram), heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    format_size(psram_blk, sizeof(psram_blk), heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM));
+    snprintf(text + n, sizeof(text) - n, "\nSRAM %s  blk %s\nPSRAM %s  blk %s\nObjects %lu",
+             sram, sram_blk, psram, psram_blk, (unsigned long)my_lvgl_port_count_objects());
+
+    last_render = render;
+    memcpy(last_idle, idle, sizeof(last_idle));
+    last_clock = clock;
+
+    // Unchanged text would still invalidate the label, so skip it
+    if (strcmp(text, last_text) != 0) {
+        strcpy(last_text, text);
+        lv_label_set_text(hud_label, text);
+    }
+}
+
+void perf_hud_set_visible(bool visible)
+{
+    if (visible == (hud_label != NULL)) return;
+
+    if (!visible) {
+        lv_timer_delete(hud_timer);
+        lv_obj_delete(hud_label);
+        hud_timer = NULL;
+        hud_label = NULL;
+        ESP_LOGI(TAG, "HUD off");
+        return;
+    }
+
+    // Fixed width and line count: the label never relayouts, it only
+    // redraws its own rectangle
+    hud_label = lv_label_create(lv_layer_sys());
+    lv_obj_set_width(hud_label, PERF_HUD_WIDTH);
+    lv_obj_align(hud_label, LV_ALIGN_TOP_RIGHT, -4, 4);
+    lv_obj_set_style_bg_color(hud_label, lv_color_black(), 0);
+    lv_obj_set_style_bg_opa(hud_label, LV_OPA_70, 0);
+    lv_obj_set_style_radius(hud_label, 4, 0);
+    lv_obj_set_style_pad_all(hud_label, 4, 0);
+    lv_obj_set_style_text_color(hud_label, lv_color_hex(0x00FF66), 0);
+    lv_obj_set_style_text_font(hud_label, UI_FONT, 0);
+    lv_label_set_long_mode(hud_label, LV_LABEL_LONG_CLIP);
+    lv_label_set_text(hud_label, "FPS -\nCPU -\nSRAM -\nPSRAM -\nObjects -");
+    // Touches pass through to whatever is underneath
+    lv_obj_remove_flag(hud_label, LV_OBJ_FLAG_CLICKABLE);
+    last_text[0] = '\0';
+
+    my_lvgl_port_get_render_stats(&last_render);
+    sample_idle(last_idle);
+    last_clock = portGET_RUN_TIME_COUNTER_VALUE();
+    hud_timer = lv_timer_create(hud_timer_cb, PERF_HUD_PERIOD_MS, NULL);
+    ESP_LOGI(TAG, "HUD on");
+}
+
+bool perf_hud_is_visible(void)
+{
+    return hud_label != NULL;
+}
@@ -47,6 +47,7 @@ static bool is_valid_child(lv_obj_t *obj) {
 static void settings_wifi_scan_clicked(lv_event_t *e);
 static void settings_wifi_item_clicked(lv_event_t *e);
 static void show_wifi_password_dialog(const char *ssid, bool is_secured);
+static void settings_wifi_refresh(bool force_list);
 
 // WiFi password dialog elements
 static lv_obj_t *wifi_password_dialog = NULL;
@@ -54,11 +55,18 @@ static lv_obj_t *wifi_password_textarea = NULL;
 static lv_obj_t *wifi_password_keyboard = NULL;
 static char pending_ssid[33] = {0};
 
-// Structure to store network info in user_data
-typedef struct {
-    char ssid[33];
-    uint8_t authmode;
-} wifi_network_info_t;
+// WiFi page live elements - the scan runs in the background and the rows are
+// updated in place from the scan cache whenever another channel has been added
+#define WIFI_LIST_MAX 40
+static lv_obj_t *wifi_networks_list = NULL;
+static lv_obj_t *wifi_list_placeholder = NULL;  // "Scanning..." while there are no rows
+static lv_obj_t *wifi_networks_header = NULL;
+static lv_obj_t *wifi_scan_label = NULL;
+static lv_obj_t *wifi_timing_label = NULL;
+static lv_timer_t *wifi_page_timer = NULL;
+static uint32_t wifi_list_generation = 0;
+static wifi_ap_info_t wifi_list_aps[WIFI_LIST_MAX];  // Item user data indexes this
+static uint16_t wifi_list_count = 0;
 
 // ============ WIFI SETTINGS PAGE ============
 
@@ -92,6 +100,17 @@ void settings_show_wifi_page(void)
     lv_obj_set_style_pad_all(settings_wifi_page, 10, 0);
     lv_obj_set_flex_flow(settings_wifi_page, LV_FLEX_FLOW_COLUMN);
     lv_obj_set_style_pad_row(settings_wifi_page, 8, 0);
+    lv_obj_add_event_cb(settings_wifi_page, [](lv_event_t *e) {
+        if (wifi_page_timer) {
+            lv_timer_delete(wifi_page_timer);
+            wifi_page_timer = NULL;
+        }
+        wifi_networks_list = NULL;
+        wifi_list_placeholder = NULL;
+        wifi_networks_header = NULL;
+        wifi_scan_label = NULL;
+        wifi_timing_label = NULL;
+    }, LV_EVENT_DELETE, NULL);
     
     // Back button - Vista style
     lv_obj_t *back_btn = lv_obj_create(settings_wifi_page);
@@ -123,6 +142,8 @@ void settings_show_wifi_page(void)
     lv_obj_set_style_radius(status_cont, 4, 0);
     lv_obj_set_style_pad_all(status_cont, 12, 0);
     lv_obj_remove_flag(status_cont, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_flex_flow(status_cont, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_style_pad_row(status_cont, 4, 0);
     
     lv_obj_t *status_label = lv_label_create(status_cont);
     if (system_wifi_is_connected()) {
@@ -135,6 +156,11 @@ void settings_show_wifi_page(void)
         lv_obj_set_style_text_color(status_label, lv_color_hex(0xCC0000), 0);
     }
     
+    // Boot-to-IP and reconnect times
+    wifi_timing_label = lv_label_create(status_cont);
+    lv_label_set_text(wifi_timing_label, "");
+    lv_obj_set_style_text_color(wifi_timing_label, lv_color_hex(0x666666), 0);
+    
     // Scan button - Vista style
     lv_obj_t *scan_btn = lv_obj_create(settings_wifi_page);
     lv_obj_set_size(scan_btn, lv_pct(100), 40);
@@ -148,19 +174,20 @@ void settings_show_wifi_page(void)
     lv_obj_remove_flag(scan_btn, LV_OBJ_FLAG_SCROLLABLE);
     lv_obj_add_event_cb(scan_btn, settings_wifi_scan_clicked, LV_EVENT_CLICKED, NULL);
     
-    lv_obj_t *scan_label = lv_label_create(scan_btn);
-    lv_label_set_text(scan_label, "Scan for Networks");
-    lv_obj_set_style_text_color(scan_label, lv_color_white(), 0);
-    lv_obj_center(scan_label);
-    lv_obj_remove_flag(scan_label, LV_OBJ_FLAG_CLICKABLE);
+    wifi_scan_label = lv_label_create(scan_btn);
+    lv_label_set_text(wifi_scan_label, "Scan for Networks");
+    lv_obj_set_style_text_color(wifi_scan_label, lv_color_white(), 0);
+    lv_obj_center(wifi_scan_label);
+    lv_obj_remove_flag(wifi_scan_label, LV_OBJ_FLAG_CLICKABLE);
     
     // Networks list header
-    lv_obj_t *networks_header = lv_label_create(settings_wifi_page);
-    lv_label_set_text(networks_header, "Available Networks");
-    lv_obj_set_style_text_color(networks_header, lv_color_hex(0x1A5090), 0);
+    wifi_networks_header = lv_label_create(settings_wifi_page);
+    lv_label_set_text(wifi_networks_header, "Available Networks");
+    lv_obj_set_style_text_color(wifi_networks_header, lv_color_hex(0x1A5090), 0);
     
     // Networks list container - white background
     lv_obj_t *networks_list = lv_obj_create(settings_wifi_page);
+    wifi_networks_list = networks_list;
     lv_obj_set_size(networks_list, lv_pct(100), lv_pct(100));
     lv_obj_set_style_bg_color(networks_list, lv_color_hex(0xFFFFFF), 0);
     lv_obj_set_style_border_color(networks_list, lv_color_hex(0x7EB4EA), 0);
@@ -170,128 +197,253 @@ void settings_show_wifi_page(void)
     lv_obj_set_flex_flow(networks_list, LV_FLEX_FLOW_COLUMN);
     lv_obj_set_style_pad_row(networks_list, 5, 0);
     
-    lv_obj_t *placeholder = lv_label_create(networks_list);
-    lv_label_set_text(placeholder, "Tap 'Scan' to find networks");
-    lv_obj_set_style_text_color(placeholder, lv_color_hex(0x888888), 0);
+    // Show what the last scan found right away; rescan if that is old
+    settings_wifi_refresh(true);
+    int32_t age_ms = -1;
+    uint16_t cached = 0;
+    system_wifi_scan_get_cached(NULL, &cached, &age_ms);
+    if (age_ms < 0 || age_ms > 30000) {
+        system_wifi_scan_start();
+    }
+    
+    wifi_page_timer = lv_timer_create([](lv_timer_t *t) {
+        settings_wifi_refresh(false);
+    }, 300, NULL);
 }
 
 static void settings_wifi_scan_clicked(lv_event_t *e)
 {
     ESP_LOGI(TAG, "WiFi scan clicked");
     
-    lv_obj_t *scan_btn = (lv_obj_t *)lv_event_get_target(e);
-    lv_obj_t *page = lv_obj_get_parent(scan_btn);
-    lv_obj_t *networks_list = lv_obj_get_child(page, -1);
+    // Results stream in through the page timer as channels complete
+    if (system_wifi_scan_start() != 0 && wifi_networks_header) {
+        lv_label_set_text(wifi_networks_header, "Available Networks (scan unavailable)");
+    }
+    settings_wifi_refresh(false);
+}
+
+static void format_ms(char *buf, size_t len, int32_t ms)
+{
+    if (ms < 0) {
+        snprintf(buf, len, "-");
+    } else {
+        snprintf(buf, len, "%ld.%02ld s", (long)(ms / 1000), (long)((ms % 1000) / 10));
+    }
+}
+
+static void set_label_if_changed(lv_obj_t *label, const char *text)
+{
+    if (label && strcmp(lv_label_get_text(label), text) != 0) {
+        lv_label_set_text(label, text);
+    }
+}
+
+// A row: SSID, signal and tag labels, filled in by settings_wifi_fill_item()
+static lv_obj_t *settings_wifi_create_item(void)
+{
+    lv_obj_t *item = lv_obj_create(wifi_networks_list);
+    lv_obj_set_size(item, lv_pct(100), 60);
+    lv_obj_set_style_bg_color(item, lv_color_white(), 0);
+    lv_obj_set_style_border_color(item, lv_color_hex(0xCCCCCC), 0);
+    lv_obj_set_style_border_width(item, 1, 0);
+    lv_obj_set_style_radius(item, 6, 0);
+    lv_obj_set_style_pad_all(item, 10, 0);
+    lv_obj_add_flag(item, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_style_bg_color(item, lv_color_hex(0xE8E8FF), LV_STATE_PRESSED);
+    lv_obj_remove_flag(item, LV_OBJ_FLAG_SCROLLABLE);
+    
+    // SSID
+    lv_obj_t *ssid_label = lv_label_create(item);
+    lv_label_set_text(ssid_label, "");
+    lv_obj_set_style_text_color(ssid_label, lv_color_black(), 0);
+    lv_obj_align(ssid_label, LV_ALIGN_TOP_LEFT, 0, 0);
+    lv_obj_remove_flag(ssid_label, LV_OBJ_FLAG_CLICKABLE);
+    
+    lv_obj_t *signal_label = lv_label_create(item);
+    lv_label_set_text(signal_label, "");
+    lv_obj_set_style_text_color(signal_label, lv_color_hex(0x666666), 0);
+    lv_obj_align(signal_label, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+    lv_obj_remove_flag(signal_label, LV_OBJ_FLAG_CLICKABLE);
+    
+    lv_obj_t *tag_label = lv_label_create(item);
+    lv_label_set_text(tag_label, "");
+    lv_obj_align(tag_label, LV_ALIGN_TOP_RIGHT, 0, 0);
+    lv_obj_remove_flag(tag_label, LV_OBJ_FLAG_CLICKABLE);
+    
+    lv_obj_add_event_cb(item, settings_wifi_item_clicked, LV_EVENT_CLICKED, NULL);
+    return item;
+}
+
+static void settings_wifi_fill_item(lv_obj_t *item, int index)
+{
+    const wifi_ap_info_t *ap = &wifi_list_aps[index];
+    const char *ssid = (const char *)ap->ssid;
+    
+    set_label_if_changed(lv_obj_get_child(item, 0), ssid);
+    
+    // Signal strength
+    char signal_str[48];
+    int rssi = ap->rssi;
+    const char *signal_quality;
+    if (rssi > -50) signal_quality = "Excellent";
+    else if (rssi > -60) signal_quality = "Good";
+    else if (rssi > -70) signal_quality = "Fair";
+    else signal_quality = "Weak";
+    
+    snprintf(signal_str, sizeof(signal_str), "%s (%d dBm), ch %d", signal_quality, rssi, ap->channel);
+    set_label_if_changed(lv_obj_get_child(item, 1), signal_str);
+    
+    // Connected / saved / security marker
+    const char *tag = NULL;
+    if (system_wifi_is_connected() && strcmp(system_wifi_get_ssid(), ssid) == 0) tag = "Connected";
+    else if (settings_find_wifi(ssid, NULL) >= 0) tag = "Saved";
+    else if (ap->authmode != 0) tag = "LOCK";
+    
+    lv_obj_t *tag_label = lv_obj_get_child(item, 2);
+    set_label_if_changed(tag_label, tag ? tag : "");
+    if (tag) lv_obj_set_style_text_color(tag_label, lv_color_hex(tag[0] == 'L' ? 0x888888 : 0x008800), 0);
+    
+    lv_obj_set_user_data(item, (void *)(intptr_t)index);
+}
+
+// A finger on a row or a scroll in progress: changing the rows now would
+// move the list or put another network under the tap
+static bool settings_wifi_list_busy(void)
+{
+    if (lv_obj_is_scrolling(wifi_networks_list)) return true;
+    uint32_t count = lv_obj_get_child_count(wifi_networks_list);
+    for (uint32_t i = 0; i < count; i++) {
+        if (lv_obj_has_state(lv_obj_get_child(wifi_networks_list, i), LV_STATE_PRESSED)) return true;
+    }
+    return false;
+}
+
+// Called from the page timer: update the rows when the scan cache changed
+// (in place, so the scroll position stays), keep the scan button, header
+// and timings current
+static void settings_wifi_refresh(bool force_list)
+{
+    if (!wifi_networks_list) return;
+    
+    bool scanning = system_wifi_scan_in_progress();
+    set_label_if_changed(wifi_scan_label, scanning ? "Scanning..." : "Scan for Networks");
+    
+    wifi_timing_t timing;
+    system_wifi_get_timing(&timing);
+    char boot_str[16], connect_str[16], reconnect_str[16], timing_str[112];
+    format_ms(boot_str, sizeof(boot_str), timing.boot_to_ip_ms);
+    format_ms(connect_str, sizeof(connect_str), timing.last_connect_ms);
+    format_ms(reconnect_str, sizeof(reconnect_str), timing.last_reconnect_ms);
+    snprintf(timing_str, sizeof(timing_str), "Boot to IP: %s   Connect: %s%s   Reconnect: %s",
+             boot_str, connect_str, timing.last_connect_ms >= 0 && timing.last_fast ? " (fast)" : "",
+             reconnect_str);
+    set_label_if_changed(wifi_timing_label, timing_str);
+    
+    uint32_t generation = system_wifi_scan_generation();
+    if (!force_list && generation == wifi_list_generation) return;
+    if (!force_list && settings_wifi_list_busy()) return;    // Next tick
+    wifi_list_generation = generation;
+    
+    int32_t age_ms = -1;
+    wifi_list_count = WIFI_LIST_MAX;
+    system_wifi_scan_get_cached(wifi_list_aps, &wifi_list_count, &age_ms);
+    
+    char header[64];
+    if (age_ms >= 0 && !scanning) {
+        snprintf(header, sizeof(header), "Available Networks (%ld s ago)", (long)(age_ms / 1000));
+    } else {
+        snprintf(header, sizeof(header), "Available Networks");
+    }
+    set_label_if_changed(wifi_networks_header, header);
     
-    lv_obj_clean(networks_list);
+    int rows = 0;
+    for (int i = 0; i < wifi_list_count; i++) {
+        // Filter: skip 0 dBm signal
+        if (wifi_list_aps[i].rssi == 0) continue;
+        if (wifi_list_placeholder) {
+            lv_obj_delete(wifi_list_placeholder);
+            wifi_list_placeholder = NULL;
+        }
+        lv_obj_t *item = lv_obj_get_child(wifi_networks_list, rows);
+        if (!item) item = settings_wifi_create_item();
+        settings_wifi_fill_item(item, i);
+        rows++;
+    }
     
-    lv_obj_t *scanning_label = lv_label_create(networks_list);
-    lv_label_set_text(scanning_label, "Scanning...");
-    lv_obj_set_style_text_color(scanning_label, lv_color_hex(0x0054E3), 0);
+    // Networks that dropped out of the cache
+    if (!wifi_list_placeholder) {
+        while (lv_obj_get_child_count(wifi_networks_list) > (uint32_t)rows) {
+            lv_obj_delete(lv_obj_get_child(wifi_networks_list, -1));
+        }
+    }
     
-    // Perform scan
-    wifi_ap_info_t ap_records[20];
-    uint16_t ap_count = 20;
-    int ret = system_wifi_scan(ap_records, &ap_count);
+    if (rows == 0) {
+        if (!wifi_list_placeholder) wifi_list_placeholder = lv_label_create(wifi_networks_list);
+        set_label_if_changed(wifi_list_placeholder, scanning ? "Scanning..." : "No networks found");
+        lv_obj_set_style_text_color(wifi_list_placeholder, lv_color_hex(scanning ? 0x0054E3 : 0xFF6666), 0);
+    }
+}
+
+// How a failed connect started from the list is followed up
+enum { WIFI_JOIN_PLAIN = 0, WIFI_JOIN_SAVED_SECURED };
+
+// Runs on the connect task with the LVGL lock held
+static void settings_wifi_connect_done(const char *ssid, int result, void *user)
+{
+    if (result == 0) {
+        ESP_LOGI(TAG, "Connected to %s", ssid);
+    } else {
+        uint8_t err = system_wifi_get_last_error();
+        ESP_LOGE(TAG, "Failed to connect to %s - Error: %d (%s)", 
+                 ssid, err, system_wifi_get_error_string(err));
+    }
     
-    lv_obj_delete(scanning_label);
+    // WiFi page closed while connecting
+    if (!wifi_networks_list) return;
     
-    if (ret != 0 || ap_count == 0) {
-        lv_obj_t *error_label = lv_label_create(networks_list);
-        lv_label_set_text(error_label, "No networks found");
-        lv_obj_set_style_text_color(error_label, lv_color_hex(0xFF6666), 0);
+    // Saved password no longer works - ask for a new one
+    if (result != 0 && (intptr_t)user == WIFI_JOIN_SAVED_SECURED) {
+        show_wifi_password_dialog(ssid, true);
         return;
     }
+    settings_show_wifi_page();
+}
+
+static void settings_wifi_connect_start(const char *ssid, const char *password, int join)
+{
+    if (system_wifi_connect_async(ssid, password, settings_wifi_connect_done, (void *)(intptr_t)join) != 0) return;
     
-    int valid_count = 0;
-    for (int i = 0; i < ap_count; i++) {
-        // Filter: skip empty SSID or 0 dBm signal
-        if (ap_records[i].ssid[0] == '\0' || ap_records[i].rssi == 0) {
-            continue;
-        }
-        
-        valid_count++;
-        
-        lv_obj_t *item = lv_obj_create(networks_list);
-        lv_obj_set_size(item, lv_pct(100), 60);
-        lv_obj_set_style_bg_color(item, lv_color_white(), 0);
-        lv_obj_set_style_border_color(item, lv_color_hex(0xCCCCCC), 0);
-        lv_obj_set_style_border_width(item, 1, 0);
-        lv_obj_set_style_radius(item, 6, 0);
-        lv_obj_set_style_pad_all(item, 10, 0);
-        lv_obj_add_flag(item, LV_OBJ_FLAG_CLICKABLE);
-        lv_obj_set_style_bg_color(item, lv_color_hex(0xE8E8FF), LV_STATE_PRESSED);
-        lv_obj_remove_flag(item, LV_OBJ_FLAG_SCROLLABLE);
-        
-        // SSID
-        lv_obj_t *ssid_label = lv_label_create(item);
-        lv_label_set_text(ssid_label, (const char *)ap_records[i].ssid);
-        lv_obj_set_style_text_color(ssid_label, lv_color_black(), 0);
-        lv_obj_align(ssid_label, LV_ALIGN_TOP_LEFT, 0, 0);
-        lv_obj_remove_flag(ssid_label, LV_OBJ_FLAG_CLICKABLE);
-        
-        // Signal strength
-        char signal_str[32];
-        int rssi = ap_records[i].rssi;
-        const char *signal_quality;
-        if (rssi > -50) signal_quality = "Excellent";
-        else if (rssi > -60) signal_quality = "Good";
-        else if (rssi > -70) signal_quality = "Fair";
-        else signal_quality = "Weak";
-        
-        snprintf(signal_str, sizeof(signal_str), "%s (%d dBm)", signal_quality, rssi);
-        
-        lv_obj_t *signal_label = lv_label_create(item);
-        lv_label_set_text(signal_label, signal_str);
-        lv_obj_set_style_text_color(signal_label, lv_color_hex(0x666666), 0);
-        lv_obj_align(signal_label, LV_ALIGN_BOTTOM_LEFT, 0, 0);
-        lv_obj_remove_flag(signal_label, LV_OBJ_FLAG_CLICKABLE);
-        
-        // Security icon (authmode != 0 means secured)
-        if (ap_records[i].authmode != 0) {
-            lv_obj_t *lock_label = lv_label_create(item);
-            lv_label_set_text(lock_label, "LOCK");
-            lv_obj_set_style_text_color(lock_label, lv_color_hex(0x888888), 0);
-            lv_obj_align(lock_label, LV_ALIGN_TOP_RIGHT, 0, 0);
-            lv_obj_remove_flag(lock_label, LV_OBJ_FLAG_CLICKABLE);
-        }
-        
-        // Store network info in user data
-        wifi_network_info_t *net_info = (wifi_network_info_t *)malloc(sizeof(wifi_network_info_t));
-        strncpy(net_info->ssid, (const char *)ap_records[i].ssid, 32);
-        net_info->ssid[32] = '\0';
-        net_info->authmode = ap_records[i].authmode;
-        lv_obj_set_user_data(item, net_info);
-        
-        lv_obj_add_event_cb(item, settings_wifi_item_clicked, LV_EVENT_CLICKED, NULL);
-    }
-    
-    if (valid_count == 0) {
-        lv_obj_t *error_label = lv_label_create(networks_list);
-        lv_label_set_text(error_label, "No valid networks found");
-        lv_obj_set_style_text_color(error_label, lv_color_hex(0xFF6666), 0);
+    if (wifi_networks_header) {
+        char header[64];
+        snprintf(header, sizeof(header), "Connecting to %s...", ssid);
+        lv_label_set_text(wifi_networks_header, header);
     }
 }
 
 static void settings_wifi_item_clicked(lv_event_t *e)
 {
     lv_obj_t *item = (lv_obj_t *)lv_event_get_target(e);
-    wifi_network_info_t *net_info = (wifi_network_info_t *)lv_obj_get_user_data(item);
+    int index = (int)(intptr_t)lv_obj_get_user_data(item);
     
-    if (!net_info) return;
+    if (index < 0 || index >= wifi_list_count) return;
     
-    ESP_LOGI(TAG, "WiFi network clicked: %s (secured: %d)", net_info->ssid, net_info->authmode);
+    // Copy out: the list may be rebuilt while connecting
+    wifi_ap_info_t ap = wifi_list_aps[index];
+    const char *ssid = (const char *)ap.ssid;
     
-    // If network is secured, show password dialog
-    if (net_info->authmode != 0) {
-        show_wifi_password_dialog(net_info->ssid, true);
+    ESP_LOGI(TAG, "WiFi network clicked: %s (secured: %d)", ssid, ap.authmode);
+    
+    // Saved network - reconnect with the stored password (and its saved channel)
+    wifi_credentials_t saved;
+    if (settings_find_wifi(ssid, &saved) >= 0) {
+        settings_wifi_connect_start(saved.ssid, saved.password,
+                                    ap.authmode != 0 ? WIFI_JOIN_SAVED_SECURED : WIFI_JOIN_PLAIN);
+    } else if (ap.authmode != 0) {
+        // If network is secured, show password dialog
+        show_wifi_password_dialog(ssid, true);
     } else {
         // Open network - connect directly
-        int ret = system_wifi_connect(net_info->ssid, "");
-        if (ret == 0) {
-            ESP_LOGI(TAG, "Connected to %s", net_info->ssid);
-            settings_show_wifi_page();
-        }
+        settings_wifi_connect_start(ssid, "", WIFI_JOIN_PLAIN);
     }
 }
 
@@ -329,21 +481,8 @@ static void wifi_password_connect_clicked(lv_event_t *e)
         wifi_password_keyboard = NULL;
     }
     
-    // Connect with copied password
-    int ret = system_wifi_connect(pending_ssid, password_copy);
-    if (ret == 0) {
-        ESP_LOGI(TAG, "Connected to %s", pending_ssid);
-        // Save WiFi credentials on successful connection
-        settings_save_wifi(pending_ssid, password_copy);
-        ESP_LOGI(TAG, "WiFi credentials saved for: %s", pending_ssid);
-    } else {
-        uint8_t err = system_wifi_get_last_error();
-        ESP_LOGE(TAG, "Failed to connect to %s - Error: %d (%s)", 
-                 pending_ssid, err, system_wifi_get_error_string(err));
-    }
-    
-    // Refresh page
-    settings_show_wifi_page();
+    // Connect with copied password; credentials are saved once it succeeds
+    settings_wifi_connect_start(pending_ssid, password_copy, WIFI_JOIN_PLAIN);
 }
 
 static void wifi_password_cancel_clicked(lv_event_t *e)
@@ -1455,8 +1594,21 @@ static void bt_status_timer_cb(lv_timer_t *timer) {
             lv_label_set_text(bt_status_label, "Connected");
             lv_obj_set_style_text_color(bt_status_label, lv_color_hex(0x00AA00), 0);
             
-            char conn_text[64];
-            snprintf(conn_text, sizeof(conn_text), "Device: %s", bt_get_connected_device());
+            char conn_text[160];
+            int n = snprintf(conn_text, sizeof(conn_text), "Device: %s", bt_get_connected_device());
+            
+            const bt_transfer_info_t *ti = bt_get_transfer_info();
+            if (ti->status == BT_TRANSFER_SENDING || ti->status == BT_TRANSFER_RECEIVING ||
+                ti->status == BT_TRANSFER_COMPLETE) {
+                n += snprintf(conn_text + n, sizeof(conn_text) - n, "\n%s %s: %u%%, %lu KB/s",
+                              ti->direction == BT_DIR_SEND ? "Sending" : "Receiving", ti->filename,
+                              ti->progress_percent, (unsigned long)ti->throughput_kbs);
+                if (ti->files_total > 0 && n < (int)sizeof(conn_text)) {
+                    snprintf(conn_text + n, sizeof(conn_text) - n, " (%u/%u files)", ti->files_done, ti->files_total);
+                } else if (ti->files_done > 0 && n < (int)sizeof(conn_text)) {
+                    snprintf(conn_text + n, sizeof(conn_text) - n, " (%u files)", ti->files_done);
+                }
+            }
             lv_label_set_text(bt_connected_label, conn_text);
         } else {
             lv_label_set_text(bt_status_label, "Advertising...");
@@ -8,10 +8,16 @@
 #include "win32_ui.h"
 #include "hardware/hardware.h"
 #include "system_settings.h"
+#include "trace.h"
+#include "http_service.h"
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_lvgl_port.h"
 #include "nvs_flash.h"
+#include "freertos/semphr.h"
 #include <string.h>
+#include <stdlib.h>
 #include <time.h>
 
 // ESP-Hosted WiFi headers (always available with esp_hosted component)
@@ -42,10 +48,44 @@ static char connected_ssid[33] = {0};
 static volatile bool wifi_ui_update_needed = false;
 static volatile bool wifi_ui_connected_state = false;
 
-// Scan results storage
-#define MAX_SCAN_RESULTS 20
-static wifi_ap_info_t scan_results[MAX_SCAN_RESULTS];
-static uint16_t scan_result_count = 0;
+// Scan cache - filled one channel at a time so the list grows while the
+// sweep runs; entries not seen in a complete sweep are dropped
+#define MAX_SCAN_RESULTS    40
+#define SCAN_FIRST_CHANNEL  1
+#define SCAN_LAST_CHANNEL   13
+
+typedef struct {
+    wifi_ap_info_t info;
+    int64_t seen_us;
+} scan_entry_t;
+
+static scan_entry_t scan_cache[MAX_SCAN_RESULTS];
+static uint16_t scan_cache_count = 0;
+static int64_t scan_cache_time_us = 0;     // End of the last complete sweep
+static int64_t scan_sweep_start_us = 0;
+static uint8_t scan_channel = 0;           // Channel being scanned, 0 = idle
+static volatile uint32_t scan_generation = 0;
+static SemaphoreHandle_t scan_lock = NULL;
+
+// Connection management
+#define CONNECT_FAST_TIMEOUT_MS  5000       // Saved channel + BSSID
+#define CONNECT_FULL_TIMEOUT_MS  15000      // All-channel scan
+static SemaphoreHandle_t connect_lock = NULL;
+static volatile bool connect_in_progress = false;
+static TaskHandle_t autoconnect_task = NULL;
+static volatile bool autoconnect_cancel = false;
+static volatile bool connect_abort = false;     // Ends the attempt in progress early
+static TaskHandle_t connect_task = NULL;        // User-initiated connect
+
+// AP of the current association (from STA_CONNECTED)
+static uint8_t joined_bssid[6];
+static uint8_t joined_channel = 0;
+static uint8_t joined_authmode = 0;
+
+// Timing
+static int64_t connect_start_us = 0;
+static int64_t link_lost_us = 0;
+static wifi_timing_t wifi_timing = { -1, -1, -1, false };
 
 // UI elements that need updating
 static lv_obj_t *time_label = NULL;
@@ -60,6 +100,7 @@ static esp_netif_t *sta_netif = NULL;
 static EventGroupHandle_t wifi_event_group = NULL;
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT      BIT1
+#define WIFI_SCAN_DONE_BIT BIT2
 
 // Disconnect reason to string
 static const char* wifi_disconnect_reason_str(uint8_t reason) {
@@ -102,6 +143,8 @@ static const char* wifi_disconnect_reason_str(uint8_t reason) {
 
 static uint8_t last_disconnect_reason = 0;
 
+static void scan_sweep_step(void);
+
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                int32_t event_id, void* event_data)
 {
@@ -112,6 +155,7 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                 break;
             case WIFI_EVENT_STA_DISCONNECTED: {
                 wifi_event_sta_disconnected_t *event = (wifi_event_sta_disconnected_t *)event_data;
+                TRACE_INSTANT("wifi_disconnected");
                 last_disconnect_reason = event->reason;
                 ESP_LOGW(TAG, "WiFi disconnected! Reason: %d (%s)", 
                          event->reason, wifi_disconnect_reason_str(event->reason));
@@ -120,8 +164,16 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                          event->bssid[0], event->bssid[1], event->bssid[2],
                          event->bssid[3], event->bssid[4], event->bssid[5]);
                 
+                // A drop nobody asked for: reconnect and time how long it takes
+                if (wifi_connected && !connect_in_progress) {
+                    link_lost_us = esp_timer_get_time();
+                    system_wifi_autoconnect();
+                }
+                
                 wifi_connected = false;
                 connected_ssid[0] = '\0';
+                // Pooled sockets are dead now; don't make the next request find out the slow way
+                http_service_close_idle();
                 if (wifi_event_group) {
                     xEventGroupSetBits(wifi_event_group, WIFI_FAIL_BIT);
                 }
@@ -132,12 +184,17 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
             }
             case WIFI_EVENT_STA_CONNECTED: {
                 wifi_event_sta_connected_t *event = (wifi_event_sta_connected_t *)event_data;
+                TRACE_INSTANT("wifi_connected");
                 ESP_LOGI(TAG, "WiFi connected to AP! SSID: %s, Channel: %d", 
                          event->ssid, event->channel);
+                memcpy(joined_bssid, event->bssid, sizeof(joined_bssid));
+                joined_channel = event->channel;
+                joined_authmode = (uint8_t)event->authmode;
                 break;
             }
             case WIFI_EVENT_SCAN_DONE:
-                ESP_LOGI(TAG, "WiFi scan done");
+                ESP_LOGD(TAG, "WiFi scan done (channel %d)", scan_channel);
+                scan_sweep_step();
                 break;
             default:
                 ESP_LOGD(TAG, "WiFi event: %ld", (long)event_id);
@@ -145,9 +202,25 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         }
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
+        TRACE_INSTANT("wifi_got_ip");
         ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&event->ip_info.ip));
         ESP_LOGI(TAG, "  Netmask: " IPSTR, IP2STR(&event->ip_info.netmask));
         ESP_LOGI(TAG, "  Gateway: " IPSTR, IP2STR(&event->ip_info.gw));
+        
+        int64_t now = esp_timer_get_time();
+        if (wifi_timing.boot_to_ip_ms < 0) {
+            wifi_timing.boot_to_ip_ms = (int32_t)(now / 1000);
+            ESP_LOGI(TAG, "  Boot to IP: %ld ms", (long)wifi_timing.boot_to_ip_ms);
+        }
+        if (connect_start_us) {
+            wifi_timing.last_connect_ms = (int32_t)((now - connect_start_us) / 1000);
+            connect_start_us = 0;
+        }
+        if (link_lost_us) {
+            wifi_timing.last_reconnect_ms = (int32_t)((now - link_lost_us) / 1000);
+            link_lost_us = 0;
+            ESP_LOGI(TAG, "  Reconnected after %ld ms", (long)wifi_timing.last_reconnect_ms);
+        }
         wifi_connected = true;
         if (wifi_event_group) {
             xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT);
@@ -264,8 +337,10 @@ int system_wifi_init(void) {
     
     // Create event group for synchronization
     wifi_event_group = xEventGroupCreate();
-    if (!wifi_event_group) {
-        ESP_LOGE(TAG, "Failed to create WiFi event group");
+    scan_lock = xSemaphoreCreateMutex();
+    connect_lock = xSemaphoreCreateMutex();
+    if (!wifi_event_group || !scan_lock || !connect_lock) {
+        ESP_LOGE(TAG, "Failed to create WiFi event group/locks");
         esp_wifi_deinit();
         if (sta_netif) {
             esp_netif_destroy(sta_netif);
@@ -297,66 +372,237 @@ int system_wifi_init(void) {
     return 0;
 }
 
-int system_wifi_scan(wifi_ap_info_t *ap_records, uint16_t *ap_count) {
-    if (!wifi_initialized) {
-        system_wifi_init();
+// ============ WIFI SCAN (incremental, cached) ============
+
+static esp_err_t scan_channel_start(uint8_t channel) {
+    wifi_scan_config_t scan_config = {};
+    scan_config.channel = channel;
+    scan_config.show_hidden = false;
+    scan_config.scan_type = WIFI_SCAN_TYPE_ACTIVE;
+    scan_config.scan_time.active.min = 60;
+    scan_config.scan_time.active.max = 120;
+    return esp_wifi_scan_start(&scan_config, false);
+}
+
+// Merge the records of the channel just scanned into the cache
+static void scan_collect(void) {
+    uint16_t num = 0;
+    esp_wifi_scan_get_ap_num(&num);
+    
+    wifi_ap_record_t *list = num ? (wifi_ap_record_t *)malloc(num * sizeof(wifi_ap_record_t)) : NULL;
+    if (!list) {
+        esp_wifi_clear_ap_list();
+        return;
     }
+    if (esp_wifi_scan_get_ap_records(&num, list) != ESP_OK) num = 0;
     
-    ESP_LOGI(TAG, "Starting WiFi scan...");
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    for (int i = 0; i < num; i++) {
+        if (list[i].ssid[0] == '\0') continue;
     
-    // Configure scan
-    wifi_scan_config_t scan_config = {
-        .ssid = NULL,
-        .bssid = NULL,
-        .channel = 0,
-        .show_hidden = false,
-        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
-        .scan_time = {
-            .active = { .min = 100, .max = 300 }
+        int slot = -1;
+        int weakest = -1;
+        for (int j = 0; j < scan_cache_count; j++) {
+            if (memcmp(scan_cache[j].info.bssid, list[i].bssid, 6) == 0) {
+                slot = j;
+                break;
+            }
+            if (weakest < 0 || scan_cache[j].info.rssi < scan_cache[weakest].info.rssi) weakest = j;
         }
-    };
+        if (slot < 0) {
+            if (scan_cache_count < MAX_SCAN_RESULTS) {
+                slot = scan_cache_count++;
+            } else if (list[i].rssi > scan_cache[weakest].info.rssi) {
+                slot = weakest;
+            } else {
+                continue;
+            }
+        }
+    
+        wifi_ap_info_t *ap = &scan_cache[slot].info;
+        memcpy(ap->ssid, list[i].ssid, 32);
+        ap->ssid[32] = '\0';
+        ap->rssi = list[i].rssi;
+        ap->authmode = (list[i].authmode != WIFI_AUTH_OPEN) ? 1 : 0;
+        memcpy(ap->bssid, list[i].bssid, 6);
+        ap->channel = list[i].primary;
+        scan_cache[slot].seen_us = now;
+    }
+    scan_generation++;
+    xSemaphoreGive(scan_lock);
     
-    // Start scan (blocking)
-    esp_err_t ret = esp_wifi_scan_start(&scan_config, true);
+    free(list);
+}
+
+static void scan_sweep_finish(bool complete) {
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    if (complete) {
+        // Drop APs that did not answer this time
+        uint16_t kept = 0;
+        for (int i = 0; i < scan_cache_count; i++) {
+            if (scan_cache[i].seen_us >= scan_sweep_start_us) scan_cache[kept++] = scan_cache[i];
+        }
+        scan_cache_count = kept;
+        scan_cache_time_us = esp_timer_get_time();
+        ESP_LOGI(TAG, "WiFi scan complete: %d networks in %lld ms", kept,
+                 (long long)((scan_cache_time_us - scan_sweep_start_us) / 1000));
+    }
+    scan_channel = 0;
+    scan_generation++;
+    xSemaphoreGive(scan_lock);
+    xEventGroupSetBits(wifi_event_group, WIFI_SCAN_DONE_BIT);
+}
+
+// Stop the sweep for a connect. Under scan_lock, so scan_sweep_step()
+// cannot start the next channel in between.
+static void scan_sweep_abort(void) {
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    bool sweeping = scan_channel != 0;
+    if (sweeping) {
+        esp_wifi_scan_stop();
+        scan_channel = 0;
+        scan_generation++;
+    }
+    xSemaphoreGive(scan_lock);
+    if (sweeping) xEventGroupSetBits(wifi_event_group, WIFI_SCAN_DONE_BIT);
+}
+
+// Runs on the event loop task after each channel
+static void scan_sweep_step(void) {
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    bool sweeping = scan_channel != 0;
+    xSemaphoreGive(scan_lock);
+    if (!sweeping) {
+        // Not our sweep (or aborted for a connect): just release the records
+        esp_wifi_clear_ap_list();
+        return;
+    }
+    
+    scan_collect();
+    
+    // Check and advance in one step: a connect may have aborted the sweep
+    // while the records were merged
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    if (scan_channel == 0) {
+        xSemaphoreGive(scan_lock);
+        return;
+    }
+    if (scan_channel >= SCAN_LAST_CHANNEL) {
+        xSemaphoreGive(scan_lock);
+        scan_sweep_finish(true);
+        return;
+    }
+    uint8_t channel = ++scan_channel;
+    esp_err_t ret = scan_channel_start(channel);
+    xSemaphoreGive(scan_lock);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "WiFi scan failed: %s", esp_err_to_name(ret));
+        ESP_LOGW(TAG, "WiFi scan stopped at channel %d: %s", channel, esp_err_to_name(ret));
+        scan_sweep_finish(false);
+    }
+}
+
+int system_wifi_scan_start(void) {
+    if (!wifi_initialized && system_wifi_init() != 0) {
         return -1;
     }
     
-    // Get scan results
-    uint16_t num_aps = MAX_SCAN_RESULTS;
-    wifi_ap_record_t ap_list[MAX_SCAN_RESULTS];
-    ESP_ERROR_CHECK(esp_wifi_scan_get_ap_records(&num_aps, ap_list));
-    
-    // Convert to our format
-    uint16_t count = (num_aps < *ap_count) ? num_aps : *ap_count;
-    for (int i = 0; i < count; i++) {
-        memcpy(ap_records[i].ssid, ap_list[i].ssid, 32);
-        ap_records[i].ssid[32] = '\0';
-        ap_records[i].rssi = ap_list[i].rssi;
-        ap_records[i].authmode = (ap_list[i].authmode != WIFI_AUTH_OPEN) ? 1 : 0;
+    // A connect aborts sweeps under the same lock, so none can start behind it
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    if (connect_in_progress) {
+        xSemaphoreGive(scan_lock);
+        return -1;
     }
-    *ap_count = count;
+    if (scan_channel != 0) {
+        xSemaphoreGive(scan_lock);
+        return 0;   // Already sweeping
+    }
+    scan_sweep_start_us = esp_timer_get_time();
+    scan_channel = SCAN_FIRST_CHANNEL;
     
-    ESP_LOGI(TAG, "Found %d networks", count);
+    ESP_LOGI(TAG, "Starting WiFi scan...");
+    xEventGroupClearBits(wifi_event_group, WIFI_SCAN_DONE_BIT);
+    esp_err_t ret = scan_channel_start(SCAN_FIRST_CHANNEL);
+    xSemaphoreGive(scan_lock);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "WiFi scan failed: %s", esp_err_to_name(ret));
+        scan_sweep_finish(false);
+        return -1;
+    }
     return 0;
 }
 
+bool system_wifi_scan_in_progress(void) {
+    return scan_channel != 0;
+}
 
-int system_wifi_connect(const char *ssid, const char *password) {
-    if (!wifi_initialized) {
-        int ret = system_wifi_init();
-        if (ret != 0) {
-            ESP_LOGE(TAG, "WiFi init failed!");
-            return -1;
+uint32_t system_wifi_scan_generation(void) {
+    return scan_generation;
+}
+
+int system_wifi_scan_get_cached(wifi_ap_info_t *ap_records, uint16_t *ap_count, int32_t *age_ms) {
+    if (!scan_lock) {
+        *ap_count = 0;
+        if (age_ms) *age_ms = -1;
+        return -1;
+    }
+    
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    // Strongest first (insertion sort; the cache is small)
+    uint16_t count = 0;
+    for (int i = 0; i < scan_cache_count; i++) {
+        const wifi_ap_info_t *ap = &scan_cache[i].info;
+        int pos = count < *ap_count ? count : *ap_count - 1;
+        if (pos < 0) break;
+        if (count >= *ap_count && ap->rssi <= ap_records[pos].rssi) continue;
+        while (pos > 0 && ap_records[pos - 1].rssi < ap->rssi) {
+            ap_records[pos] = ap_records[pos - 1];
+            pos--;
         }
+        ap_records[pos] = *ap;
+        if (count < *ap_count) count++;
     }
+    if (age_ms) {
+        *age_ms = scan_cache_time_us ? (int32_t)((esp_timer_get_time() - scan_cache_time_us) / 1000) : -1;
+    }
+    xSemaphoreGive(scan_lock);
     
+    *ap_count = count;
+    return 0;
+}
+
+// Blocking scan, kept for callers that want the full list in one go
+int system_wifi_scan(wifi_ap_info_t *ap_records, uint16_t *ap_count) {
+    if (system_wifi_scan_start() != 0) {
+        return -1;
+    }
+    xEventGroupWaitBits(wifi_event_group, WIFI_SCAN_DONE_BIT, pdFALSE, pdFALSE, pdMS_TO_TICKS(10000));
+    system_wifi_scan_get_cached(ap_records, ap_count, NULL);
+    ESP_LOGI(TAG, "Found %d networks", *ap_count);
+    return 0;
+}
+
+// ============ WIFI CONNECT ============
+
+// Caller holds connect_lock. With a hint (saved channel + BSSID) the driver
+// probes that one channel instead of sweeping all of them.
+static int wifi_connect_internal(const char *ssid, const char *password,
+                                 const wifi_credentials_t *hint, int timeout_ms) {
     ESP_LOGI(TAG, "========================================");
     ESP_LOGI(TAG, "Connecting to WiFi: %s", ssid);
     ESP_LOGI(TAG, "  Password length: %d", password ? (int)strlen(password) : 0);
+    if (hint) {
+        ESP_LOGI(TAG, "  Fast connect: channel %d, BSSID %02x:%02x:%02x:%02x:%02x:%02x",
+                 hint->channel, hint->bssid[0], hint->bssid[1], hint->bssid[2],
+                 hint->bssid[3], hint->bssid[4], hint->bssid[5]);
+    }
     ESP_LOGI(TAG, "========================================");
     
+    connect_in_progress = true;
+    
+    // The driver cannot scan and connect at once
+    scan_sweep_abort();
+    
     // Reset last error
     last_disconnect_reason = 0;
     
@@ -391,55 +637,156 @@ int system_wifi_connect(const char *ssid, const char *password) {
     wifi_config.sta.pmf_cfg.capable = true;
     wifi_config.sta.pmf_cfg.required = false;
     
-    // Set scan method to all channels
-    wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
-    wifi_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    if (hint) {
+        wifi_config.sta.channel = hint->channel;
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, hint->bssid, 6);
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        // Set scan method to all channels
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        wifi_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
     
     esp_err_t ret = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "esp_wifi_set_config failed: %s (0x%x)", esp_err_to_name(ret), ret);
+        connect_in_progress = false;
         return -1;
     }
     ESP_LOGI(TAG, "WiFi config set successfully");
     
-    // Clear event bits
+    // Clear event bits; an abort from here on sets WIFI_FAIL_BIT again
     xEventGroupClearBits(wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT);
+    if (connect_abort) {
+        connect_in_progress = false;
+        return -1;
+    }
     
     // Connect
     ESP_LOGI(TAG, "Calling esp_wifi_connect()...");
+    connect_start_us = esp_timer_get_time();
     ret = esp_wifi_connect();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "esp_wifi_connect failed: %s (0x%x)", esp_err_to_name(ret), ret);
+        connect_start_us = 0;
+        connect_in_progress = false;
         return -1;
     }
     
     // Wait for connection (with timeout)
-    ESP_LOGI(TAG, "Waiting for connection (timeout: 15s)...");
+    ESP_LOGI(TAG, "Waiting for connection (timeout: %ds)...", timeout_ms / 1000);
     EventBits_t bits = xEventGroupWaitBits(wifi_event_group,
                                            WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
                                            pdFALSE, pdFALSE,
-                                           pdMS_TO_TICKS(15000));
+                                           pdMS_TO_TICKS(timeout_ms));
+    connect_in_progress = false;
     
     if (bits & WIFI_CONNECTED_BIT) {
         strncpy(connected_ssid, ssid, sizeof(connected_ssid) - 1);
         wifi_connected = true;
-        
+        wifi_timing.last_fast = hint != NULL;
+    
         ESP_LOGI(TAG, "========================================");
-        ESP_LOGI(TAG, "SUCCESS! Connected to: %s", ssid);
+        ESP_LOGI(TAG, "SUCCESS! Connected to: %s (%ld ms%s)", ssid,
+                 (long)wifi_timing.last_connect_ms, hint ? ", fast" : "");
         ESP_LOGI(TAG, "========================================");
-        
+    
         // Sync time via SNTP
         sntp_sync_time();
-        
+        return 0;
+    }
+    
+    connect_start_us = 0;
+    if (!(bits & WIFI_FAIL_BIT)) {
+        // Timed out mid-attempt; stop the driver before the next one
+        esp_wifi_disconnect();
+    }
+    ESP_LOGE(TAG, "========================================");
+    ESP_LOGE(TAG, "FAILED to connect to: %s", ssid);
+    ESP_LOGE(TAG, "  Last disconnect reason: %d (%s)",
+             last_disconnect_reason, wifi_disconnect_reason_str(last_disconnect_reason));
+    if (last_disconnect_reason == 15 || last_disconnect_reason == 204) {
+        ESP_LOGE(TAG, "  >>> LIKELY WRONG PASSWORD! <<<");
+    } else if (last_disconnect_reason == 201) {
+        ESP_LOGE(TAG, "  >>> AP NOT FOUND - check SSID <<<");
+    }
+    ESP_LOGE(TAG, "========================================");
+    return -1;
+}
+
+// Saved channel/BSSID first, full scan if the AP has moved
+static int wifi_connect_saved(const wifi_credentials_t *cred) {
+    if (cred->channel != 0 &&
+        wifi_connect_internal(cred->ssid, cred->password, cred, CONNECT_FAST_TIMEOUT_MS) == 0) {
+        return 0;
+    }
+    if (connect_abort) return -1;
+    return wifi_connect_internal(cred->ssid, cred->password, NULL, CONNECT_FULL_TIMEOUT_MS);
+}
+
+// Stop the background reconnect, including an attempt it is waiting on
+static void wifi_abort_autoconnect(void) {
+    autoconnect_cancel = true;
+    if (!autoconnect_task) return;
+    connect_abort = true;
+    if (connect_in_progress) {
+        esp_wifi_disconnect();
+        xEventGroupSetBits(wifi_event_group, WIFI_FAIL_BIT);
+    }
+}
+
+// Store where the current AP lives so the next connect can skip the scan
+static void wifi_remember_ap(const char *ssid) {
+    if (joined_channel != 0) {
+        settings_set_wifi_ap(ssid, joined_bssid, joined_channel, joined_authmode);
+    }
+}
+
+static void wifi_update_ui_connected(void) {
+    if (wifi_status_label) {
+        lv_label_set_text(wifi_status_label, connected_ssid);
+    }
+    win32_update_wifi(true);
+}
+
+int system_wifi_connect(const char *ssid, const char *password) {
+    if (!wifi_initialized) {
+        int ret = system_wifi_init();
+        if (ret != 0) {
+            ESP_LOGE(TAG, "WiFi init failed!");
+            return -1;
+        }
+    }
+    
+    // An explicit choice wins over a background reconnect
+    wifi_abort_autoconnect();
+    if (xSemaphoreTake(connect_lock, pdMS_TO_TICKS(CONNECT_FAST_TIMEOUT_MS + CONNECT_FULL_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGE(TAG, "WiFi busy, connect to %s not started", ssid);
+        return -1;
+    }
+    connect_abort = false;
+    
+    // Same network and password as saved: try its last channel first
+    wifi_credentials_t saved;
+    int ret = -1;
+    if (settings_find_wifi(ssid, &saved) >= 0 && strcmp(saved.password, password ? password : "") == 0) {
+        ret = wifi_connect_saved(&saved);
+    } else {
+        ret = wifi_connect_internal(ssid, password, NULL, CONNECT_FULL_TIMEOUT_MS);
+    }
+    
+    if (ret == 0) {
         // Update UI
-        if (wifi_status_label) {
-            lv_label_set_text(wifi_status_label, connected_ssid);
+        if (lvgl_port_lock(0)) {
+            wifi_update_ui_connected();
+            lvgl_port_unlock();
         }
-        win32_update_wifi(true);
-        
+    
         // Save credentials to LittleFS (new system)
         settings_save_wifi(ssid, password ? password : "");
-        
+        wifi_remember_ap(ssid);
+    
         // Save credentials to NVS (legacy backup)
         nvs_handle_t nvs;
         if (nvs_open("wifi", NVS_READWRITE, &nvs) == ESP_OK) {
@@ -449,27 +796,111 @@ int system_wifi_connect(const char *ssid, const char *password) {
             nvs_close(nvs);
             ESP_LOGI(TAG, "Credentials saved to NVS");
         }
-        
-        return 0;
-    } else {
-        ESP_LOGE(TAG, "========================================");
-        ESP_LOGE(TAG, "FAILED to connect to: %s", ssid);
-        ESP_LOGE(TAG, "  Last disconnect reason: %d (%s)", 
-                 last_disconnect_reason, wifi_disconnect_reason_str(last_disconnect_reason));
-        if (last_disconnect_reason == 15 || last_disconnect_reason == 204) {
-            ESP_LOGE(TAG, "  >>> LIKELY WRONG PASSWORD! <<<");
-        } else if (last_disconnect_reason == 201) {
-            ESP_LOGE(TAG, "  >>> AP NOT FOUND - check SSID <<<");
-        }
-        ESP_LOGE(TAG, "========================================");
+    }
+    
+    xSemaphoreGive(connect_lock);
+    return ret;
+}
+
+typedef struct {
+    char ssid[33];
+    char password[65];
+    wifi_connect_cb_t cb;
+    void *user;
+} wifi_connect_job_t;
+
+static void wifi_connect_task(void *arg) {
+    wifi_connect_job_t *job = (wifi_connect_job_t *)arg;
+    int ret = system_wifi_connect(job->ssid, job->password);
+    if (job->cb && lvgl_port_lock(0)) {
+        job->cb(job->ssid, ret, job->user);
+        lvgl_port_unlock();
+    }
+    free(job);
+    connect_task = NULL;
+    vTaskDelete(NULL);
+}
+
+// Connects take up to 20 s: keep them off the LVGL thread
+int system_wifi_connect_async(const char *ssid, const char *password, wifi_connect_cb_t cb, void *user) {
+    if (connect_task) {
+        ESP_LOGW(TAG, "WiFi connect already running, %s ignored", ssid);
+        return -1;
+    }
+    
+    wifi_connect_job_t *job = (wifi_connect_job_t *)calloc(1, sizeof(wifi_connect_job_t));
+    if (!job) return -1;
+    strncpy(job->ssid, ssid, sizeof(job->ssid) - 1);
+    strncpy(job->password, password ? password : "", sizeof(job->password) - 1);
+    job->cb = cb;
+    job->user = user;
+    
+    if (xTaskCreate(wifi_connect_task, "wifi_conn", 4096, job, 4, &connect_task) != pdPASS) {
+        connect_task = NULL;
+        free(job);
+        ESP_LOGE(TAG, "Failed to start WiFi connect");
         return -1;
     }
+    return 0;
+}
+
+// ============ AUTO-CONNECT (boot and link loss) ============
+
+static void wifi_autoconnect_task(void *arg) {
+    static const uint16_t backoff_s[] = { 0, 2, 5, 10, 30, 60 };
+    int round = 0;
+    
+    while (!wifi_connected && !autoconnect_cancel) {
+        int count = settings_get_wifi_count();
+        if (count == 0) break;
+    
+        int delay_s = backoff_s[round < 5 ? round : 5];
+        for (int t = 0; t < delay_s * 10 && !autoconnect_cancel; t++) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+        }
+    
+        // Most recently added network first
+        for (int i = count - 1; i >= 0 && !wifi_connected && !autoconnect_cancel; i--) {
+            wifi_credentials_t cred;
+            if (settings_get_wifi(i, &cred) != 0 || !cred.valid) continue;
+    
+            // Someone is connecting by hand; leave it to them
+            if (xSemaphoreTake(connect_lock, 0) != pdTRUE) {
+                autoconnect_cancel = true;
+                break;
+            }
+            int ret = autoconnect_cancel ? -1 : wifi_connect_saved(&cred);
+            if (ret == 0) wifi_remember_ap(cred.ssid);
+            xSemaphoreGive(connect_lock);
+    
+            if (ret == 0 && lvgl_port_lock(100)) {
+                wifi_update_ui_connected();
+                lvgl_port_unlock();
+            }
+        }
+        round++;
+    }
+    
+    autoconnect_task = NULL;
+    vTaskDelete(NULL);
+}
+
+void system_wifi_autoconnect(void) {
+    if (!wifi_initialized || autoconnect_task) return;
+    
+    autoconnect_cancel = false;
+    connect_abort = false;
+    if (xTaskCreate(wifi_autoconnect_task, "wifi_auto", 4096, NULL, 4, &autoconnect_task) != pdPASS) {
+        autoconnect_task = NULL;
+        ESP_LOGE(TAG, "Failed to start WiFi auto-connect");
+    }
 }
 
 // ============ COMMON WIFI FUNCTIONS ============
 
 bool system_wifi_is_connected(void) { return wifi_connected; }
 const char* system_wifi_get_ssid(void) { return connected_ssid; }
+void system_wifi_get_timing(wifi_timing_t *timing) { *timing = wifi_timing; }
 
 // Public function to resync time (call after timezone change)
 void system_time_resync(void) {
@@ -544,6 +975,17 @@ static void systray_settings_clicked(lv_event_t *e) {
     app_launch("settings");
 }
 
+static lv_obj_t *hud_tile = NULL;
+
+static void systray_hud_clicked(lv_event_t *e) {
+    bool on = !perf_hud_is_visible();
+    perf_hud_set_visible(on);
+    settings_set_debug_mode(on);
+    if (hud_tile) {
+        lv_obj_set_style_bg_color(hud_tile, on ? lv_color_hex(0x0078D4) : lv_color_hex(0x3D3D3D), 0);
+    }
+}
+
 static void systray_brightness_changed(lv_event_t *e) {
     lv_obj_t *slider = (lv_obj_t *)lv_event_get_target(e);
     int32_t value = lv_slider_get_value(slider);
@@ -638,10 +1080,13 @@ static void create_systray_panel(void) {
     bt_tile = create_win10_tile(systray_panel, tile_w + gap, start_y, tile_w, tile_h, 
                                  "Bluetooth", false, systray_bt_clicked);
     
-    // Row 2: Settings (full width)
+    // Row 2: Settings, performance HUD
     settings_tile = create_win10_tile(systray_panel, 0, start_y + tile_h + gap, 
-                                       tile_w * 2 + gap, tile_h, 
+                                       tile_w, tile_h, 
                                        "All Settings", false, systray_settings_clicked);
+    hud_tile = create_win10_tile(systray_panel, tile_w + gap, start_y + tile_h + gap,
+                                  tile_w, tile_h,
+                                  "Perf HUD", perf_hud_is_visible(), systray_hud_clicked);
     
     int y_pos = start_y + (tile_h + gap) * 2 + 15;
     
@@ -743,6 +1188,9 @@ void system_tray_show(void) {
         if (wifi_tile) {
             lv_obj_set_style_bg_color(wifi_tile, wifi_connected ? lv_color_hex(0x0078D4) : lv_color_hex(0x3D3D3D), 0);
         }
+        if (hud_tile) {
+            lv_obj_set_style_bg_color(hud_tile, perf_hud_is_visible() ? lv_color_hex(0x0078D4) : lv_color_hex(0x3D3D3D), 0);
+        }
         
         // Update battery
         hw_battery_info_t batt_info;
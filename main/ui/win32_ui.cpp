@@ -16,6 +16,7 @@
 #include "hardware/hardware.h"
 #include "system_settings.h"
 #include "recovery_trigger.h"
+#include "boot_sequence.h"
 #include <time.h>
 #include <string.h>
 
@@ -114,6 +115,9 @@ static void create_debug_app(void);
 static void update_lock_time(void);
 static void update_aod_time(void);
 static void show_lock_recovery_dialog(void);
+static void ensure_lock_screen(void);
+static void ensure_aod_screen(void);
+static void ensure_start_menu(void);
 
 // App definitions - English text for ASCII fonts
 typedef struct {
@@ -154,13 +158,14 @@ void win32_ui_init(void)
 {
     ESP_LOGI(TAG, "Initializing Win32 UI");
     
-    // Create screens
+    int64_t t0 = esp_timer_get_time();
+    
+    // Only boot and desktop are built up front; lock, AOD and the start
+    // menu are created on first use and released again when idle
     create_boot_screen();
     create_desktop_screen();
-    create_lock_screen();
-    create_aod_screen();
     
-    ESP_LOGI(TAG, "UI initialized");
+    ESP_LOGI(TAG, "UI initialized in %lld ms", (esp_timer_get_time() - t0) / 1000);
 }
 
 void win32_set_app_launch_callback(app_launch_cb_t cb)
@@ -266,8 +271,7 @@ static void create_desktop_screen(void)
     // Create taskbar (at bottom)
     create_taskbar();
     
-    // Create start menu (hidden initially)
-    create_start_menu();
+    // Start menu is built on first open (see ensure_start_menu)
 }
 
 // ============ DESKTOP ICONS WITH DRAG & DROP ============
@@ -1569,6 +1573,7 @@ void win32_toggle_start_menu(void)
 
 void win32_show_start_menu(void)
 {
+    if (!start_menu_visible) ensure_start_menu();
     if (start_menu && !start_menu_visible) {
         // Get menu height based on style
         ui_style_t style = settings_get_ui_style();
@@ -1941,7 +1946,23 @@ static void create_debug_app(void)
             color_idx = (color_idx + 1) % 8;
         }
     }, LV_EVENT_CLICKED, NULL);
-    
+
+    // Touch latency calibration button
+    lv_obj_t *latency_btn = lv_btn_create(btn_row);
+    lv_obj_set_size(latency_btn, 90, 36);
+    lv_obj_set_style_bg_color(latency_btn, lv_color_hex(0x8B4513), 0);
+    lv_obj_set_style_radius(latency_btn, 4, 0);
+
+    lv_obj_t *latency_label = lv_label_create(latency_btn);
+    lv_label_set_text(latency_label, "Latency");
+    lv_obj_set_style_text_color(latency_label, lv_color_white(), 0);
+    lv_obj_set_style_text_font(latency_label, UI_FONT, 0);
+    lv_obj_center(latency_label);
+
+    lv_obj_add_event_cb(latency_btn, [](lv_event_t *e) {
+        latency_screen_show();
+    }, LV_EVENT_CLICKED, NULL);
+
     // Interface tests section
     add_info("");
     add_info("=== INTERFACE TESTS ===");
@@ -2277,7 +2298,7 @@ static void create_lock_screen(void)
     
     // Wallpaper (same as desktop, will be updated)
     lock_wallpaper = lv_image_create(scr_lock);
-    lv_image_set_src(lock_wallpaper, &img_win7);  // Default to Win7 wallpaper
+    lv_image_set_src(lock_wallpaper, wallpapers[current_wallpaper_index].image);
     lv_obj_set_size(lock_wallpaper, SCREEN_WIDTH, SCREEN_HEIGHT);
     lv_image_set_inner_align(lock_wallpaper, LV_IMAGE_ALIGN_STRETCH);
     lv_obj_align(lock_wallpaper, LV_ALIGN_TOP_LEFT, 0, 0);
@@ -2557,11 +2578,6 @@ static void create_lock_screen(void)
         }
     }, LV_EVENT_VALUE_CHANGED, NULL);
     
-    // Create timer for updating time
-    if (!lock_timer) {
-        lock_timer = lv_timer_create(lock_timer_cb, 1000, NULL);
-    }
-    
     update_lock_time();
     ESP_LOGI(TAG, "Lock screen created");
 }
@@ -2774,10 +2790,168 @@ void win32_show_recovery_dialog(void)
     lv_obj_center(no_label);
 }
 
+// ============ LAZY SCREENS ============
+// Lock, AOD and the start menu are built on first use. A reaper timer tears
+// them down once they have been unused for a while; when heap runs low the
+// idle timeout shrinks so their LVGL memory is handed back sooner.
+
+#define LAZY_REAPER_PERIOD_MS       5000
+#define LAZY_IDLE_TIMEOUT_MS        120000
+#define LAZY_PRESSURE_TIMEOUT_MS    10000
+#define LAZY_PRESSURE_INTERNAL_FREE (48 * 1024)
+#define LAZY_PRESSURE_PSRAM_FREE    (1024 * 1024)
+
+static uint32_t lock_last_used = 0;
+static uint32_t aod_last_used = 0;
+static uint32_t start_menu_last_used = 0;
+static lv_timer_t *lazy_reaper_timer = NULL;
+
+static void lazy_reaper_cb(lv_timer_t *timer);
+
+static void lazy_update_timers(void)
+{
+    // Clock refresh is only needed while a lock or AOD screen exists
+    if ((scr_lock || scr_aod) && !lock_timer) {
+        lock_timer = lv_timer_create(lock_timer_cb, 1000, NULL);
+    } else if (!scr_lock && !scr_aod && lock_timer) {
+        lv_timer_delete(lock_timer);
+        lock_timer = NULL;
+    }
+    
+    if ((scr_lock || scr_aod || start_menu) && !lazy_reaper_timer) {
+        lazy_reaper_timer = lv_timer_create(lazy_reaper_cb, LAZY_REAPER_PERIOD_MS, NULL);
+    } else if (!scr_lock && !scr_aod && !start_menu && lazy_reaper_timer) {
+        lv_timer_delete(lazy_reaper_timer);
+        lazy_reaper_timer = NULL;
+    }
+}
+
+static void ensure_lock_screen(void)
+{
+    if (!scr_lock) {
+        int64_t t0 = esp_timer_get_time();
+        create_lock_screen();
+        ESP_LOGI(TAG, "Lock screen built in %lld us", esp_timer_get_time() - t0);
+        lazy_update_timers();
+    }
+    lock_last_used = lv_tick_get();
+}
+
+static void ensure_aod_screen(void)
+{
+    if (!scr_aod) {
+        int64_t t0 = esp_timer_get_time();
+        create_aod_screen();
+        ESP_LOGI(TAG, "AOD screen built in %lld us", esp_timer_get_time() - t0);
+        lazy_update_timers();
+    }
+    aod_last_used = lv_tick_get();
+}
+
+static void ensure_start_menu(void)
+{
+    if (!start_menu) {
+        int64_t t0 = esp_timer_get_time();
+        create_start_menu();  // Current UI style only
+        ESP_LOGI(TAG, "Start menu built in %lld us", esp_timer_get_time() - t0);
+        lazy_update_timers();
+    }
+    start_menu_last_used = lv_tick_get();
+}
+
+static void destroy_lock_screen(void)
+{
+    if (!scr_lock || lv_screen_active() == scr_lock) return;
+    
+    lv_obj_delete(scr_lock);
+    scr_lock = NULL;
+    lock_time_label = NULL;
+    lock_date_label = NULL;
+    lock_swipe_hint = NULL;
+    lock_avatar_cont = NULL;
+    lock_avatar_letter = NULL;
+    lock_username_label = NULL;
+    lock_wallpaper = NULL;
+    lock_overlay = NULL;
+    lock_slide_container = NULL;
+    lock_slider_bar = NULL;
+    lock_slider_handle = NULL;
+    lock_slider_dragging = false;
+    lock_pin_container = NULL;
+    lock_password_container = NULL;
+    memset(lock_pin_dots, 0, sizeof(lock_pin_dots));
+    lock_pin_error_label = NULL;
+    lock_password_textarea = NULL;
+    lock_password_keyboard = NULL;
+    lock_password_error_label = NULL;
+    lock_recovery_dialog = NULL;
+    memset(lock_pin_buffer, 0, sizeof(lock_pin_buffer));
+    lock_pin_length = 0;
+    
+    ESP_LOGI(TAG, "Lock screen released");
+    lazy_update_timers();
+}
+
+static void destroy_aod_screen(void)
+{
+    if (!scr_aod || lv_screen_active() == scr_aod) return;
+    
+    lv_obj_delete(scr_aod);
+    scr_aod = NULL;
+    aod_time_label = NULL;
+    
+    ESP_LOGI(TAG, "AOD screen released");
+    lazy_update_timers();
+}
+
+static void destroy_start_menu(void)
+{
+    if (!start_menu || start_menu_visible) return;
+    
+    lv_anim_delete(start_menu, NULL);
+    lv_obj_delete(start_menu);
+    start_menu = NULL;
+    start_menu_avatar = NULL;
+    start_menu_avatar_letter = NULL;
+    start_menu_username = NULL;
+    
+    ESP_LOGI(TAG, "Start menu released");
+    lazy_update_timers();
+}
+
+static bool lazy_memory_pressure(void)
+{
+    return heap_caps_get_free_size(MALLOC_CAP_INTERNAL) < LAZY_PRESSURE_INTERNAL_FREE ||
+           heap_caps_get_free_size(MALLOC_CAP_SPIRAM) < LAZY_PRESSURE_PSRAM_FREE;
+}
+
+static void lazy_reaper_cb(lv_timer_t *timer)
+{
+    uint32_t timeout = lazy_memory_pressure() ? LAZY_PRESSURE_TIMEOUT_MS : LAZY_IDLE_TIMEOUT_MS;
+    lv_obj_t *active = lv_screen_active();
+    
+    // A screen that is showing counts as in use
+    if (scr_lock && active == scr_lock) lock_last_used = lv_tick_get();
+    if (scr_aod && active == scr_aod) aod_last_used = lv_tick_get();
+    if (start_menu && start_menu_visible) start_menu_last_used = lv_tick_get();
+    
+    if (scr_lock && lv_tick_elaps(lock_last_used) > timeout) destroy_lock_screen();
+    if (scr_aod && lv_tick_elaps(aod_last_used) > timeout) destroy_aod_screen();
+    if (start_menu && lv_tick_elaps(start_menu_last_used) > timeout) destroy_start_menu();
+}
+
+void win32_ui_release_idle_screens(void)
+{
+    destroy_lock_screen();
+    destroy_aod_screen();
+    destroy_start_menu();
+}
+
 // ============ SCREEN STATE MANAGEMENT ============
 
 void win32_show_lock(void)
 {
+    ensure_lock_screen();
     if (scr_lock) {
         // Update user profile on lock screen
         if (lock_avatar_cont) {
@@ -2839,11 +3013,20 @@ void win32_show_lock(void)
         current_screen_state = SCREEN_STATE_LOCK;
         hw_backlight_set(80);  // Normal brightness
         ESP_LOGI(TAG, "Showing lock screen");
+        boot_timeline_mark_lock_screen();  // No-op after the first lock of this boot
+        
+        // Boot animation only plays once - free it after the first lock screen
+        if (scr_boot) {
+            lv_obj_delete(scr_boot);
+            scr_boot = NULL;
+            boot_anim_img = NULL;
+        }
     }
 }
 
 void win32_show_aod(void)
 {
+    ensure_aod_screen();
     if (scr_aod) {
         update_aod_time();
         lv_screen_load(scr_aod);
@@ -35,9 +35,19 @@
 typedef struct {
     uint8_t ssid[33];
     int8_t rssi;
-    uint8_t authmode;
+    uint8_t authmode;       // 0 = open, 1 = secured
+    uint8_t bssid[6];
+    uint8_t channel;
 } wifi_ap_info_t;
 
+// Connection timings in ms (-1 = not measured yet)
+typedef struct {
+    int32_t boot_to_ip_ms;      // Power-on to first IP
+    int32_t last_connect_ms;    // Last connect attempt to IP
+    int32_t last_reconnect_ms;  // Link drop to IP again
+    bool last_fast;             // Last connect used the saved channel/BSSID
+} wifi_timing_t;
+
 // All functions - no extern "C" needed for C++ only project
 void win32_ui_init(void);
 void win32_show_boot_screen(void);
@@ -54,6 +64,7 @@ void win32_show_start_menu(void);
 void win32_hide_start_menu(void);
 bool win32_is_start_menu_visible(void);
 void win32_refresh_start_menu_user(void);  // Refresh user profile in start menu
+void win32_ui_release_idle_screens(void);   // Free lock/AOD/start menu now if not showing
 void win32_update_time(void);
 void win32_update_wifi(bool connected);
 void win32_update_battery(uint8_t level, bool charging);
@@ -114,9 +125,25 @@ void system_tray_show(void);
 void system_tray_hide(void);
 bool system_tray_is_visible(void);
 
+// Performance HUD (FPS, render time, CPU, heap) above everything else
+void perf_hud_set_visible(bool visible);
+bool perf_hud_is_visible(void);
+
+// Touch latency calibration screen (Debug app)
+void latency_screen_show(void);
+
 int system_wifi_init(void);
 int system_wifi_scan(wifi_ap_info_t *ap_records, uint16_t *ap_count);
-int system_wifi_connect(const char *ssid, const char *password);
+int system_wifi_scan_start(void);       // Non-blocking, one channel at a time
+bool system_wifi_scan_in_progress(void);
+uint32_t system_wifi_scan_generation(void);  // Bumped whenever the cache changes
+int system_wifi_scan_get_cached(wifi_ap_info_t *ap_records, uint16_t *ap_count, int32_t *age_ms);
+void system_wifi_autoconnect(void);     // Join the best saved network in the background
+void system_wifi_get_timing(wifi_timing_t *timing);
+int system_wifi_connect(const char *ssid, const char *password);  // Blocks up to 20 s: not on the LVGL thread
+// Connect on a task; cb (may be NULL) then runs with the LVGL lock held
+typedef void (*wifi_connect_cb_t)(const char *ssid, int result, void *user);
+int system_wifi_connect_async(const char *ssid, const char *password, wifi_connect_cb_t cb, void *user);
 bool system_wifi_is_connected(void);
 const char* system_wifi_get_ssid(void);
 uint8_t system_wifi_get_last_error(void);
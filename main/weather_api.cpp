@@ -4,178 +4,204 @@
  */
 
 #include "weather_api.h"
+#include "weather_parse.h"
 #include "system_settings.h"
+#include "ui/win32_ui.h"
 #include "lvgl.h"
 #include "esp_log.h"
-#include "esp_http_client.h"
-#include "cJSON.h"
+#include "esp_timer.h"
+#include "http_service.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
 #include <time.h>
 #include <sys/time.h>
 
 static const char *TAG = "WEATHER_API";
 
+#define WEATHER_FRESH_S             (30 * 60)   // Cache considered fresh for 30 min
+#define WEATHER_BACKOFF_MIN_S       30
+#define WEATHER_BACKOFF_MAX_S       (30 * 60)
+#define WEATHER_WIFI_POLL_MS        5000
+#define WEATHER_TASK_STACK          8192
+#define WEATHER_CLOCK_VALID         1700000000  // Earlier wall-clock times mean SNTP hasn't synced
+
+#define WEATHER_CACHE_TMP_PATH      "/littlefs/weather.tmp"
+#define WEATHER_CACHE_MAGIC         0x52485457  // "WTHR"
+#define WEATHER_CACHE_VERSION       1
+
+// LittleFS cache file header; size guards against weather_data_t layout changes
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+} weather_cache_header_t;
+
 // Cached weather data
 static weather_data_t cached_weather = {0};
 static bool initialized = false;
+static SemaphoreHandle_t cache_mutex = NULL;
+static int64_t last_fetch_us = 0;           // esp_timer time of last fetch this boot
+
+// Background refresh state (guarded by cache_mutex)
+static TaskHandle_t refresh_task = NULL;
+static bool refresh_pending = false;
+static bool refresh_force = false;
+static uint32_t backoff_s = 0;
+static int64_t next_attempt_us = 0;
+static weather_update_cb_t update_cb = NULL;
 
-// HTTP response buffer
-#define HTTP_BUFFER_SIZE 4096
-static char *http_buffer = NULL;
-static int http_buffer_len = 0;
+// ============ HTTP ============
 
-// HTTP event handler
-static esp_err_t http_event_handler(esp_http_client_event_t *evt)
+static int weather_http_headers(int status, int64_t content_length, void *user)
 {
-    switch (evt->event_id) {
-        case HTTP_EVENT_ON_DATA:
-            // Handle both chunked and non-chunked responses
-            if (http_buffer && (http_buffer_len + evt->data_len < HTTP_BUFFER_SIZE - 1)) {
-                memcpy(http_buffer + http_buffer_len, evt->data, evt->data_len);
-                http_buffer_len += evt->data_len;
-                http_buffer[http_buffer_len] = '\0';
-            }
-            break;
-        default:
-            break;
+    (void)content_length;
+    (void)user;
+    return status == 200 ? 0 : -1;     // Don't feed error pages to the parser
+}
+
+// Body chunks go straight into the parser
+static int weather_http_body(const char *data, size_t len, void *user)
+{
+    return json_stream_feed((json_stream_t *)user, data, len);
+}
+
+// ============ PERSISTENT CACHE ============
+
+static void cache_save(const weather_data_t *data)
+{
+    FILE *f = fopen(WEATHER_CACHE_TMP_PATH, "wb");
+    if (!f) {
+        ESP_LOGW(TAG, "Cannot write weather cache");
+        return;
     }
-    return ESP_OK;
+
+    weather_cache_header_t hdr = {WEATHER_CACHE_MAGIC, WEATHER_CACHE_VERSION, (uint16_t)sizeof(weather_data_t)};
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+              fwrite(data, sizeof(weather_data_t), 1, f) == 1;
+    ok = (fclose(f) == 0) && ok;
+
+    // Write-then-rename so a power cut never leaves a torn cache behind
+    if (!ok || rename(WEATHER_CACHE_TMP_PATH, WEATHER_CACHE_PATH) != 0) {
+        ESP_LOGW(TAG, "Failed to save weather cache");
+        remove(WEATHER_CACHE_TMP_PATH);
+    }
+}
+
+static bool cache_load(weather_data_t *data)
+{
+    FILE *f = fopen(WEATHER_CACHE_PATH, "rb");
+    if (!f) return false;
+
+    weather_cache_header_t hdr;
+    bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1 &&
+              hdr.magic == WEATHER_CACHE_MAGIC &&
+              hdr.version == WEATHER_CACHE_VERSION &&
+              hdr.size == sizeof(weather_data_t) &&
+              fread(data, sizeof(weather_data_t), 1, f) == 1;
+    fclose(f);
+
+    if (!ok || !data->valid ||
+        data->daily_count > WEATHER_DAILY_MAX || data->hourly_count > WEATHER_HOURLY_MAX) {
+        ESP_LOGW(TAG, "Ignoring invalid weather cache");
+        memset(data, 0, sizeof(*data));
+        return false;
+    }
+    return true;
+}
+
+static void current_location(float *lat, float *lon)
+{
+    location_settings_t *loc = settings_get_location();
+    if (!loc || !loc->valid) {
+        // No location set, use Moscow
+        *lat = 55.7558f;
+        *lon = 37.6173f;
+    } else {
+        *lat = loc->latitude;
+        *lon = loc->longitude;
+    }
+}
+
+static bool matches_location(const weather_data_t *data)
+{
+    float lat, lon;
+    current_location(&lat, &lon);
+    return data->valid && fabsf(data->latitude - lat) < 0.01f && fabsf(data->longitude - lon) < 0.01f;
 }
 
 void weather_api_init(void)
 {
     if (initialized) return;
-    
+
+    cache_mutex = xSemaphoreCreateMutex();
     memset(&cached_weather, 0, sizeof(cached_weather));
     cached_weather.valid = false;
     initialized = true;
-    
-    ESP_LOGI(TAG, "Weather API initialized");
+
+    if (cache_load(&cached_weather)) {
+        ESP_LOGI(TAG, "Weather API initialized, cached data for %s", cached_weather.city_name);
+    } else {
+        ESP_LOGI(TAG, "Weather API initialized");
+    }
 }
 
+// ============ FETCH ============
+
 int weather_api_fetch(float latitude, float longitude, weather_data_t *data)
 {
     if (!data) return ESP_ERR_INVALID_ARG;
-    
-    // Allocate HTTP buffer
-    http_buffer = (char*)malloc(HTTP_BUFFER_SIZE);
-    if (!http_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate HTTP buffer");
-        return ESP_ERR_NO_MEM;
-    }
-    http_buffer_len = 0;
-    http_buffer[0] = '\0';
-    
-    // Build URL
+
+    // Build URL - unix timestamps avoid parsing ISO dates on device
     char url[512];
     snprintf(url, sizeof(url),
         "https://api.open-meteo.com/v1/forecast?"
         "latitude=%.4f&longitude=%.4f"
         "&current=temperature_2m,relative_humidity_2m,apparent_temperature,weather_code,wind_speed_10m,surface_pressure"
+        "&hourly=temperature_2m,weather_code,precipitation_probability&forecast_hours=%d"
         "&daily=weather_code,temperature_2m_max,temperature_2m_min"
-        "&timezone=auto&forecast_days=7",
-        latitude, longitude);
-    
+        "&timezone=auto&timeformat=unixtime&forecast_days=%d",
+        latitude, longitude, WEATHER_HOURLY_MAX, WEATHER_DAILY_MAX);
+
     ESP_LOGI(TAG, "Fetching weather from: %s", url);
-    
-    // Configure HTTP client with SSL - skip certificate verification for Open-Meteo
-    esp_http_client_config_t config = {};
-    config.url = url;
-    config.event_handler = http_event_handler;
-    config.timeout_ms = 15000;
-    config.buffer_size = 2048;
-    // Disable SSL certificate verification completely
-    config.cert_pem = NULL;
-    config.use_global_ca_store = false;
-    config.skip_cert_common_name_check = true;
-    config.transport_type = HTTP_TRANSPORT_OVER_SSL;
-    // Tell mbedtls to skip server verification
-    config.crt_bundle_attach = NULL;
-    
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (!client) {
-        free(http_buffer);
-        http_buffer = NULL;
-        ESP_LOGE(TAG, "Failed to init HTTP client");
-        return ESP_FAIL;
-    }
-    
-    // Perform request
-    esp_err_t err = esp_http_client_perform(client);
-    int status_code = esp_http_client_get_status_code(client);
-    esp_http_client_cleanup(client);
-    
-    if (err != ESP_OK || status_code != 200) {
-        ESP_LOGE(TAG, "HTTP request failed: err=%d, status=%d", err, status_code);
-        free(http_buffer);
-        http_buffer = NULL;
+
+    json_stream_t parser;
+    weather_parse_begin(&parser, data);
+
+    // Shared client keeps the TLS connection to Open-Meteo alive between refreshes
+    http_service_request_t req = {};
+    req.url = url;
+    req.timeout_ms = 15000;
+    req.on_headers = weather_http_headers;
+    req.on_body = weather_http_body;
+    req.user = &parser;
+
+    http_service_result_t result = {};
+    esp_err_t err = http_service_perform(&req, &result);
+
+    if (err != ESP_OK || result.status != 200) {
+        ESP_LOGE(TAG, "HTTP request failed: err=%d, status=%d", err, result.status);
         return ESP_FAIL;
     }
-    
-    ESP_LOGI(TAG, "Received %d bytes", http_buffer_len);
-    
-    // Parse JSON
-    cJSON *root = cJSON_Parse(http_buffer);
-    free(http_buffer);
-    http_buffer = NULL;
-    
-    if (!root) {
-        ESP_LOGE(TAG, "Failed to parse JSON");
+
+    ESP_LOGI(TAG, "Received %u bytes in %lld ms%s", (unsigned)parser.bytes,
+             (long long)(result.elapsed_us / 1000), result.reused ? " (connection reused)" : "");
+
+    if (!weather_parse_end(&parser, data)) {
+        ESP_LOGE(TAG, "Failed to parse JSON (%s)", parser.error ? "syntax error" : "truncated");
         return ESP_FAIL;
     }
-    
-    // Parse current weather
-    cJSON *current = cJSON_GetObjectItem(root, "current");
-    if (current) {
-        cJSON *temp = cJSON_GetObjectItem(current, "temperature_2m");
-        cJSON *apparent = cJSON_GetObjectItem(current, "apparent_temperature");
-        cJSON *humidity = cJSON_GetObjectItem(current, "relative_humidity_2m");
-        cJSON *wind = cJSON_GetObjectItem(current, "wind_speed_10m");
-        cJSON *pressure = cJSON_GetObjectItem(current, "surface_pressure");
-        cJSON *code = cJSON_GetObjectItem(current, "weather_code");
-        
-        if (temp) data->current.temperature = (float)temp->valuedouble;
-        if (apparent) data->current.apparent_temperature = (float)apparent->valuedouble;
-        if (humidity) data->current.humidity = (float)humidity->valuedouble;
-        if (wind) data->current.wind_speed = (float)wind->valuedouble;
-        if (pressure) data->current.pressure = (float)pressure->valuedouble;
-        if (code) data->current.weather_code = (weather_code_t)code->valueint;
-    }
 
-    // Parse daily forecast
-    cJSON *daily = cJSON_GetObjectItem(root, "daily");
-    if (daily) {
-        cJSON *codes = cJSON_GetObjectItem(daily, "weather_code");
-        cJSON *temps_max = cJSON_GetObjectItem(daily, "temperature_2m_max");
-        cJSON *temps_min = cJSON_GetObjectItem(daily, "temperature_2m_min");
-        
-        if (codes && temps_max && temps_min) {
-            int count = cJSON_GetArraySize(codes);
-            if (count > 7) count = 7;
-            data->daily_count = count;
-            
-            for (int i = 0; i < count; i++) {
-                cJSON *code = cJSON_GetArrayItem(codes, i);
-                cJSON *tmax = cJSON_GetArrayItem(temps_max, i);
-                cJSON *tmin = cJSON_GetArrayItem(temps_min, i);
-                
-                if (code) data->daily[i].weather_code = (weather_code_t)code->valueint;
-                if (tmax) data->daily[i].temp_max = (float)tmax->valuedouble;
-                if (tmin) data->daily[i].temp_min = (float)tmin->valuedouble;
-                
-                // Set day name
-                strncpy(data->daily[i].day_name, weather_get_day_name(i), 3);
-                data->daily[i].day_name[3] = '\0';
-            }
-        }
-    }
-    
-    cJSON_Delete(root);
-    
     // Set metadata
     data->valid = true;
     data->fetch_time = time(NULL);
-    
+    data->latitude = latitude;
+    data->longitude = longitude;
+
     // Copy city name from settings
     location_settings_t *loc = settings_get_location();
     if (loc && loc->valid) {
@@ -183,13 +209,20 @@ int weather_api_fetch(float latitude, float longitude, weather_data_t *data)
     } else {
         snprintf(data->city_name, sizeof(data->city_name), "Unknown");
     }
-    
+
     // Update cache
+    weather_api_init();
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
     memcpy(&cached_weather, data, sizeof(weather_data_t));
-    
-    ESP_LOGI(TAG, "Weather fetched: %.1f°C, code=%d, city=%s", 
-             data->current.temperature, data->current.weather_code, data->city_name);
-    
+    last_fetch_us = esp_timer_get_time();
+    xSemaphoreGive(cache_mutex);
+
+    cache_save(data);
+
+    ESP_LOGI(TAG, "Weather fetched: %.1f°C, code=%d, %d days, %d hours, city=%s",
+             data->current.temperature, data->current.weather_code,
+             data->daily_count, data->hourly_count, data->city_name);
+
     return ESP_OK;
 }
 
@@ -198,13 +231,135 @@ weather_data_t* weather_api_get_cached(void)
     return &cached_weather;
 }
 
-bool weather_api_cache_valid(void)
+bool weather_api_get_snapshot(weather_data_t *out)
 {
-    if (!cached_weather.valid) return false;
-    
-    // Cache valid for 30 minutes
+    if (!out || !initialized) return false;
+
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    bool ok = matches_location(&cached_weather);
+    if (ok) memcpy(out, &cached_weather, sizeof(*out));
+    xSemaphoreGive(cache_mutex);
+    return ok;
+}
+
+int weather_api_cache_age(void)
+{
+    if (!cached_weather.valid) return -1;
+
+    if (last_fetch_us) {
+        return (int)((esp_timer_get_time() - last_fetch_us) / 1000000);
+    }
+
+    // Loaded from LittleFS - only the wall clock can tell how old it is
     int64_t now = time(NULL);
-    return (now - cached_weather.fetch_time) < (30 * 60);
+    if (now < WEATHER_CLOCK_VALID || cached_weather.fetch_time > now) return -1;
+    return (int)(now - cached_weather.fetch_time);
+}
+
+bool weather_api_cache_valid(void)
+{
+    int age = weather_api_cache_age();
+    return age >= 0 && age < WEATHER_FRESH_S && matches_location(&cached_weather);
+}
+
+// ============ BACKGROUND REFRESH ============
+
+static void weather_refresh_task(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        if (!system_wifi_is_connected()) {
+            // Park until Wi-Fi is up; a new request re-checks immediately
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WEATHER_WIFI_POLL_MS));
+            continue;
+        }
+
+        xSemaphoreTake(cache_mutex, portMAX_DELAY);
+        if (!refresh_force && weather_api_cache_valid()) {
+            // A request queued during the last fetch is already satisfied
+            refresh_pending = false;
+            refresh_task = NULL;
+            xSemaphoreGive(cache_mutex);
+            break;
+        }
+        int64_t wait_us = refresh_force ? 0 : next_attempt_us - esp_timer_get_time();
+        if (wait_us <= 0) {
+            refresh_force = false;
+            refresh_pending = false;
+        }
+        xSemaphoreGive(cache_mutex);
+
+        if (wait_us > 0) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_us / 1000 + 1));
+            continue;
+        }
+
+        float lat, lon;
+        current_location(&lat, &lon);
+
+        weather_data_t *data = (weather_data_t *)malloc(sizeof(weather_data_t));
+        int ret = data ? weather_api_fetch(lat, lon, data) : ESP_ERR_NO_MEM;
+        free(data);
+
+        xSemaphoreTake(cache_mutex, portMAX_DELAY);
+        if (ret == ESP_OK) {
+            backoff_s = 0;
+            next_attempt_us = 0;
+        } else {
+            backoff_s = backoff_s ? backoff_s * 2 : WEATHER_BACKOFF_MIN_S;
+            if (backoff_s > WEATHER_BACKOFF_MAX_S) backoff_s = WEATHER_BACKOFF_MAX_S;
+            next_attempt_us = esp_timer_get_time() + (int64_t)backoff_s * 1000000;
+            refresh_pending = true;
+            ESP_LOGW(TAG, "Refresh failed, retrying in %lu s", (unsigned long)backoff_s);
+        }
+        weather_update_cb_t cb = update_cb;
+        bool done = !refresh_pending;
+        if (done) refresh_task = NULL;
+        xSemaphoreGive(cache_mutex);
+
+        if (cb) cb(ret == ESP_OK);
+        if (done) break;
+    }
+
+    vTaskDelete(NULL);
+}
+
+void weather_api_request_refresh(bool force)
+{
+    weather_api_init();
+
+    if (!force && weather_api_cache_valid()) return;
+
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    refresh_pending = true;
+    refresh_force = refresh_force || force;
+    TaskHandle_t task = refresh_task;
+    if (!task) {
+        if (xTaskCreate(weather_refresh_task, "weather_refresh", WEATHER_TASK_STACK, NULL, 5,
+                        &refresh_task) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create refresh task");
+            refresh_task = NULL;
+            refresh_pending = false;
+        }
+    }
+    xSemaphoreGive(cache_mutex);
+
+    if (task) xTaskNotifyGive(task);
+}
+
+bool weather_api_is_refreshing(void)
+{
+    return refresh_task != NULL;
+}
+
+void weather_api_set_update_cb(weather_update_cb_t cb)
+{
+    weather_api_init();
+
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    update_cb = cb;
+    xSemaphoreGive(cache_mutex);
 }
 
 const char* weather_code_to_string(weather_code_t code)
@@ -282,6 +437,20 @@ const char* weather_code_to_icon(weather_code_t code)
     }
 }
 
+const char* weather_day_label(const weather_data_t *data, int index)
+{
+    if (!data || index < 0 || index >= data->daily_count) return "---";
+
+    // Compare calendar days at the forecast location, so a cache from
+    // yesterday still labels its days correctly
+    int64_t day = (data->daily[index].time + data->utc_offset) / 86400;
+    int64_t today = ((int64_t)time(NULL) + data->utc_offset) / 86400;
+
+    if (day == today) return "Today";
+    if (day == today + 1) return "Tmrw";
+    return data->daily[index].day_name;
+}
+
 const char* weather_get_day_name(int day_offset)
 {
     static const char* days[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
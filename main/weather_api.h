@@ -1,6 +1,10 @@
 /**
  * Weather API - Open-Meteo Integration
  * Free weather API without API key
+ *
+ * The last good response is kept in LittleFS so the app can show it
+ * immediately after boot; refreshes run on a background task that waits
+ * for Wi-Fi and backs off exponentially on failure.
  */
 
 #ifndef WEATHER_API_H
@@ -9,6 +13,10 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#define WEATHER_DAILY_MAX       7
+#define WEATHER_HOURLY_MAX      24
+#define WEATHER_CACHE_PATH      "/littlefs/weather.bin"
+
 // Weather codes from Open-Meteo (WMO codes)
 typedef enum {
     WEATHER_CLEAR = 0,
@@ -58,31 +66,69 @@ typedef struct {
     float temp_min;             // °C
     weather_code_t weather_code;
     char day_name[4];           // "Mon", "Tue", etc.
+    int64_t time;               // Unix timestamp of local midnight
 } daily_forecast_t;
 
+// Hourly forecast data
+typedef struct {
+    int64_t time;               // Unix timestamp of the hour
+    float temperature;          // °C
+    weather_code_t weather_code;
+    uint8_t precipitation_prob; // %
+} hourly_forecast_t;
+
 // Complete weather data
 typedef struct {
     current_weather_t current;
-    daily_forecast_t daily[7];  // 7-day forecast
+    daily_forecast_t daily[WEATHER_DAILY_MAX];      // 7-day forecast
     int daily_count;
+    hourly_forecast_t hourly[WEATHER_HOURLY_MAX];   // Next 24 hours
+    int hourly_count;
     char city_name[64];
+    float latitude;             // Location the data was fetched for
+    float longitude;
+    int32_t utc_offset;         // Seconds, for local dates of the location
     bool valid;
     int64_t fetch_time;         // When data was fetched
 } weather_data_t;
 
-// Initialize weather API (call once)
+// Called from the refresh task when a refresh finishes
+typedef void (*weather_update_cb_t)(bool ok);
+
+// Initialize weather API and load the LittleFS cache (safe to call again)
 void weather_api_init(void);
 
 // Fetch weather data (blocking, call from task)
+// Streams the response into data and updates both caches
 // Returns ESP_OK on success
 int weather_api_fetch(float latitude, float longitude, weather_data_t *data);
 
 // Get cached weather data (non-blocking)
 weather_data_t* weather_api_get_cached(void);
 
-// Check if cached data is valid (not older than 30 min)
+// Copy the cached data for the current location, even if stale
+// Returns false if there is nothing to show
+bool weather_api_get_snapshot(weather_data_t *out);
+
+// Check if cached data is valid (not older than 30 min, same location)
 bool weather_api_cache_valid(void);
 
+// Age of the cached data in seconds, -1 if unknown (no data or clock not set)
+int weather_api_cache_age(void);
+
+// Start a background refresh; without force it is skipped while the cache
+// is fresh and waits out the current backoff. Never blocks.
+void weather_api_request_refresh(bool force);
+
+// Check if a refresh request is being processed
+bool weather_api_is_refreshing(void);
+
+// Set the refresh completion callback (NULL to clear)
+void weather_api_set_update_cb(weather_update_cb_t cb);
+
+// "Today", "Tmrw" or the weekday name of a forecast day
+const char* weather_day_label(const weather_data_t *data, int index);
+
 // Get weather description string from code
 const char* weather_code_to_string(weather_code_t code);
 
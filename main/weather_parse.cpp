@@ -0,0 +1,102 @@
+/**
+ * Win32 OS - Open-Meteo Response Parser Implementation
+ * One table row per requested field: its JSON path, where it goes in
+ * weather_data_t and how to convert it
+ */
+
+#include "weather_parse.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <time.h>
+
+typedef enum { WF_CURRENT, WF_DAILY, WF_HOURLY } weather_series_t;
+typedef enum { WF_FLOAT, WF_CODE, WF_TIME, WF_PERCENT } weather_field_type_t;
+
+typedef struct {
+    const char *path;
+    uint8_t series;             // weather_series_t
+    uint8_t type;               // weather_field_type_t
+    uint16_t offset;            // Into weather_data_t, daily_forecast_t or hourly_forecast_t
+} weather_field_t;
+
+static const weather_field_t weather_fields[] = {
+    {"current.time",                        WF_CURRENT, WF_TIME,    offsetof(weather_data_t, current.timestamp)},
+    {"current.temperature_2m",              WF_CURRENT, WF_FLOAT,   offsetof(weather_data_t, current.temperature)},
+    {"current.apparent_temperature",        WF_CURRENT, WF_FLOAT,   offsetof(weather_data_t, current.apparent_temperature)},
+    {"current.relative_humidity_2m",        WF_CURRENT, WF_FLOAT,   offsetof(weather_data_t, current.humidity)},
+    {"current.wind_speed_10m",              WF_CURRENT, WF_FLOAT,   offsetof(weather_data_t, current.wind_speed)},
+    {"current.surface_pressure",            WF_CURRENT, WF_FLOAT,   offsetof(weather_data_t, current.pressure)},
+    {"current.weather_code",                WF_CURRENT, WF_CODE,    offsetof(weather_data_t, current.weather_code)},
+    {"daily.time[]",                        WF_DAILY,   WF_TIME,    offsetof(daily_forecast_t, time)},
+    {"daily.weather_code[]",                WF_DAILY,   WF_CODE,    offsetof(daily_forecast_t, weather_code)},
+    {"daily.temperature_2m_max[]",          WF_DAILY,   WF_FLOAT,   offsetof(daily_forecast_t, temp_max)},
+    {"daily.temperature_2m_min[]",          WF_DAILY,   WF_FLOAT,   offsetof(daily_forecast_t, temp_min)},
+    {"hourly.time[]",                       WF_HOURLY,  WF_TIME,    offsetof(hourly_forecast_t, time)},
+    {"hourly.temperature_2m[]",             WF_HOURLY,  WF_FLOAT,   offsetof(hourly_forecast_t, temperature)},
+    {"hourly.weather_code[]",               WF_HOURLY,  WF_CODE,    offsetof(hourly_forecast_t, weather_code)},
+    {"hourly.precipitation_probability[]",  WF_HOURLY,  WF_PERCENT, offsetof(hourly_forecast_t, precipitation_prob)},
+};
+
+static void weather_json_value(json_stream_t *js, json_stream_type_t type, const char *text, void *user)
+{
+    weather_data_t *data = (weather_data_t *)user;
+    if (type != JSON_STREAM_NUMBER) return;     // nulls leave the field at zero
+
+    double v = strtod(text, NULL);
+
+    if (json_stream_match(js, "utc_offset_seconds")) {
+        data->utc_offset = (int32_t)v;
+        return;
+    }
+
+    for (size_t f = 0; f < sizeof(weather_fields) / sizeof(weather_fields[0]); f++) {
+        const weather_field_t *field = &weather_fields[f];
+        if (!json_stream_match(js, field->path)) continue;
+
+        uint8_t *base = (uint8_t *)data;
+        if (field->series != WF_CURRENT) {
+            int i = json_stream_index(js);
+            if (field->series == WF_DAILY) {
+                if (i < 0 || i >= WEATHER_DAILY_MAX) return;
+                base = (uint8_t *)&data->daily[i];
+                if (i >= data->daily_count) data->daily_count = i + 1;
+            } else {
+                if (i < 0 || i >= WEATHER_HOURLY_MAX) return;
+                base = (uint8_t *)&data->hourly[i];
+                if (i >= data->hourly_count) data->hourly_count = i + 1;
+            }
+        }
+
+        void *dst = base + field->offset;
+        switch (field->type) {
+            case WF_FLOAT:   *(float *)dst = (float)v; break;
+            case WF_CODE:    *(weather_code_t *)dst = (weather_code_t)(int)v; break;
+            case WF_TIME:    *(int64_t *)dst = (int64_t)v; break;
+            case WF_PERCENT: *(uint8_t *)dst = (uint8_t)v; break;
+        }
+        return;
+    }
+}
+
+void weather_parse_begin(json_stream_t *js, weather_data_t *data)
+{
+    memset(data, 0, sizeof(*data));
+    json_stream_init(js, weather_json_value, data);
+}
+
+bool weather_parse_end(const json_stream_t *js, weather_data_t *data)
+{
+    if (!json_stream_done(js)) return false;
+
+    // Weekday at the forecast location, not on the device clock
+    for (int i = 0; i < data->daily_count; i++) {
+        static const char *days[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+        time_t local = (time_t)(data->daily[i].time + data->utc_offset);
+        struct tm tm_day;
+        gmtime_r(&local, &tm_day);
+        snprintf(data->daily[i].day_name, sizeof(data->daily[i].day_name), "%s", days[tm_day.tm_wday % 7]);
+    }
+    return true;
+}
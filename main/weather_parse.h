@@ -0,0 +1,25 @@
+/**
+ * Win32 OS - Open-Meteo Response Parser
+ * Picks the fields weather_api asks for out of a forecast body while it
+ * streams in. Plain C library only, so the host tests can feed it
+ * recorded responses.
+ */
+
+#ifndef WEATHER_PARSE_H
+#define WEATHER_PARSE_H
+
+#include "json_stream.h"
+#include "weather_api.h"
+
+/**
+ * Clear data and set up js to fill it; then json_stream_feed() every chunk
+ */
+void weather_parse_begin(json_stream_t *js, weather_data_t *data);
+
+/**
+ * Finish after the last chunk: fills the day names
+ * @return false if the body was malformed or truncated
+ */
+bool weather_parse_end(const json_stream_t *js, weather_data_t *data);
+
+#endif // WEATHER_PARSE_H
@@ -0,0 +1,246 @@
+/**
+ * Duktape host benchmark
+ * Runs a fixed suite of JS microbenchmarks and scripts shaped like what
+ * the JS IDE runs through duktape_esp32.c, with the firmware's own heap
+ * arena, and reports per benchmark:
+ *   ops/s     iterations of the benchmark's loop per second (best run)
+ *   peak KB   highest arena use over all runs
+ *   GC ms     mark-and-sweep time per run (refcount frees not included)
+ *
+ * One binary is built per duk_config variant (duk_bench_variant.h);
+ * matrix.py runs them all and compares them against the baseline.
+ *
+ * Usage: duk_bench_<variant> [-c] [-s scale] [-r runs] [-a arena_kb] [name...]
+ *   -c  CSV: variant,bench,ops_per_sec,peak_bytes,gc_us,gc_passes
+ */
+
+#include "duktape_esp32.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_timer.h"
+
+#ifndef DUK_BENCH_VARIANT_NAME
+#define DUK_BENCH_VARIANT_NAME  "baseline"
+#endif
+
+#define DEFAULT_RUNS        3
+#define DEFAULT_ARENA_KB    (16 * 1024)     // Host values are bigger than the target's
+
+typedef struct {
+    const char *name;
+    const char *source;         // Defines run(n)
+    uint32_t n;                 // Iterations at scale 1
+} bench_t;
+
+// ============ SUITE ============
+
+static const bench_t suite[] = {
+    // Microbenchmarks
+    { "int-arith",
+      "function run(n) { var s = 0; for (var i = 0; i < n; i++) s = (s + i * 7) % 1000003; return s; }",
+      2000000 },
+    { "float-math",
+      "function run(n) { var s = 0; for (var i = 0; i < n; i++) s += Math.sqrt(i) * Math.sin(i * 0.01); return s; }",
+      500000 },
+    { "property",
+      "function run(n) { var o = { x: 1, y: 2, z: 3 };"
+      "  for (var i = 0; i < n; i++) { o.x = o.y + o.z; o.y = o.x - i; o.z = i; } return o.x; }",
+      1000000 },
+    { "call",
+      "function add(a, b) { return a + b; }"
+      "function run(n) { var s = 0; for (var i = 0; i < n; i++) s = add(s, i) & 0xffff; return s; }",
+      1000000 },
+    { "closure",
+      "function run(n) { var c = 0; function make(k) { return function () { c += k; }; }"
+      "  for (var i = 0; i < n; i++) make(i & 7)(); return c; }",
+      300000 },
+    { "string-concat",
+      "function run(n) { var t = 0; for (var i = 0; i < n; i += 100) { var s = '';"
+      "  for (var j = 0; j < 100; j++) s += String.fromCharCode(97 + j % 26); t += s.length; } return t; }",
+      1000000 },
+    { "string-intern",
+      "function run(n) { var o = {}; for (var i = 0; i < n; i++) { o['key' + i] = i;"
+      "  if ((i & 4095) == 4095) o = {}; } return i; }",
+      300000 },
+    { "array-sort",
+      "function run(n) { var t = 0; for (var k = 0; k < n; k++) { var a = [];"
+      "  for (var i = 0; i < 64; i++) a.push((i * 7919 + k) % 101);"
+      "  a.sort(function (x, y) { return x - y; }); t += a[0]; } return t; }",
+      5000 },
+    { "object-alloc",
+      "function run(n) { var l = null; for (var i = 0; i < n; i++) l = { v: i, next: (i % 1000) ? l : null, tag: [i] };"
+      "  return l.v; }",
+      500000 },
+    { "json",
+      "var doc = { name: 'sensor-7', ok: true, items: [] };"
+      "for (var i = 0; i < 16; i++) doc.items.push({ id: i, t: 20.5 + i / 10, label: 'probe ' + i });"
+      "function run(n) { var t = 0; for (var i = 0; i < n; i++) t += JSON.parse(JSON.stringify(doc)).items.length;"
+      "  return t; }",
+      20000 },
+    { "regex",
+      "function run(n) { var re = /(\\d+)-(\\w+)/; var t = 0;"
+      "  for (var i = 0; i < n; i++) t += re.exec('id ' + i + '-item' + (i & 15))[2].length; return t; }",
+      200000 },
+
+    // Scripts: a game, a parser, an app screen, async code
+    { "life-48x48",
+      "var W = 48, H = 48, cells = [];"
+      "for (var i = 0; i < W * H; i++) cells.push((i * 2654435761 >>> 28) & 1);"
+      "function step(c) { var next = new Array(W * H);"
+      "  for (var y = 0; y < H; y++) for (var x = 0; x < W; x++) { var k = 0;"
+      "    for (var dy = -1; dy <= 1; dy++) for (var dx = -1; dx <= 1; dx++)"
+      "      if (dx || dy) k += c[((y + dy + H) % H) * W + (x + dx + W) % W];"
+      "    var a = c[y * W + x]; next[y * W + x] = (k == 3 || (a && k == 2)) ? 1 : 0; }"
+      "  return next; }"
+      "function run(n) { for (var g = 0; g < n; g++) cells = step(cells); return cells.length; }",
+      100 },
+    { "tokenizer",
+      "var src = '';"
+      "for (var i = 0; i < 40; i++) src += 'function f' + i + '(a, b) { return a * ' + i + ' + b; } // ok\\n';"
+      "function tokens(s) { var n = 0, i = 0, len = s.length;"
+      "  while (i < len) { var c = s.charCodeAt(i);"
+      "    if (c == 32 || c == 10) { i++; continue; }"
+      "    if (c == 47 && s.charCodeAt(i + 1) == 47) { while (i < len && s.charCodeAt(i) != 10) i++; n++; continue; }"
+      "    if ((c >= 97 && c <= 122) || (c >= 65 && c <= 90)) { while (i < len && /[\\w$]/.test(s[i])) i++; n++; continue; }"
+      "    if (c >= 48 && c <= 57) { while (i < len && s.charCodeAt(i) >= 48 && s.charCodeAt(i) <= 57) i++; n++; continue; }"
+      "    i++; n++; }"
+      "  return n; }"
+      "function run(n) { var t = 0; for (var i = 0; i < n; i++) t += tokens(src); return t; }",
+      200 },
+    { "dashboard",
+      "var readings = [];"
+      "for (var i = 0; i < 64; i++) readings.push({ ts: 1700000000 + i * 60, temp: 20 + Math.sin(i / 5) * 4, hum: 40 + i % 20 });"
+      "var payload = JSON.stringify({ device: 'esp32-p4', readings: readings });"
+      "function run(n) { var out = '';"
+      "  for (var k = 0; k < n; k++) { var d = JSON.parse(payload), min = 1e9, max = -1e9, sum = 0;"
+      "    d.readings.forEach(function (r) { min = Math.min(min, r.temp); max = Math.max(max, r.temp); sum += r.temp; });"
+      "    var lines = [d.device, 'min ' + min.toFixed(1), 'max ' + max.toFixed(1),"
+      "                 'avg ' + (sum / d.readings.length).toFixed(2)];"
+      "    out = lines.join(' | '); }"
+      "  return out; }",
+      2000 },
+    { "promise-chain",
+      "function run(n) { var done = 0, p = Promise.resolve(0);"
+      "  for (var i = 0; i < n; i++) p = p.then(function (v) { done++; return v + 1; });"
+      "  return n; }",
+      2000 },
+};
+
+#define SUITE_SIZE  (int)(sizeof(suite) / sizeof(suite[0]))
+
+// ============ RUNNER ============
+
+typedef struct {
+    double ops_per_sec;
+    size_t peak;
+    uint64_t gc_us;             // Per run
+    uint32_t gc_passes;         // Per run
+} bench_result_t;
+
+static bool eval_ok(duk_esp32_t *duk, const char *code, const char *name) {
+    free(duk_esp32_eval(duk, code));
+    if (duk->end == DUK_ESP32_END_OK) return true;
+    fprintf(stderr, "%s: %s\n", name, duk_esp32_get_error(duk) ? duk_esp32_get_error(duk) : "failed");
+    return false;
+}
+
+static bool bench_run(const bench_t *b, double scale, int runs, size_t arena_size, bench_result_t *res) {
+    duk_esp32_t *duk = duk_esp32_init_arena(arena_size);
+    if (!duk) return false;
+    duk_esp32_set_budget(duk, 0);
+    duk_esp32_set_cache_dir(duk, NULL);
+
+    bool ok = eval_ok(duk, b->source, b->name);
+    uint32_t n = (uint32_t)(b->n * scale);
+    if (n < 1) n = 1;
+    char call[32];
+    snprintf(call, sizeof(call), "run(%lu)", (unsigned long)n);
+
+    // Best of the runs, the first one also warms up the heap
+    memset(&duk->gc, 0, sizeof(duk->gc));
+    int64_t best = INT64_MAX;
+    for (int r = 0; ok && r < runs; r++) {
+        int64_t start = esp_timer_get_time();
+        ok = eval_ok(duk, call, b->name);
+        int64_t us = esp_timer_get_time() - start;
+        if (us < best) best = us;
+    }
+
+    if (ok) {
+        duk_arena_stats_t stats;
+        res->ops_per_sec = best > 0 ? n * 1e6 / (double)best : 0;
+        res->peak = duk_esp32_get_arena_stats(duk, &stats) ? stats.peak : 0;
+        res->gc_us = duk->gc.total_us / runs;
+        res->gc_passes = duk->gc.count / runs;
+    }
+    duk_esp32_cleanup(duk);
+    return ok;
+}
+
+static bool selected(const char *name, int argc, char **argv, int first) {
+    if (first >= argc) return true;
+    for (int i = first; i < argc; i++) {
+        if (strcmp(argv[i], name) == 0) return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    bool csv = false;
+    double scale = 1.0;
+    int runs = DEFAULT_RUNS;
+    size_t arena_kb = DEFAULT_ARENA_KB;
+
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-c") == 0) {
+            csv = true;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            scale = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            arena_kb = (size_t)atol(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [-c] [-s scale] [-r runs] [-a arena_kb] [name...]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (scale <= 0 || runs < 1 || arena_kb * 1024 < DUK_ARENA_MIN_SIZE) {
+        fprintf(stderr, "Bad -s, -r or -a\n");
+        return 2;
+    }
+
+    if (!csv) {
+        printf("Duktape %ld.%ld.%ld, config %s, %d-bit, values %s\n",
+               (long)(DUK_VERSION / 10000), (long)(DUK_VERSION / 100 % 100), (long)(DUK_VERSION % 100),
+               DUK_BENCH_VARIANT_NAME, (int)(sizeof(void *) * 8),
+#if defined(DUK_USE_PACKED_TVAL)
+               "packed"
+#else
+               "unpacked"
+#endif
+               );
+        printf("%-16s %14s %10s %10s %8s\n", "bench", "ops/s", "peak KB", "GC ms", "GC runs");
+    }
+
+    int failed = 0;
+    for (int b = 0; b < SUITE_SIZE; b++) {
+        if (!selected(suite[b].name, argc, argv, i)) continue;
+        bench_result_t res;
+        if (!bench_run(&suite[b], scale, runs, arena_kb * 1024, &res)) {
+            failed++;
+            continue;
+        }
+        if (csv) {
+            printf("%s,%s,%.1f,%lu,%llu,%lu\n", DUK_BENCH_VARIANT_NAME, suite[b].name, res.ops_per_sec,
+                   (unsigned long)res.peak, (unsigned long long)res.gc_us, (unsigned long)res.gc_passes);
+        } else {
+            printf("%-16s %14.0f %10lu %10.2f %8lu\n", suite[b].name, res.ops_per_sec,
+                   (unsigned long)(res.peak / 1024), res.gc_us / 1000.0, (unsigned long)res.gc_passes);
+        }
+        fflush(stdout);
+    }
+    return failed ? 1 : 0;
+}
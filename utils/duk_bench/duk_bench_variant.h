@@ -0,0 +1,46 @@
+/**
+ * Duktape config variants for the host benchmark
+ * Included at the end of components/duktape/duk_config.h when
+ * DUK_BENCH_VARIANT is defined; each variant changes one option of the
+ * shipped config. The numbers match DUK_BENCH_VARIANTS in CMakeLists.txt.
+ */
+
+#ifndef DUK_BENCH_VARIANT_H
+#define DUK_BENCH_VARIANT_H
+
+#if DUK_BENCH_VARIANT == 0
+#define DUK_BENCH_VARIANT_NAME  "baseline"
+
+#elif DUK_BENCH_VARIANT == 1
+// Integers kept as 48-bit ints, arithmetic on them without doubles
+#define DUK_BENCH_VARIANT_NAME  "fastint"
+#define DUK_USE_FASTINT
+
+#elif DUK_BENCH_VARIANT == 2
+// 16-byte values instead of 8 (the target packs them, being 32-bit)
+#define DUK_BENCH_VARIANT_NAME  "unpacked"
+#undef DUK_USE_PACKED_TVAL
+
+#elif DUK_BENCH_VARIANT == 3
+// Mark-and-sweep only: garbage waits for the next GC pass
+#define DUK_BENCH_VARIANT_NAME  "no-refcount"
+#undef DUK_USE_REFERENCE_COUNTING
+#undef DUK_USE_DOUBLE_LINKED_HEAP
+
+#elif DUK_BENCH_VARIANT == 4
+// String intern table starts at 128 slots instead of 1024
+#define DUK_BENCH_VARIANT_NAME  "strtab-128"
+#undef DUK_USE_STRTAB_MINSIZE
+#define DUK_USE_STRTAB_MINSIZE 128
+
+#elif DUK_BENCH_VARIANT == 5
+// ... or at 8192
+#define DUK_BENCH_VARIANT_NAME  "strtab-8192"
+#undef DUK_USE_STRTAB_MINSIZE
+#define DUK_USE_STRTAB_MINSIZE 8192
+
+#else
+#error Unknown DUK_BENCH_VARIANT
+#endif
+
+#endif // DUK_BENCH_VARIANT_H
@@ -0,0 +1,27 @@
+/**
+ * Host stand-in for esp_heap_caps.h (duk_bench): every capability is malloc
+ */
+
+#ifndef ESP_HEAP_CAPS_H
+#define ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_8BIT     (1 << 2)
+
+static inline void *heap_caps_malloc(size_t size, int caps) {
+    (void)caps;
+    return malloc(size);
+}
+
+static inline void *heap_caps_realloc(void *ptr, size_t size, int caps) {
+    (void)caps;
+    return realloc(ptr, size);
+}
+
+static inline void heap_caps_free(void *ptr) {
+    free(ptr);
+}
+
+#endif // ESP_HEAP_CAPS_H
@@ -0,0 +1,14 @@
+/**
+ * Host stand-in for esp_log.h (duk_bench): warnings and errors to stderr
+ */
+
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include <stdio.h>
+
+#define ESP_LOGI(tag, fmt, ...)     do { } while (0)
+#define ESP_LOGW(tag, fmt, ...)     fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGE(tag, fmt, ...)     fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+
+#endif // ESP_LOG_H
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""
+Duktape Config Matrix for Win32 OS
+Runs every duk_bench_<variant> binary in a build directory and compares
+the variants with the baseline (the config the firmware ships):
+speed, peak heap and GC time per benchmark, then an overall verdict.
+
+Usage:
+    python matrix.py build-bench [-s 0.2] [-r 3] [-n 3] [bench ...]
+
+The variants take turns for -n rounds and each keeps its best figures,
+so a burst of load on the host does not land on one variant only.
+
+A variant is recommended if it is at least 3% faster overall (geometric
+mean over the suite, smaller differences are host noise) without
+needing more than 5% more heap at peak.
+"""
+
+import argparse
+import csv
+import glob
+import io
+import math
+import os
+import subprocess
+import sys
+
+MIN_GAIN = 1.03
+PEAK_TOLERANCE = 1.05
+
+
+def run_variant(binary, args):
+    cmd = [binary, '-c', '-s', str(args.scale), '-r', str(args.runs)] + args.bench
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+    if proc.stderr:
+        sys.stderr.write(proc.stderr)
+    rows = {}
+    variant = None
+    for row in csv.reader(io.StringIO(proc.stdout)):
+        if len(row) != 6:
+            continue
+        variant = row[0]
+        rows[row[1]] = {
+            'ops': float(row[2]),
+            'peak': int(row[3]),
+            'gc_us': int(row[4]),
+            'gc_passes': int(row[5]),
+        }
+    return variant, rows
+
+
+def merge_best(best, rows):
+    for bench, r in rows.items():
+        old = best.get(bench)
+        if old is None or r['ops'] > old['ops']:
+            best[bench] = dict(r, gc_us=min(r['gc_us'], old['gc_us']) if old else r['gc_us'])
+        else:
+            old['gc_us'] = min(old['gc_us'], r['gc_us'])
+
+
+def geomean(values):
+    values = [v for v in values if v > 0]
+    if not values:
+        return 0.0
+    return math.exp(sum(math.log(v) for v in values) / len(values))
+
+
+def print_table(title, benches, variants, results, cell):
+    print('\n' + title)
+    print('%-16s' % 'bench' + ''.join('%14s' % v for v in variants))
+    for bench in benches:
+        line = '%-16s' % bench
+        for v in variants:
+            r = results[v].get(bench)
+            line += '%14s' % (cell(bench, v, r) if r else '-')
+        print(line)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare Duktape config variants')
+    parser.add_argument('build_dir', help='Directory with the duk_bench_* binaries')
+    parser.add_argument('-s', '--scale', type=float, default=1.0, help='Iteration scale')
+    parser.add_argument('-r', '--runs', type=int, default=3, help='Runs per benchmark (best is kept)')
+    parser.add_argument('-n', '--rounds', type=int, default=3, help='Rounds over all variants')
+    parser.add_argument('bench', nargs='*', help='Only these benchmarks')
+    args = parser.parse_intermixed_args()
+
+    binaries = sorted(glob.glob(os.path.join(args.build_dir, 'duk_bench_*')))
+    binaries = [b for b in binaries if os.access(b, os.X_OK) and not os.path.isdir(b)]
+    if not binaries:
+        print('No duk_bench_* binaries in %s' % args.build_dir, file=sys.stderr)
+        return 1
+
+    results = {}
+    for round_no in range(args.rounds):
+        for binary in binaries:
+            print('Round %d/%d: %s...' % (round_no + 1, args.rounds, os.path.basename(binary)),
+                  file=sys.stderr)
+            variant, rows = run_variant(binary, args)
+            if variant:
+                merge_best(results.setdefault(variant, {}), rows)
+    if 'baseline' not in results:
+        print('The baseline variant did not run', file=sys.stderr)
+        return 1
+
+    variants = ['baseline'] + sorted(v for v in results if v != 'baseline')
+    benches = list(results['baseline'].keys())
+    base = results['baseline']
+
+    print_table('ops/s (baseline) and % of baseline', benches, variants, results,
+                lambda b, v, r: '%.0f' % r['ops'] if v == 'baseline'
+                else '%+.1f%%' % ((r['ops'] / base[b]['ops'] - 1) * 100))
+    print_table('Peak heap KB', benches, variants, results,
+                lambda b, v, r: '%d' % (r['peak'] // 1024))
+    print_table('GC ms per run (passes)', benches, variants, results,
+                lambda b, v, r: '%.1f (%d)' % (r['gc_us'] / 1000.0, r['gc_passes']))
+
+    print('\nOverall against the baseline')
+    print('%-14s %10s %10s %10s' % ('variant', 'speed', 'peak', 'GC ms'))
+    best = ('baseline', MIN_GAIN)
+    for v in variants:
+        common = [b for b in benches if b in results[v]]
+        speed = geomean([results[v][b]['ops'] / base[b]['ops'] for b in common])
+        peak = geomean([results[v][b]['peak'] / base[b]['peak'] for b in common if base[b]['peak']])
+        gc_ms = sum(results[v][b]['gc_us'] for b in common) / 1000.0
+        print('%-14s %9.1f%% %9.1f%% %10.1f' % (v, speed * 100, peak * 100, gc_ms))
+        if len(common) == len(benches) and speed > best[1] and peak <= PEAK_TOLERANCE:
+            best = (v, speed)
+
+    if best[0] == 'baseline':
+        print('\nKeep the shipped config: no variant is %d%% faster within %d%% of its heap.'
+              % (round((MIN_GAIN - 1) * 100), round((PEAK_TOLERANCE - 1) * 100)))
+    else:
+        print('\nShip %s: %.1f%% faster overall within %d%% of the baseline heap.'
+              % (best[0], (best[1] - 1) * 100, round((PEAK_TOLERANCE - 1) * 100)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
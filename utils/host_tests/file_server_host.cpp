@@ -0,0 +1,66 @@
+/**
+ * File server on a Linux host
+ * Serves <dir>/littlefs and <dir>/sdcard under the firmware's URL roots
+ * with the firmware's request handling, one connection at a time.
+ *
+ * Usage: file_server_host <port> <dir> <token>
+ */
+
+#include "file_server_http.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_BUF_SIZE   (32 * 1024)
+
+int main(int argc, char **argv)
+{
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s <port> <dir> <token>\n", argv[0]);
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    static char littlefs[512], sdcard[512];
+    snprintf(littlefs, sizeof(littlefs), "%s/littlefs", argv[2]);
+    snprintf(sdcard, sizeof(sdcard), "%s/sdcard", argv[2]);
+    const file_server_root_t roots[] = {
+        { "/littlefs", littlefs },
+        { "/sdcard",   sdcard },
+    };
+
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)atoi(argv[1]));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(sock, 4) != 0) {
+        perror("bind/listen");
+        return 1;
+    }
+
+    static uint8_t buf[HOST_BUF_SIZE];
+    file_server_ctx_t ctx = {};
+    ctx.roots = roots;
+    ctx.root_count = sizeof(roots) / sizeof(roots[0]);
+    ctx.buf = buf;
+    ctx.buf_size = sizeof(buf);
+    ctx.idle_timeout_ms = 2000;
+    ctx.token = argv[3];
+
+    printf("Listening on 127.0.0.1:%s\n", argv[1]);
+    fflush(stdout);
+    for (;;) {
+        int conn = accept(sock, NULL, NULL);
+        if (conn < 0) continue;
+        file_server_handle_connection(&ctx, conn);
+        close(conn);
+    }
+}
@@ -0,0 +1,154 @@
+/**
+ * Host stand-in for NVS (host_tests)
+ * Flat key store for the single namespace the tests use. Writes go
+ * straight to the store like the real NVS does; nvs_commit only counts.
+ */
+
+#include "nvs.h"
+#include <sys/mman.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define NVS_HOST_KEYS       96
+#define NVS_HOST_KEY_LEN    16      // NVS key limit, with the terminator
+#define NVS_HOST_VALUE_MAX  512
+
+typedef struct {
+    bool used;
+    char key[NVS_HOST_KEY_LEN];
+    size_t len;
+    uint8_t value[NVS_HOST_VALUE_MAX];
+} nvs_host_entry_t;
+
+typedef struct {
+    nvs_host_entry_t entries[NVS_HOST_KEYS];
+    nvs_host_stats_t stats;
+    int fail_after;
+} nvs_host_store_t;
+
+static nvs_host_store_t s_local = { {}, {}, -1 };
+static nvs_host_store_t *s_store = &s_local;
+
+static nvs_host_entry_t *find(const char *key)
+{
+    for (int i = 0; i < NVS_HOST_KEYS; i++) {
+        if (s_store->entries[i].used && strcmp(s_store->entries[i].key, key) == 0) {
+            return &s_store->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t set(const char *key, const void *value, size_t length)
+{
+    if (strlen(key) >= NVS_HOST_KEY_LEN || length > NVS_HOST_VALUE_MAX) return ESP_ERR_INVALID_ARG;
+    if (s_store->fail_after >= 0 && s_store->fail_after-- == 0) return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+
+    nvs_host_entry_t *e = find(key);
+    for (int i = 0; !e && i < NVS_HOST_KEYS; i++) {
+        if (!s_store->entries[i].used) e = &s_store->entries[i];
+    }
+    if (!e) return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+
+    e->used = true;
+    strcpy(e->key, key);
+    e->len = length;
+    memcpy(e->value, value, length);
+
+    nvs_host_stats_t *st = &s_store->stats;
+    st->writes++;
+    st->bytes += length;
+    size_t used = strlen(st->keys);
+    if (used + strlen(key) + 2 < sizeof(st->keys)) {
+        if (used) st->keys[used++] = ' ';
+        strcpy(st->keys + used, key);
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle)
+{
+    *handle = 1;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+    for (int i = 0; i < NVS_HOST_KEYS; i++) s_store->entries[i].used = false;
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *length)
+{
+    nvs_host_entry_t *e = find(key);
+    if (!e) return ESP_ERR_NVS_NOT_FOUND;
+    if (!out) {
+        *length = e->len;
+        return ESP_OK;
+    }
+    if (*length < e->len) return ESP_ERR_INVALID_SIZE;
+    memcpy(out, e->value, e->len);
+    *length = e->len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return set(key, value, length);
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out)
+{
+    nvs_host_entry_t *e = find(key);
+    if (!e) return ESP_ERR_NVS_NOT_FOUND;
+    if (e->len != 1) return ESP_ERR_INVALID_SIZE;
+    *out = e->value[0];
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value)
+{
+    return set(key, &value, 1);
+}
+
+// ============ TEST HOOKS ============
+
+void nvs_host_reset_stats(void)
+{
+    memset(&s_store->stats, 0, sizeof(s_store->stats));
+}
+
+void nvs_host_get_stats(nvs_host_stats_t *stats)
+{
+    *stats = s_store->stats;
+}
+
+void nvs_host_fail_write(int after)
+{
+    s_store->fail_after = after;
+}
+
+void nvs_host_clear(void)
+{
+    memset(s_store->entries, 0, sizeof(s_store->entries));
+    nvs_host_reset_stats();
+    s_store->fail_after = -1;
+}
+
+void nvs_host_share(void)
+{
+    void *shared = mmap(NULL, sizeof(nvs_host_store_t), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) abort();
+    memcpy(shared, s_store, sizeof(nvs_host_store_t));
+    s_store = (nvs_host_store_t *)shared;
+}
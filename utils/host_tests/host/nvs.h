@@ -0,0 +1,59 @@
+/**
+ * Host stand-in for nvs.h (host_tests): one in-memory namespace store
+ * (host/nvs.cpp) that counts writes and can be told to fail them
+ */
+
+#ifndef NVS_H
+#define NVS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t nvs_handle_t;
+
+typedef enum {
+    NVS_READONLY,
+    NVS_READWRITE
+} nvs_open_mode_t;
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle);
+void nvs_close(nvs_handle_t handle);
+esp_err_t nvs_commit(nvs_handle_t handle);
+esp_err_t nvs_erase_all(nvs_handle_t handle);
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *length);
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length);
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out);
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value);
+
+// ---- Test hooks ----
+
+// Keys written and bytes written since the last reset
+typedef struct {
+    int writes;
+    size_t bytes;
+    char keys[256];         // Space separated, in write order
+} nvs_host_stats_t;
+
+void nvs_host_reset_stats(void);
+void nvs_host_get_stats(nvs_host_stats_t *stats);
+
+// Fail one set, after the next 'after' successful ones (-1 = none)
+void nvs_host_fail_write(int after);
+
+// Forget every key
+void nvs_host_clear(void);
+
+// Keep the store in shared memory, so forked children ("boots") see and
+// leave the same flash contents
+void nvs_host_share(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NVS_H
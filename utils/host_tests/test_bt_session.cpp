@@ -0,0 +1,363 @@
+/**
+ * Bluetooth transfer sessions against a simulated GATT peer
+ * The peer moves the stream in ATT notifications of (MTU - 3) bytes, the
+ * way bluetooth_transfer.cpp does, for the usual negotiated MTUs and for
+ * random ones. A nested folder has to arrive identical, corrupted streams
+ * have to be rejected without leaving .part files behind, and the codec
+ * is fuzzed on its own.
+ */
+
+#include "bt_session.h"
+#include "bt_codec.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+static int s_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        s_failures++; \
+    } \
+} while (0)
+
+typedef std::map<std::string, std::string> tree_t;    // Relative path -> content
+
+static std::string s_tmp;
+
+// ============ FILE TREES ============
+
+static void write_file(const std::string &path, const std::string &content)
+{
+    for (size_t p = s_tmp.size() + 1; (p = path.find('/', p)) != std::string::npos; p++) {
+        mkdir(path.substr(0, p).c_str(), 0755);
+    }
+    FILE *f = fopen(path.c_str(), "wb");
+    fwrite(content.data(), 1, content.size(), f);
+    fclose(f);
+}
+
+static void read_tree(const std::string &root, const std::string &rel, tree_t *tree)
+{
+    DIR *dir = opendir((root + rel).c_str());
+    if (!dir) return;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) continue;
+        std::string name = rel + "/" + ent->d_name;
+        struct stat st;
+        stat((root + name).c_str(), &st);
+        if (S_ISDIR(st.st_mode)) {
+            read_tree(root, name, tree);
+            continue;
+        }
+        std::string content;
+        FILE *f = fopen((root + name).c_str(), "rb");
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) content.append(buf, n);
+        fclose(f);
+        (*tree)[name.substr(1)] = content;
+    }
+    closedir(dir);
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+    return remove(path);
+}
+
+static void remove_tree(const std::string &root)
+{
+    nftw(root.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+static std::string random_bytes(size_t len, unsigned seed)
+{
+    srand(seed);
+    std::string s(len, '\0');
+    for (size_t i = 0; i < len; i++) s[i] = (char)rand();
+    return s;
+}
+
+static std::string text_bytes(size_t len)
+{
+    static const char *words[] = { "the ", "quick ", "brown ", "fox ", "jumps ", "over ", "lazy ", "dog\n" };
+    std::string s;
+    for (int i = 0; s.size() < len; i++) s += words[(i * 7 + i / 5) % 8];
+    return s.substr(0, len);
+}
+
+// The folder queued by the tests; returns what the receiver must end up with
+static tree_t make_source(void)
+{
+    std::string bmp(150 * 1024, '\0');
+    for (size_t i = 0; i < bmp.size(); i++) bmp[i] = (char)((i / 3) % 64);
+
+    tree_t sent = {
+        { "Photos/notes.txt",                   text_bytes(20000) },
+        { "Photos/empty.txt",                   "" },
+        { "Photos/2024/img_001.bmp",            bmp },
+        { "Photos/2024/Summer/beach.jpg",       random_bytes(9000, 1) },
+        { "Photos/2024/Summer/block.bin",       random_bytes(BT_CODEC_BLOCK_SIZE, 2) },
+        { "Photos/2024/Summer/block1.bin",      random_bytes(BT_CODEC_BLOCK_SIZE + 1, 3) },
+        { "Photos/a/b/c/d/deepest.txt",         "four levels below Photos\n" },
+    };
+    for (const auto &f : sent) write_file(s_tmp + "/src/" + f.first, f.second);
+
+    // Not sent: hidden entries and anything below BT_SESSION_MAX_DEPTH
+    write_file(s_tmp + "/src/Photos/.thumbs", "hidden");
+    write_file(s_tmp + "/src/Photos/a/b/c/d/e/too_deep.txt", "five levels below Photos\n");
+    return sent;
+}
+
+// ============ SIMULATED PEER ============
+
+// Whole stream in one buffer
+static std::string encode(const char *path)
+{
+    static bt_session_tx_t tx;
+    bt_session_tx_init(&tx);
+    CHECK(bt_session_tx_add(&tx, path) > 0);
+    std::string stream;
+    uint8_t buf[1024];
+    size_t n;
+    while ((n = bt_session_tx_read(&tx, buf, sizeof(buf))) > 0) stream.append((const char *)buf, n);
+    CHECK(bt_session_tx_done(&tx) && tx.error == 0);
+    bt_session_tx_free(&tx);
+    return stream;
+}
+
+// Sender and receiver joined by notifications of (mtu - 3) bytes; mtu 0
+// picks a random size for every notification
+static int transfer(const char *src, const std::string &dst, int mtu, unsigned seed)
+{
+    static bt_session_tx_t tx;
+    static bt_session_rx_t rx;
+    mkdir(dst.c_str(), 0755);
+    bt_session_tx_init(&tx);
+    CHECK(bt_session_tx_add(&tx, src) > 0);
+    bt_session_rx_init(&rx, dst.c_str());
+
+    srand(seed);
+    uint8_t pdu[512];
+    int rc = 0;
+    size_t n;
+    while (rc == 0) {
+        size_t payload = mtu ? mtu - 3 : 1 + rand() % 509;
+        n = bt_session_tx_read(&tx, pdu, payload);
+        if (n == 0) break;
+        rc = bt_session_rx_feed(&rx, pdu, n);
+    }
+    CHECK(bt_session_tx_done(&tx));
+    CHECK(tx.stream_bytes == rx.stream_bytes);
+    CHECK(tx.raw_done == rx.raw_bytes);
+    bt_session_tx_free(&tx);
+    return rc;
+}
+
+static void test_round_trip(const tree_t &sent)
+{
+    static const int mtus[] = { 23, 185, 247, 517, 0, 0, 0 };
+    for (size_t i = 0; i < sizeof(mtus) / sizeof(mtus[0]); i++) {
+        std::string dst = s_tmp + "/dst" + std::to_string(i);
+        CHECK(transfer((s_tmp + "/src/Photos/").c_str(), dst, mtus[i], (unsigned)i) == 1);
+        tree_t got;
+        read_tree(dst, "", &got);
+        if (got != sent) {
+            fprintf(stderr, "MTU %d: received tree differs (%u files, %u expected)\n",
+                    mtus[i], (unsigned)got.size(), (unsigned)sent.size());
+            s_failures++;
+        }
+    }
+
+    // Compressible data shrinks, already compressed formats are stored
+    std::string text = encode((s_tmp + "/src/Photos/notes.txt").c_str());
+    CHECK(text.size() < 20000 / 2);
+    std::string jpeg = encode((s_tmp + "/src/Photos/2024/Summer/beach.jpg").c_str());
+    CHECK(jpeg.size() > 9000);
+}
+
+// ============ CORRUPTED STREAMS ============
+
+static int feed_stream(const std::string &stream, const std::string &dst, int *error)
+{
+    static bt_session_rx_t rx;
+    remove_tree(dst);
+    mkdir(dst.c_str(), 0755);
+    bt_session_rx_init(&rx, dst.c_str());
+    int rc = bt_session_rx_feed(&rx, (const uint8_t *)stream.data(), stream.size());
+    if (rc == 0) bt_session_rx_abort(&rx);
+    if (error) *error = rx.error;
+    return rc;
+}
+
+static bool has_part_file(const tree_t &tree)
+{
+    for (const auto &f : tree) {
+        if (f.first.size() > 5 && f.first.compare(f.first.size() - 5, 5, ".part") == 0) return true;
+    }
+    return false;
+}
+
+static void test_corruption(const tree_t &sent)
+{
+    std::string dst = s_tmp + "/bad";
+    std::string stream = encode((s_tmp + "/src/Photos/2024/Summer").c_str());
+
+    // A flipped byte: rejected, or every file that does arrive is intact
+    // (a flipped name byte can still spell a valid name). Every byte of
+    // the first records, every 7th further on
+    int rejected = 0, tried = 0;
+    for (size_t i = 0; i < stream.size(); i += i < 512 ? 1 : 7) {
+        tried++;
+        std::string bad = stream;
+        bad[i] ^= 0x10;
+        int rc = feed_stream(bad, dst, NULL);
+        tree_t got;
+        read_tree(dst, "", &got);
+        if (has_part_file(got)) {
+            fprintf(stderr, "Flip at %u left a .part file\n", (unsigned)i);
+            s_failures++;
+            break;
+        }
+        if (rc < 0) {
+            rejected++;
+            continue;
+        }
+        for (const auto &f : got) {
+            auto it = sent.find(f.first);
+            bool intact = it != sent.end() && it->second == f.second;
+            for (const auto &other : sent) intact |= it == sent.end() && other.second == f.second;
+            if (!intact) {
+                fprintf(stderr, "Flip at %u accepted corrupted %s\n", (unsigned)i, f.first.c_str());
+                s_failures++;
+                i = stream.size();
+                break;
+            }
+        }
+    }
+    CHECK(rejected > tried * 9 / 10);
+
+    // Block payload damage is caught by the CRC
+    int error = 0;
+    std::string bad = stream;
+    bad[bad.size() / 2] ^= 0x01;
+    CHECK(feed_stream(bad, dst, &error) == -1 && (error == EBADMSG || error == EPROTO));
+
+    // Truncated anywhere: not complete, and no .part once aborted
+    for (size_t k = 0; k < stream.size(); k += 97) {
+        CHECK(feed_stream(stream.substr(0, k), dst, NULL) == 0);
+        tree_t got;
+        read_tree(dst, "", &got);
+        CHECK(!has_part_file(got));
+    }
+
+    // Names that would leave the receive folder
+    static const char *names[] = { "../evil", "/abs", "a//b", "a/./b", "a/../../b", "dir/", "." };
+    for (const char *name : names) {
+        std::string s;
+        s += (char)BT_SESSION_REC_HELLO;
+        s += (char)BT_SESSION_VERSION;
+        s += (char)BT_SESSION_REC_FILE;
+        s += std::string("\x01\x00\x00\x00\x00", 5);
+        s += (char)strlen(name);
+        s += name;
+        CHECK(feed_stream(s, dst, &error) == -1 && error == EACCES);
+    }
+    CHECK(access((s_tmp + "/evil").c_str(), F_OK) != 0);
+
+    // Wrong version, missing HELLO, END with the wrong count
+    CHECK(feed_stream(std::string("\x00\x02", 2), dst, &error) == -1 && error == EPROTONOSUPPORT);
+    CHECK(feed_stream(std::string("\x04\x00\x00", 3), dst, &error) == -1);
+    CHECK(feed_stream(std::string("\x00\x01\x04\x01\x00", 5), dst, &error) == -1);
+    CHECK(feed_stream(std::string("\x00\x01\x04\x00\x00", 5), dst, &error) == 1);
+}
+
+// ============ CODEC FUZZ ============
+
+static void test_codec(void)
+{
+    static bt_codec_state_t state;
+    static uint8_t src[BT_CODEC_BLOCK_SIZE], enc[2 * BT_CODEC_BLOCK_SIZE], dec[BT_CODEC_BLOCK_SIZE];
+    CHECK(bt_codec_crc32(0, "123456789", 9) == 0xCBF43926);
+
+    srand(3);
+    for (int it = 0; it < 20000; it++) {
+        size_t len = rand() % (BT_CODEC_BLOCK_SIZE + 1);
+        int mode = rand() % 4;
+        for (size_t i = 0; i < len; i++) {
+            src[i] = mode == 0 ? rand() : mode == 1 ? rand() % 4 : mode == 2 ? "abcabcabd"[i % 9] : (i / 50) & 0xFF;
+        }
+
+        size_t n = bt_codec_compress(&state, src, len, enc, sizeof(enc));
+        int d = bt_codec_decompress(enc, n, dec, sizeof(dec));
+        if ((n == 0 && len) || d != (int)len || memcmp(src, dec, len) != 0) {
+            fprintf(stderr, "Codec round trip failed: iteration %d, %u bytes, mode %d\n", it, (unsigned)len, mode);
+            s_failures++;
+            return;
+        }
+
+        // Output limited to the input size minus one: smaller or nothing
+        size_t small = len > 1 ? bt_codec_compress(&state, src, len, enc, len - 1) : 0;
+        CHECK(small < len || small == 0);
+        if (small) CHECK(bt_codec_decompress(enc, small, dec, len) == (int)len && memcmp(src, dec, len) == 0);
+
+        // Too little room to decode into is an error, not an overrun
+        if (len > 1) CHECK(bt_codec_decompress(enc, n, dec, len - 1) == -1);
+
+        // Damaged blocks never write past cap
+        for (size_t i = 0; i < 8 && n; i++) enc[rand() % n] = (uint8_t)rand();
+        size_t cap = rand() % (BT_CODEC_BLOCK_SIZE + 1);
+        memset(dec, 0xA5, sizeof(dec));
+        d = bt_codec_decompress(enc, n, dec, cap);
+        CHECK(d <= (int)cap);
+        for (size_t i = cap; i < sizeof(dec); i++) {
+            if (dec[i] != 0xA5) {
+                fprintf(stderr, "Decoder wrote past cap %u\n", (unsigned)cap);
+                s_failures++;
+                return;
+            }
+        }
+    }
+
+    CHECK(bt_codec_is_compressed_name("IMG_0001.JPG"));
+    CHECK(bt_codec_is_compressed_name("song.mp3"));
+    CHECK(!bt_codec_is_compressed_name("notes.txt"));
+    CHECK(!bt_codec_is_compressed_name("jpg"));
+}
+
+int main(void)
+{
+    char tmpl[] = "/tmp/bt_session_XXXXXX";
+    if (!mkdtemp(tmpl)) return 1;
+    s_tmp = tmpl;
+
+    tree_t sent = make_source();
+    test_round_trip(sent);
+
+    tree_t summer;
+    for (const auto &f : sent) {
+        if (f.first.compare(0, 19, "Photos/2024/Summer/") == 0) summer["Summer/" + f.first.substr(19)] = f.second;
+    }
+    test_corruption(summer);
+    test_codec();
+
+    remove_tree(s_tmp);
+    if (s_failures) {
+        printf("%d bt_session check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("All bt_session checks passed\n");
+    return 0;
+}
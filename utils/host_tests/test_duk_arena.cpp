@@ -0,0 +1,250 @@
+/**
+ * duk_arena stress: random alloc, realloc and free over slab classes and
+ * page runs, with every block filled with its own pattern and checked
+ * when it is resized or freed (an overlap or a bad copy shows up as a
+ * wrong byte). Each round ends by freeing everything, after which nothing
+ * may be left but the one empty slab a size class keeps cached; with page
+ * runs only, the arena has to coalesce back into a single free run.
+ */
+
+#include "duk_arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static int s_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        s_failures++; \
+    } \
+} while (0)
+
+#define ARENA_SIZE      (1024 * 1024)
+#define MAX_LIVE        1500
+#define ROUNDS          4
+#define OPS_PER_ROUND   20000
+
+// Empty slabs the arena may keep once everything is freed: one per size
+// class (28 of them, up to 4 pages each)
+#define MAX_CACHED_BYTES    (28 * 4 * DUK_ARENA_PAGE_SIZE)
+
+struct block_t {
+    uint8_t *ptr;
+    size_t size;
+    uint32_t seed;
+};
+
+static uint8_t pattern(uint32_t seed, size_t i)
+{
+    return (uint8_t)((seed >> (i & 7)) ^ (i * 131) ^ (i >> 8));
+}
+
+static void fill(const block_t &b)
+{
+    for (size_t i = 0; i < b.size; i++) b.ptr[i] = pattern(b.seed, i);
+}
+
+static bool intact(const block_t &b, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (b.ptr[i] != pattern(b.seed, i)) return false;
+    }
+    return true;
+}
+
+// Mostly Duktape-sized objects, some up to the slab limit, a few runs
+static size_t random_size(void)
+{
+    int r = rand() % 100;
+    if (r < 70) return 1 + rand() % 256;
+    if (r < 95) return 257 + rand() % (DUK_ARENA_SMALL_MAX - 256);
+    return DUK_ARENA_SMALL_MAX + 1 + rand() % (48 * 1024);
+}
+
+static void check_stats(duk_arena_t *arena, const std::vector<block_t> &live)
+{
+    duk_arena_stats_t stats;
+    duk_arena_get_stats(arena, &stats);
+    size_t bytes = 0;
+    for (const block_t &b : live) bytes += b.size;
+    CHECK(stats.live == live.size());
+    CHECK(stats.used >= bytes);
+    CHECK(stats.used <= stats.pages_used);
+    CHECK(stats.pages_used + stats.free == stats.size);
+    CHECK(stats.peak >= stats.used);
+}
+
+static void check_empty(duk_arena_t *arena)
+{
+    duk_arena_stats_t stats;
+    duk_arena_get_stats(arena, &stats);
+    CHECK(stats.live == 0);
+    CHECK(stats.used == 0);
+    // Pages still taken are empty cached slabs and nothing else
+    CHECK(stats.slab_slack == stats.pages_used);
+    CHECK(stats.pages_used <= MAX_CACHED_BYTES);
+    CHECK(stats.pages_used + stats.free == stats.size);
+
+    void *largest = duk_arena_alloc(arena, stats.largest_free);
+    CHECK(largest != NULL);
+    duk_arena_free(arena, largest);
+}
+
+// Nothing but page runs: once freed, the arena is one run again
+static void check_coalesced(duk_arena_t *arena)
+{
+    duk_arena_stats_t stats;
+    duk_arena_get_stats(arena, &stats);
+    CHECK(stats.live == 0);
+    CHECK(stats.used == 0);
+    CHECK(stats.pages_used == 0);
+    CHECK(stats.free == stats.size);
+    CHECK(stats.largest_free == stats.size);
+    CHECK(stats.fragmentation == 0);
+
+    void *all = duk_arena_alloc(arena, stats.size);
+    CHECK(all != NULL);
+    duk_arena_free(arena, all);
+}
+
+static size_t random_run_size(void)
+{
+    return DUK_ARENA_SMALL_MAX + 1 + rand() % (24 * 1024);
+}
+
+static void stress(size_t (*next_size)(void), bool runs_only)
+{
+    duk_arena_t *arena = duk_arena_create(ARENA_SIZE);
+    CHECK(arena != NULL);
+    if (!arena) return;
+    check_coalesced(arena);
+
+    srand(1);
+    uint32_t seed = 1;
+    int refused = 0;
+    int moved = 0;
+    std::vector<block_t> live;
+
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int op = 0; op < OPS_PER_ROUND; op++) {
+            int r = rand() % 100;
+            // Lean towards growing for the first half of a round
+            int alloc_share = op < OPS_PER_ROUND / 2 ? 50 : 30;
+
+            if (live.empty() || (r < alloc_share && live.size() < MAX_LIVE)) {
+                block_t b = { NULL, next_size(), seed++ };
+                b.ptr = (uint8_t *)duk_arena_alloc(arena, b.size);
+                if (!b.ptr) {
+                    refused++;
+                    continue;
+                }
+                CHECK(((uintptr_t)b.ptr & 7) == 0);
+                fill(b);
+                live.push_back(b);
+            } else if (r < 75) {
+                size_t i = rand() % live.size();
+                block_t &b = live[i];
+                size_t size = rand() % 4 ? next_size() : b.size + 1 + rand() % 64;
+                uint8_t *ptr = (uint8_t *)duk_arena_realloc(arena, b.ptr, size);
+                if (!ptr) {
+                    // Refused: the old block stays as it was
+                    refused++;
+                    CHECK(intact(b, b.size));
+                    continue;
+                }
+                if (ptr != b.ptr) moved++;
+                b.ptr = ptr;
+                CHECK(((uintptr_t)b.ptr & 7) == 0);
+                CHECK(intact(b, b.size < size ? b.size : size));
+                b.size = size;
+                b.seed = seed++;
+                fill(b);
+            } else {
+                size_t i = rand() % live.size();
+                CHECK(intact(live[i], live[i].size));
+                duk_arena_free(arena, live[i].ptr);
+                live[i] = live.back();
+                live.pop_back();
+            }
+
+            if (op % 2000 == 0) check_stats(arena, live);
+        }
+
+        // Nothing written since a block was filled may have changed
+        for (const block_t &b : live) CHECK(intact(b, b.size));
+        check_stats(arena, live);
+
+        // Free in random order, then the arena has to be empty again
+        while (!live.empty()) {
+            size_t i = rand() % live.size();
+            duk_arena_free(arena, live[i].ptr);
+            live[i] = live.back();
+            live.pop_back();
+        }
+        if (runs_only) {
+            check_coalesced(arena);
+        } else {
+            check_empty(arena);
+        }
+    }
+
+    duk_arena_stats_t stats;
+    duk_arena_get_stats(arena, &stats);
+    CHECK(refused > 0);         // The arena actually filled up
+    CHECK(moved > 0);
+    CHECK(stats.failed >= (uint32_t)refused);
+    duk_arena_destroy(arena);
+}
+
+static void test_stress(void)
+{
+    stress(random_size, false);
+    stress(random_run_size, true);
+}
+
+// Edge cases of the malloc/realloc/free contract
+static void test_api(void)
+{
+    duk_arena_t *arena = duk_arena_create(0);      // Raised to the minimum
+    CHECK(arena != NULL);
+    if (!arena) return;
+
+    CHECK(duk_arena_alloc(arena, 0) == NULL);
+    duk_arena_free(arena, NULL);
+
+    // realloc(NULL) allocates, realloc(p, 0) frees
+    void *p = duk_arena_realloc(arena, NULL, 100);
+    CHECK(p != NULL);
+    CHECK(duk_arena_realloc(arena, p, 0) == NULL);
+
+    // Foreign pointers are left alone
+    int outside = 0;
+    duk_arena_free(arena, &outside);
+    CHECK(duk_arena_realloc(arena, &outside, 16) == NULL);
+
+    // Too big for the arena: refused and counted
+    duk_arena_stats_t stats;
+    duk_arena_get_stats(arena, &stats);
+    CHECK(duk_arena_alloc(arena, stats.size + 1) == NULL);
+    duk_arena_get_stats(arena, &stats);
+    CHECK(stats.failed == 1);
+
+    check_empty(arena);
+    duk_arena_destroy(arena);
+}
+
+int main(void)
+{
+    test_api();
+    test_stress();
+
+    if (s_failures) {
+        printf("%d duk_arena check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("All duk_arena checks passed\n");
+    return 0;
+}
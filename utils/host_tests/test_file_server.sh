@@ -0,0 +1,111 @@
+#!/usr/bin/env bash
+# Drives file_server_host with curl: listings, ranges, PUT, multipart,
+# DELETE, the write token and hidden paths.
+#
+# Usage: test_file_server.sh <path to file_server_host>
+
+set -u
+SERVER=$1
+TOKEN=host-test-token
+PORT=$((20000 + RANDOM % 20000))
+URL=http://127.0.0.1:$PORT
+DIR=$(mktemp -d)
+FAILS=0
+
+cleanup() {
+    kill "$PID" 2>/dev/null
+    wait "$PID" 2>/dev/null
+    rm -rf "$DIR"
+}
+
+check() {
+    local name=$1 expected=$2 actual=$3
+    if [ "$expected" == "$actual" ]; then
+        echo "ok    $name"
+    else
+        echo "FAIL  $name: expected '$expected', got '$actual'"
+        FAILS=$((FAILS + 1))
+    fi
+}
+
+# status <curl args...>: HTTP status only
+status() {
+    curl -s -o /dev/null -w '%{http_code}' "$@"
+}
+
+mkdir -p "$DIR/littlefs/docs" "$DIR/littlefs/.jscache" "$DIR/sdcard" "$DIR/out"
+head -c 100000 /dev/urandom > "$DIR/littlefs/data.bin"
+echo "cached" > "$DIR/littlefs/.jscache/0000000000000000.dbc"
+echo "hello" > "$DIR/littlefs/docs/note.txt"
+
+"$SERVER" "$PORT" "$DIR" "$TOKEN" > /dev/null &
+PID=$!
+trap cleanup EXIT
+for _ in $(seq 50); do
+    curl -s -o /dev/null "$URL/" && break
+    sleep 0.1
+done
+
+# ---- Listings ----
+check "root listing" 1 "$(curl -s "$URL/?json" | grep -c '"name":"littlefs"')"
+check "json listing" 1 "$(curl -s "$URL/littlefs/?json" | grep -c '"name":"data.bin","dir":false,"size":100000')"
+check "html listing" 200 "$(status "$URL/littlefs/docs/")"
+check "listing hides dot entries" 0 "$(curl -s "$URL/littlefs/?json" | grep -c jscache)"
+
+# ---- Downloads and ranges ----
+curl -s -o "$DIR/out/full" "$URL/littlefs/data.bin"
+check "full download" "" "$(cmp "$DIR/littlefs/data.bin" "$DIR/out/full")"
+check "range status" 206 "$(status -r 100-1099 "$URL/littlefs/data.bin")"
+curl -s -r 100-1099 -o "$DIR/out/range" "$URL/littlefs/data.bin"
+check "range bytes" "" "$(cmp <(tail -c +101 "$DIR/littlefs/data.bin" | head -c 1000) "$DIR/out/range")"
+curl -s -r -500 -o "$DIR/out/suffix" "$URL/littlefs/data.bin"
+check "suffix range" "" "$(cmp <(tail -c 500 "$DIR/littlefs/data.bin") "$DIR/out/suffix")"
+curl -s -r 99000- -o "$DIR/out/open" "$URL/littlefs/data.bin"
+check "open range" 1000 "$(stat -c %s "$DIR/out/open")"
+check "range past the end" 416 "$(status -r 200000-300000 "$URL/littlefs/data.bin")"
+check "missing file" 404 "$(status "$URL/littlefs/nope")"
+
+# ---- PUT ----
+head -c 1500000 /dev/urandom > "$DIR/out/big"
+check "put without token" 401 "$(status -T "$DIR/out/big" "$URL/sdcard/big")"
+check "put without token leaves nothing" "no" "$([ -e "$DIR/sdcard/big" ] && echo yes || echo no)"
+check "put wrong token" 401 "$(status -T "$DIR/out/big" -H "Authorization: Bearer nope" "$URL/sdcard/big")"
+check "put" 201 "$(status -T "$DIR/out/big" -H "Authorization: Bearer $TOKEN" "$URL/sdcard/big")"
+check "put content" "" "$(cmp "$DIR/out/big" "$DIR/sdcard/big")"
+check "put token in query" 201 "$(status -T "$DIR/littlefs/docs/note.txt" "$URL/sdcard/note.txt?token=$TOKEN")"
+check "put onto a directory" 409 "$(status -T "$DIR/out/big" -H "Authorization: Bearer $TOKEN" "$URL/sdcard/../sdcard")"
+
+# ---- Multipart ----
+printf 'first\n' > "$DIR/out/a.txt"
+printf 'second\n' > "$DIR/out/b.txt"
+check "multipart without token" 401 "$(status -F f=@"$DIR/out/a.txt" "$URL/littlefs/docs/")"
+check "multipart" 200 "$(status -F f=@"$DIR/out/a.txt" -F f=@"$DIR/out/b.txt" -F note=text \
+                         "$URL/littlefs/docs/?token=$TOKEN")"
+check "multipart first file" "" "$(cmp "$DIR/out/a.txt" "$DIR/littlefs/docs/a.txt")"
+check "multipart second file" "" "$(cmp "$DIR/out/b.txt" "$DIR/littlefs/docs/b.txt")"
+check "multipart big file" 200 "$(status -F f=@"$DIR/out/big" "$URL/littlefs/docs/?token=$TOKEN")"
+check "multipart big content" "" "$(cmp "$DIR/out/big" "$DIR/littlefs/docs/big")"
+cp "$DIR/out/a.txt" "$DIR/out/.hidden"
+check "multipart dot file name skipped" "Uploaded 0 files" \
+      "$(curl -s -F f=@"$DIR/out/.hidden" "$URL/littlefs/docs/?token=$TOKEN")"
+check "multipart dot file not written" "no" "$([ -e "$DIR/littlefs/docs/.hidden" ] && echo yes || echo no)"
+
+# ---- DELETE ----
+check "delete without token" 401 "$(status -X DELETE "$URL/sdcard/big")"
+check "delete" 204 "$(status -X DELETE -H "Authorization: Bearer $TOKEN" "$URL/sdcard/big")"
+check "deleted" "no" "$([ -e "$DIR/sdcard/big" ] && echo yes || echo no)"
+
+# ---- Hidden and parent paths ----
+check "get hidden file" 404 "$(status "$URL/littlefs/.jscache/0000000000000000.dbc")"
+check "put into hidden dir" 404 "$(status -T "$DIR/out/a.txt" -H "Authorization: Bearer $TOKEN" \
+                                 "$URL/littlefs/.jscache/1111111111111111.dbc")"
+check "hidden dir untouched" "no" "$([ -e "$DIR/littlefs/.jscache/1111111111111111.dbc" ] && echo yes || echo no)"
+check "encoded dot segment" 404 "$(status "$URL/littlefs/%2ejscache/0000000000000000.dbc")"
+check "parent segment" 404 "$(status --path-as-is "$URL/littlefs/../littlefs/data.bin")"
+check "outside the roots" 404 "$(status "$URL/etc/passwd")"
+
+if [ "$FAILS" -ne 0 ]; then
+    echo "$FAILS check(s) failed"
+    exit 1
+fi
+echo "All file server checks passed"
@@ -0,0 +1,217 @@
+/**
+ * GT911 interrupt mode wakes: the edge bookkeeping of gt911_touch.cpp
+ * driven by a simulated LVGL that only reads the touch when woken (INT or
+ * the driver's retry timer) and a camera holding the shared bus at random.
+ * Whatever the bus does, the last point LVGL reports has to match the
+ * finger once things settle: a release read while the camera had the bus
+ * must not leave the press stuck. TP_INT_PIN is -1 on the shipped board,
+ * so this is the only place the path runs.
+ */
+
+#include "gt911_wake.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <map>
+#include <vector>
+
+static int s_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        s_failures++; \
+    } \
+} while (0)
+
+#define BUS_WAIT_US     20000       // TOUCH_BUS_WAIT_MS
+#define RETRY_US        10000       // TOUCH_RETRY_US
+
+// ============ STATE ============
+
+static void test_state(void)
+{
+    gt911_wake_t w = {};
+    int64_t edge = 0;
+
+    CHECK(!gt911_wake_take(&w, &edge));
+
+    // Edges before a read coalesce into the first
+    gt911_wake_edge(&w, 100);
+    gt911_wake_edge(&w, 200);
+    CHECK(gt911_wake_take(&w, &edge) && edge == 100);
+    CHECK(!gt911_wake_take(&w, &edge));
+
+    // A postponed read keeps its edge and asks for one retry wake
+    gt911_wake_edge(&w, 300);
+    CHECK(gt911_wake_take(&w, &edge) && edge == 300);
+    CHECK(gt911_wake_defer(&w, edge));
+    CHECK(gt911_wake_take(&w, &edge) && edge == 300);
+    CHECK(!gt911_wake_defer(&w, edge));         // Retry already on its way
+    gt911_wake_retry_done(&w);
+    CHECK(gt911_wake_take(&w, &edge) && edge == 300);
+
+    // An edge during the bus wait: the older one is kept
+    gt911_wake_edge(&w, 500);
+    CHECK(gt911_wake_defer(&w, 400));
+    CHECK(gt911_wake_take(&w, &edge) && edge == 400);
+}
+
+// ============ SIMULATION ============
+
+enum {
+    EV_TOUCH,       // Press or release: INT edge and new finger state
+    EV_MOVE,        // INT edge, same finger state
+    EV_WAKE,        // LVGL woken from the ISR
+    EV_RETRY,       // LVGL woken by the driver's retry timer
+};
+
+struct event_t {
+    int type;
+    bool down;      // EV_TOUCH: finger state from here on
+};
+
+struct sim_t {
+    std::multimap<int64_t, event_t> events;
+    std::vector<std::pair<int64_t, int64_t>> busy;     // Camera holds the bus [from, to)
+    bool finger = false;
+    bool held = false;      // Last point handed to LVGL
+    bool retry = true;      // false: the driver without the retry timer
+    gt911_wake_t wake = {};
+    int reads = 0;
+    int deferred = 0;
+};
+
+static bool bus_busy(const sim_t &s, int64_t t)
+{
+    for (const auto &b : s.busy) {
+        if (t >= b.first && t < b.second) return true;
+    }
+    return false;
+}
+
+// INT edge: the ISR flags it and wakes LVGL
+static void sim_edge(sim_t *s, int64_t t, const event_t &ev)
+{
+    if (ev.type == EV_TOUCH) s->finger = ev.down;
+    gt911_wake_edge(&s->wake, t);
+    s->events.insert({t, {EV_WAKE, false}});    // wake_cb from the ISR
+}
+
+static void sim_read(sim_t *s, int64_t t)
+{
+    int64_t edge;
+    if (!gt911_wake_take(&s->wake, &edge)) return;     // Held point
+
+    if (!bus_busy(*s, t)) {
+        s->held = s->finger;
+        s->reads++;
+        return;
+    }
+
+    // Edges that come in while the read waits for the bus
+    int64_t until = t + BUS_WAIT_US;
+    for (auto it = s->events.begin(); it != s->events.end() && it->first < until; ) {
+        if (it->second.type == EV_TOUCH || it->second.type == EV_MOVE) {
+            sim_edge(s, it->first, it->second);
+            it = s->events.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (!bus_busy(*s, until - 1)) {
+        s->held = s->finger;
+        s->reads++;
+        return;
+    }
+    s->deferred++;
+    if (gt911_wake_defer(&s->wake, edge) && s->retry) {
+        s->events.insert({until + RETRY_US, {EV_RETRY, false}});
+    }
+}
+
+static void sim_run(sim_t *s)
+{
+    while (!s->events.empty()) {
+        auto it = s->events.begin();
+        int64_t t = it->first;
+        event_t ev = it->second;
+        s->events.erase(it);
+        if (ev.type == EV_TOUCH || ev.type == EV_MOVE) {
+            sim_edge(s, t, ev);
+        } else {
+            if (ev.type == EV_RETRY) gt911_wake_retry_done(&s->wake);
+            sim_read(s, t);
+        }
+    }
+}
+
+// Press, then release while the camera writes a long register sequence
+static void test_release_during_camera(void)
+{
+    for (int retry = 0; retry < 2; retry++) {
+        sim_t s;
+        s.retry = retry;
+        s.events.insert({0, {EV_TOUCH, true}});
+        s.events.insert({50000, {EV_TOUCH, false}});
+        s.busy.push_back({45000, 120000});
+        sim_run(&s);
+        CHECK(s.deferred > 0);
+        if (retry) {
+            CHECK(!s.held);
+            CHECK(!s.wake.pending && !s.wake.retry_armed);
+        } else {
+            CHECK(s.held);      // The stuck press this guards against
+        }
+    }
+}
+
+static void test_random(void)
+{
+    srand(1);
+    int deferred = 0;
+    for (int run = 0; run < 20000; run++) {
+        sim_t s;
+        int64_t t = 0;
+        bool down = false;
+        int touches = 1 + rand() % 12;
+        for (int i = 0; i < touches; i++) {
+            t += 1000 + rand() % 60000;
+            down = !down;
+            s.events.insert({t, {EV_TOUCH, down}});
+            // Extra INT edges while the finger moves
+            for (int j = rand() % 4; down && j > 0; j--) {
+                s.events.insert({t + 1 + rand() % 20000, {EV_MOVE, false}});
+            }
+        }
+        int busy = rand() % 6;
+        for (int i = 0; i < busy; i++) {
+            int64_t from = rand() % (t + 50000);
+            s.busy.push_back({from, from + 1000 + rand() % 150000});
+        }
+        sim_run(&s);
+
+        deferred += s.deferred;
+        CHECK(s.held == s.finger);
+        CHECK(!s.wake.pending);
+        CHECK(!s.wake.retry_armed);
+        if (s.held != s.finger) {
+            fprintf(stderr, "run %d: finger %d, reported %d\n", run, s.finger, s.held);
+            break;
+        }
+    }
+    CHECK(deferred > 1000);     // The bus was actually in the way
+}
+
+int main(void)
+{
+    test_state();
+    test_release_during_camera();
+    test_random();
+
+    if (s_failures) {
+        printf("%d gt911_wake check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("All gt911_wake checks passed\n");
+    return 0;
+}
@@ -0,0 +1,186 @@
+/**
+ * JS syntax model: random edits (inserts and deletes that open and close
+ * comments, strings, templates and regexes, and split or join lines)
+ * applied through js_syntax_update(), each result compared line by line
+ * with a model that lexed the same text from scratch. Any line whose start
+ * state the incremental update got wrong shows up as a mismatch.
+ */
+
+#include "js_syntax.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+static int s_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        s_failures++; \
+    } \
+} while (0)
+
+#define EDITS_PER_RUN   400
+#define RUNS            60
+
+static const char *s_start =
+    "/* Bouncing balls\n"
+    " * step() moves every ball once */\n"
+    "function step(balls, dt) {\n"
+    "    for (var i = 0; i < balls.length; i++) {\n"
+    "        var b = balls[i];   // position in pixels\n"
+    "        b.x += b.vx * dt / 1000;\n"
+    "        var name = 'ball ' + i + \"\\\"\";\n"
+    "        var tag = `#${i}:\n"
+    "            ${b.x.toFixed(1)}`;\n"
+    "        if (/^ball [0-9]+$/.test(name)) print(tag);\n"
+    "        var s = 'continued \\\n"
+    "on the next line';\n"
+    "    }\n"
+    "}\n";
+
+// Pieces that change the lexer state, and some that do not
+static const char *s_pieces[] = {
+    "/*", "*/", "//", "/", "'", "\"", "`", "\\", "\n", "\n\n", "\\\n",
+    "x", " ", "(", ")", "]", "}", "return ", "typeof ", "a / b", "/re[/]x/g",
+    "1e+5", "0x1F", "'str'", "`t\n${x}`", "/* c */", "// line\n", "\r\n",
+};
+
+#define PIECES  (int)(sizeof(s_pieces) / sizeof(s_pieces[0]))
+
+// Same lines, same start states, same tokens
+static bool same_model(const js_syntax_t *inc, const js_syntax_t *full)
+{
+    if (inc->lines != full->lines || inc->len != full->len) return false;
+    if (memcmp(inc->text, full->text, full->len) != 0) return false;
+
+    js_syntax_token_t a[JS_SYNTAX_MAX_TOKENS];
+    js_syntax_token_t b[JS_SYNTAX_MAX_TOKENS];
+    for (uint32_t line = 0; line < full->lines; line++) {
+        if (inc->line_start[line] != full->line_start[line]) return false;
+        if (inc->line_state[line] != full->line_state[line]) return false;
+        int na = js_syntax_tokens(inc, line, a, JS_SYNTAX_MAX_TOKENS);
+        int nb = js_syntax_tokens(full, line, b, JS_SYNTAX_MAX_TOKENS);
+        if (na != nb) return false;
+        for (int i = 0; i < na; i++) {
+            if (a[i].start != b[i].start || a[i].len != b[i].len || a[i].cls != b[i].cls) return false;
+        }
+    }
+    return true;
+}
+
+static bool check_against_full(const js_syntax_t *inc, const std::string &text)
+{
+    js_syntax_t *full = js_syntax_create();
+    CHECK(full != NULL);
+    if (!full) return false;
+    CHECK(js_syntax_update(full, text.c_str()));
+    bool same = same_model(inc, full);
+    js_syntax_destroy(full);
+    return same;
+}
+
+static void random_edit(std::string *text)
+{
+    size_t pos = text->empty() ? 0 : rand() % (text->size() + 1);
+    int r = rand() % 100;
+    if (r < 55 || text->empty()) {
+        text->insert(pos, s_pieces[rand() % PIECES]);
+    } else if (r < 90) {
+        size_t len = 1 + rand() % 6;
+        text->erase(pos, len);
+    } else if (r < 97) {
+        // Replace a stretch, which may cover several lines
+        size_t len = rand() % 80;
+        text->replace(pos, len, s_pieces[rand() % PIECES]);
+    } else {
+        // Paste a copy of another part of the text
+        size_t from = rand() % (text->size() + 1);
+        text->insert(pos, text->substr(from, rand() % 200));
+    }
+}
+
+static void test_random_edits(void)
+{
+    srand(1);
+    uint32_t partial = 0;
+    uint32_t edits = 0;
+    for (int run = 0; run < RUNS; run++) {
+        js_syntax_t *inc = js_syntax_create();
+        CHECK(inc != NULL);
+        if (!inc) return;
+
+        std::string text;
+        int copies = 1 + rand() % 4;
+        for (int i = 0; i < copies; i++) text += s_start;
+        CHECK(js_syntax_update(inc, text.c_str()));
+
+        for (int e = 0; e < EDITS_PER_RUN; e++) {
+            std::string before = text;
+            random_edit(&text);
+            CHECK(js_syntax_update(inc, text.c_str()));
+            edits++;
+            if (inc->last_lexed < inc->lines) partial++;
+            if (!check_against_full(inc, text)) {
+                CHECK(false);
+                fprintf(stderr, "run %d edit %d:\n--- before\n%s\n--- after\n%s\n",
+                        run, e, before.c_str(), text.c_str());
+                js_syntax_destroy(inc);
+                return;
+            }
+        }
+        js_syntax_destroy(inc);
+    }
+    // Most edits stay incremental, or this tests nothing
+    CHECK(partial > edits / 2);
+}
+
+// Edits that move the state of everything below them
+static void test_state_flips(void)
+{
+    js_syntax_t *inc = js_syntax_create();
+    CHECK(inc != NULL);
+    if (!inc) return;
+
+    std::string text = std::string(s_start) + s_start;
+    CHECK(js_syntax_update(inc, text.c_str()));
+
+    // Open a comment at the top: all lines up to the next "*/" change
+    text.insert(0, "/*\n");
+    CHECK(js_syntax_update(inc, text.c_str()));
+    CHECK(check_against_full(inc, text));
+    text.erase(0, 3);
+    CHECK(js_syntax_update(inc, text.c_str()));
+    CHECK(check_against_full(inc, text));
+
+    // Unterminated template at the top runs to the first backquote
+    text.insert(0, "`");
+    CHECK(js_syntax_update(inc, text.c_str()));
+    CHECK(check_against_full(inc, text));
+
+    // Everything deleted, then typed in again
+    CHECK(js_syntax_update(inc, ""));
+    CHECK(inc->lines == 1);
+    CHECK(js_syntax_update(inc, text.c_str()));
+    CHECK(check_against_full(inc, text));
+
+    // Unchanged text lexes nothing
+    CHECK(js_syntax_update(inc, text.c_str()));
+    CHECK(inc->last_lexed == 0);
+
+    js_syntax_destroy(inc);
+}
+
+int main(void)
+{
+    test_state_flips();
+    test_random_edits();
+
+    if (s_failures) {
+        printf("%d js_syntax check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("All js_syntax checks passed\n");
+    return 0;
+}
@@ -0,0 +1,289 @@
+/**
+ * system_settings on the host NVS stub
+ * Every setter must write only the keys whose bytes changed, and a legacy
+ * import that fails to reach NVS must run again on the next boot. Each
+ * boot is a forked child, so the module starts from scratch while the
+ * shared NVS store plays the flash.
+ */
+
+#include "system_settings.h"
+#include "nvs.h"
+#include <sys/wait.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int s_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        s_failures++; \
+    } \
+} while (0)
+
+#define FIELD_SIZE(field)   sizeof(((system_settings_t *)0)->field)
+
+// Run one boot in a child process; returns its failure count
+static int boot(void (*fn)(void))
+{
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid == 0) {
+        fn();
+        fflush(NULL);
+        _exit(s_failures > 255 ? 255 : s_failures);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+static void expect_writes(const char *what, const char *keys, size_t bytes)
+{
+    nvs_host_stats_t st;
+    nvs_host_get_stats(&st);
+    if (strcmp(st.keys, keys) != 0 || st.bytes != bytes) {
+        fprintf(stderr, "%s: wrote [%s] %u bytes, expected [%s] %u bytes\n",
+                what, st.keys, (unsigned)st.bytes, keys, (unsigned)bytes);
+        s_failures++;
+    }
+    nvs_host_reset_stats();
+}
+
+// ============ WRITE AMPLIFICATION ============
+
+static void boot_setters(void)
+{
+    CHECK(settings_init() == 0);
+    nvs_host_reset_stats();
+    
+    const size_t wifi = FIELD_SIZE(saved_wifi[0]);
+    const size_t wifi_cnt = FIELD_SIZE(saved_wifi_count);
+    const size_t icon = FIELD_SIZE(personalization.icon_positions[0]);
+    const size_t icon_cnt = FIELD_SIZE(personalization.icon_position_count);
+    
+    settings_set_brightness(80);
+    expect_writes("brightness", "bright", FIELD_SIZE(brightness));
+    settings_set_brightness(80);
+    expect_writes("same brightness", "", 0);
+    settings_set_wallpaper(2);
+    expect_writes("wallpaper", "wallpaper", FIELD_SIZE(wallpaper_index));
+    
+    settings_set_time(1700000000, 5);
+    expect_writes("time", "tz last_time", FIELD_SIZE(timezone_offset) + FIELD_SIZE(last_known_time));
+    settings_set_time(0, 5);
+    expect_writes("same time", "", 0);
+    
+    settings_save_wifi("home", "secret");
+    expect_writes("add wifi", "wifi0 wifi_cnt", wifi + wifi_cnt);
+    settings_save_wifi("home", "secret");
+    expect_writes("same wifi", "", 0);
+    const uint8_t bssid[6] = { 1, 2, 3, 4, 5, 6 };
+    settings_set_wifi_ap("home", bssid, 6, 3);
+    expect_writes("wifi ap", "wifi0", wifi);
+    settings_set_wifi_ap("home", bssid, 6, 3);
+    expect_writes("same wifi ap", "", 0);
+    settings_save_wifi("work", "x");
+    expect_writes("second wifi", "wifi1 wifi_cnt", wifi + wifi_cnt);
+    settings_delete_wifi("home");
+    expect_writes("delete wifi", "wifi0 wifi_cnt", wifi + wifi_cnt);
+    
+    settings_set_keyboard_height(50);
+    expect_writes("keyboard height", "keyboard", FIELD_SIZE(keyboard));
+    settings_set_keyboard_theme(KEYBOARD_THEME_LIGHT);
+    expect_writes("keyboard theme", "keyboard", FIELD_SIZE(keyboard));
+    
+    settings_set_location("Berlin", 52.52f, 13.40f, 1);
+    expect_writes("location", "tz location", FIELD_SIZE(timezone_offset) + FIELD_SIZE(location));
+    settings_set_location("Berlin", 52.52f, 13.40f, 1);
+    expect_writes("same location", "", 0);
+    
+    settings_set_username("Alice");
+    expect_writes("username", "user", FIELD_SIZE(user));
+    settings_set_password("1234");
+    expect_writes("password", "user", FIELD_SIZE(user));
+    
+    settings_set_flappy_score(10);
+    expect_writes("high score", "scores", FIELD_SIZE(scores));
+    settings_set_flappy_score(5);
+    expect_writes("lower score", "", 0);
+    
+    settings_set_ui_style(UI_STYLE_WIN11);
+    expect_writes("ui style", "ui_style", FIELD_SIZE(personalization.ui_style));
+    settings_set_desktop_grid(6, 5);
+    expect_writes("grid", "grid_cols", FIELD_SIZE(personalization.desktop_grid_cols));
+    settings_set_pinned_app(1, "Notepad");
+    expect_writes("pinned app", "pinned1", FIELD_SIZE(personalization.pinned_apps[1]));
+    settings_save_icon_position("Paint", 1, 2);
+    expect_writes("new icon", "icon0 icon_cnt", icon + icon_cnt);
+    settings_save_icon_position("Paint", 2, 2);
+    expect_writes("moved icon", "icon0", icon);
+    
+    settings_set_debug_mode(true);
+    expect_writes("debug", "debug", FIELD_SIZE(debug_mode));
+    
+    // Saving the whole struct unchanged writes nothing
+    settings_save(settings_get_global());
+    expect_writes("unchanged save", "", 0);
+    
+    system_settings_t s;
+    settings_load(&s);
+    s.bt_enabled = true;
+    settings_save(&s);
+    expect_writes("struct save", "bt_en", FIELD_SIZE(bt_enabled));
+}
+
+// Values written by boot_setters come back on the next boot
+static void boot_readback(void)
+{
+    CHECK(settings_init() == 0);
+    nvs_host_reset_stats();
+    
+    CHECK(settings_get_brightness() == 80);
+    CHECK(settings_get_timezone() == 1);
+    CHECK(settings_get_time() == 1700000000);
+    CHECK(settings_get_wifi_count() == 1);
+    wifi_credentials_t cred;
+    CHECK(settings_find_wifi("work", &cred) == 0 && strcmp(cred.password, "x") == 0);
+    CHECK(settings_get_keyboard_height() == 50);
+    CHECK(strcmp(settings_get_location()->city_name, "Berlin") == 0);
+    CHECK(strcmp(settings_get_username(), "Alice") == 0);
+    CHECK(settings_check_password("1234") && !settings_check_password("0000"));
+    CHECK(settings_get_flappy_score() == 10);
+    CHECK(settings_get_desktop_grid_cols() == 6);
+    CHECK(strcmp(settings_get_pinned_app(1), "Notepad") == 0);
+    int8_t x = 0, y = 0;
+    CHECK(settings_get_icon_position("Paint", &x, &y) && x == 2 && y == 2);
+    CHECK(settings_get_debug_mode());
+    CHECK(settings_get_global()->bt_enabled);
+    
+    // Reading never writes
+    expect_writes("readback", "", 0);
+}
+
+// ============ LEGACY MIGRATION ============
+
+typedef struct {
+    char ssid[33];
+    char password[65];
+    bool valid;
+} wifi_credentials_v1_t;
+
+// v1 file: magic, version 1, then the struct with 99-byte wifi entries
+static void write_legacy_file(void)
+{
+    system_settings_t s;
+    memset(&s, 0, sizeof(s));
+    s.brightness = 77;
+    s.wallpaper_index = 3;
+    s.timezone_offset = 2;
+    s.time_24h_format = true;
+    s.saved_wifi_count = 1;
+    s.keyboard.height_percent = 40;
+    s.keyboard.use_percent = true;
+    strcpy(s.location.city_name, "Oslo");
+    s.location.valid = true;
+    strcpy(s.user.username, "Bob");
+    s.scores.flappy_best = 42;
+    s.personalization.desktop_grid_cols = 5;
+    s.personalization.desktop_grid_rows = 6;
+    strcpy(s.bt_name, "legacy-bt");
+    
+    const size_t growth = sizeof(s.saved_wifi) - 5 * sizeof(wifi_credentials_v1_t);
+    const size_t wifi_off = offsetof(system_settings_t, saved_wifi);
+    const size_t tail_off = offsetof(system_settings_t, saved_wifi_count);
+    uint8_t legacy[sizeof(system_settings_t)] = {0};
+    memcpy(legacy, &s, wifi_off);
+    wifi_credentials_v1_t *wifi = (wifi_credentials_v1_t *)(legacy + wifi_off);
+    strcpy(wifi[0].ssid, "legacy-net");
+    strcpy(wifi[0].password, "legacy-pass");
+    wifi[0].valid = true;
+    memcpy(legacy + tail_off - growth, (uint8_t *)&s + tail_off, sizeof(s) - tail_off);
+    
+    FILE *f = fopen(SETTINGS_LEGACY_PATH, "wb");
+    CHECK(f != NULL);
+    fwrite("WIN32CFG", 1, 8, f);
+    fputc(1, f);
+    fwrite(legacy, 1, sizeof(s) - growth, f);
+    fclose(f);
+}
+
+static bool legacy_file_exists(void)
+{
+    return access(SETTINGS_LEGACY_PATH, F_OK) == 0;
+}
+
+static uint8_t stored_schema(void)
+{
+    nvs_handle_t nvs;
+    uint8_t schema = 0;
+    nvs_open("syscfg", NVS_READONLY, &nvs);
+    nvs_get_u8(nvs, "schema", &schema);
+    nvs_close(nvs);
+    return schema;
+}
+
+// The third key of the import fails to write; later writes would succeed
+static void boot_migrate_fail(void)
+{
+    nvs_host_fail_write(2);
+    CHECK(settings_init() == 0);
+    CHECK(stored_schema() == 0);
+    CHECK(legacy_file_exists());
+}
+
+static void boot_migrate_retry(void)
+{
+    CHECK(settings_init() == 0);
+    CHECK(stored_schema() == 2);
+    CHECK(!legacy_file_exists());
+    CHECK(settings_get_brightness() == 77);
+    CHECK(settings_get_wallpaper() == 3);
+    CHECK(settings_get_timezone() == 2);
+    wifi_credentials_t cred;
+    CHECK(settings_get_wifi(0, &cred) == 0 && strcmp(cred.ssid, "legacy-net") == 0 &&
+          strcmp(cred.password, "legacy-pass") == 0 && cred.channel == 0);
+    CHECK(settings_get_keyboard_height() == 40);
+    CHECK(strcmp(settings_get_location()->city_name, "Oslo") == 0);
+    CHECK(strcmp(settings_get_username(), "Bob") == 0);
+    CHECK(settings_get_flappy_score() == 42);
+    CHECK(settings_get_desktop_grid_rows() == 6);
+    CHECK(strcmp(settings_get_global()->bt_name, "legacy-bt") == 0);
+}
+
+// Migrated store: a plain boot reads it without writing anything
+static void boot_after_migration(void)
+{
+    nvs_host_reset_stats();
+    CHECK(settings_init() == 0);
+    CHECK(settings_get_brightness() == 77);
+    settings_get_global();
+    expect_writes("boot after migration", "", 0);
+}
+
+int main(void)
+{
+    nvs_host_share();
+    remove(SETTINGS_LEGACY_PATH);
+    
+    int failures = 0;
+    failures += boot(boot_setters);
+    failures += boot(boot_readback);
+    
+    nvs_host_clear();
+    write_legacy_file();
+    failures += boot(boot_migrate_fail);
+    failures += boot(boot_migrate_retry);
+    failures += boot(boot_after_migration);
+    remove(SETTINGS_LEGACY_PATH);
+    
+    if (failures) {
+        printf("%d settings check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All settings checks passed\n");
+    return 0;
+}
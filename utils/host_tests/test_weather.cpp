@@ -0,0 +1,320 @@
+/**
+ * json_stream and the Open-Meteo extractor on recorded responses
+ * Every document is also fed split at every byte and one byte at a time,
+ * and every truncated prefix must be reported as incomplete.
+ */
+
+#include "json_stream.h"
+#include "weather_parse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static int s_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        s_failures++; \
+    } \
+} while (0)
+
+static std::string read_file(const char *name)
+{
+    std::string path = std::string(WEATHER_DATA_DIR) + "/" + name;
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        exit(1);
+    }
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    fclose(f);
+    return text;
+}
+
+// ============ JSON STREAM ============
+
+// Every value as "<path> <type> <text>", path like .arr[1].k
+static void record_value(json_stream_t *js, json_stream_type_t type, const char *text, void *user)
+{
+    std::string line;
+    for (int i = 0; i < js->depth; i++) {
+        if (js->level[i].is_array) {
+            line += "[" + std::to_string(js->level[i].index) + "]";
+        } else {
+            line += std::string(".") + js->level[i].key;
+        }
+    }
+    line += std::string(" ") + "SNBZ"[type] + " " + text;
+    ((std::vector<std::string> *)user)->push_back(line);
+}
+
+typedef struct {
+    std::vector<std::string> values;
+    bool done;
+    bool error;
+} parse_result_t;
+
+// Feed doc in pieces cut at the given offsets
+static parse_result_t parse_split(const std::string &doc, const std::vector<size_t> &cuts)
+{
+    parse_result_t r;
+    json_stream_t js;
+    json_stream_init(&js, record_value, &r.values);
+    size_t pos = 0;
+    for (size_t cut : cuts) {
+        json_stream_feed(&js, doc.data() + pos, cut - pos);
+        pos = cut;
+    }
+    json_stream_feed(&js, doc.data() + pos, doc.size() - pos);
+    r.done = json_stream_done(&js);
+    r.error = js.error;
+    return r;
+}
+
+// Same outcome whole, in two pieces at every offset and byte by byte
+static parse_result_t parse_all_splits(const std::string &doc)
+{
+    parse_result_t whole = parse_split(doc, {});
+    for (size_t k = 1; k < doc.size(); k++) {
+        parse_result_t r = parse_split(doc, {k});
+        if (r.values != whole.values || r.done != whole.done || r.error != whole.error) {
+            fprintf(stderr, "Split at %u changes the result of %.40s\n", (unsigned)k, doc.c_str());
+            s_failures++;
+            break;
+        }
+    }
+    std::vector<size_t> bytes;
+    for (size_t k = 1; k < doc.size(); k++) bytes.push_back(k);
+    parse_result_t r = parse_split(doc, bytes);
+    CHECK(r.values == whole.values && r.done == whole.done && r.error == whole.error);
+    return whole;
+}
+
+static void test_escapes(void)
+{
+    const std::string doc =
+        "{\"s\":\"q\\\"b\\\\s\\/n\\nt\\tr\\rb\\bf\\f\","
+        " \"u\":\"\\u00e9\\u4E2D\\ud83d\\ude00\","
+        " \"lone\":\"a\\ud800b\\udc00\","
+        " \"num\":-12.5e-1,"
+        " \"arr\":[1,[true,false],{\"k\":null}],"
+        " \"long\":\"" + std::string(70, 'a') + "\","
+        " \"\xc3\xa9\":\"raw \xc2\xb0" "C\"}";
+    const std::vector<std::string> expected = {
+        ".s S q\"b\\s/n\nt\tr\rb\bf\f",
+        ".u S \xc3\xa9\xe4\xb8\xad\xf0\x9f\x98\x80",
+        ".lone S a\xef\xbf\xbd" "b\xef\xbf\xbd",
+        ".num N -12.5e-1",
+        ".arr[0] N 1",
+        ".arr[1][0] B true",
+        ".arr[1][1] B false",
+        ".arr[2].k Z null",
+        ".long S " + std::string(JSON_STREAM_TOKEN_LEN - 1, 'a'),
+        ".\xc3\xa9 S raw \xc2\xb0" "C",
+    };
+
+    parse_result_t r = parse_all_splits(doc);
+    CHECK(r.done && !r.error);
+    CHECK(r.values == expected);
+    if (r.values != expected) {
+        for (const std::string &v : r.values) fprintf(stderr, "  got: %s\n", v.c_str());
+    }
+
+    // A long escape sequence is cut before it, never inside it
+    std::string cut = "\"" + std::string(JSON_STREAM_TOKEN_LEN - 3, 'x') + "\\u4e2d\"";
+    r = parse_all_splits(cut);
+    CHECK(r.done && r.values.size() == 1 && r.values[0] == " S " + std::string(JSON_STREAM_TOKEN_LEN - 3, 'x'));
+}
+
+static void test_syntax_errors(void)
+{
+    static const char *bad[] = {
+        "{\"a\":1,}",
+        "{\"a\" 1}",
+        "[1 2]",
+        "{\"a\":tru}",
+        "{\"a\":-}",
+        "{\"a\":\"\\x\"}",
+        "{\"a\":\"\\u12G4\"}",
+        "{\"a\":1}}",
+        "{\"a\":1} x",
+        "[1,2]]",
+        "{\"a\":[1}",
+        "\"ctl\x01\"",
+        "[[[[[[[[[1]]]]]]]]]",     // One level deeper than JSON_STREAM_MAX_DEPTH
+        "{1:2}",
+    };
+    for (const char *doc : bad) {
+        parse_result_t r = parse_all_splits(doc);
+        if (!r.error || r.done) {
+            fprintf(stderr, "Accepted bad JSON: %s\n", doc);
+            s_failures++;
+        }
+    }
+
+    parse_result_t r = parse_all_splits("[[[[[[[[1]]]]]]]]");
+    CHECK(r.done && !r.error && r.values.size() == 1);
+    r = parse_all_splits("  {\"a\" : [ ] , \"b\" : { } }\r\n");
+    CHECK(r.done && !r.error && r.values.empty());
+}
+
+// Every proper prefix is incomplete but not an error
+static void test_truncated(const std::string &doc)
+{
+    for (size_t k = 0; k < doc.size(); k++) {
+        parse_result_t r = parse_split(doc.substr(0, k), {});
+        if (r.done || r.error) {
+            fprintf(stderr, "Prefix of %u bytes reported %s\n", (unsigned)k, r.done ? "complete" : "an error");
+            s_failures++;
+            return;
+        }
+    }
+}
+
+// ============ WEATHER EXTRACTOR ============
+
+static bool parse_weather(const std::string &doc, const std::vector<size_t> &cuts, weather_data_t *data)
+{
+    json_stream_t js;
+    weather_parse_begin(&js, data);
+    size_t pos = 0;
+    for (size_t cut : cuts) {
+        json_stream_feed(&js, doc.data() + pos, cut - pos);
+        pos = cut;
+    }
+    json_stream_feed(&js, doc.data() + pos, doc.size() - pos);
+    return weather_parse_end(&js, data);
+}
+
+// Whole, split at every byte, byte by byte and truncated: same data or a failure
+static bool parse_weather_all(const std::string &doc, weather_data_t *whole)
+{
+    if (!parse_weather(doc, {}, whole)) return false;
+
+    static weather_data_t other;
+    for (size_t k = 1; k < doc.size(); k++) {
+        if (!parse_weather(doc, {k}, &other) || memcmp(&other, whole, sizeof(other)) != 0) {
+            fprintf(stderr, "Weather split at %u differs\n", (unsigned)k);
+            s_failures++;
+            break;
+        }
+    }
+    std::vector<size_t> bytes;
+    for (size_t k = 1; k < doc.size(); k++) bytes.push_back(k);
+    CHECK(parse_weather(doc, bytes, &other) && memcmp(&other, whole, sizeof(other)) == 0);
+
+    for (size_t k = 0; k < doc.size(); k++) {
+        if (parse_weather(doc.substr(0, k), {}, &other)) {
+            fprintf(stderr, "Weather prefix of %u bytes accepted\n", (unsigned)k);
+            s_failures++;
+            break;
+        }
+    }
+    return true;
+}
+
+static void test_moscow(void)
+{
+    static weather_data_t w;
+    std::string doc = read_file("open_meteo_moscow.json");
+    CHECK(parse_weather_all(doc, &w));
+    test_truncated(doc);
+
+    CHECK(w.utc_offset == 10800);
+    CHECK(w.current.timestamp == 1792305900);
+    CHECK(w.current.temperature == 5.7f);
+    CHECK(w.current.apparent_temperature == 2.5f);
+    CHECK(w.current.humidity == 81.0f);
+    CHECK(w.current.wind_speed == 11.9f);
+    CHECK(w.current.pressure == 998.4f);
+    CHECK(w.current.weather_code == WEATHER_OVERCAST);
+
+    CHECK(w.daily_count == 7);
+    CHECK(w.daily[0].time == 1792270800);
+    CHECK(w.daily[0].temp_max == 9.7f && w.daily[0].temp_min == 1.2f);
+    CHECK(w.daily[3].weather_code == WEATHER_RAIN_MODERATE);
+    CHECK(w.daily[6].temp_min == 0.9f);
+    // 2026-10-18 starts at 21:00 UTC the day before: local weekday, not UTC
+    CHECK(strcmp(w.daily[0].day_name, "Sun") == 0);
+    CHECK(strcmp(w.daily[6].day_name, "Sat") == 0);
+
+    CHECK(w.hourly_count == 24);
+    CHECK(w.hourly[0].time == 1792303200);
+    CHECK(w.hourly[0].temperature == 5.7f);
+    CHECK(w.hourly[1].precipitation_prob == 15);
+    CHECK(w.hourly[23].time == 1792386000);
+    CHECK(w.hourly[23].temperature == 5.1f);
+    CHECK(w.hourly[23].precipitation_prob == 60);
+}
+
+static void test_new_york(void)
+{
+    static weather_data_t w;
+    std::string doc = read_file("open_meteo_new_york.json");
+    CHECK(parse_weather_all(doc, &w));
+
+    CHECK(w.utc_offset == -14400);
+    CHECK(w.current.timestamp == 1792294200);
+    CHECK(w.current.temperature == 11.9f);
+    CHECK(w.current.humidity == 67.0f);
+    CHECK(w.current.pressure == 1016.2f);
+    CHECK(w.daily_count == 7);
+    CHECK(w.daily[0].weather_code == WEATHER_DRIZZLE_LIGHT);
+    // 23:30 local on Saturday is already Sunday in UTC
+    CHECK(strcmp(w.daily[0].day_name, "Sat") == 0);
+    CHECK(strcmp(w.daily[1].day_name, "Sun") == 0);
+    CHECK(w.hourly_count == 24);
+    CHECK(w.hourly[3].precipitation_prob == 60);
+    // null leaves the field at zero
+    CHECK(w.hourly[20].precipitation_prob == 0 && w.hourly[23].precipitation_prob == 0);
+    CHECK(w.hourly[23].time == 1792375200);
+}
+
+static void test_error_body(void)
+{
+    // Open-Meteo's 400 body: valid JSON with none of the fields
+    static weather_data_t w;
+    CHECK(parse_weather_all(read_file("open_meteo_error.json"), &w));
+    CHECK(w.daily_count == 0 && w.hourly_count == 0 && w.current.timestamp == 0);
+}
+
+static void test_long_series(void)
+{
+    // More elements than the arrays hold: the rest is read and dropped
+    std::string doc = "{\"daily\":{\"time\":[";
+    for (int i = 0; i < 16; i++) doc += (i ? "," : "") + std::to_string(1792270800 + i * 86400);
+    doc += "]},\"hourly\":{\"temperature_2m\":[";
+    for (int i = 0; i < 48; i++) doc += (i ? "," : "") + std::to_string(i) + ".5";
+    doc += "]},\"current\":{\"temperature_2m\":-3.5,\"weather_code\":null}}";
+
+    static weather_data_t w;
+    CHECK(parse_weather_all(doc, &w));
+    CHECK(w.daily_count == WEATHER_DAILY_MAX);
+    CHECK(w.daily[WEATHER_DAILY_MAX - 1].time == 1792270800 + (WEATHER_DAILY_MAX - 1) * 86400);
+    CHECK(w.hourly_count == WEATHER_HOURLY_MAX);
+    CHECK(w.hourly[WEATHER_HOURLY_MAX - 1].temperature == WEATHER_HOURLY_MAX - 0.5f);
+    CHECK(w.current.temperature == -3.5f);
+}
+
+int main(void)
+{
+    test_escapes();
+    test_syntax_errors();
+    test_moscow();
+    test_new_york();
+    test_error_body();
+    test_long_series();
+
+    if (s_failures) {
+        printf("%d weather check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("All weather checks passed\n");
+    return 0;
+}
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""
+Trace Tool for Win32 OS
+Merges and summarises Chrome trace dumps written by the 'trace dump'
+console command (/sdcard/trace/trace_*.json)
+
+Usage:
+    python trace_tool.py summary trace_120.json [trace_300.json ...]
+    python trace_tool.py merge -o merged.json trace_120.json trace_300.json
+
+Merged files open in chrome://tracing or https://ui.perfetto.dev
+Each input becomes its own process (pid) so separate captures do not overlap.
+"""
+
+import argparse
+import json
+import os
+import sys
+from collections import defaultdict
+
+
+def load_trace(path):
+    with open(path, 'r', encoding='utf-8') as f:
+        data = json.load(f)
+    if isinstance(data, list):
+        return {'traceEvents': data}
+    return data
+
+
+def merge_traces(paths):
+    merged = []
+    dropped = 0
+    for pid, path in enumerate(paths):
+        data = load_trace(path)
+        dropped += data.get('otherData', {}).get('dropped', 0)
+        merged.append({'name': 'process_name', 'ph': 'M', 'pid': pid, 'tid': 0,
+                       'args': {'name': os.path.basename(path)}})
+        for ev in data.get('traceEvents', []):
+            ev = dict(ev)
+            ev['pid'] = pid
+            merged.append(ev)
+    merged.sort(key=lambda e: (e.get('ph') != 'M', e.get('pid', 0), e.get('ts', 0)))
+    return {'displayTimeUnit': 'ms', 'otherData': {'dropped': dropped}, 'traceEvents': merged}
+
+
+def percentile(sorted_vals, p):
+    if not sorted_vals:
+        return 0
+    k = min(len(sorted_vals) - 1, int(round(p / 100.0 * (len(sorted_vals) - 1))))
+    return sorted_vals[k]
+
+
+def summarise(trace):
+    events = trace.get('traceEvents', [])
+    thread_names = {}
+    durations = defaultdict(list)       # name -> [us]
+    per_thread = defaultdict(float)     # (pid, tid) -> busy us
+    counters = defaultdict(list)        # name -> [values]
+    instants = defaultdict(int)
+    stacks = defaultdict(list)          # (pid, tid) -> [(name, ts)]
+    unmatched = 0
+
+    for ev in sorted(events, key=lambda e: e.get('ts', 0)):
+        ph = ev.get('ph')
+        key = (ev.get('pid', 0), ev.get('tid', 0))
+        if ph == 'M':
+            if ev.get('name') == 'thread_name':
+                thread_names[key] = ev.get('args', {}).get('name', '?')
+        elif ph == 'B':
+            stacks[key].append((ev['name'], ev['ts']))
+        elif ph == 'E':
+            stack = stacks[key]
+            # Match the innermost open slice with the same name
+            for i in range(len(stack) - 1, -1, -1):
+                if stack[i][0] == ev['name']:
+                    name, start = stack.pop(i)
+                    dur = ev['ts'] - start
+                    durations[name].append(dur)
+                    if i == 0:
+                        per_thread[key] += dur
+                    break
+            else:
+                unmatched += 1
+        elif ph == 'X':
+            durations[ev['name']].append(ev.get('dur', 0))
+            per_thread[key] += ev.get('dur', 0)
+        elif ph == 'C':
+            counters[ev['name']].append(ev.get('args', {}).get('value', 0))
+        elif ph in ('i', 'I'):
+            instants[ev['name']] += 1
+
+    unmatched += sum(len(s) for s in stacks.values())
+    ts_all = [e['ts'] for e in events if 'ts' in e]
+    span = (max(ts_all) - min(ts_all)) if ts_all else 0
+
+    print("Trace span: %.1f ms, %d events, %d dropped on device, %d unmatched begin/end"
+          % (span / 1000.0, len(events), trace.get('otherData', {}).get('dropped', 0), unmatched))
+
+    if durations:
+        print("\n%-24s %7s %10s %9s %9s %9s %9s" % ('Slice', 'Count', 'Total ms', 'Mean us', 'p50 us', 'p95 us', 'Max us'))
+        rows = sorted(durations.items(), key=lambda kv: -sum(kv[1]))
+        for name, vals in rows:
+            vals.sort()
+            print("%-24s %7d %10.2f %9.1f %9d %9d %9d"
+                  % (name[:24], len(vals), sum(vals) / 1000.0, sum(vals) / len(vals),
+                     percentile(vals, 50), percentile(vals, 95), vals[-1]))
+
+    if per_thread:
+        multi = len(set(k[0] for k in per_thread)) > 1
+        print("\n%-24s %10s %7s" % ('Task', 'Busy ms', '% span'))
+        for key, busy in sorted(per_thread.items(), key=lambda kv: -kv[1]):
+            name = thread_names.get(key, 'tid %d' % key[1])
+            if multi:
+                name = '%d:%s' % (key[0], name)
+            pct = 100.0 * busy / span if span else 0
+            print("%-24s %10.2f %6.1f%%" % (name[:24], busy / 1000.0, pct))
+
+    if counters:
+        print("\n%-24s %7s %10s %10s %10s" % ('Counter', 'Samples', 'Min', 'Max', 'Last'))
+        for name, vals in sorted(counters.items()):
+            print("%-24s %7d %10d %10d %10d" % (name[:24], len(vals), min(vals), max(vals), vals[-1]))
+
+    if instants:
+        print("\n%-24s %7s" % ('Instant', 'Count'))
+        for name, count in sorted(instants.items(), key=lambda kv: -kv[1]):
+            print("%-24s %7d" % (name[:24], count))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Merge and summarise Win32 OS trace dumps')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+
+    p_sum = sub.add_parser('summary', help='Print slice/task/counter statistics')
+    p_sum.add_argument('files', nargs='+')
+
+    p_merge = sub.add_parser('merge', help='Merge dumps into one Chrome trace')
+    p_merge.add_argument('files', nargs='+')
+    p_merge.add_argument('-o', '--output', required=True)
+
+    args = parser.parse_args()
+    for path in args.files:
+        if not os.path.isfile(path):
+            print("ERROR: %s not found" % path)
+            sys.exit(1)
+
+    trace = merge_traces(args.files)
+    if args.cmd == 'merge':
+        with open(args.output, 'w', encoding='utf-8') as f:
+            json.dump(trace, f)
+        print("Merged %d file(s), %d events -> %s" % (len(args.files), len(trace['traceEvents']), args.output))
+    else:
+        summarise(trace)
+
+
+if __name__ == '__main__':
+    main()